@@ -361,11 +361,14 @@ migrate_bdb_to_sqlitedb (EBookBackendSqliteDB *sqlitedb,
 		return FALSE;
 	}
 
-	/* Add the contacts to the SQLite (only if there are any contacts to add) */
+	/* Add the contacts to the SQLite (only if there are any contacts to add),
+	 * building the indexes once all of them are in */
 	if (contacts &&
-	    !e_book_backend_sqlitedb_add_contacts (sqlitedb,
-						   sqlite_folder_id,
-						   contacts, FALSE, error)) {
+	    (!e_book_backend_sqlitedb_begin_bulk_load (sqlitedb, sqlite_folder_id, error) ||
+	     !e_book_backend_sqlitedb_add_contacts (sqlitedb,
+						    sqlite_folder_id,
+						    contacts, FALSE, error) ||
+	     !e_book_backend_sqlitedb_end_bulk_load (sqlitedb, sqlite_folder_id, error))) {
 		if (error && *error) {
 			g_warning ("Failed to add contacts to sqlite db: %s", (*error)->message);
 		} else {
@@ -1596,6 +1596,25 @@ book_backend_file_configure_direct (EBookBackend *backend,
 	priv->base_directory = g_strdup (config);
 }
 
+static EDataBookCursor *
+book_backend_file_create_cursor (EBookBackend *backend,
+                                 const EContactField *sort_fields,
+                                 const EBookCursorSortType *sort_types,
+                                 guint n_fields,
+                                 GError **error)
+{
+	EBookBackendFile *bf = E_BOOK_BACKEND_FILE (backend);
+	EDataBookCursor *cursor;
+
+	g_rw_lock_reader_lock (&(bf->priv->lock));
+	cursor = e_data_book_cursor_sqlite_new (
+		backend, bf->priv->sqlitedb, SQLITEDB_FOLDER_ID,
+		sort_fields, sort_types, n_fields, error);
+	g_rw_lock_reader_unlock (&(bf->priv->lock));
+
+	return cursor;
+}
+
 static void
 book_backend_file_sync (EBookBackend *backend)
 {
@@ -1654,6 +1673,9 @@ book_backend_file_initable_init (GInitable *initable,
 			goto exit;
 		}
 
+		/* Photos are kept in separate files, the remaining vCard text compresses well */
+		e_book_backend_sqlitedb_set_compress_vcards (priv->sqlitedb, TRUE);
+
 		success = e_book_backend_file_migrate_bdb (
 			priv->sqlitedb,
 			SQLITEDB_FOLDER_ID,
@@ -1702,6 +1724,9 @@ book_backend_file_initable_init (GInitable *initable,
 			goto exit;
 		}
 
+		/* Photos are kept in separate files, the remaining vCard text compresses well */
+		e_book_backend_sqlitedb_set_compress_vcards (priv->sqlitedb, TRUE);
+
 		/* An sqlite DB only 'exists' if the populated flag is set. */
 		populated = e_book_backend_sqlitedb_get_is_populated (
 			priv->sqlitedb,
@@ -1726,6 +1751,18 @@ book_backend_file_initable_init (GInitable *initable,
 		}
 	}
 
+	/* Only the backend running in the addressbook factory owns the
+	 * address-book.  Clients in direct read access mode, for which
+	 * the base directory is configured, use the collation keys as
+	 * they are. */
+	if (priv->base_directory == NULL) {
+		success = e_book_backend_sqlitedb_set_locale (
+			priv->sqlitedb, SQLITEDB_FOLDER_ID, error);
+
+		if (!success)
+			goto exit;
+	}
+
 	/* Resolve the photo directory here. */
 	priv->photo_dirname =
 		e_book_backend_file_extract_path_from_source (
@@ -1767,6 +1804,7 @@ e_book_backend_file_class_init (EBookBackendFileClass *class)
 	backend_class->get_direct_book = book_backend_file_get_direct_book;
 	backend_class->configure_direct = book_backend_file_configure_direct;
 	backend_class->sync = book_backend_file_sync;
+	backend_class->create_cursor = book_backend_file_create_cursor;
 }
 
 static void
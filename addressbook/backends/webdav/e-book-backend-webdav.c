@@ -865,7 +865,12 @@ download_contacts (EBookBackendWebdav *webdav,
 		++count;
 	}
 
-	/* download contacts */
+	/* download contacts, writing the cache to disk once at the end
+	 * rather than after every contact */
+	g_mutex_lock (&priv->cache_lock);
+	e_file_cache_freeze_changes (E_FILE_CACHE (priv->cache));
+	g_mutex_unlock (&priv->cache_lock);
+
 	i = 0;
 	for (element = elements; element != NULL; element = element->next, ++i) {
 		const gchar  *uri;
@@ -926,6 +931,10 @@ download_contacts (EBookBackendWebdav *webdav,
 		g_free (stored_etag);
 	}
 
+	g_mutex_lock (&priv->cache_lock);
+	e_file_cache_thaw_changes (E_FILE_CACHE (priv->cache));
+	g_mutex_unlock (&priv->cache_lock);
+
 	/* free element list */
 	for (element = elements; element != NULL; element = next) {
 		next = element->next;
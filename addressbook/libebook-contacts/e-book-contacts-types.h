@@ -126,15 +126,63 @@ typedef struct {
  * <note><para>that phone numbers must be convertible into FQTN according to E.164 to be
  * stored in this index. The number "+9999999" for instance won't be stored because
  * the country calling code "+999" currently is not assigned.</para></note>
+ * @E_BOOK_INDEX_SUBSTRING: An index suitable for searching contacts with a
+ * contains pattern (Since: 3.12)
  *
  * The type of index defined by e_source_backend_summary_setup_set_indexed_fields()
  */
 typedef enum {
 	E_BOOK_INDEX_PREFIX = 0,
 	E_BOOK_INDEX_SUFFIX,
-	E_BOOK_INDEX_PHONE
+	E_BOOK_INDEX_PHONE,
+	E_BOOK_INDEX_SUBSTRING
 } EBookIndexType;
 
+/**
+ * EBookCursorSortType:
+ * @E_BOOK_CURSOR_SORT_ASCENDING: Sort results in ascending order
+ * @E_BOOK_CURSOR_SORT_DESCENDING: Sort results in descending order
+ *
+ * Specifies the sort order of an ordered query
+ *
+ * Since: 3.12
+ */
+typedef enum {
+	E_BOOK_CURSOR_SORT_ASCENDING = 0,
+	E_BOOK_CURSOR_SORT_DESCENDING
+} EBookCursorSortType;
+
+/**
+ * EBookCursorOrigin:
+ * @E_BOOK_CURSOR_ORIGIN_CURRENT: The current cursor position
+ * @E_BOOK_CURSOR_ORIGIN_BEGIN: The beginning of the cursor results
+ * @E_BOOK_CURSOR_ORIGIN_END: The ending of the cursor results
+ *
+ * Specifies the start position to in the list of traversed contacts
+ * when stepping through a cursor.
+ *
+ * Since: 3.12
+ */
+typedef enum {
+	E_BOOK_CURSOR_ORIGIN_CURRENT = 0,
+	E_BOOK_CURSOR_ORIGIN_BEGIN,
+	E_BOOK_CURSOR_ORIGIN_END
+} EBookCursorOrigin;
+
+/**
+ * EBookCursorStepFlags:
+ * @E_BOOK_CURSOR_STEP_MOVE: The cursor position should be modified while stepping
+ * @E_BOOK_CURSOR_STEP_FETCH: Traversed contacts should be listed and returned while stepping.
+ *
+ * Defines the behaviour of stepping through a cursor.
+ *
+ * Since: 3.12
+ */
+typedef enum { /*< flags >*/
+	E_BOOK_CURSOR_STEP_MOVE = (1 << 0),
+	E_BOOK_CURSOR_STEP_FETCH = (1 << 1)
+} EBookCursorStepFlags;
+
 GQuark		e_book_client_error_quark	(void) G_GNUC_CONST;
 const gchar *	e_book_client_error_to_string	(EBookClientError code);
 
@@ -1076,8 +1076,23 @@ e_contact_set_property (GObject *object,
 			p = g_list_nth (values, info->list_elem);
 
 			if (p) {
-				g_free (p->data);
-				p->data = g_strdup (g_value_get_string (value));
+				GList *copy = NULL;
+
+				/* Replace the element through the EVCard API, so
+				 * that its cached serialization is dropped. */
+				for (; values; values = values->next) {
+					copy = g_list_prepend (
+						copy, values == p ?
+						g_strdup (sval) :
+						g_strdup (values->data));
+				}
+				copy = g_list_reverse (copy);
+
+				e_vcard_attribute_remove_values (attr);
+				for (p = copy; p; p = p->next)
+					e_vcard_attribute_add_value (attr, p->data);
+
+				g_list_free_full (copy, g_free);
 			}
 			else {
 				/* there weren't enough elements in the list, pad it */
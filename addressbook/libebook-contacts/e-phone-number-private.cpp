@@ -319,26 +319,6 @@ _e_phone_number_cxx_compare (const EPhoneNumber *first_number,
 	return _e_phone_number_cxx_compare (first_number->priv, second_number->priv);
 }
 
-EPhoneNumberMatch
-_e_phone_number_cxx_compare_strings (const gchar *first_number,
-                                     const gchar *second_number,
-                                     const gchar *region_code,
-                                     GError **error)
-{
-	g_return_val_if_fail (NULL != first_number, E_PHONE_NUMBER_MATCH_NONE);
-	g_return_val_if_fail (NULL != second_number, E_PHONE_NUMBER_MATCH_NONE);
-
-	const std::string region = _e_phone_number_cxx_make_region_code (region_code);
-	PhoneNumber pn1, pn2;
-
-	if (!_e_phone_number_cxx_parse (first_number, region, &pn1, error))
-		return E_PHONE_NUMBER_MATCH_NONE;
-	if (!_e_phone_number_cxx_parse (second_number, region, &pn2, error))
-		return E_PHONE_NUMBER_MATCH_NONE;
-
-	return _e_phone_number_cxx_compare (pn1, pn2);
-}
-
 EPhoneNumber *
 _e_phone_number_cxx_copy (const EPhoneNumber *phone_number)
 {
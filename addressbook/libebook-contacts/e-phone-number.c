@@ -66,6 +66,116 @@ _e_phone_number_set_error (GError **error,
 	g_set_error_literal (error, E_PHONE_NUMBER_ERROR, code, message);
 }
 
+#ifdef ENABLE_PHONENUMBER
+
+/* Parsing through libphonenumber is expensive, and matching contacts
+ * against phone number queries parses the same few numbers over and
+ * over again. Keep the most recently parsed ones around. */
+#define PARSE_CACHE_SIZE 512
+
+typedef struct _ParsedNumber ParsedNumber;
+
+struct _ParsedNumber {
+	gchar *key;
+	EPhoneNumber *number;	/* NULL if parsing failed */
+	EPhoneNumberError error_code;
+};
+
+G_LOCK_DEFINE_STATIC (parse_cache);
+static GHashTable *parse_cache;	/* key -> link in parse_cache_lru */
+static GQueue parse_cache_lru = G_QUEUE_INIT;	/* most recent first */
+
+static void
+parsed_number_free (ParsedNumber *parsed)
+{
+	g_free (parsed->key);
+	_e_phone_number_cxx_free (parsed->number);
+	g_slice_free (ParsedNumber, parsed);
+}
+
+static EPhoneNumber *
+phone_number_parse_cached (const gchar *phone_number,
+                           const gchar *region_code,
+                           GError **error)
+{
+	ParsedNumber *parsed;
+	EPhoneNumber *number;
+	GError *local_error = NULL;
+	GList *link;
+	gchar *key;
+
+	g_return_val_if_fail (phone_number != NULL, NULL);
+
+	/* A NULL region stands for the region of the current locale */
+	key = g_strconcat (
+		region_code ? region_code : "", "\n", phone_number, NULL);
+
+	G_LOCK (parse_cache);
+
+	if (parse_cache == NULL)
+		parse_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+	link = g_hash_table_lookup (parse_cache, key);
+	if (link != NULL) {
+		parsed = link->data;
+
+		g_queue_unlink (&parse_cache_lru, link);
+		g_queue_push_head_link (&parse_cache_lru, link);
+
+		if (parsed->number != NULL)
+			number = _e_phone_number_cxx_copy (parsed->number);
+		else {
+			number = NULL;
+			_e_phone_number_set_error (error, parsed->error_code);
+		}
+
+		G_UNLOCK (parse_cache);
+
+		g_free (key);
+
+		return number;
+	}
+
+	G_UNLOCK (parse_cache);
+
+	number = _e_phone_number_cxx_from_string (
+		phone_number, region_code, &local_error);
+
+	parsed = g_slice_new0 (ParsedNumber);
+	parsed->key = key;
+	parsed->number = _e_phone_number_cxx_copy (number);
+	parsed->error_code = local_error != NULL ?
+		local_error->code : E_PHONE_NUMBER_ERROR_UNKNOWN;
+
+	G_LOCK (parse_cache);
+
+	if (g_hash_table_contains (parse_cache, key)) {
+		/* Another thread parsed the same number meanwhile */
+		parsed_number_free (parsed);
+	} else {
+		g_queue_push_head (&parse_cache_lru, parsed);
+		g_hash_table_insert (
+			parse_cache, parsed->key, parse_cache_lru.head);
+
+		if (parse_cache_lru.length > PARSE_CACHE_SIZE) {
+			ParsedNumber *oldest;
+
+			oldest = g_queue_pop_tail (&parse_cache_lru);
+			g_hash_table_remove (parse_cache, oldest->key);
+			parsed_number_free (oldest);
+		}
+	}
+
+	G_UNLOCK (parse_cache);
+
+	if (local_error != NULL)
+		g_propagate_error (error, local_error);
+
+	return number;
+}
+
+#endif /* ENABLE_PHONENUMBER */
+
 /**
  * e_phone_number_is_supported:
  *
@@ -176,6 +286,9 @@ e_phone_number_get_default_region (GError **error)
  * If the number is guaranteed to start with a '+' followed by the country
  * calling code, then "ZZ" can be passed for @region_code.
  *
+ * The most recently parsed numbers are cached, so parsing the same
+ * string again is cheap.
+ *
  * Returns: (transfer full): a new EPhoneNumber instance on success,
  * or %NULL on error. Call e_phone_number_free() to release this instance.
  *
@@ -188,7 +301,7 @@ e_phone_number_from_string (const gchar *phone_number,
 {
 #ifdef ENABLE_PHONENUMBER
 
-	return _e_phone_number_cxx_from_string (phone_number, region_code, error);
+	return phone_number_parse_cached (phone_number, region_code, error);
 
 #else /* ENABLE_PHONENUMBER */
 
@@ -362,8 +475,28 @@ e_phone_number_compare_strings_with_region (const gchar *first_number,
 {
 #ifdef ENABLE_PHONENUMBER
 
-	return _e_phone_number_cxx_compare_strings (
-		first_number, second_number, region_code, error);
+	EPhoneNumber *pn1, *pn2;
+	EPhoneNumberMatch match;
+
+	g_return_val_if_fail (first_number != NULL, E_PHONE_NUMBER_MATCH_NONE);
+	g_return_val_if_fail (second_number != NULL, E_PHONE_NUMBER_MATCH_NONE);
+
+	pn1 = phone_number_parse_cached (first_number, region_code, error);
+	if (pn1 == NULL)
+		return E_PHONE_NUMBER_MATCH_NONE;
+
+	pn2 = phone_number_parse_cached (second_number, region_code, error);
+	if (pn2 == NULL) {
+		_e_phone_number_cxx_free (pn1);
+		return E_PHONE_NUMBER_MATCH_NONE;
+	}
+
+	match = _e_phone_number_cxx_compare (pn1, pn2);
+
+	_e_phone_number_cxx_free (pn1);
+	_e_phone_number_cxx_free (pn2);
+
+	return match;
 
 #else /* ENABLE_PHONENUMBER */
 
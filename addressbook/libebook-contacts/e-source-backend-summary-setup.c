@@ -539,7 +539,9 @@ e_source_backend_summary_setup_get_indexed_fields (ESourceBackendSummarySetup *e
  * be used for #E_BOOK_QUERY_BEGINS_WITH queries. A #E_BOOK_INDEX_SUFFIX index
  * will be constructed efficiently for suffix matching and will be used for
  * #E_BOOK_QUERY_ENDS_WITH queries. Similar a #E_BOOK_INDEX_PHONE index will optimize
- * #E_BOOK_QUERY_EQUALS_PHONE_NUMBER searches.
+ * #E_BOOK_QUERY_EQUALS_PHONE_NUMBER searches. An #E_BOOK_INDEX_SUBSTRING index
+ * speeds up #E_BOOK_QUERY_CONTAINS queries, it can only be added along with a new
+ * addressbook.
  *
  * <note><para>The specified indexed fields must also be a part of the summary, any indexed fields
  * specified that are not already a part of the summary will be ignored.</para></note>
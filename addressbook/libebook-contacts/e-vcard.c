@@ -134,6 +134,13 @@ typedef enum {
 struct _EVCardPrivate {
 	GList *attributes;
 	gchar *vcard;
+
+	/* The last vCard 3.0 serialization, dropped by any change made
+	 * through the EVCard API, see vcard_changed(). Lists returned by
+	 * the getters must not be edited in place, the cache would not
+	 * notice. Guarded by the serialized lock, since concurrent reads
+	 * fill it in. */
+	gchar *serialized;
 };
 
 struct _EVCardAttribute {
@@ -144,13 +151,52 @@ struct _EVCardAttribute {
 	GList *decoded_values;
 	EVCardEncoding encoding;
 	gboolean encoding_set;
+
+	/* Parsed attributes keep a copy of their undecoded value and
+	 * decode it on first access, most attributes of a parsed vCard
+	 * are never read. See attribute_ensure_values(). */
+	gchar *raw_value;
+	gchar *raw_charset;
+	gboolean raw_quoted_printable;
+
+	EVCard *owner; /* not referenced, the vCard owns the attribute */
 };
 
 struct _EVCardAttributeParam {
 	gchar     *name;
 	GList    *values;  /* GList of gchar *'s */
+
+	EVCardAttribute *owner; /* the attribute owning the param, or NULL */
 };
 
+G_LOCK_DEFINE_STATIC (serialized);
+
+static void
+vcard_changed (EVCard *evc)
+{
+	gchar *serialized;
+
+	G_LOCK (serialized);
+	serialized = evc->priv->serialized;
+	evc->priv->serialized = NULL;
+	G_UNLOCK (serialized);
+
+	g_free (serialized);
+}
+
+static void
+attribute_changed (EVCardAttribute *attr)
+{
+	if (attr != NULL && attr->owner != NULL)
+		vcard_changed (attr->owner);
+}
+
+static void
+attribute_param_changed (EVCardAttributeParam *param)
+{
+	attribute_changed (param->owner);
+}
+
 static void
 vcard_finalize (GObject *object)
 {
@@ -165,6 +211,7 @@ vcard_finalize (GObject *object)
 		priv->attributes, (GDestroyNotify) e_vcard_attribute_free);
 
 	g_free (priv->vcard);
+	g_free (priv->serialized);
 
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (e_vcard_parent_class)->finalize (object);
@@ -320,6 +367,48 @@ skip_until (gchar **p,
 	*p = lp;
 }
 
+/* Advances *p past an attribute value, the same way
+ * read_attribute_value() does, without decoding it */
+static void
+skip_attribute_value (gchar **p,
+                      gboolean quoted_printable)
+{
+	gchar *lp;
+
+	for (lp = skip_newline (*p, quoted_printable);
+	     *lp != '\n' && *lp != '\r' && *lp != '\0';
+	     lp = skip_newline (lp, quoted_printable)) {
+
+		if (*lp == '=' && quoted_printable) {
+			lp++;
+			lp = skip_newline (lp, quoted_printable);
+
+			if (*lp == '\0') break;
+			lp++;
+			lp = skip_newline (lp, quoted_printable);
+
+			if (*lp == '\0') break;
+			lp++;
+		} else if (*lp == '\\') {
+			lp = g_utf8_next_char (lp);
+			if (*lp == '\0')
+				break;
+
+			lp = skip_newline (lp, quoted_printable);
+			if (*lp == '\0')
+				break;
+
+			lp = g_utf8_next_char (lp);
+		} else {
+			lp = g_utf8_next_char (lp);
+		}
+	}
+
+	skip_to_next_line (&lp);
+
+	*p = lp;
+}
+
 static void
 read_attribute_value (EVCardAttribute *attr,
                       gchar **p,
@@ -328,6 +417,10 @@ read_attribute_value (EVCardAttribute *attr,
 {
 	gchar *lp = *p;
 	GString *str;
+	GList *values = NULL;
+	gboolean split_commas;
+
+	split_commas = !g_ascii_strcasecmp (attr->name, "CATEGORIES");
 
 	/* read in the value */
 	str = g_string_new ("");
@@ -342,10 +435,12 @@ read_attribute_value (EVCardAttribute *attr,
 			lp++;
 			lp = skip_newline (lp, quoted_printable);
 
-			if ((a = *(lp++)) == '\0') break;
+			if ((a = *lp) == '\0') break;
+			lp++;
 			lp = skip_newline (lp, quoted_printable);
 
-			if ((b = *(lp++)) == '\0') break;
+			if ((b = *lp) == '\0') break;
+			lp++;
 			if (isxdigit (a) && isxdigit (b)) {
 				gchar c;
 
@@ -374,6 +469,10 @@ read_attribute_value (EVCardAttribute *attr,
 			 * need next real character
 			 */
 			lp = skip_newline (lp, quoted_printable);
+			if (*lp == '\0') {
+				g_string_append_c (str, '\\');
+				break;
+			}
 
 			switch (*lp) {
 			case 'n': g_string_append_c (str, '\n'); break;
@@ -391,8 +490,7 @@ read_attribute_value (EVCardAttribute *attr,
 			}
 			lp = g_utf8_next_char (lp);
 		}
-		else if ((*lp == ';') ||
-			 (*lp == ',' && !g_ascii_strcasecmp (attr->name, "CATEGORIES"))) {
+		else if ((*lp == ';') || (*lp == ',' && split_commas)) {
 			if (charset) {
 				gchar *tmp;
 
@@ -403,35 +501,80 @@ read_attribute_value (EVCardAttribute *attr,
 				}
 			}
 
-			e_vcard_attribute_add_value (attr, str->str);
-			g_string_assign (str, "");
+			values = g_list_prepend (values, g_strndup (str->str, str->len));
+			g_string_truncate (str, 0);
 			lp = g_utf8_next_char (lp);
 		}
 		else {
-			g_string_append_unichar (str, g_utf8_get_char (lp));
-			lp = g_utf8_next_char (lp);
+			gchar *run = lp;
+
+			/* Copy the run of plain characters up to the next one
+			 * needing attention at once, they are all ASCII */
+			while (*lp != '\n' && *lp != '\r' && *lp != '\0' &&
+			       *lp != '\\' && *lp != ';' && *lp != ',' &&
+			       (*lp != '=' || !quoted_printable))
+				lp++;
+
+			/* A plain ',' outside of CATEGORIES */
+			if (lp == run)
+				lp = g_utf8_next_char (lp);
+
+			g_string_append_len (str, run, lp - run);
 		}
 	}
-	if (str) {
-		if (charset) {
-			gchar *tmp;
-
-			tmp = g_convert (str->str, str->len, "UTF-8", charset, NULL, NULL, NULL);
-			if (tmp) {
-				g_string_assign (str, tmp);
-				g_free (tmp);
-			}
-		}
 
-		e_vcard_attribute_add_value (attr, str->str);
-		g_string_free (str, TRUE);
+	if (charset) {
+		gchar *tmp;
+
+		tmp = g_convert (str->str, str->len, "UTF-8", charset, NULL, NULL, NULL);
+		if (tmp) {
+			g_string_assign (str, tmp);
+			g_free (tmp);
+		}
 	}
 
+	values = g_list_prepend (values, g_string_free (str, FALSE));
+	attr->values = g_list_concat (attr->values, g_list_reverse (values));
+
 	skip_to_next_line ( &lp );
 
 	*p = lp;
 }
 
+/* Guards decoding the values of parsed attributes, so that
+ * reading an attribute stays safe from several threads */
+G_LOCK_DEFINE_STATIC (raw_values);
+
+/* Decodes the values of a parsed attribute, if not done yet */
+static GList *
+attribute_ensure_values (EVCardAttribute *attr)
+{
+	if (g_atomic_pointer_get (&attr->raw_value) == NULL)
+		return attr->values;
+
+	G_LOCK (raw_values);
+
+	if (attr->raw_value != NULL) {
+		gchar *raw_value = attr->raw_value;
+		gchar *lp = raw_value;
+
+		read_attribute_value (
+			attr, &lp, attr->raw_quoted_printable,
+			attr->raw_charset);
+
+		g_free (attr->raw_charset);
+		attr->raw_charset = NULL;
+
+		/* Only now the values are complete */
+		g_atomic_pointer_set (&attr->raw_value, NULL);
+		g_free (raw_value);
+	}
+
+	G_UNLOCK (raw_values);
+
+	return attr->values;
+}
+
 static void
 read_attribute_params (EVCardAttribute *attr,
                        gchar **p,
@@ -596,10 +739,12 @@ read_attribute_params (EVCardAttribute *attr,
 }
 
 /* reads an entire attribute from the input buffer, leaving p pointing
- * at the start of the next line (past the \r\n) */
+ * at the start of the next line (past the \r\n). The value is not
+ * decoded, the attribute keeps a copy of it until it is needed. */
 static EVCardAttribute *
 read_attribute (gchar **p)
 {
+	gchar *value_start;
 	gchar *attr_group = NULL;
 	gchar *attr_name = NULL;
 	EVCardAttribute *attr = NULL;
@@ -677,18 +822,23 @@ read_attribute (gchar **p)
 		if (is_qp)
 			attr->encoding = EVC_ENCODING_RAW;
 	}
-	if (*lp == ':') {
-		/* skip past the ':' */
-		lp = g_utf8_next_char (lp);
-		read_attribute_value (attr, &lp, is_qp, charset);
+	if (*lp != ':') {
+		g_free (charset);
+		*p = lp;
+		goto lose;
 	}
 
-	g_free (charset);
+	/* skip past the ':' */
+	lp = g_utf8_next_char (lp);
 
-	*p = lp;
+	value_start = lp;
+	skip_attribute_value (&lp, is_qp);
 
-	if (!attr->values)
-		goto lose;
+	attr->raw_value = g_strndup (value_start, lp - value_start);
+	attr->raw_charset = charset;
+	attr->raw_quoted_printable = is_qp;
+
+	*p = lp;
 
 	return attr;
  lose:
@@ -738,17 +888,24 @@ make_valid_utf8 (const gchar *name)
 /* we try to be as forgiving as we possibly can here - this isn't a
  * validator.  Almost nothing is considered a fatal error.  We always
  * try to return *something*.
+ *
+ * Takes ownership of @str.
  */
 static void
 parse (EVCard *evc,
-       const gchar *str,
+       gchar *str,
        gboolean ignore_uid)
 {
 	gchar *buf;
 	gchar *p;
 	EVCardAttribute *attr;
 
-	buf = make_valid_utf8 (str);
+	if (g_utf8_validate (str, -1, NULL)) {
+		buf = str;
+	} else {
+		buf = make_valid_utf8 (str);
+		g_free (str);
+	}
 
 	d (printf ("BEFORE FOLDING:\n"));
 	d (printf (str));
@@ -809,9 +966,8 @@ e_vcard_ensure_attributes (EVCard *evc)
 		/* detach vCard to avoid loops */
 		evc->priv->vcard = NULL;
 
-		/* Parse the vCard */
+		/* Parse the vCard, which takes over the string */
 		parse (evc, vcs, have_uid);
-		g_free (vcs);
 	}
 
 	return evc->priv->attributes;
@@ -976,6 +1132,7 @@ e_vcard_construct_with_uid (EVCard *evc,
 
 		attr = e_vcard_attribute_new (NULL, EVC_UID);
 		e_vcard_attribute_add_value (attr, uid);
+		attr->owner = evc;
 
 		evc->priv->attributes = g_list_prepend (evc->priv->attributes, attr);
 	}
@@ -1144,7 +1301,7 @@ e_vcard_to_string_vcard_21 (EVCard *evc)
 		empty = TRUE; /* Empty fields should be omitted -- some headsets may choke on it */
 		encode = FALSE; /* Generally only new line MUST be encoded (Quoted Printable) */
 
-		for (v = attr->values; v; v = v->next) {
+		for (v = attribute_ensure_values (attr); v; v = v->next) {
 			gchar *value = v->data;
 
 			if (value && *value)
@@ -1247,43 +1404,176 @@ e_vcard_to_string_vcard_21 (EVCard *evc)
 	return g_string_free (str, FALSE);
 }
 
+/* 5.8.2:
+ * When generating a content line, lines longer than 75
+ * characters SHOULD be folded
+ */
+#define FOLD_LENGTH 75
+
+/* Builds the vCard 3.0 string in a single pass, folding content
+ * lines as they are written instead of rebuilding them afterwards */
+typedef struct {
+	GString *str;
+	glong line_length; /* in characters */
+} VCardWriter;
+
+static void
+writer_append_len (VCardWriter *writer,
+                   const gchar *s,
+                   gsize len)
+{
+	const gchar *end = s + len;
+
+	while (s < end) {
+		const gchar *p = s;
+
+		if (writer->line_length == FOLD_LENGTH) {
+			g_string_append_len (writer->str, CRLF " ", 3);
+			writer->line_length = 1;
+		}
+
+		/* take as many characters as still fit on the line */
+		while (p < end && writer->line_length < FOLD_LENGTH) {
+			p++;
+			while (p < end && ((guchar) *p & 0xc0) == 0x80)
+				p++;
+			writer->line_length++;
+		}
+
+		g_string_append_len (writer->str, s, p - s);
+		s = p;
+	}
+}
+
+static void
+writer_append (VCardWriter *writer,
+               const gchar *s)
+{
+	writer_append_len (writer, s, strlen (s));
+}
+
+static void
+writer_append_c (VCardWriter *writer,
+                 gchar c)
+{
+	writer_append_len (writer, &c, 1);
+}
+
+static void
+writer_end_line (VCardWriter *writer)
+{
+	g_string_append_len (writer->str, CRLF, 2);
+	writer->line_length = 0;
+}
+
+/* Same escaping as e_vcard_escape_string(), without the intermediate string */
+static void
+writer_append_escaped (VCardWriter *writer,
+                       const gchar *s)
+{
+	const gchar *p = s;
+
+	while (*p) {
+		const gchar *escaped;
+
+		/* copy runs of characters needing no escape at once */
+		p += strcspn (p, "\n\r;,\\");
+		writer_append_len (writer, s, p - s);
+
+		switch (*p) {
+		case '\0':
+			return;
+		case '\n':
+			escaped = "\\n";
+			break;
+		case '\r':
+			if (*(p + 1) == '\n')
+				p++;
+			escaped = "\\n";
+			break;
+		case ';':
+			escaped = "\\;";
+			break;
+		case ',':
+			escaped = "\\,";
+			break;
+		default: /* '\\' */
+			escaped = "\\\\";
+			break;
+		}
+
+		writer_append_len (writer, escaped, 2);
+		s = ++p;
+	}
+}
+
+/* Estimates the length of the vCard 3.0 string, so the whole
+ * string can be allocated at once */
+static gsize
+vcard_30_estimate_length (GList *attributes)
+{
+	GList *l, *list, *v;
+	gsize length = 0;
+
+	for (l = attributes; l; l = l->next) {
+		EVCardAttribute *attr = l->data;
+
+		if (attr->group)
+			length += strlen (attr->group) + 1;
+		length += strlen (attr->name) + 3;
+
+		for (list = attr->params; list; list = list->next) {
+			EVCardAttributeParam *param = list->data;
+
+			length += strlen (param->name) + 2;
+			for (v = param->values; v; v = v->next)
+				length += strlen (v->data) + 3;
+		}
+
+		for (v = attribute_ensure_values (attr); v; v = v->next)
+			length += strlen (v->data) + 1;
+	}
+
+	/* room for escapes and folding */
+	return length + length / 16 + 64;
+}
+
 static gchar *
 e_vcard_to_string_vcard_30 (EVCard *evc)
 {
 	GList *l;
 	GList *v;
+	VCardWriter writer;
 
-	GString *str = g_string_new ("");
+	writer.str = g_string_sized_new (
+		vcard_30_estimate_length (e_vcard_ensure_attributes (evc)));
+	writer.line_length = 0;
 
-	g_string_append (str, "BEGIN:VCARD" CRLF);
+	g_string_append (writer.str, "BEGIN:VCARD" CRLF);
 
 	/* we hardcode the version (since we're outputting to a
 	 * specific version) and ignore any version attributes the
 	 * vcard might contain */
-	g_string_append (str, "VERSION:3.0" CRLF);
+	g_string_append (writer.str, "VERSION:3.0" CRLF);
 
 	for (l = e_vcard_ensure_attributes (evc); l; l = l->next) {
 		GList *list;
 		EVCardAttribute *attr = l->data;
-		GString *attr_str;
-		glong len;
 		EVCardAttributeParam *quoted_printable_param = NULL;
 
 		if (!g_ascii_strcasecmp (attr->name, "VERSION"))
 			continue;
 
-		attr_str = g_string_new ("");
-
 		/* From rfc2425, 5.8.2
 		 *
 		 * contentline  = [group "."] name *(";" param) ":" value CRLF
 		 */
 
 		if (attr->group) {
-			g_string_append (attr_str, attr->group);
-			g_string_append_c (attr_str, '.');
+			writer_append (&writer, attr->group);
+			writer_append_c (&writer, '.');
 		}
-		g_string_append (attr_str, attr->name);
+		writer_append (&writer, attr->name);
 
 		/* handle the parameters */
 		for (list = attr->params; list; list = list->next) {
@@ -1303,10 +1593,10 @@ e_vcard_to_string_vcard_30 (EVCard *evc)
 			/* 5.8.2:
 			 * param        = param-name "=" param-value *("," param-value)
 			 */
-			g_string_append_c (attr_str, ';');
-			g_string_append (attr_str, param->name);
+			writer_append_c (&writer, ';');
+			writer_append (&writer, param->name);
 			if (param->values) {
-				g_string_append_c (attr_str, '=');
+				writer_append_c (&writer, '=');
 
 				for (v = param->values; v; v = v->next) {
 					gchar *value = v->data;
@@ -1321,33 +1611,31 @@ e_vcard_to_string_vcard_30 (EVCard *evc)
 					}
 
 					if (quotes) {
-						gint i;
-
-						g_string_append_c (attr_str, '"');
+						const gchar *quote;
 
-						for (i = 0; value[i]; i++) {
-							/* skip quotes in quoted string; it is not allowed */
-							if (value[i] == '\"')
-								continue;
+						writer_append_c (&writer, '"');
 
-							g_string_append_c (attr_str, value[i]);
+						/* skip quotes in quoted string; it is not allowed */
+						while ((quote = strchr (value, '"')) != NULL) {
+							writer_append_len (&writer, value, quote - value);
+							value = (gchar *) quote + 1;
 						}
+						writer_append (&writer, value);
 
-						g_string_append_c (attr_str, '"');
+						writer_append_c (&writer, '"');
 					} else
-						g_string_append (attr_str, value);
+						writer_append (&writer, value);
 
 					if (v->next)
-						g_string_append_c (attr_str, ',');
+						writer_append_c (&writer, ',');
 				}
 			}
 		}
 
-		g_string_append_c (attr_str, ':');
+		writer_append_c (&writer, ':');
 
-		for (v = attr->values; v; v = v->next) {
+		for (v = attribute_ensure_values (attr); v; v = v->next) {
 			gchar *value = v->data;
-			gchar *escaped_value = NULL;
 
 			/* values are in quoted-printable encoding, but this cannot be used in vCard 3.0,
 			 * thus it needs to be converted first */
@@ -1362,60 +1650,28 @@ e_vcard_to_string_vcard_30 (EVCard *evc)
 				v->data = value;
 			}
 
-			escaped_value = e_vcard_escape_string (value);
-
-			g_string_append (attr_str, escaped_value);
+			writer_append_escaped (&writer, value);
 			if (v->next) {
 				/* XXX toshok - i hate you, rfc 2426.
 				 * why doesn't CATEGORIES use a; like
 				 * a normal list attribute? */
 				if (!g_ascii_strcasecmp (attr->name, "CATEGORIES"))
-					g_string_append_c (attr_str, ',');
+					writer_append_c (&writer, ',');
 				else
-					g_string_append_c (attr_str, ';');
+					writer_append_c (&writer, ';');
 			}
-
-			g_free (escaped_value);
 		}
 
-		/* 5.8.2:
-		 * When generating a content line, lines longer than 75
-		 * characters SHOULD be folded
-		 */
-		len = g_utf8_strlen (attr_str->str, -1);
-		if (len > 75) {
-			GString *fold_str = g_string_sized_new (attr_str->len + len / 74 * 3);
-			gchar *pos1 = attr_str->str;
-			gchar *pos2 = pos1;
-			pos2 = g_utf8_offset_to_pointer (pos2, 75);
-			len -= 75;
-
-			while (1) {
-				g_string_append_len (fold_str, pos1, pos2 - pos1);
-				g_string_append (fold_str, CRLF " ");
-				pos1 = pos2;
-				if (len <= 74)
-					break;
-				pos2 = g_utf8_offset_to_pointer (pos2, 74);
-				len -= 74;
-			}
-			g_string_append (fold_str, pos1);
-			g_string_free (attr_str, TRUE);
-			attr_str = fold_str;
-		}
-		g_string_append (attr_str, CRLF);
-
-		g_string_append (str, attr_str->str);
-		g_string_free (attr_str, TRUE);
+		writer_end_line (&writer);
 
 		/* remove the encoding parameter, to not decode multiple times */
 		if (quoted_printable_param)
 			e_vcard_attribute_remove_param (attr, quoted_printable_param->name);
 	}
 
-	g_string_append (str, "END:VCARD");
+	g_string_append (writer.str, "END:VCARD");
 
-	return g_string_free (str, FALSE);
+	return g_string_free (writer.str, FALSE);
 }
 
 /**
@@ -1432,6 +1688,8 @@ gchar *
 e_vcard_to_string (EVCard *evc,
                    EVCardFormat format)
 {
+	gchar *str;
+
 	g_return_val_if_fail (E_IS_VCARD (evc), NULL);
 
 	switch (format) {
@@ -1446,7 +1704,24 @@ e_vcard_to_string (EVCard *evc,
 		    strstr_nocase (evc->priv->vcard, CRLF "VERSION:3.0" CRLF))
 			return g_strdup (evc->priv->vcard);
 
-		return e_vcard_to_string_vcard_30 (evc);
+		G_LOCK (serialized);
+		str = g_strdup (evc->priv->serialized);
+		G_UNLOCK (serialized);
+
+		if (str != NULL)
+			return str;
+
+		/* Serializing may drop quoted-printable parameters, which
+		 * discards the cache, hence do it unlocked and assign the
+		 * result afterwards */
+		str = e_vcard_to_string_vcard_30 (evc);
+
+		G_LOCK (serialized);
+		if (evc->priv->serialized == NULL)
+			evc->priv->serialized = g_strdup (str);
+		G_UNLOCK (serialized);
+
+		return str;
 	default:
 		g_warning ("invalid format specifier passed to e_vcard_to_string");
 		return g_strdup ("");
@@ -1493,7 +1768,7 @@ e_vcard_dump_structure (EVCard *evc)
 			}
 		}
 		printf ("    +- values=\n");
-		for (v = attr->values, i = 0; v; v = v->next, i++) {
+		for (v = attribute_ensure_values (attr), i = 0; v; v = v->next, i++) {
 			printf ("        [%d] = `%s'\n", i, (gchar *) v->data);
 		}
 	}
@@ -1562,8 +1837,20 @@ e_vcard_attribute_copy (EVCardAttribute *attr)
 
 	a = e_vcard_attribute_new (attr->group, attr->name);
 
-	for (p = attr->values; p; p = p->next)
-		e_vcard_attribute_add_value (a, p->data);
+	/* Copy the undecoded value rather than decoding it for the copy */
+	G_LOCK (raw_values);
+
+	if (attr->raw_value != NULL) {
+		a->raw_value = g_strdup (attr->raw_value);
+		a->raw_charset = g_strdup (attr->raw_charset);
+		a->raw_quoted_printable = attr->raw_quoted_printable;
+	} else {
+		for (p = attr->values; p; p = p->next)
+			a->values = g_list_prepend (a->values, g_strdup (p->data));
+		a->values = g_list_reverse (a->values);
+	}
+
+	G_UNLOCK (raw_values);
 
 	for (p = attr->params; p; p = p->next)
 		e_vcard_attribute_add_param (a, e_vcard_attribute_param_copy (p->data));
@@ -1626,6 +1913,7 @@ e_vcard_remove_attributes (EVCard *evc,
 			evc->priv->attributes = g_list_delete_link (evc->priv->attributes, attr);
 
 			e_vcard_attribute_free (a);
+			vcard_changed (evc);
 		}
 
 		attr = next_attr;
@@ -1651,6 +1939,7 @@ e_vcard_remove_attribute (EVCard *evc,
 	 * our attributes. */
 	evc->priv->attributes = g_list_remove (evc->priv->attributes, attr);
 	e_vcard_attribute_free (attr);
+	vcard_changed (evc);
 }
 
 /**
@@ -1678,6 +1967,9 @@ e_vcard_append_attribute (EVCard *evc,
 	} else {
 		evc->priv->attributes = g_list_append (e_vcard_ensure_attributes (evc), attr);
 	}
+
+	attr->owner = evc;
+	vcard_changed (evc);
 }
 
 /**
@@ -1765,6 +2057,9 @@ e_vcard_add_attribute (EVCard *evc,
 	} else {
 		evc->priv->attributes = g_list_prepend (e_vcard_ensure_attributes (evc), attr);
 	}
+
+	attr->owner = evc;
+	vcard_changed (evc);
 }
 
 /**
@@ -1839,7 +2134,10 @@ e_vcard_attribute_add_value (EVCardAttribute *attr,
 {
 	g_return_if_fail (attr != NULL);
 
+	attribute_ensure_values (attr);
+
 	attr->values = g_list_append (attr->values, g_strdup (value));
+	attribute_changed (attr);
 }
 
 /**
@@ -1861,6 +2159,8 @@ e_vcard_attribute_add_value_decoded (EVCardAttribute *attr,
 {
 	g_return_if_fail (attr != NULL);
 
+	attribute_changed (attr);
+
 	switch (attr->encoding) {
 	case EVC_ENCODING_RAW:
 		g_warning ("can't add_value_decoded with an attribute using RAW encoding.  you must set the ENCODING parameter first");
@@ -1938,6 +2238,14 @@ e_vcard_attribute_remove_values (EVCardAttribute *attr)
 {
 	g_return_if_fail (attr != NULL);
 
+	/* Values which were never decoded are just dropped */
+	if (attr->raw_value != NULL) {
+		g_free (attr->raw_value);
+		attr->raw_value = NULL;
+		g_free (attr->raw_charset);
+		attr->raw_charset = NULL;
+	}
+
 	g_list_foreach (attr->values, (GFunc) g_free, NULL);
 	g_list_free (attr->values);
 	attr->values = NULL;
@@ -1945,6 +2253,8 @@ e_vcard_attribute_remove_values (EVCardAttribute *attr)
 	g_list_foreach (attr->decoded_values, (GFunc) free_gstring, NULL);
 	g_list_free (attr->decoded_values);
 	attr->decoded_values = NULL;
+
+	attribute_changed (attr);
 }
 
 /**
@@ -1963,12 +2273,14 @@ e_vcard_attribute_remove_value (EVCardAttribute *attr,
 	g_return_if_fail (attr != NULL);
 	g_return_if_fail (s != NULL);
 
-	l = g_list_find_custom (attr->values, s, (GCompareFunc) strcmp);
+	l = g_list_find_custom (
+		attribute_ensure_values (attr), s, (GCompareFunc) strcmp);
 	if (l == NULL) {
 		return;
 	}
 
 	attr->values = g_list_delete_link (attr->values, l);
+	attribute_changed (attr);
 }
 
 /**
@@ -1998,6 +2310,7 @@ e_vcard_attribute_remove_param (EVCardAttribute *attr,
 					param_name) == 0) {
 			attr->params = g_list_delete_link (attr->params, l);
 			e_vcard_attribute_param_free (param);
+			attribute_changed (attr);
 			break;
 		}
 	}
@@ -2023,6 +2336,8 @@ e_vcard_attribute_remove_params (EVCardAttribute *attr)
 	/* also remove the cached encoding on this attribute */
 	attr->encoding_set = FALSE;
 	attr->encoding = EVC_ENCODING_RAW;
+
+	attribute_changed (attr);
 }
 
 GType
@@ -2058,6 +2373,7 @@ e_vcard_attribute_param_new (const gchar *name)
 	EVCardAttributeParam *param = g_slice_new (EVCardAttributeParam);
 	param->values = NULL;
 	param->name = g_strdup (name);
+	param->owner = NULL;
 
 	return param;
 }
@@ -2127,6 +2443,8 @@ e_vcard_attribute_add_param (EVCardAttribute *attr,
 	g_return_if_fail (attr != NULL);
 	g_return_if_fail (param != NULL);
 
+	attribute_changed (attr);
+
 	contains = FALSE;
 	params = attr->params;
 	par_name = param->name;
@@ -2168,6 +2486,7 @@ e_vcard_attribute_add_param (EVCardAttribute *attr,
 
 	if (!contains) {
 		attr->params = g_list_prepend (attr->params, param);
+		param->owner = attr;
 	}
 
 	/* we handle our special encoding stuff here */
@@ -2219,6 +2538,7 @@ e_vcard_attribute_param_add_value (EVCardAttributeParam *param,
 	g_return_if_fail (param != NULL);
 
 	param->values = g_list_append (param->values, g_strdup (value));
+	attribute_param_changed (param);
 }
 
 /**
@@ -2318,6 +2638,8 @@ e_vcard_attribute_param_remove_values (EVCardAttributeParam *param)
 	g_list_foreach (param->values, (GFunc) g_free, NULL);
 	g_list_free (param->values);
 	param->values = NULL;
+
+	attribute_param_changed (param);
 }
 
 /**
@@ -2352,8 +2674,9 @@ e_vcard_attribute_remove_param_value (EVCardAttribute *attr,
 				return;
 			}
 
-			param->values = g_list_delete_link (param->values, l);
 			g_free (l->data);
+			param->values = g_list_delete_link (param->values, l);
+			attribute_changed (attr);
 
 			if (param->values == NULL) {
 				e_vcard_attribute_param_free (param);
@@ -2501,7 +2824,9 @@ e_vcard_attribute_get_name (EVCardAttribute *attr)
  * @attr: an #EVCardAttribute
  *
  * Gets the ordered list of values from @attr. The list and its
- * contents are owned by @attr, and must not be freed.
+ * contents are owned by @attr, and must not be freed or modified; use
+ * e_vcard_attribute_remove_values() and e_vcard_attribute_add_value()
+ * to change them.
  *
  * For example, for an <code>ADR</code> (postal address) attribute, this will
  * return the components of the postal address.
@@ -2511,6 +2836,10 @@ e_vcard_attribute_get_name (EVCardAttribute *attr)
  * one-element list in that case. Alternatively, use
  * e_vcard_attribute_get_value() in such cases.
  *
+ * The values of an attribute parsed from a vCard string are decoded the
+ * first time they are asked for. Like any other read, this may be done
+ * from several threads at once.
+ *
  * Returns: (transfer none) (element-type utf8): A list of string values. They
  * will all be non-%NULL, but may be empty strings. The list itself may be
  * empty.
@@ -2520,7 +2849,7 @@ e_vcard_attribute_get_values (EVCardAttribute *attr)
 {
 	g_return_val_if_fail (attr != NULL, NULL);
 
-	return attr->values;
+	return attribute_ensure_values (attr);
 }
 
 /**
@@ -2544,6 +2873,8 @@ e_vcard_attribute_get_values_decoded (EVCardAttribute *attr)
 {
 	g_return_val_if_fail (attr != NULL, NULL);
 
+	attribute_ensure_values (attr);
+
 	if (!attr->decoded_values) {
 		GList *l;
 		switch (attr->encoding) {
@@ -2592,6 +2923,8 @@ e_vcard_attribute_is_single_valued (EVCardAttribute *attr)
 {
 	g_return_val_if_fail (attr != NULL, FALSE);
 
+	attribute_ensure_values (attr);
+
 	if (attr->values == NULL
 	    || attr->values->next != NULL)
 		return FALSE;
@@ -2622,7 +2955,7 @@ e_vcard_attribute_get_value (EVCardAttribute *attr)
 
 	g_return_val_if_fail (attr != NULL, NULL);
 
-	values = e_vcard_attribute_get_values (attr);
+	values = attribute_ensure_values (attr);
 
 	if (!e_vcard_attribute_is_single_valued (attr))
 		g_warning ("e_vcard_attribute_get_value called on multivalued attribute");
@@ -2703,10 +3036,9 @@ e_vcard_attribute_has_type (EVCardAttribute *attr,
 		EVCardAttributeParam *param = p->data;
 
 		if (!g_ascii_strcasecmp (e_vcard_attribute_param_get_name (param), EVC_TYPE)) {
-			GList *values = e_vcard_attribute_param_get_values (param);
 			GList *v;
 
-			for (v = values; v; v = v->next) {
+			for (v = param->values; v; v = v->next) {
 				if (!g_ascii_strcasecmp ((gchar *) v->data, typestr))
 					return TRUE;
 			}
@@ -2814,7 +3146,7 @@ e_vcard_attribute_param_get_name (EVCardAttributeParam *param)
  * @param: an #EVCardAttributeParam
  *
  * Gets the list of values from @param. The list and its
- * contents are owned by @param, and must not be freed.
+ * contents are owned by @param, and must not be freed or modified.
  *
  * For example, for the <code>TYPE</code> parameter of the vCard attribute:
  * |[
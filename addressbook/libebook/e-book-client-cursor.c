@@ -0,0 +1,374 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * SECTION: e-book-client-cursor
+ * @include: libebook/libebook.h
+ * @short_description: Paging through the sorted contacts of an address book
+ *
+ * An #EBookClientCursor traverses the contacts of an address book in a
+ * stable sort order, a page at a time, so that even very large address
+ * books can be browsed without loading all of their contacts in memory.
+ * Cursors are created with e_book_client_get_cursor_sync().
+ *
+ * Cursors are currently only available for address books opened in
+ * direct read access mode, see e_book_client_connect_direct_sync().
+ **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <libedata-book/libedata-book.h>
+
+#include "e-book-client.h"
+#include "e-book-client-cursor.h"
+
+#define E_BOOK_CLIENT_CURSOR_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), E_TYPE_BOOK_CLIENT_CURSOR, EBookClientCursorPrivate))
+
+struct _EBookClientCursorPrivate {
+	EBookClient *client;
+	EDataBookCursor *direct_cursor;
+};
+
+enum {
+	PROP_0,
+	PROP_CLIENT,
+	PROP_DIRECT_CURSOR
+};
+
+G_DEFINE_TYPE (
+	EBookClientCursor,
+	e_book_client_cursor,
+	G_TYPE_OBJECT)
+
+static void
+book_client_cursor_set_client (EBookClientCursor *cursor,
+                               EBookClient *client)
+{
+	g_return_if_fail (E_IS_BOOK_CLIENT (client));
+	g_return_if_fail (cursor->priv->client == NULL);
+
+	cursor->priv->client = g_object_ref (client);
+}
+
+static void
+book_client_cursor_set_direct_cursor (EBookClientCursor *cursor,
+                                      EDataBookCursor *direct_cursor)
+{
+	g_return_if_fail (E_IS_DATA_BOOK_CURSOR (direct_cursor));
+	g_return_if_fail (cursor->priv->direct_cursor == NULL);
+
+	cursor->priv->direct_cursor = g_object_ref (direct_cursor);
+}
+
+static void
+book_client_cursor_set_property (GObject *object,
+                                 guint property_id,
+                                 const GValue *value,
+                                 GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_CLIENT:
+			book_client_cursor_set_client (
+				E_BOOK_CLIENT_CURSOR (object),
+				g_value_get_object (value));
+			return;
+
+		case PROP_DIRECT_CURSOR:
+			book_client_cursor_set_direct_cursor (
+				E_BOOK_CLIENT_CURSOR (object),
+				g_value_get_object (value));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+book_client_cursor_get_property (GObject *object,
+                                 guint property_id,
+                                 GValue *value,
+                                 GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_CLIENT:
+			g_value_take_object (
+				value,
+				e_book_client_cursor_ref_client (
+				E_BOOK_CLIENT_CURSOR (object)));
+			return;
+
+		case PROP_DIRECT_CURSOR:
+			g_value_set_object (
+				value,
+				E_BOOK_CLIENT_CURSOR (object)->priv->direct_cursor);
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+book_client_cursor_dispose (GObject *object)
+{
+	EBookClientCursorPrivate *priv;
+
+	priv = E_BOOK_CLIENT_CURSOR_GET_PRIVATE (object);
+
+	g_clear_object (&priv->direct_cursor);
+	g_clear_object (&priv->client);
+
+	/* Chain up to parent's dispose() method. */
+	G_OBJECT_CLASS (e_book_client_cursor_parent_class)->dispose (object);
+}
+
+static void
+e_book_client_cursor_class_init (EBookClientCursorClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (EBookClientCursorPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->set_property = book_client_cursor_set_property;
+	object_class->get_property = book_client_cursor_get_property;
+	object_class->dispose = book_client_cursor_dispose;
+
+	g_object_class_install_property (
+		object_class,
+		PROP_CLIENT,
+		g_param_spec_object (
+			"client",
+			"Client",
+			"The EBookClient for the cursor",
+			E_TYPE_BOOK_CLIENT,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT_ONLY |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_DIRECT_CURSOR,
+		g_param_spec_object (
+			"direct-cursor",
+			"Direct Cursor",
+			"The EDataBookCursor for direct read access",
+			E_TYPE_DATA_BOOK_CURSOR,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT_ONLY |
+			G_PARAM_STATIC_STRINGS));
+}
+
+static void
+e_book_client_cursor_init (EBookClientCursor *cursor)
+{
+	cursor->priv = E_BOOK_CLIENT_CURSOR_GET_PRIVATE (cursor);
+}
+
+/**
+ * e_book_client_cursor_ref_client:
+ * @cursor: an #EBookClientCursor
+ *
+ * Returns the #EBookClient for @cursor.
+ *
+ * The returned #EBookClient is referenced for thread-safety.
+ * Unreference the #EBookClient with g_object_unref() when finished with it.
+ *
+ * Returns: (transfer full): an #EBookClient
+ *
+ * Since: 3.12
+ **/
+EBookClient *
+e_book_client_cursor_ref_client (EBookClientCursor *cursor)
+{
+	g_return_val_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor), NULL);
+
+	return g_object_ref (cursor->priv->client);
+}
+
+/**
+ * e_book_client_cursor_set_sexp_sync:
+ * @cursor: an #EBookClientCursor
+ * @sexp: (allow-none): an S-expression filtering the contacts, or %NULL
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Changes the query which filters the contacts traversed by @cursor.
+ * Only queries on the fields of the address book summary are supported.
+ * The position of @cursor is preserved.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_client_cursor_set_sexp_sync (EBookClientCursor *cursor,
+                                    const gchar *sexp,
+                                    GCancellable *cancellable,
+                                    GError **error)
+{
+	g_return_val_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor), FALSE);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	return e_data_book_cursor_set_sexp (
+		cursor->priv->direct_cursor, sexp, error);
+}
+
+/**
+ * e_book_client_cursor_step_sync:
+ * @cursor: an #EBookClientCursor
+ * @flags: the #EBookCursorStepFlags for this step
+ * @origin: the #EBookCursorOrigin from whence to step
+ * @count: a positive or negative amount of contacts to traverse
+ * @out_contacts: (out) (allow-none) (element-type EContact) (transfer full):
+ *   return location for the traversed #EContact<!-- -->s, if
+ *   %E_BOOK_CURSOR_STEP_FETCH is specified in @flags
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Traverses up to @count contacts from @origin, forward through the
+ * sort order for a positive @count and backward for a negative one.
+ *
+ * With %E_BOOK_CURSOR_STEP_FETCH, the traversed contacts are returned in
+ * @out_contacts in traversal order. Free the list with g_slist_free_full()
+ * and g_object_unref(). With %E_BOOK_CURSOR_STEP_MOVE, @cursor is left on
+ * the last traversed contact, or at the end (or beginning) of the address
+ * book when fewer than @count contacts were left.
+ *
+ * Returns: the number of contacts traversed, or -1 on failure
+ *
+ * Since: 3.12
+ **/
+gint
+e_book_client_cursor_step_sync (EBookClientCursor *cursor,
+                                EBookCursorStepFlags flags,
+                                EBookCursorOrigin origin,
+                                gint count,
+                                GSList **out_contacts,
+                                GCancellable *cancellable,
+                                GError **error)
+{
+	GSList *vcards = NULL, *link;
+	gint n_traversed;
+
+	g_return_val_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor), -1);
+	g_return_val_if_fail ((flags & E_BOOK_CURSOR_STEP_FETCH) == 0 ||
+			      out_contacts != NULL, -1);
+
+	n_traversed = e_data_book_cursor_step (
+		cursor->priv->direct_cursor, flags, origin, count,
+		(flags & E_BOOK_CURSOR_STEP_FETCH) != 0 ? &vcards : NULL,
+		cancellable, error);
+
+	if (n_traversed < 0)
+		return -1;
+
+	/* Parse the vCards in place, keeping the list order */
+	for (link = vcards; link != NULL; link = g_slist_next (link)) {
+		gchar *vcard = link->data;
+
+		link->data = e_contact_new_from_vcard (vcard);
+		g_free (vcard);
+	}
+
+	if (out_contacts != NULL)
+		*out_contacts = vcards;
+	else
+		g_slist_free_full (vcards, (GDestroyNotify) g_object_unref);
+
+	return n_traversed;
+}
+
+/**
+ * e_book_client_cursor_set_alphabetic_index:
+ * @cursor: an #EBookClientCursor
+ * @index: the index into the labels returned by e_book_client_cursor_get_alphabet()
+ *
+ * Positions @cursor right before the contacts whose primary sort key
+ * starts with the label at @index, so that the next step forward
+ * traverses them first.
+ *
+ * Since: 3.12
+ **/
+void
+e_book_client_cursor_set_alphabetic_index (EBookClientCursor *cursor,
+                                           gint index)
+{
+	g_return_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor));
+
+	e_data_book_cursor_set_alphabetic_index (
+		cursor->priv->direct_cursor, index);
+}
+
+/**
+ * e_book_client_cursor_get_position_sync:
+ * @cursor: an #EBookClientCursor
+ * @out_total: (out) (allow-none): return location for the number of matching contacts
+ * @out_position: (out) (allow-none): return location for the position of @cursor
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Calculates how many contacts match the query of @cursor and where
+ * @cursor is in them. The position is 0 at the beginning, @out_total + 1
+ * at the end, and otherwise the number of contacts up to and including
+ * the current one, which is suitable for placing a scroll bar.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_client_cursor_get_position_sync (EBookClientCursor *cursor,
+                                        gint *out_total,
+                                        gint *out_position,
+                                        GCancellable *cancellable,
+                                        GError **error)
+{
+	g_return_val_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor), FALSE);
+
+	return e_data_book_cursor_get_position (
+		cursor->priv->direct_cursor,
+		out_total, out_position,
+		cancellable, error);
+}
+
+/**
+ * e_book_client_cursor_get_alphabet:
+ * @cursor: an #EBookClientCursor
+ * @n_labels: (out): return location for the number of labels
+ *
+ * Fetches the labels of the alphabetic indexes usable with
+ * e_book_client_cursor_set_alphabetic_index(), in the sort order
+ * of the current locale.
+ *
+ * Returns: (array length=n_labels) (transfer none): the alphabet labels
+ *
+ * Since: 3.12
+ **/
+const gchar * const *
+e_book_client_cursor_get_alphabet (EBookClientCursor *cursor,
+                                   gint *n_labels)
+{
+	g_return_val_if_fail (E_IS_BOOK_CLIENT_CURSOR (cursor), NULL);
+
+	return e_data_book_cursor_get_alphabet (
+		cursor->priv->direct_cursor, n_labels);
+}
@@ -0,0 +1,102 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#if !defined (__LIBEBOOK_H_INSIDE__) && !defined (LIBEBOOK_COMPILATION)
+#error "Only <libebook/libebook.h> should be included directly."
+#endif
+
+#ifndef E_BOOK_CLIENT_CURSOR_H
+#define E_BOOK_CLIENT_CURSOR_H
+
+#include <gio/gio.h>
+#include <libebook-contacts/libebook-contacts.h>
+
+/* Standard GObject macros */
+#define E_TYPE_BOOK_CLIENT_CURSOR \
+	(e_book_client_cursor_get_type ())
+#define E_BOOK_CLIENT_CURSOR(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), E_TYPE_BOOK_CLIENT_CURSOR, EBookClientCursor))
+#define E_BOOK_CLIENT_CURSOR_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), E_TYPE_BOOK_CLIENT_CURSOR, EBookClientCursorClass))
+#define E_IS_BOOK_CLIENT_CURSOR(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), E_TYPE_BOOK_CLIENT_CURSOR))
+#define E_IS_BOOK_CLIENT_CURSOR_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), E_TYPE_BOOK_CLIENT_CURSOR))
+#define E_BOOK_CLIENT_CURSOR_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), E_TYPE_BOOK_CLIENT_CURSOR, EBookClientCursorClass))
+
+G_BEGIN_DECLS
+
+typedef struct _EBookClientCursor EBookClientCursor;
+typedef struct _EBookClientCursorClass EBookClientCursorClass;
+typedef struct _EBookClientCursorPrivate EBookClientCursorPrivate;
+
+struct _EBookClient;
+
+/**
+ * EBookClientCursor:
+ *
+ * Contains only private data the should be read and manipulated using the
+ * functions below.
+ *
+ * Since: 3.12
+ **/
+struct _EBookClientCursor {
+	GObject parent;
+	EBookClientCursorPrivate *priv;
+};
+
+struct _EBookClientCursorClass {
+	GObjectClass parent_class;
+};
+
+GType		e_book_client_cursor_get_type	(void) G_GNUC_CONST;
+struct _EBookClient *
+		e_book_client_cursor_ref_client	(EBookClientCursor *cursor);
+gboolean	e_book_client_cursor_set_sexp_sync
+						(EBookClientCursor *cursor,
+						 const gchar *sexp,
+						 GCancellable *cancellable,
+						 GError **error);
+gint		e_book_client_cursor_step_sync	(EBookClientCursor *cursor,
+						 EBookCursorStepFlags flags,
+						 EBookCursorOrigin origin,
+						 gint count,
+						 GSList **out_contacts,
+						 GCancellable *cancellable,
+						 GError **error);
+void		e_book_client_cursor_set_alphabetic_index
+						(EBookClientCursor *cursor,
+						 gint index);
+gboolean	e_book_client_cursor_get_position_sync
+						(EBookClientCursor *cursor,
+						 gint *out_total,
+						 gint *out_position,
+						 GCancellable *cancellable,
+						 GError **error);
+const gchar * const *
+		e_book_client_cursor_get_alphabet
+						(EBookClientCursor *cursor,
+						 gint *n_labels);
+
+G_END_DECLS
+
+#endif /* E_BOOK_CLIENT_CURSOR_H */
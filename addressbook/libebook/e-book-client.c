@@ -3466,3 +3466,81 @@ e_book_client_get_view_sync (EBookClient *client,
 	return success;
 }
 
+/**
+ * e_book_client_get_cursor_sync:
+ * @client: an #EBookClient
+ * @sexp: (allow-none): an S-expression filtering the contacts, or %NULL
+ * @sort_fields: (array length=n_fields): the #EContactField<!-- -->s to sort by
+ * @sort_types: (array length=n_fields): the #EBookCursorSortType of each field
+ * @n_fields: the number of fields to sort by
+ * @out_cursor: (out): return location for an #EBookClientCursor
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Creates an #EBookClientCursor which pages through the contacts of
+ * @client matching @sexp, sorted by @sort_fields. The sort fields must
+ * be string fields of the address book summary, and @sexp must only
+ * query summary fields.
+ *
+ * Cursors are only supported for clients created with
+ * e_book_client_connect_direct_sync() whose backend supports them,
+ * otherwise an %E_CLIENT_ERROR_NOT_SUPPORTED error is set.
+ *
+ * If successful, the @out_cursor is set to a newly allocated
+ * #EBookClientCursor, which should be freed with g_object_unref().
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_client_get_cursor_sync (EBookClient *client,
+                               const gchar *sexp,
+                               const EContactField *sort_fields,
+                               const EBookCursorSortType *sort_types,
+                               guint n_fields,
+                               EBookClientCursor **out_cursor,
+                               GCancellable *cancellable,
+                               GError **error)
+{
+	EDataBookCursor *direct_cursor;
+
+	g_return_val_if_fail (E_IS_BOOK_CLIENT (client), FALSE);
+	g_return_val_if_fail (sort_fields != NULL, FALSE);
+	g_return_val_if_fail (sort_types != NULL, FALSE);
+	g_return_val_if_fail (n_fields > 0, FALSE);
+	g_return_val_if_fail (out_cursor != NULL, FALSE);
+
+	if (client->priv->direct_backend == NULL) {
+		g_set_error_literal (
+			error, E_CLIENT_ERROR,
+			E_CLIENT_ERROR_NOT_SUPPORTED,
+			_("Cursors are only supported in direct read access mode"));
+		return FALSE;
+	}
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	direct_cursor = e_book_backend_create_cursor (
+		client->priv->direct_backend,
+		sort_fields, sort_types, n_fields, error);
+
+	if (direct_cursor == NULL)
+		return FALSE;
+
+	if (!e_data_book_cursor_set_sexp (direct_cursor, sexp, error)) {
+		g_object_unref (direct_cursor);
+		return FALSE;
+	}
+
+	*out_cursor = g_object_new (
+		E_TYPE_BOOK_CLIENT_CURSOR,
+		"client", client,
+		"direct-cursor", direct_cursor, NULL);
+
+	g_object_unref (direct_cursor);
+
+	return TRUE;
+}
+
@@ -30,6 +30,7 @@
 #include <libedataserver/libedataserver.h>
 
 #include <libebook/e-book-client-view.h>
+#include <libebook/e-book-client-cursor.h>
 #include <libebook-contacts/libebook-contacts.h>
 
 /* Standard GObject macros */
@@ -276,6 +277,14 @@ gboolean	e_book_client_get_view_sync	(EBookClient *client,
 						 EBookClientView **out_view,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	e_book_client_get_cursor_sync	(EBookClient *client,
+						 const gchar *sexp,
+						 const EContactField *sort_fields,
+						 const EBookCursorSortType *sort_types,
+						 guint n_fields,
+						 EBookClientCursor **out_cursor,
+						 GCancellable *cancellable,
+						 GError **error);
 
 #ifndef EDS_DISABLE_DEPRECATED
 /**
@@ -24,6 +24,7 @@
 #include <libedataserver/libedataserver.h>
 #include <libebook-contacts/libebook-contacts.h>
 
+#include <libebook/e-book-client-cursor.h>
 #include <libebook/e-book-client-view.h>
 #include <libebook/e-book-client.h>
 #include <libebook/e-book-enumtypes.h>
@@ -36,7 +36,8 @@
 G_DEFINE_TYPE (EBookBackendSExp, e_book_backend_sexp, G_TYPE_OBJECT)
 
 typedef struct _SearchContext SearchContext;
-typedef gboolean (*CompareFunc) (const gchar *, const gchar *, const gchar *);
+typedef struct _CachedString CachedString;
+typedef gboolean (*CompareFunc) (SearchContext *, const gchar *, const gchar *, const gchar *);
 
 struct _EBookBackendSExpPrivate {
 	ESExp *search_sexp;
@@ -46,194 +47,294 @@ struct _EBookBackendSExpPrivate {
 
 struct _SearchContext {
 	EContact *contact;
+
+	/* Forms of the strings compared by the helpers, so that every
+	 * value is normalized only once, however many predicates look
+	 * at it. Query strings live as long as the expression, field
+	 * values only while matching one contact. */
+	GHashTable *query_strings;
+	GHashTable *field_strings;
 };
 
+struct _CachedString {
+	gchar *unaccented;	/* e_util_utf8_remove_accents() */
+	gchar *normal;		/* e_util_utf8_normalize() */
+	gchar *collate_key;	/* of the case-folded unaccented string */
+
+	/* for query strings only */
+	GSList *words;		/* see contains_helper() */
+	GRegex *regex;
+	gboolean regex_failed;
+};
+
+static void
+cached_string_free (CachedString *cached)
+{
+	g_free (cached->unaccented);
+	g_free (cached->normal);
+	g_free (cached->collate_key);
+	g_slist_free_full (cached->words, (GDestroyNotify) g_free);
+	if (cached->regex)
+		g_regex_unref (cached->regex);
+
+	g_slice_free (CachedString, cached);
+}
+
+static CachedString *
+cached_string_lookup (GHashTable *cache,
+                      const gchar *str)
+{
+	CachedString *cached;
+
+	cached = g_hash_table_lookup (cache, str);
+	if (cached == NULL) {
+		cached = g_slice_new0 (CachedString);
+		g_hash_table_insert (cache, g_strdup (str), cached);
+	}
+
+	return cached;
+}
+
+static const gchar *
+get_unaccented (GHashTable *cache,
+                const gchar *str)
+{
+	CachedString *cached = cached_string_lookup (cache, str);
+
+	if (cached->unaccented == NULL)
+		cached->unaccented = e_util_utf8_remove_accents (str);
+
+	return cached->unaccented;
+}
+
+static const gchar *
+get_normal (GHashTable *cache,
+            const gchar *str)
+{
+	CachedString *cached = cached_string_lookup (cache, str);
+
+	if (cached->normal == NULL)
+		cached->normal = e_util_utf8_normalize (str);
+
+	return cached->normal;
+}
+
+/* Equal keys are what e_util_utf8_strcasecmp() considers equal */
+static const gchar *
+get_collate_key (GHashTable *cache,
+                 const gchar *str)
+{
+	CachedString *cached = cached_string_lookup (cache, str);
+
+	if (cached->collate_key == NULL) {
+		gchar *folded;
+
+		folded = g_utf8_casefold (get_unaccented (cache, str), -1);
+		cached->collate_key = g_utf8_collate_key (folded, -1);
+		g_free (folded);
+	}
+
+	return cached->collate_key;
+}
+
+/* Compares the first value of each @attr_name attribute, or all
+ * values of the first one with @all_values, stripped of surrounding
+ * white space like the EContact getters do, without copying them */
 static gboolean
-compare_im (EContact *contact,
-            const gchar *str,
-            const gchar *region,
-            CompareFunc compare,
-            EContactField im_field)
+compare_attribute_values (SearchContext *ctx,
+                          const gchar *attr_name,
+                          gboolean all_values,
+                          const gchar *str,
+                          const gchar *region,
+                          CompareFunc compare)
 {
-	GList    *aims, *l;
-	gboolean  found_it = FALSE;
+	GList *attrs, *a;
 
-	aims = e_contact_get (contact, im_field);
+	attrs = e_vcard_get_attributes (E_VCARD (ctx->contact));
 
-	for (l = aims; l != NULL; l = l->next) {
-		gchar *im = (gchar *) l->data;
+	for (a = attrs; a; a = a->next) {
+		EVCardAttribute *attr = a->data;
+		GList *v;
 
-		if (im && compare (im, str, region)) {
-			found_it = TRUE;
-			break;
+		if (g_ascii_strcasecmp (e_vcard_attribute_get_name (attr), attr_name) != 0)
+			continue;
+
+		for (v = e_vcard_attribute_get_values (attr); v; v = v->next) {
+			const gchar *value = v->data;
+			gsize len;
+			gboolean rv;
+
+			if (value == NULL)
+				continue;
+
+			len = strlen (value);
+			if (len > 0 && (g_ascii_isspace (value[0]) ||
+			    g_ascii_isspace (value[len - 1]))) {
+				gchar *stripped = g_strstrip (g_strdup (value));
+
+				rv = compare (ctx, stripped, str, region);
+				g_free (stripped);
+			} else {
+				rv = compare (ctx, value, str, region);
+			}
+
+			if (rv)
+				return TRUE;
+
+			if (!all_values)
+				break;
 		}
+
+		if (all_values)
+			break;
 	}
 
-	e_contact_attr_list_free (aims);
+	return FALSE;
+}
 
-	return found_it;
+static gboolean
+compare_im (SearchContext *ctx,
+            const gchar *str,
+            const gchar *region,
+            CompareFunc compare,
+            EContactField im_field)
+{
+	return compare_attribute_values (
+		ctx, e_contact_vcard_attribute (im_field),
+		FALSE, str, region, compare);
 }
 
 static gboolean
-compare_im_aim (EContact *contact,
+compare_im_aim (SearchContext *ctx,
                 const gchar *str,
                 const gchar *region,
                 CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_AIM);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_AIM);
 }
 
 static gboolean
-compare_im_msn (EContact *contact,
+compare_im_msn (SearchContext *ctx,
                 const gchar *str,
                 const gchar *region,
                 CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_MSN);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_MSN);
 }
 
 static gboolean
-compare_im_skype (EContact *contact,
+compare_im_skype (SearchContext *ctx,
                   const gchar *str,
                   const gchar *region,
                   CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_SKYPE);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_SKYPE);
 }
 
 static gboolean
-compare_im_google_talk (EContact *contact,
+compare_im_google_talk (SearchContext *ctx,
                         const gchar *str,
                         const gchar *region,
                         CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_GOOGLE_TALK);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_GOOGLE_TALK);
 }
 
 static gboolean
-compare_im_icq (EContact *contact,
+compare_im_icq (SearchContext *ctx,
                 const gchar *str,
                 const gchar *region,
                 CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_ICQ);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_ICQ);
 }
 
 static gboolean
-compare_im_yahoo (EContact *contact,
+compare_im_yahoo (SearchContext *ctx,
                   const gchar *str,
                   const gchar *region,
                   CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_YAHOO);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_YAHOO);
 }
 
 static gboolean
-compare_im_gadugadu (EContact *contact,
+compare_im_gadugadu (SearchContext *ctx,
                      const gchar *str,
                      const gchar *region,
                      CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_GADUGADU);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_GADUGADU);
 }
 
 static gboolean
-compare_im_jabber (EContact *contact,
+compare_im_jabber (SearchContext *ctx,
                    const gchar *str,
                    const gchar *region,
                    CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_JABBER);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_JABBER);
 }
 
 static gboolean
-compare_im_groupwise (EContact *contact,
+compare_im_groupwise (SearchContext *ctx,
                       const gchar *str,
                       const gchar *region,
                       CompareFunc compare)
 {
-	return compare_im (contact, str, region, compare, E_CONTACT_IM_GROUPWISE);
+	return compare_im (ctx, str, region, compare, E_CONTACT_IM_GROUPWISE);
 }
 
 static gboolean
-compare_email (EContact *contact,
+compare_email (SearchContext *ctx,
                const gchar *str,
                const gchar *region,
                CompareFunc compare)
 {
-	gboolean rv = FALSE;
-	GList *list, *l;
-
-	list = e_contact_get (contact, E_CONTACT_EMAIL);
-
-	for (l = list; l; l = l->next) {
-		const gchar *email = l->data;
-
-		rv = email && compare (email, str, region);
-
-		if (rv)
-			break;
-	}
-
-	e_contact_attr_list_free (list);
-
-	return rv;
+	return compare_attribute_values (
+		ctx, EVC_EMAIL, FALSE, str, region, compare);
 }
 
 static gboolean
-compare_phone (EContact *contact,
+compare_phone (SearchContext *ctx,
                const gchar *str,
                const gchar *region,
                CompareFunc compare)
 {
-	GList *list, *l;
-	gboolean rv = FALSE;
-
-	list = e_contact_get (contact, E_CONTACT_TEL);
-
-	for (l = list; l; l = l->next) {
-		const gchar *phone = l->data;
-
-		rv = phone && compare (phone, str, region);
-
-		if (rv)
-			break;
-	}
-
-	e_contact_attr_list_free (list);
-
-	return rv;
+	return compare_attribute_values (
+		ctx, EVC_TEL, FALSE, str, region, compare);
 }
 
 static gboolean
-compare_name (EContact *contact,
+compare_name (SearchContext *ctx,
               const gchar *str,
               const gchar *region,
               CompareFunc compare)
 {
+	EContact *contact = ctx->contact;
 	const gchar *name;
 
 	name = e_contact_get_const (contact, E_CONTACT_FULL_NAME);
-	if (name && compare (name, str, region))
+	if (name && compare (ctx, name, str, region))
 		return TRUE;
 
 	name = e_contact_get_const (contact, E_CONTACT_FAMILY_NAME);
-	if (name && compare (name, str, region))
+	if (name && compare (ctx, name, str, region))
 		return TRUE;
 
 	name = e_contact_get_const (contact, E_CONTACT_GIVEN_NAME);
-	if (name && compare (name, str, region))
+	if (name && compare (ctx, name, str, region))
 		return TRUE;
 
 	name = e_contact_get_const (contact, E_CONTACT_NICKNAME);
-	if (name && compare (name, str, region))
+	if (name && compare (ctx, name, str, region))
 		return TRUE;
 
 	return FALSE;
 }
 
 static gboolean
-compare_photo_uri (EContact *contact,
+compare_photo_uri (SearchContext *ctx,
                    const gchar *str,
                    const gchar *region,
                    CompareFunc compare)
@@ -241,12 +342,12 @@ compare_photo_uri (EContact *contact,
 	EContactPhoto *photo;
 	gboolean ret_val = FALSE;
 
-	photo = e_contact_get (contact, E_CONTACT_PHOTO);
+	photo = e_contact_get (ctx->contact, E_CONTACT_PHOTO);
 
 	if (photo) {
 		/* Compare the photo uri with the string */
 		if ((photo->type == E_CONTACT_PHOTO_TYPE_URI)
-		     && compare (photo->data.uri, str, region)) {
+		     && compare (ctx, photo->data.uri, str, region)) {
 			ret_val = TRUE;
 		}
 		e_contact_photo_free (photo);
@@ -255,7 +356,7 @@ compare_photo_uri (EContact *contact,
 }
 
 static gboolean
-compare_address (EContact *contact,
+compare_address (SearchContext *ctx,
                  const gchar *str,
                  const gchar *region,
                  CompareFunc compare)
@@ -265,15 +366,15 @@ compare_address (EContact *contact,
 	gboolean rv = FALSE;
 
 	for (i = E_CONTACT_FIRST_ADDRESS_ID; i <= E_CONTACT_LAST_ADDRESS_ID; i++) {
-		EContactAddress *address = e_contact_get (contact, i);
+		EContactAddress *address = e_contact_get (ctx->contact, i);
 		if (address) {
-			rv = (address->po && compare (address->po, str, region)) ||
-				(address->street && compare (address->street, str, region)) ||
-				(address->ext && compare (address->ext, str, region)) ||
-				(address->locality && compare (address->locality, str, region)) ||
-				(address->region && compare (address->region, str, region)) ||
-				(address->code && compare (address->code, str, region)) ||
-				(address->country && compare (address->country, str, region));
+			rv = (address->po && compare (ctx, address->po, str, region)) ||
+				(address->street && compare (ctx, address->street, str, region)) ||
+				(address->ext && compare (ctx, address->ext, str, region)) ||
+				(address->locality && compare (ctx, address->locality, str, region)) ||
+				(address->region && compare (ctx, address->region, str, region)) ||
+				(address->code && compare (ctx, address->code, str, region)) ||
+				(address->country && compare (ctx, address->country, str, region));
 
 			e_contact_address_free (address);
 
@@ -287,34 +388,18 @@ compare_address (EContact *contact,
 }
 
 static gboolean
-compare_category (EContact *contact,
+compare_category (SearchContext *ctx,
                   const gchar *str,
                   const gchar *region,
                   CompareFunc compare)
 {
-	GList *categories;
-	GList *iterator;
-	gboolean ret_val = FALSE;
-
-	categories = e_contact_get (contact, E_CONTACT_CATEGORY_LIST);
-
-	for (iterator = categories; iterator; iterator = iterator->next) {
-		const gchar *category = iterator->data;
-
-		if (compare (category, str, region)) {
-			ret_val = TRUE;
-			break;
-		}
-	}
-
-	g_list_foreach (categories, (GFunc) g_free, NULL);
-	g_list_free (categories);
-
-	return ret_val;
+	return compare_attribute_values (
+		ctx, EVC_CATEGORIES, TRUE, str, region, compare);
 }
 
 static gboolean
-compare_date (EContactDate *date,
+compare_date (SearchContext *ctx,
+              EContactDate *date,
               const gchar *str,
               const gchar *region,
               CompareFunc compare)
@@ -323,7 +408,7 @@ compare_date (EContactDate *date,
 	gboolean ret_val = FALSE;
 
 	if (date_str) {
-		if (compare (date_str, str, region)) {
+		if (compare (ctx, date_str, str, region)) {
 			ret_val = TRUE;
 		}
 		g_free (date_str);
@@ -341,7 +426,7 @@ static struct prop_info {
 	EContactField field_id;
 	const gchar *query_prop;
 	enum prop_type prop_type;
-	gboolean (*list_compare) (EContact *contact,
+	gboolean (*list_compare) (SearchContext *ctx,
 				  const gchar *str,
 				  const gchar *region,
 				  CompareFunc compare);
@@ -442,16 +527,16 @@ entry_compare (SearchContext *ctx,
 
 					prop = e_contact_get_const (ctx->contact, info->field_id);
 
-					if (prop && compare (prop, argv[1]->value.string, region)) {
+					if (prop && compare (ctx, prop, argv[1]->value.string, region)) {
 						truth = TRUE;
 					}
-					if ((!prop) && compare ("", argv[1]->value.string, region)) {
+					if ((!prop) && compare (ctx, "", argv[1]->value.string, region)) {
 						truth = TRUE;
 					}
 				}
 				else if (info->prop_type == PROP_TYPE_LIST) {
 					/* the special searches that match any of the list elements */
-					truth = info->list_compare (ctx->contact, argv[1]->value.string, region, compare);
+					truth = info->list_compare (ctx, argv[1]->value.string, region, compare);
 				}
 				else if (info->prop_type == PROP_TYPE_DATE) {
 					/* the special searches that match dates */
@@ -460,7 +545,7 @@ entry_compare (SearchContext *ctx,
 					date = e_contact_get (ctx->contact, info->field_id);
 
 					if (date) {
-						truth = compare_date (date, argv[1]->value.string, region, compare);
+						truth = compare_date (ctx, date, argv[1]->value.string, region, compare);
 						e_contact_date_free (date);
 					}
 				} else {
@@ -488,11 +573,11 @@ entry_compare (SearchContext *ctx,
 			if (fid >= E_CONTACT_FIELD_FIRST && fid < E_CONTACT_FIELD_LAST) {
 				const gchar *prop = e_contact_get_const (ctx->contact, fid);
 
-				if (prop && compare (prop, argv[1]->value.string, region)) {
+				if (prop && compare (ctx, prop, argv[1]->value.string, region)) {
 					truth = TRUE;
 				}
 
-				if ((!prop) && compare ("", argv[1]->value.string, region)) {
+				if ((!prop) && compare (ctx, "", argv[1]->value.string, region)) {
 					truth = TRUE;
 				}
 			} else {
@@ -507,9 +592,9 @@ entry_compare (SearchContext *ctx,
 						for (l = values; l && !truth; l = l->next) {
 							const gchar *value = l->data;
 
-							if (value && compare (value, argv[1]->value.string, region)) {
+							if (value && compare (ctx, value, argv[1]->value.string, region)) {
 								truth = TRUE;
-							} else if ((!value) && compare ("", argv[1]->value.string, region)) {
+							} else if ((!value) && compare (ctx, "", argv[1]->value.string, region)) {
 								truth = TRUE;
 							}
 						}
@@ -525,22 +610,13 @@ entry_compare (SearchContext *ctx,
 	return r;
 }
 
-static void
-contains_helper_free_word (gpointer data,
-                           gpointer user_data)
-{
-	if (data) {
-		g_string_free ((GString *) data, TRUE);
-	}
-}
-
 static gboolean
 try_contains_word (const gchar *s1,
                    GSList *word)
 {
 	const gchar *o, *p;
 	gunichar unival, first_w_char;
-	GString *w;
+	const gchar *w;
 
 	if (s1 == NULL)
 		return FALSE;
@@ -550,14 +626,14 @@ try_contains_word (const gchar *s1,
 		return FALSE; /* illegal structure */
 
 	w = word->data;
-	first_w_char = g_utf8_get_char (w->str);
+	first_w_char = g_utf8_get_char (w);
 
 	o = s1;
 	for (p = e_util_unicode_get_utf8 (o, &unival); p && unival; p = e_util_unicode_get_utf8 (p, &unival)) {
 		if (unival == first_w_char) {
 			gunichar unival2;
 			const gchar *q = p;
-			const gchar *r = e_util_unicode_get_utf8 (w->str, &unival2);
+			const gchar *r = e_util_unicode_get_utf8 (w, &unival2);
 			while (q && r && unival && unival2) {
 				q = e_util_unicode_get_utf8 (q, &unival);
 				if (!q)
@@ -583,55 +659,18 @@ try_contains_word (const gchar *s1,
 }
 
 /* first space between words is treated as wildcard character;
- * we are looking for s2 in s1, so s2 will be breaked into words
+ * breaks the normalized query string @s2uni into the words to look for
 */
-static gboolean
-contains_helper (const gchar *s1,
-                 const gchar *s2,
-                 const gchar *region)
+static GSList *
+contains_helper_split_words (const gchar *s2uni)
 {
-	gchar *s1uni;
-	gchar *s2uni;
-	GSList *words;
-	gchar *next;
+	GSList *words, *link;
+	const gchar *next;
 	gboolean have_nonspace;
 	gboolean have_space;
 	GString *last_word, *w;
-	gboolean res;
 	gunichar unich;
-	glong len1, len2;
-
-	if (!s2)
-		return FALSE;
 
-	/* the initial word contains an empty string for sure */
-	if (!*s2)
-		return TRUE;
-
-	s1uni = e_util_utf8_normalize (s1);
-	if (s1uni == NULL)
-		return FALSE;
-
-	s2uni = e_util_utf8_normalize (s2);
-	if (s2uni == NULL) {
-		g_free (s1uni);
-		return FALSE;
-	}
-
-	len1 = g_utf8_strlen (s1uni, -1);
-	len2 = g_utf8_strlen (s2uni, -1);
-	if (len1 == 0 || len2 == 0) {
-		g_free (s1uni);
-		g_free (s2uni);
-
-		/* both are empty strings */
-		if (len1 == len2)
-			return TRUE;
-
-		return FALSE;
-	}
-
-	/* breaking s2 into words */
 	words = NULL;
 	have_nonspace = FALSE;
 	have_space = FALSE;
@@ -668,14 +707,49 @@ contains_helper (const gchar *s1,
 		words = g_slist_append (words, w);
 	}
 
-	res = try_contains_word (s1uni, words);
+	/* keep the word strings only */
+	for (link = words; link; link = link->next)
+		link->data = g_string_free (link->data, FALSE);
 
-	g_free (s1uni);
-	g_free (s2uni);
-	g_slist_foreach (words, contains_helper_free_word, NULL);
-	g_slist_free (words);
+	return words;
+}
 
-	return res;
+/* we are looking for s2 in s1, so s2 will be breaked into words */
+static gboolean
+contains_helper (SearchContext *ctx,
+                 const gchar *s1,
+                 const gchar *s2,
+                 const gchar *region)
+{
+	const gchar *s1uni;
+	const gchar *s2uni;
+	CachedString *cached;
+
+	if (!s2)
+		return FALSE;
+
+	/* the initial word contains an empty string for sure */
+	if (!*s2)
+		return TRUE;
+
+	s1uni = get_normal (ctx->field_strings, s1);
+	if (s1uni == NULL)
+		return FALSE;
+
+	s2uni = get_normal (ctx->query_strings, s2);
+	if (s2uni == NULL)
+		return FALSE;
+
+	if (!*s1uni || !*s2uni) {
+		/* both are empty strings */
+		return *s1uni == *s2uni;
+	}
+
+	cached = cached_string_lookup (ctx->query_strings, s2);
+	if (cached->words == NULL)
+		cached->words = contains_helper_split_words (s2uni);
+
+	return try_contains_word (s1uni, cached->words);
 }
 
 static ESExpResult *
@@ -690,23 +764,18 @@ func_contains (struct _ESExp *f,
 }
 
 static gboolean
-is_helper (const gchar *ps1,
+is_helper (SearchContext *ctx,
+           const gchar *ps1,
            const gchar *ps2,
            const gchar *region)
 {
-	gchar *s1, *s2;
-	gboolean res = FALSE;
-
-	s1 = e_util_utf8_remove_accents (ps1);
-	s2 = e_util_utf8_remove_accents (ps2);
-
-	if (!e_util_utf8_strcasecmp (s1, s2))
-		res = TRUE;
-
-	g_free (s1);
-	g_free (s2);
+	if (!strcmp (get_unaccented (ctx->field_strings, ps1),
+		     get_unaccented (ctx->query_strings, ps2)))
+		return TRUE;
 
-	return res;
+	return !strcmp (
+		get_collate_key (ctx->field_strings, ps1),
+		get_collate_key (ctx->query_strings, ps2));
 }
 
 static ESExpResult *
@@ -721,25 +790,20 @@ func_is (struct _ESExp *f,
 }
 
 static gboolean
-endswith_helper (const gchar *ps1,
+endswith_helper (SearchContext *ctx,
+                 const gchar *ps1,
                  const gchar *ps2,
                  const gchar *region)
 {
-	gchar *s1 = e_util_utf8_remove_accents (ps1);
-	gchar *s2 = e_util_utf8_remove_accents (ps2);
-	gboolean res = FALSE;
+	const gchar *s1 = get_unaccented (ctx->field_strings, ps1);
+	const gchar *s2 = get_unaccented (ctx->query_strings, ps2);
 	glong s1len = g_utf8_strlen (s1, -1);
 	glong s2len = g_utf8_strlen (s2, -1);
 
 	if (s1len < s2len)
-		res = FALSE;
-	else
-		res = e_util_utf8_strstrcase (g_utf8_offset_to_pointer (s1, s1len - s2len), s2) != NULL;
-
-	g_free (s1);
-	g_free (s2);
+		return FALSE;
 
-	return res;
+	return e_util_utf8_strstrcase (g_utf8_offset_to_pointer (s1, s1len - s2len), s2) != NULL;
 }
 
 static ESExpResult *
@@ -754,23 +818,20 @@ func_endswith (struct _ESExp *f,
 }
 
 static gboolean
-beginswith_helper (const gchar *ps1,
+beginswith_helper (SearchContext *ctx,
+                   const gchar *ps1,
                    const gchar *ps2,
                    const gchar *region)
 {
-	gchar *p;
-	gboolean res = FALSE;
-	gchar *s1 = e_util_utf8_remove_accents (ps1);
-	gchar *s2 = e_util_utf8_remove_accents (ps2);
+	const gchar *p;
+	const gchar *s1 = get_unaccented (ctx->field_strings, ps1);
+	const gchar *s2 = get_unaccented (ctx->query_strings, ps2);
 
-	if ((p = (gchar *) e_util_utf8_strstrcase (s1, s2))
+	if ((p = e_util_utf8_strstrcase (s1, s2))
 	    && (p == s1))
-		res = TRUE;
-
-	g_free (s1);
-	g_free (s2);
+		return TRUE;
 
-	return res;
+	return FALSE;
 }
 
 static ESExpResult *
@@ -799,7 +860,8 @@ eqphone_helper (const gchar *ps1,
 }
 
 static gboolean
-eqphone_exact_helper (const gchar *ps1,
+eqphone_exact_helper (SearchContext *ctx,
+                      const gchar *ps1,
                       const gchar *ps2,
                       const gchar *region)
 {
@@ -807,7 +869,8 @@ eqphone_exact_helper (const gchar *ps1,
 }
 
 static gboolean
-eqphone_national_helper (const gchar *ps1,
+eqphone_national_helper (SearchContext *ctx,
+                         const gchar *ps1,
                          const gchar *ps2,
                          const gchar *region)
 {
@@ -815,7 +878,8 @@ eqphone_national_helper (const gchar *ps1,
 }
 
 static gboolean
-eqphone_short_helper (const gchar *ps1,
+eqphone_short_helper (SearchContext *ctx,
+                      const gchar *ps1,
                       const gchar *ps2,
                       const gchar *region)
 {
@@ -856,54 +920,56 @@ func_eqphone_short (struct _ESExp *f,
 }
 
 static gboolean
-regex_helper (const gchar *ps1,
+regex_helper (SearchContext *ctx,
+              const gchar *ps1,
               const gchar *ps2,
               const gchar *region,
               gboolean normalize)
 {
 	const gchar *field_data = ps1;
 	const gchar *expression = ps2;
-	GRegex      *regex;
-	GError      *error = NULL;
-	gboolean     match = FALSE;
-
-	regex = g_regex_new (expression, 0, 0, &error);
-	if (!regex) {
-		g_warning (
-			"Failed to parse regular expression '%s': %s",
-			expression, error ? error->message : _("Unknown error"));
-		g_clear_error (&error);
-		return FALSE;
+	CachedString *cached;
+
+	/* compile the expression once, not once per field and contact */
+	cached = cached_string_lookup (ctx->query_strings, expression);
+	if (cached->regex == NULL && !cached->regex_failed) {
+		GError *error = NULL;
+
+		cached->regex = g_regex_new (expression, 0, 0, &error);
+		if (!cached->regex) {
+			g_warning (
+				"Failed to parse regular expression '%s': %s",
+				expression, error ? error->message : _("Unknown error"));
+			g_clear_error (&error);
+			cached->regex_failed = TRUE;
+		}
 	}
 
-	if (normalize) {
-		gchar *normal = e_util_utf8_normalize (field_data);
-
-		match = g_regex_match (regex, normal, 0, NULL);
-
-		g_free (normal);
-	} else
-		match = g_regex_match (regex, field_data, 0, NULL);
+	if (!cached->regex)
+		return FALSE;
 
-	g_regex_unref (regex);
+	if (normalize)
+		field_data = get_normal (ctx->field_strings, field_data);
 
-	return match;
+	return field_data && g_regex_match (cached->regex, field_data, 0, NULL);
 }
 
 static gboolean
-regex_normal_helper (const gchar *ps1,
+regex_normal_helper (SearchContext *ctx,
+                     const gchar *ps1,
                      const gchar *ps2,
                      const gchar *region)
 {
-	return regex_helper (ps1, ps2, region, TRUE);
+	return regex_helper (ctx, ps1, ps2, region, TRUE);
 }
 
 static gboolean
-regex_raw_helper (const gchar *ps1,
+regex_raw_helper (SearchContext *ctx,
+                  const gchar *ps1,
                   const gchar *ps2,
                   const gchar *region)
 {
-	return regex_helper (ps1, ps2, region, FALSE);
+	return regex_helper (ctx, ps1, ps2, region, FALSE);
 }
 
 static ESExpResult *
@@ -929,21 +995,14 @@ func_regex_raw (struct _ESExp *f,
 }
 
 static gboolean
-exists_helper (const gchar *ps1,
+exists_helper (SearchContext *ctx,
+               const gchar *ps1,
                const gchar *ps2,
                const gchar *region)
 {
-	gboolean res = FALSE;
-	gchar *s1 = e_util_utf8_remove_accents (ps1);
-	gchar *s2 = e_util_utf8_remove_accents (ps2);
-
-	if (e_util_utf8_strstrcase (s1, s2))
-		res = TRUE;
-
-	g_free (s1);
-	g_free (s2);
-
-	return res;
+	return e_util_utf8_strstrcase (
+		get_unaccented (ctx->field_strings, ps1),
+		get_unaccented (ctx->query_strings, ps2)) != NULL;
 }
 
 static ESExpResult *
@@ -982,7 +1041,7 @@ func_exists (struct _ESExp *f,
 				}
 				else if (info->prop_type == PROP_TYPE_LIST) {
 					/* the special searches that match any of the list elements */
-					truth = info->list_compare (ctx->contact, "", NULL, exists_helper);
+					truth = info->list_compare (ctx, "", NULL, exists_helper);
 				}
 				else if (info->prop_type == PROP_TYPE_DATE) {
 					EContactDate *date;
@@ -1078,6 +1137,8 @@ book_backend_sexp_finalize (GObject *object)
 
 	e_sexp_unref (priv->search_sexp);
 	g_free (priv->text);
+	g_hash_table_destroy (priv->search_context->query_strings);
+	g_hash_table_destroy (priv->search_context->field_strings);
 	g_free (priv->search_context);
 
 	/* Chain up to parent's finalize() method. */
@@ -1099,7 +1160,17 @@ static void
 e_book_backend_sexp_init (EBookBackendSExp *sexp)
 {
 	sexp->priv = E_BOOK_BACKEND_SEXP_GET_PRIVATE (sexp);
-	sexp->priv->search_context = g_new (SearchContext, 1);
+	sexp->priv->search_context = g_new0 (SearchContext, 1);
+	sexp->priv->search_context->query_strings = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) cached_string_free);
+	sexp->priv->search_context->field_strings = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) cached_string_free);
 }
 
 /* 'builtin' functions */
@@ -1215,6 +1286,7 @@ e_book_backend_sexp_match_contact (EBookBackendSExp *sexp,
 	retval = (r && r->type == ESEXP_RES_BOOL && r->value.boolean);
 
 	g_object_unref (sexp->priv->search_context->contact);
+	g_hash_table_remove_all (sexp->priv->search_context->field_strings);
 
 	e_sexp_result_free (sexp->priv->search_sexp, r);
 
@@ -32,6 +32,7 @@
 #include <glib/gstdio.h>
 
 #include <sqlite3.h>
+#include <zlib.h>
 #include <libebackend/libebackend.h>
 
 #include "e-book-backend-sexp.h"
@@ -62,14 +63,33 @@
 #endif
 
 #define DB_FILENAME "contacts.db"
-#define FOLDER_VERSION 6
+
+/* Upper bound of the database file mapped into memory, the mapped pages
+ * are shared through the page cache by every process reading the book */
+#define MMAP_SIZE "67108864" /* 64 MiB */
+#define FOLDER_VERSION 9
 
 typedef enum {
 	INDEX_PREFIX = (1 << 0),
 	INDEX_SUFFIX = (1 << 1),
-	INDEX_PHONE = (1 << 2)
+	INDEX_PHONE = (1 << 2),
+	INDEX_SUBSTRING = (1 << 3)
 } IndexFlags;
 
+/* Fields with a substring index have a "<folderid>_<dbname>_trigrams" table
+ * listing the distinct trigrams of the normalized values of each contact,
+ * which narrows down the candidates of a contains query before its LIKE
+ * pattern is evaluated.  Queries shorter than a trigram cannot use it. */
+#define TRIGRAM_LENGTH 3
+
+/* SQLite limits the number of terms in a compound SELECT to 500 */
+#define MAX_TRIGRAMS_PER_STMT 400
+
+/* Compressed vCards are stored as BLOBs, the length of the vCard as a
+ * 32 bit big endian integer followed by its zlib stream. Plain vCards
+ * are stored as TEXT, rows of both kinds can be mixed. */
+#define COMPRESSED_VCARD_HEADER_SIZE 4
+
 typedef struct {
 	EContactField field;   /* The EContact field */
 	GType         type;    /* The GType (only support string or gboolean) */
@@ -77,6 +97,15 @@ typedef struct {
 	IndexFlags    index;   /* Whether this summary field should have an index in the SQLite DB */
 } SummaryField;
 
+/* String summary fields other than the UID and REV also store a collation
+ * key for the active locale in a "<dbname>_localized" column, which cursors
+ * sort on.  The locale the keys were generated for is kept in the folders
+ * table, so that they can be regenerated when it changes. */
+#define SUMMARY_FIELD_HAS_KEY(sfield) \
+	((sfield)->type == G_TYPE_STRING && \
+	 (sfield)->field != E_CONTACT_UID && \
+	 (sfield)->field != E_CONTACT_REV)
+
 struct _EBookBackendSqliteDBPrivate {
 	sqlite3 *db;
 	gchar *path;
@@ -86,12 +115,18 @@ struct _EBookBackendSqliteDBPrivate {
 	GMutex updates_lock; /* This is for deprecated e_book_backend_sqlitedb_lock_updates () */
 
 	gboolean store_vcard;
+	gboolean compress_vcards;
 	guint32 in_transaction;
 
 	SummaryField   *summary_fields;
 	gint            n_summary_fields;
 	guint           have_attr_list : 1;
 	IndexFlags      attr_list_indexes;
+
+	/* Set of the folder IDs being bulk loaded, the indexes to
+	 * create again are kept in the bulk_load_indexes table */
+	GHashTable     *bulk_loads;
+	gchar          *bulk_load_synchronous;
 };
 
 G_DEFINE_TYPE (EBookBackendSqliteDB, e_book_backend_sqlitedb, G_TYPE_OBJECT)
@@ -134,6 +169,9 @@ static SummaryField * append_summary_field (GArray         *array,
 static gboolean upgrade_contacts_table (EBookBackendSqliteDB  *ebsdb,
 					 const gchar           *folderid,
 					 GError               **error);
+static gboolean restore_bulk_load_indexes (EBookBackendSqliteDB  *ebsdb,
+					   const gchar           *folderid,
+					   GError               **error);
 
 static const gchar *
 summary_dbname_from_field (EBookBackendSqliteDB *ebsdb,
@@ -213,6 +251,11 @@ e_book_backend_sqlitedb_finalize (GObject *object)
 
 	g_free (priv->path);
 	g_free (priv->summary_fields);
+	g_free (priv->bulk_load_synchronous);
+
+	/* Indexes dropped by an unfinished bulk load are
+	 * created again the next time the folder is opened */
+	g_hash_table_destroy (priv->bulk_loads);
 
 	g_mutex_clear (&priv->lock);
 	g_mutex_clear (&priv->updates_lock);
@@ -241,6 +284,11 @@ e_book_backend_sqlitedb_init (EBookBackendSqliteDB *ebsdb)
 	ebsdb->priv->store_vcard = TRUE;
 
 	ebsdb->priv->in_transaction = 0;
+	ebsdb->priv->bulk_loads = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) NULL);
 	g_mutex_init (&ebsdb->priv->lock);
 	g_mutex_init (&ebsdb->priv->updates_lock);
 }
@@ -392,6 +440,213 @@ book_backend_sql_exec (sqlite3 *db,
 	return book_backend_sql_exec_real (db, stmt, callback, data, error);
 }
 
+/* Returns the compressed vCard, or NULL if it would not get any
+ * smaller (free the result with g_free() ) */
+static guint8 *
+compress_vcard (const gchar *vcard_str,
+                gsize *out_length)
+{
+	guint8 *compressed;
+	guint32 header;
+	uLong length;
+	uLongf compressed_length;
+
+	length = strlen (vcard_str);
+	compressed_length = compressBound (length);
+	compressed = g_malloc (COMPRESSED_VCARD_HEADER_SIZE + compressed_length);
+
+	if (compress2 (compressed + COMPRESSED_VCARD_HEADER_SIZE, &compressed_length,
+		       (const Bytef *) vcard_str, length, Z_DEFAULT_COMPRESSION) != Z_OK ||
+	    COMPRESSED_VCARD_HEADER_SIZE + compressed_length >= length) {
+		g_free (compressed);
+		return NULL;
+	}
+
+	header = GUINT32_TO_BE (length);
+	memcpy (compressed, &header, COMPRESSED_VCARD_HEADER_SIZE);
+
+	*out_length = COMPRESSED_VCARD_HEADER_SIZE + compressed_length;
+
+	return compressed;
+}
+
+/* Returns the vCard string stored in a compressed vcard
+ * column (free the result with g_free() ) */
+static gchar *
+uncompress_vcard (const guint8 *compressed,
+                  gsize compressed_length)
+{
+	gchar *vcard_str;
+	guint32 header;
+	uLongf length;
+
+	if (compressed_length < COMPRESSED_VCARD_HEADER_SIZE)
+		return NULL;
+
+	memcpy (&header, compressed, COMPRESSED_VCARD_HEADER_SIZE);
+	length = GUINT32_FROM_BE (header);
+
+	vcard_str = g_malloc (length + 1);
+
+	if (uncompress ((Bytef *) vcard_str, &length,
+			compressed + COMPRESSED_VCARD_HEADER_SIZE,
+			compressed_length - COMPRESSED_VCARD_HEADER_SIZE) != Z_OK) {
+		g_warning ("%s: Failed to uncompress a stored vCard", G_STRFUNC);
+		g_free (vcard_str);
+		return NULL;
+	}
+
+	vcard_str[length] = '\0';
+
+	return vcard_str;
+}
+
+static void
+book_backend_sql_set_error (sqlite3 *db,
+                            gint ret,
+                            GError **error)
+{
+	g_set_error_literal (
+		error, E_BOOK_SDB_ERROR,
+		ret == SQLITE_CONSTRAINT ?
+		E_BOOK_SDB_ERROR_CONSTRAINT : E_BOOK_SDB_ERROR_OTHER,
+		sqlite3_errmsg (db));
+}
+
+/* Like book_backend_sql_exec(), but steps through a prepared statement,
+ * BLOB columns are passed to the callback as uncompressed vCards. */
+static gboolean
+book_backend_sql_select (sqlite3 *db,
+                         const gchar *stmt,
+                         gint (*callback)(gpointer ,gint,gchar **,gchar **),
+                         gpointer data,
+                         GError **error)
+{
+	sqlite3_stmt *prepared = NULL;
+	gchar **cols = NULL, **names = NULL, **vcards = NULL;
+	gint ret, n_cols = 0, i;
+
+	if (booksql_debug ())
+		book_backend_sql_debug (db, stmt, callback, data, error);
+
+	ret = sqlite3_prepare_v2 (db, stmt, -1, &prepared, NULL);
+	while (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+		g_thread_yield ();
+		ret = sqlite3_prepare_v2 (db, stmt, -1, &prepared, NULL);
+	}
+
+	if (ret == SQLITE_OK) {
+		n_cols = sqlite3_column_count (prepared);
+		cols = g_new0 (gchar *, n_cols);
+		names = g_new0 (gchar *, n_cols);
+		vcards = g_new0 (gchar *, n_cols);
+
+		for (i = 0; i < n_cols; i++)
+			names[i] = (gchar *) sqlite3_column_name (prepared, i);
+	}
+
+	while (ret == SQLITE_OK || ret == SQLITE_ROW ||
+	       ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+		if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED)
+			g_thread_yield ();
+
+		ret = sqlite3_step (prepared);
+
+		if (ret != SQLITE_ROW || callback == NULL)
+			continue;
+
+		for (i = 0; i < n_cols; i++) {
+			if (sqlite3_column_type (prepared, i) == SQLITE_BLOB) {
+				const guint8 *blob = sqlite3_column_blob (prepared, i);
+
+				vcards[i] = uncompress_vcard (
+					blob, sqlite3_column_bytes (prepared, i));
+				cols[i] = vcards[i];
+			} else {
+				cols[i] = (gchar *) sqlite3_column_text (prepared, i);
+			}
+		}
+
+		if (callback (data, n_cols, cols, names) != 0)
+			ret = SQLITE_ABORT;
+
+		for (i = 0; i < n_cols; i++) {
+			g_free (vcards[i]);
+			vcards[i] = NULL;
+		}
+	}
+
+	if (ret != SQLITE_DONE) {
+		d (g_printerr ("Error in SQL SELECT statement: %s [%s].\n", stmt, sqlite3_errmsg (db)));
+		book_backend_sql_set_error (db, ret, error);
+	}
+
+	sqlite3_finalize (prepared);
+
+	g_free (cols);
+	g_free (names);
+	g_free (vcards);
+
+	return ret == SQLITE_DONE;
+}
+
+/* Runs an INSERT statement with a single parameter, which is bound
+ * to the vCard, compressed if @compress is %TRUE and that pays off. */
+static gboolean
+book_backend_sql_exec_with_vcard (sqlite3 *db,
+                                  const gchar *stmt,
+                                  const gchar *vcard_str,
+                                  gboolean compress,
+                                  GError **error)
+{
+	sqlite3_stmt *prepared = NULL;
+	guint8 *compressed = NULL;
+	gsize compressed_length = 0;
+	gint ret;
+
+	if (booksql_debug ())
+		g_printerr ("DEBUG STATEMENT: %s\n", stmt);
+
+	ret = sqlite3_prepare_v2 (db, stmt, -1, &prepared, NULL);
+	while (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+		g_thread_yield ();
+		ret = sqlite3_prepare_v2 (db, stmt, -1, &prepared, NULL);
+	}
+
+	if (ret != SQLITE_OK) {
+		book_backend_sql_set_error (db, ret, error);
+		return FALSE;
+	}
+
+	if (vcard_str != NULL && compress)
+		compressed = compress_vcard (vcard_str, &compressed_length);
+
+	if (compressed != NULL)
+		sqlite3_bind_blob (
+			prepared, 1, compressed,
+			(gint) compressed_length, g_free);
+	else if (vcard_str != NULL)
+		sqlite3_bind_text (prepared, 1, vcard_str, -1, SQLITE_STATIC);
+	else
+		sqlite3_bind_null (prepared, 1);
+
+	ret = sqlite3_step (prepared);
+	while (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+		g_thread_yield ();
+		sqlite3_reset (prepared);
+		ret = sqlite3_step (prepared);
+	}
+
+	if (ret != SQLITE_DONE) {
+		d (g_printerr ("Error in SQL INSERT statement: %s [%s].\n", stmt, sqlite3_errmsg (db)));
+		book_backend_sql_set_error (db, ret, error);
+	}
+
+	sqlite3_finalize (prepared);
+
+	return ret == SQLITE_DONE;
+}
+
 /* This function must always be called with the priv->lock held */
 static gboolean
 book_backend_sqlitedb_start_transaction (EBookBackendSqliteDB *ebsdb,
@@ -476,6 +731,19 @@ collect_versions_cb (gpointer ref,
 	return 0;
 }
 
+static gint
+collect_strings_cb (gpointer ref,
+                    gint col,
+                    gchar **cols,
+                    gchar **name)
+{
+	GPtrArray *strings = ref;
+
+	g_ptr_array_add (strings, g_strdup (cols[0]));
+
+	return 0;
+}
+
 static gboolean
 create_folders_table (EBookBackendSqliteDB *ebsdb,
                       gint *previous_schema,
@@ -502,7 +770,8 @@ create_folders_table (EBookBackendSqliteDB *ebsdb,
 		"  partial_content INTEGER DEFAULT 0,"
 		" version INTEGER,"
 		"  revision TEXT,"
-		" multivalues TEXT )";
+		" multivalues TEXT,"
+		" lc_collate TEXT )";
 
 	if (!book_backend_sqlitedb_start_transaction (ebsdb, error))
 		return FALSE;
@@ -521,6 +790,13 @@ create_folders_table (EBookBackendSqliteDB *ebsdb,
 	if (!book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error))
 		goto rollback;
 
+	/* Create a child table holding the CREATE INDEX statements of the
+	 * indexes dropped by a bulk load, until they are created again. */
+	stmt = "CREATE TABLE IF NOT EXISTS bulk_load_indexes"
+		"( folder_id TEXT REFERENCES folders, stmt TEXT )";
+	if (!book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error))
+		goto rollback;
+
 	/* Fetch the version, it should be the
 	 * same for all folders (hence the LIMIT). */
 	stmt = "SELECT version FROM folders LIMIT 1";
@@ -581,6 +857,54 @@ create_folders_table (EBookBackendSqliteDB *ebsdb,
 			goto rollback;
 	}
 
+	/* Upgrade DB to version 7: Add the locale of the collation keys,
+	 * the contacts tables get their key columns in create_contacts_table().
+	 */
+	if (version >= 1 && version < 7) {
+		stmt = "ALTER TABLE folders ADD COLUMN lc_collate TEXT";
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+
+		if (!success)
+			goto rollback;
+	}
+
+	/* Upgrade DB to version 8: Nothing to do. The vcard column may hold
+	 * compressed vCards as BLOBs from now on, next to the plain ones.
+	 */
+
+	/* Upgrade DB to version 9: The ixphone collations order numbers
+	 * stored without a country code differently now, rebuild the
+	 * phone number indexes using them.
+	 */
+	if (version >= 1 && version < 9) {
+		GPtrArray *indexes;
+		guint ii;
+
+		indexes = g_ptr_array_new_with_free_func (g_free);
+
+		stmt = "SELECT name FROM sqlite_master WHERE type = 'index' "
+			"AND name LIKE 'PINDEX_%_WITH_ixphone_%'";
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt,
+			collect_strings_cb, indexes, error);
+
+		for (ii = 0; success && ii < indexes->len; ii++) {
+			gchar *reindex_stmt;
+
+			reindex_stmt = sqlite3_mprintf (
+				"REINDEX %Q", g_ptr_array_index (indexes, ii));
+			success = book_backend_sql_exec (
+				ebsdb->priv->db, reindex_stmt, NULL, NULL, error);
+			sqlite3_free (reindex_stmt);
+		}
+
+		g_ptr_array_unref (indexes);
+
+		if (!success)
+			goto rollback;
+	}
+
 	/* Finish the eventual upgrade by storing the current schema version.
 	 */
 	if (version >= 1 && version < FOLDER_VERSION) {
@@ -722,6 +1046,35 @@ get_count_cb (gpointer ref,
 	return 0;
 }
 
+static gchar *
+trigram_table_name (const gchar *folderid,
+                    const gchar *dbname)
+{
+	return g_strdup_printf ("%s_%s_trigrams", folderid, dbname);
+}
+
+/* Adds the distinct trigrams of an already normalized string to @trigrams */
+static void
+collect_trigrams (GHashTable *trigrams,
+                  const gchar *normal)
+{
+	const gchar *p, *end;
+	gint i;
+
+	if (normal == NULL)
+		return;
+
+	for (p = normal; *p; p = g_utf8_next_char (p)) {
+		for (end = p, i = 0; *end && i < TRIGRAM_LENGTH; i++)
+			end = g_utf8_next_char (end);
+
+		if (i < TRIGRAM_LENGTH)
+			break;
+
+		g_hash_table_add (trigrams, g_strndup (p, end - p));
+	}
+}
+
 static gboolean
 check_folderid_exists (EBookBackendSqliteDB *ebsdb,
                        const gchar *folderid,
@@ -772,6 +1125,10 @@ introspect_summary (EBookBackendSqliteDB *ebsdb,
 		gchar *p;
 		IndexFlags computed = 0;
 
+		/* Collation keys are derived from their summary field */
+		if (g_str_has_suffix (col, "_localized"))
+			continue;
+
 		/* Check if we're parsing a reverse field */
 		if ((p = strstr (col, "_reverse")) != NULL) {
 			computed = INDEX_SUFFIX;
@@ -863,6 +1220,24 @@ introspect_summary (EBookBackendSqliteDB *ebsdb,
 		g_strfreev (fields);
 	}
 
+	/* Substring indexes are recorded by the existence of their tables */
+	for (i = 0; success && i < summary_fields->len; i++) {
+		SummaryField *iter = &g_array_index (summary_fields, SummaryField, i);
+		gboolean exists = FALSE;
+		gchar *table;
+
+		if (iter->type != G_TYPE_STRING &&
+		    iter->type != E_TYPE_CONTACT_ATTR_LIST)
+			continue;
+
+		table = trigram_table_name (folderid, iter->dbname);
+		success = check_folderid_exists (ebsdb, table, &exists, error);
+		g_free (table);
+
+		if (exists)
+			iter->index |= INDEX_SUBSTRING;
+	}
+
  introspect_summary_finish:
 
 	g_list_free_full (summary_columns, (GDestroyNotify) g_free);
@@ -921,6 +1296,11 @@ create_contacts_table (EBookBackendSqliteDB *ebsdb,
 				g_string_append  (string, ebsdb->priv->summary_fields[i].dbname);
 				g_string_append  (string, "_phone TEXT, ");
 			}
+
+			if (SUMMARY_FIELD_HAS_KEY (&ebsdb->priv->summary_fields[i])) {
+				g_string_append  (string, ebsdb->priv->summary_fields[i].dbname);
+				g_string_append  (string, "_localized TEXT, ");
+			}
 		}
 	}
 	g_string_append (string, "vcard TEXT, bdata TEXT)");
@@ -979,10 +1359,56 @@ create_contacts_table (EBookBackendSqliteDB *ebsdb,
 		g_free (tmp);
 	}
 
+	/* Substring indexes can only be set up along with a new table,
+	 * introspection would take an empty one for an up to date index */
+	for (i = 0; success && !already_exists && i < ebsdb->priv->n_summary_fields; i++) {
+		if ((ebsdb->priv->summary_fields[i].index & INDEX_SUBSTRING) == 0)
+			continue;
+
+		tmp = trigram_table_name (folderid, ebsdb->priv->summary_fields[i].dbname);
+
+		stmt = sqlite3_mprintf (
+			"CREATE TABLE IF NOT EXISTS %Q ( uid TEXT NOT NULL REFERENCES %Q(uid), "
+			"trigram TEXT NOT NULL)", tmp, folderid);
+		success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+
+		if (success) {
+			stmt = sqlite3_mprintf (
+				"CREATE INDEX IF NOT EXISTS \"TINDEX_%q\" ON %Q (trigram, uid)",
+				tmp, tmp);
+			success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+			sqlite3_free (stmt);
+		}
+
+		if (success) {
+			stmt = sqlite3_mprintf (
+				"CREATE INDEX IF NOT EXISTS \"TUINDEX_%q\" ON %Q (uid)",
+				tmp, tmp);
+			success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+			sqlite3_free (stmt);
+		}
+
+		g_free (tmp);
+	}
+
 	/* Dont introspect the summary if the table did not yet exist */
 	if (success && already_exists)
 		success = introspect_summary (ebsdb, folderid, error);
 
+	/* Tables from before version 7 lack the collation key columns */
+	for (i = 0; success && already_exists && previous_schema < 7 &&
+	     i < ebsdb->priv->n_summary_fields; i++) {
+		if (!SUMMARY_FIELD_HAS_KEY (&ebsdb->priv->summary_fields[i]))
+			continue;
+
+		stmt = sqlite3_mprintf (
+			"ALTER TABLE %Q ADD COLUMN %s_localized TEXT",
+			folderid, ebsdb->priv->summary_fields[i].dbname);
+		success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+	}
+
 	/* Create indexes on the summary fields configured for indexing */
 	for (i = 0; success && i < ebsdb->priv->n_summary_fields; i++) {
 		if ((ebsdb->priv->summary_fields[i].index & INDEX_PREFIX) != 0 &&
@@ -1030,11 +1456,58 @@ create_contacts_table (EBookBackendSqliteDB *ebsdb,
 			sqlite3_free (stmt);
 			g_free (tmp);
 		}
+
+		/* Indexed fields are the likely sort keys for cursors as well */
+		if (success &&
+		    ebsdb->priv->summary_fields[i].index != 0 &&
+		    SUMMARY_FIELD_HAS_KEY (&ebsdb->priv->summary_fields[i])) {
+			/* Derive index name from field & folder */
+			tmp = g_strdup_printf (
+				"LINDEX_%s_%s",
+				ebsdb->priv->summary_fields[i].dbname,
+				folderid);
+			stmt = sqlite3_mprintf (
+				"CREATE INDEX IF NOT EXISTS %Q ON %Q (%s_localized)", tmp, folderid,
+				ebsdb->priv->summary_fields[i].dbname);
+			success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+			sqlite3_free (stmt);
+			g_free (tmp);
+		}
 	}
 
-	/* Until version 6, the whole contacts table requires a re-normalization of the data */
-	if (success && previous_schema < 6)
-		success = upgrade_contacts_table (ebsdb, folderid, error);
+	/* Until version 6, the whole contacts table requires a re-normalization of the data,
+	 * and until version 7 the collation keys need to be generated.  The keys are made for
+	 * the locale recorded with a new or upgraded table; opening the table in a process
+	 * with another locale leaves them alone, only e_book_backend_sqlitedb_set_locale()
+	 * regenerates them. */
+	if (success && (!already_exists || previous_schema < 7)) {
+		if (already_exists)
+			success = upgrade_contacts_table (ebsdb, folderid, error);
+
+		if (success) {
+			stmt = sqlite3_mprintf (
+				"UPDATE folders SET lc_collate = %Q WHERE folder_id = %Q",
+				setlocale (LC_COLLATE, NULL), folderid);
+			success = book_backend_sql_exec (
+				ebsdb->priv->db, stmt, NULL, NULL, error);
+			sqlite3_free (stmt);
+		}
+	}
+
+	/* A bulk load which was never ended left its indexes dropped */
+	if (success && already_exists &&
+	    !g_hash_table_contains (ebsdb->priv->bulk_loads, folderid)) {
+		if (!book_backend_sqlitedb_start_transaction (ebsdb, error))
+			return FALSE;
+
+		success = restore_bulk_load_indexes (ebsdb, folderid, error);
+
+		if (success)
+			success = book_backend_sqlitedb_commit_transaction (ebsdb, error);
+		else
+			/* The GError is already set. */
+			book_backend_sqlitedb_rollback_transaction (ebsdb, NULL);
+	}
 
 	return success;
 }
@@ -1112,17 +1585,6 @@ create_phone_indexes_for_tables (gpointer data,
 	return 0;
 }
 
-static GString *
-ixphone_str (gint country_code,
-             const gchar *const national_str,
-             gint national_len)
-{
-	GString *const str = g_string_sized_new (6 + national_len);
-	g_string_append_printf (str, "+%d|", country_code);
-	g_string_append_len (str, national_str, national_len);
-	return str;
-}
-
 static gint
 e_strcmp2n (const gchar *str1,
             size_t len1,
@@ -1136,6 +1598,27 @@ e_strcmp2n (const gchar *str1,
 		len1 < len2 ? -1 : 1);
 }
 
+/* Compares @prefix followed by @str1 with @str2, without building
+ * the concatenated string; collations run for every row visited */
+static gint
+e_strcmp2n_prefixed (const gchar *prefix,
+                     size_t prefix_len,
+                     const gchar *str1,
+                     size_t len1,
+                     const gchar *str2,
+                     size_t len2)
+{
+	const gint cmp = memcmp (prefix, str2, MIN (prefix_len, len2));
+
+	if (cmp != 0)
+		return cmp;
+
+	if (len2 < prefix_len)
+		return 1;
+
+	return e_strcmp2n (str1, len1, str2 + prefix_len, len2 - prefix_len);
+}
+
 static gint
 ixphone_compare_for_country (gpointer data,
                              gint len1,
@@ -1143,11 +1626,11 @@ ixphone_compare_for_country (gpointer data,
                              gint len2,
                              gconstpointer arg2)
 {
+	const gchar *const country_code = data;
 	const gchar *const str1 = arg1;
 	const gchar *const str2 = arg2;
 	const gchar *const sep1 = memchr (str1, '|', len1);
 	const gchar *const sep2 = memchr (str2, '|', len2);
-	const gint country_code = GPOINTER_TO_INT (data);
 
 	g_return_val_if_fail (sep1 != NULL, 0);
 	g_return_val_if_fail (sep2 != NULL, 0);
@@ -1155,17 +1638,15 @@ ixphone_compare_for_country (gpointer data,
 	if ((str1 == sep1) == (str2 == sep2))
 		return e_strcmp2n (str1, len1, str2, len2);
 
-	if (str1 == sep1) {
-		GString *const tmp = ixphone_str (country_code, str1, len1);
-		const gint cmp = e_strcmp2n (tmp->str, tmp->len, str2, len2);
-		g_string_free (tmp, TRUE);
-		return cmp;
-	} else {
-		GString *const tmp = ixphone_str (country_code, str2, len2);
-		const gint cmp = e_strcmp2n (str1, len1, tmp->str, tmp->len);
-		g_string_free (tmp, TRUE);
-		return cmp;
-	}
+	/* Numbers without country code are in the collation's country */
+	if (str1 == sep1)
+		return e_strcmp2n_prefixed (
+			country_code, strlen (country_code),
+			str1, len1, str2, len2);
+	else
+		return -e_strcmp2n_prefixed (
+			country_code, strlen (country_code),
+			str2, len2, str1, len1);
 }
 
 static gint
@@ -1242,9 +1723,10 @@ create_collation (gpointer data,
 	g_warn_if_fail (encoding == SQLITE_UTF8);
 
 	if  (1 == sscanf (name, "ixphone_%d", &country_code)) {
-		ret = sqlite3_create_collation (
-			db, name, SQLITE_UTF8, GINT_TO_POINTER (country_code),
-			ixphone_compare_for_country);
+		ret = sqlite3_create_collation_v2 (
+			db, name, SQLITE_UTF8,
+			g_strdup_printf ("+%d", country_code),
+			ixphone_compare_for_country, g_free);
 	} else if (strcmp (name, "ixphone_national") == 0) {
 		country_code = e_phone_number_get_country_code_for_region (NULL, NULL);
 
@@ -1362,6 +1844,23 @@ book_backend_sqlitedb_load (EBookBackendSqliteDB *ebsdb,
 		"PRAGMA case_sensitive_like = ON",
 		NULL, NULL, NULL);
 
+	/* With a write-ahead log, readers in other processes (direct read
+	 * access clients) keep reading the last committed snapshot without
+	 * blocking on, or being blocked by, the writing backend, and read
+	 * it through memory mapped pages instead of copying it in. SQLite
+	 * versions without these features ignore the pragmas. The WAL
+	 * journal mode is stored in the database file, which SQLite before
+	 * 3.7.0 can not open anymore. The sqlite3 VFS of libebackend does
+	 * not defer the syncs of checkpoints. */
+	book_backend_sql_exec (
+		ebsdb->priv->db,
+		"PRAGMA main.journal_mode = WAL",
+		NULL, NULL, NULL);
+	book_backend_sql_exec (
+		ebsdb->priv->db,
+		"PRAGMA mmap_size = " MMAP_SIZE,
+		NULL, NULL, NULL);
+
 	return create_folders_table (ebsdb, previous_schema, error);
 }
 
@@ -1555,6 +2054,11 @@ summary_fields_add_indexes (GArray *array,
 					if (sfield->type == E_TYPE_CONTACT_ATTR_LIST)
 						*attr_list_indexes |= INDEX_PHONE;
 					break;
+				case E_BOOK_INDEX_SUBSTRING:
+					/* Kept in separate tables, the list table
+					 * needs no extra column for it */
+					sfield->index |= INDEX_SUBSTRING;
+					break;
 				default:
 					g_warn_if_reached ();
 					break;
@@ -1830,32 +2334,61 @@ mprintf_phone (const gchar *normal,
 	return stmt;
 }
 
+/* The collation keys stored in the summary and the ones cursors seek
+ * to must come from the same function, or they do not compare. */
+static gchar *
+summary_collation_key (const gchar *value)
+{
+	return g_utf8_collate_key (value ? value : "", -1);
+}
+
 /* Add Contact (free the result with g_free() ) */
+static gchar *
+mprintf_localized (const gchar *normal)
+{
+	gchar *collation_key;
+	gchar *stmt;
+
+	collation_key = summary_collation_key (normal);
+	stmt = sqlite3_mprintf ("%Q", collation_key);
+	g_free (collation_key);
+
+	return stmt;
+}
+
 static gchar *
 insert_stmt_from_contact (EBookBackendSqliteDB *ebsdb,
                           EContact *contact,
                           const gchar *folderid,
-                          gboolean store_vcard,
                           gboolean replace_existing,
                           const gchar *default_region)
 {
 	GString *string;
-	gchar *str, *vcard_str;
+	GString *columns;
+	gchar *str;
 	gint i;
 
+	/* The columns are named explicitly, tables upgraded from older
+	 * schemas have their collation key columns at the end */
 	str = sqlite3_mprintf (
-		"INSERT or %s INTO %Q VALUES (",
+		"INSERT or %s INTO %Q (",
 		replace_existing ? "REPLACE" : "FAIL", folderid);
-	string = g_string_new (str);
+	columns = g_string_new (str);
 	sqlite3_free (str);
 
+	string = g_string_new (") VALUES (");
+
 	for (i = 0; i < ebsdb->priv->n_summary_fields; i++) {
+		const gchar *dbname = ebsdb->priv->summary_fields[i].dbname;
+
 		if (ebsdb->priv->summary_fields[i].type == G_TYPE_STRING) {
 			gchar *val;
 			gchar *normal;
 
-			if (i > 0)
+			if (i > 0) {
+				g_string_append (columns, ", ");
 				g_string_append (string, ", ");
+			}
 
 			val = e_contact_get (contact, ebsdb->priv->summary_fields[i].field);
 
@@ -1866,11 +2399,13 @@ insert_stmt_from_contact (EBookBackendSqliteDB *ebsdb,
 			else
 				normal = g_strdup (val);
 
+			g_string_append (columns, dbname);
 			str = sqlite3_mprintf ("%Q", normal);
 			g_string_append (string, str);
 			sqlite3_free (str);
 
 			if ((ebsdb->priv->summary_fields[i].index & INDEX_SUFFIX) != 0) {
+				g_string_append_printf (columns, ", %s_reverse", dbname);
 				str = mprintf_suffix (normal);
 				g_string_append (string, ", ");
 				g_string_append (string, str);
@@ -1878,20 +2413,34 @@ insert_stmt_from_contact (EBookBackendSqliteDB *ebsdb,
 			}
 
 			if ((ebsdb->priv->summary_fields[i].index & INDEX_PHONE) != 0) {
+				g_string_append_printf (columns, ", %s_phone", dbname);
 				str = mprintf_phone (normal, default_region);
 				g_string_append (string, ", ");
 				g_string_append (string, str ? str : "NULL");
 				sqlite3_free (str);
 			}
 
+			/* The collation key is generated from the raw value,
+			 * the normalized one has its case folded already */
+			if (SUMMARY_FIELD_HAS_KEY (&ebsdb->priv->summary_fields[i])) {
+				g_string_append_printf (columns, ", %s_localized", dbname);
+				str = mprintf_localized (val);
+				g_string_append (string, ", ");
+				g_string_append (string, str);
+				sqlite3_free (str);
+			}
+
 			g_free (normal);
 			g_free (val);
 		} else if (ebsdb->priv->summary_fields[i].type == G_TYPE_BOOLEAN) {
 			gboolean val;
 
-			if (i > 0)
+			if (i > 0) {
+				g_string_append (columns, ", ");
 				g_string_append (string, ", ");
+			}
 
+			g_string_append (columns, dbname);
 			val = e_contact_get (contact, ebsdb->priv->summary_fields[i].field) ? TRUE : FALSE;
 			g_string_append_printf (string, "%d", val ? 1 : 0);
 
@@ -1899,15 +2448,14 @@ insert_stmt_from_contact (EBookBackendSqliteDB *ebsdb,
 			g_warn_if_reached ();
 	}
 
-	vcard_str = store_vcard ? e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30) : NULL;
-	str = sqlite3_mprintf (", %Q, %Q)", vcard_str, NULL);
-
-	g_string_append (string, str);
+	/* The vCard is bound to the parameter, it may be a BLOB */
+	g_string_append (columns, ", vcard, bdata");
+	g_string_append (string, ", ?, NULL)");
 
-	sqlite3_free (str);
-	g_free (vcard_str);
+	g_string_append (columns, string->str);
+	g_string_free (string, TRUE);
 
-	return g_string_free (string, FALSE);
+	return g_string_free (columns, FALSE);
 }
 
 static void
@@ -1979,6 +2527,92 @@ update_e164_attribute_params (EVCard *vcard,
 	}
 }
 
+static gboolean
+insert_contact_trigrams (EBookBackendSqliteDB *ebsdb,
+                         EContact *contact,
+                         const gchar *folderid,
+                         SummaryField *sfield,
+                         GError **error)
+{
+	GHashTable *trigrams;
+	GHashTableIter iter;
+	GString *string = NULL;
+	gpointer trigram;
+	gboolean success;
+	gchar *table, *uid, *stmt;
+	gint n_terms = 0;
+
+	table = trigram_table_name (folderid, sfield->dbname);
+	uid = e_contact_get (contact, E_CONTACT_UID);
+
+	/* First remove all entries for this UID */
+	stmt = sqlite3_mprintf ("DELETE FROM %Q WHERE uid = %Q", table, uid);
+	success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+	sqlite3_free (stmt);
+
+	trigrams = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	if (sfield->type == E_TYPE_CONTACT_ATTR_LIST) {
+		GList *values, *l;
+
+		values = e_contact_get (contact, sfield->field);
+
+		for (l = values; l != NULL; l = l->next) {
+			gchar *normal = e_util_utf8_normalize (l->data);
+
+			collect_trigrams (trigrams, normal);
+			g_free (normal);
+		}
+
+		e_contact_attr_list_free (values);
+	} else {
+		gchar *value = e_contact_get (contact, sfield->field);
+		gchar *normal = e_util_utf8_normalize (value);
+
+		collect_trigrams (trigrams, normal);
+		g_free (normal);
+		g_free (value);
+	}
+
+	/* Insert the trigrams a few hundred at a time, with compound
+	 * SELECTs since multi row VALUES need a newer SQLite */
+	g_hash_table_iter_init (&iter, trigrams);
+	while (success && g_hash_table_iter_next (&iter, &trigram, NULL)) {
+		if (string == NULL) {
+			stmt = sqlite3_mprintf ("INSERT INTO %Q (uid, trigram) ", table);
+			string = g_string_new (stmt);
+			sqlite3_free (stmt);
+		} else {
+			g_string_append (string, " UNION ALL ");
+		}
+
+		stmt = sqlite3_mprintf ("SELECT %Q, %Q", uid, trigram);
+		g_string_append (string, stmt);
+		sqlite3_free (stmt);
+
+		if (++n_terms == MAX_TRIGRAMS_PER_STMT) {
+			success = book_backend_sql_exec (
+				ebsdb->priv->db, string->str, NULL, NULL, error);
+			g_string_free (string, TRUE);
+			string = NULL;
+			n_terms = 0;
+		}
+	}
+
+	if (success && string != NULL)
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, string->str, NULL, NULL, error);
+
+	if (string != NULL)
+		g_string_free (string, TRUE);
+
+	g_hash_table_destroy (trigrams);
+	g_free (table);
+	g_free (uid);
+
+	return success;
+}
+
 static gboolean
 insert_contact (EBookBackendSqliteDB *ebsdb,
                 EContact *contact,
@@ -1989,24 +2623,28 @@ insert_contact (EBookBackendSqliteDB *ebsdb,
 {
 	EBookBackendSqliteDBPrivate *priv;
 	gboolean success;
-	gchar *stmt;
+	gchar *stmt, *vcard_str = NULL;
+	gint i;
 
 	priv = ebsdb->priv;
 
 	/* Update E.164 parameters in vcard if needed */
-	if (priv->store_vcard)
+	if (priv->store_vcard) {
 		update_e164_attribute_params (E_VCARD (contact), default_region);
+		vcard_str = e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30);
+	}
 
 	/* Update main summary table */
-	stmt = insert_stmt_from_contact (ebsdb, contact, folderid, priv->store_vcard, replace_existing, default_region);
-	success = book_backend_sql_exec (priv->db, stmt, NULL, NULL, error);
+	stmt = insert_stmt_from_contact (ebsdb, contact, folderid, replace_existing, default_region);
+	success = book_backend_sql_exec_with_vcard (
+		priv->db, stmt, vcard_str, priv->compress_vcards, error);
+	g_free (vcard_str);
 	g_free (stmt);
 
 	/* Update attribute list table */
 	if (success && priv->have_attr_list) {
 		gchar *list_folder = g_strdup_printf ("%s_lists", folderid);
 		gchar *uid;
-		gint   i;
 		GList *values, *l;
 
 		/* First remove all entries for this UID */
@@ -2065,6 +2703,14 @@ insert_contact (EBookBackendSqliteDB *ebsdb,
 		g_free (uid);
 	}
 
+	/* Update the substring indexes */
+	for (i = 0; success && i < priv->n_summary_fields; i++) {
+		if ((priv->summary_fields[i].index & INDEX_SUBSTRING) != 0)
+			success = insert_contact_trigrams (
+				ebsdb, contact, folderid,
+				&priv->summary_fields[i], error);
+	}
+
 	return success;
 }
 
@@ -2170,6 +2816,285 @@ e_book_backend_sqlitedb_new_contacts (EBookBackendSqliteDB *ebsdb,
 	return success;
 }
 
+typedef struct {
+	GPtrArray *names;
+	GPtrArray *statements;
+} IndexList;
+
+static gint
+collect_indexes_cb (gpointer ref,
+                    gint col,
+                    gchar **cols,
+                    gchar **name)
+{
+	IndexList *list = ref;
+	const gchar *sql = cols[1];
+
+	g_ptr_array_add (list->names, g_strdup (cols[0]));
+
+	/* SQLite keeps the statements without their IF NOT EXISTS clause,
+	 * which makes restoring the indexes safe to repeat if needed */
+	if (g_str_has_prefix (sql, "CREATE INDEX "))
+		g_ptr_array_add (
+			list->statements, g_strconcat (
+			"CREATE INDEX IF NOT EXISTS ",
+			sql + strlen ("CREATE INDEX "), NULL));
+	else
+		g_ptr_array_add (list->statements, g_strdup (sql));
+
+	return 0;
+}
+
+/* Creates the indexes recorded by a bulk load of the folder again and
+ * forgets about them.  Call with the lock held, in a transaction. */
+static gboolean
+restore_bulk_load_indexes (EBookBackendSqliteDB *ebsdb,
+                           const gchar *folderid,
+                           GError **error)
+{
+	GPtrArray *statements;
+	gboolean success;
+	gchar *stmt;
+	gint i;
+
+	statements = g_ptr_array_new_with_free_func (g_free);
+
+	stmt = sqlite3_mprintf (
+		"SELECT stmt FROM bulk_load_indexes WHERE folder_id = %Q",
+		folderid);
+	success = book_backend_sql_exec (
+		ebsdb->priv->db, stmt, collect_strings_cb, statements, error);
+	sqlite3_free (stmt);
+
+	for (i = 0; success && i < statements->len; i++)
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, g_ptr_array_index (statements, i),
+			NULL, NULL, error);
+
+	if (success && statements->len > 0) {
+		stmt = sqlite3_mprintf (
+			"DELETE FROM bulk_load_indexes WHERE folder_id = %Q",
+			folderid);
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+	}
+
+	g_ptr_array_unref (statements);
+
+	return success;
+}
+
+/**
+ * e_book_backend_sqlitedb_begin_bulk_load:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @folderid: folder id of the address-book
+ * @error: A location to store any error that may have occurred
+ *
+ * Prepares the address-book indicated by @folderid for adding a large
+ * number of contacts, such as when first populating a cache.
+ *
+ * The secondary indexes of the address-book are dropped until
+ * e_book_backend_sqlitedb_end_bulk_load() is called, so that adding
+ * contacts does not have to maintain them row by row, and writes are
+ * no longer synced to disk after every transaction. Contacts should be
+ * added in large batches with e_book_backend_sqlitedb_new_contacts(),
+ * each batch is stored in a single transaction.
+ *
+ * Searches still work during a bulk load but are slower. The dropped
+ * indexes are recorded in the database, so if the process exits before
+ * the bulk load is ended, they are created again the next time the
+ * address-book is opened.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_begin_bulk_load (EBookBackendSqliteDB *ebsdb,
+                                         const gchar *folderid,
+                                         GError **error)
+{
+	IndexList list;
+	GString *tables;
+	gboolean success;
+	gchar *stmt;
+	gint i;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+	g_return_val_if_fail (folderid != NULL, FALSE);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+
+	/* Already bulk loading this folder */
+	if (g_hash_table_contains (ebsdb->priv->bulk_loads, folderid)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		return TRUE;
+	}
+
+	if (!book_backend_sqlitedb_start_transaction (ebsdb, error)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		return FALSE;
+	}
+
+	/* The tables holding the summary of the folder */
+	stmt = sqlite3_mprintf ("%Q", folderid);
+	tables = g_string_new (stmt);
+	sqlite3_free (stmt);
+
+	if (ebsdb->priv->have_attr_list) {
+		gchar *lists_folder = g_strdup_printf ("%s_lists", folderid);
+
+		stmt = sqlite3_mprintf (", %Q", lists_folder);
+		g_string_append (tables, stmt);
+		sqlite3_free (stmt);
+		g_free (lists_folder);
+	}
+
+	for (i = 0; i < ebsdb->priv->n_summary_fields; i++) {
+		gchar *table;
+
+		if ((ebsdb->priv->summary_fields[i].index & INDEX_SUBSTRING) == 0)
+			continue;
+
+		table = trigram_table_name (folderid, ebsdb->priv->summary_fields[i].dbname);
+		stmt = sqlite3_mprintf (", %Q", table);
+		g_string_append (tables, stmt);
+		sqlite3_free (stmt);
+		g_free (table);
+	}
+
+	list.names = g_ptr_array_new_with_free_func (g_free);
+	list.statements = g_ptr_array_new_with_free_func (g_free);
+
+	/* Keep the implicit primary key indexes, which have no SQL, as
+	 * well as the uid indexes needed to replace and remove contacts */
+	stmt = sqlite3_mprintf (
+		"SELECT name, sql FROM sqlite_master WHERE type = 'index' "
+		"AND sql IS NOT NULL AND tbl_name IN (%s) "
+		"AND name != 'LISTINDEX' AND name NOT GLOB 'TUINDEX_*'",
+		tables->str);
+	success = book_backend_sql_exec (
+		ebsdb->priv->db, stmt, collect_indexes_cb, &list, error);
+	sqlite3_free (stmt);
+	g_string_free (tables, TRUE);
+
+	for (i = 0; success && i < list.names->len; i++) {
+		stmt = sqlite3_mprintf (
+			"INSERT INTO bulk_load_indexes (folder_id, stmt) "
+			"VALUES (%Q, %Q)", folderid,
+			g_ptr_array_index (list.statements, i));
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+
+		if (!success)
+			break;
+
+		stmt = sqlite3_mprintf (
+			"DROP INDEX %Q", g_ptr_array_index (list.names, i));
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+	}
+
+	if (success)
+		success = book_backend_sqlitedb_commit_transaction (ebsdb, error);
+	else
+		/* The GError is already set. */
+		book_backend_sqlitedb_rollback_transaction (ebsdb, NULL);
+
+	/* A crash during the bulk load loses nothing but the contacts
+	 * added so far, which are fetched again anyway */
+	if (success && g_hash_table_size (ebsdb->priv->bulk_loads) == 0) {
+		g_free (ebsdb->priv->bulk_load_synchronous);
+		ebsdb->priv->bulk_load_synchronous = NULL;
+
+		book_backend_sql_exec (
+			ebsdb->priv->db, "PRAGMA synchronous",
+			get_string_cb, &ebsdb->priv->bulk_load_synchronous, NULL);
+		book_backend_sql_exec (
+			ebsdb->priv->db, "PRAGMA synchronous = OFF",
+			NULL, NULL, NULL);
+	}
+
+	if (success)
+		g_hash_table_add (ebsdb->priv->bulk_loads, g_strdup (folderid));
+
+	g_ptr_array_unref (list.names);
+	g_ptr_array_unref (list.statements);
+
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	return success;
+}
+
+/**
+ * e_book_backend_sqlitedb_end_bulk_load:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @folderid: folder id of the address-book
+ * @error: A location to store any error that may have occurred
+ *
+ * Ends a bulk load started with e_book_backend_sqlitedb_begin_bulk_load(),
+ * creating the indexes of the address-book indicated by @folderid again
+ * in one pass over the added contacts.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_end_bulk_load (EBookBackendSqliteDB *ebsdb,
+                                       const gchar *folderid,
+                                       GError **error)
+{
+	gboolean success;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+	g_return_val_if_fail (folderid != NULL, FALSE);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+
+	if (!g_hash_table_contains (ebsdb->priv->bulk_loads, folderid)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		return TRUE;
+	}
+
+	if (!book_backend_sqlitedb_start_transaction (ebsdb, error)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		return FALSE;
+	}
+
+	success = restore_bulk_load_indexes (ebsdb, folderid, error);
+
+	if (success)
+		success = book_backend_sqlitedb_commit_transaction (ebsdb, error);
+	else
+		/* The GError is already set. */
+		book_backend_sqlitedb_rollback_transaction (ebsdb, NULL);
+
+	/* On failure the bulk load stays active, so it can be ended again */
+	if (success) {
+		g_hash_table_remove (ebsdb->priv->bulk_loads, folderid);
+
+		if (g_hash_table_size (ebsdb->priv->bulk_loads) == 0 &&
+		    ebsdb->priv->bulk_load_synchronous != NULL) {
+			gchar *stmt;
+
+			stmt = sqlite3_mprintf (
+				"PRAGMA synchronous = %s",
+				ebsdb->priv->bulk_load_synchronous);
+			book_backend_sql_exec (
+				ebsdb->priv->db, stmt, NULL, NULL, NULL);
+			sqlite3_free (stmt);
+		}
+	}
+
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	return success;
+}
+
 /**
  * e_book_backend_sqlitedb_add_contact
  * @ebsdb:
@@ -2309,6 +3234,7 @@ e_book_backend_sqlitedb_remove_contacts (EBookBackendSqliteDB *ebsdb,
 {
 	gboolean success = TRUE;
 	gchar *stmt;
+	gint i;
 
 	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
 	g_return_val_if_fail (folderid != NULL, FALSE);
@@ -2332,6 +3258,22 @@ e_book_backend_sqlitedb_remove_contacts (EBookBackendSqliteDB *ebsdb,
 		g_free (stmt);
 	}
 
+	for (i = 0; success && i < ebsdb->priv->n_summary_fields; i++) {
+		gchar *trigrams_table;
+
+		if ((ebsdb->priv->summary_fields[i].index & INDEX_SUBSTRING) == 0)
+			continue;
+
+		trigrams_table = trigram_table_name (
+			folderid, ebsdb->priv->summary_fields[i].dbname);
+
+		stmt = generate_delete_stmt (trigrams_table, uids);
+		g_free (trigrams_table);
+
+		success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
+		g_free (stmt);
+	}
+
 	if (success) {
 		stmt = generate_delete_stmt (folderid, uids);
 		success = book_backend_sql_exec (ebsdb->priv->db, stmt, NULL, NULL, error);
@@ -2683,7 +3625,7 @@ e_book_backend_sqlitedb_get_vcard_string (EBookBackendSqliteDB *ebsdb,
 	} else if (ebsdb->priv->store_vcard) {
 		stmt = sqlite3_mprintf (
 			"SELECT vcard FROM %Q WHERE uid = %Q", folderid, uid);
-		book_backend_sql_exec (
+		book_backend_sql_select (
 			ebsdb->priv->db, stmt,
 			get_vcard_cb , &vcard_str, error);
 		sqlite3_free (stmt);
@@ -3386,28 +4328,95 @@ field_oper (MatchType match)
 	return "LIKE";
 }
 
-static ESExpResult *
-convert_match_exp (struct _ESExp *f,
-                   gint argc,
-                   struct _ESExpResult **argv,
-                   gpointer data,
-                   MatchType match)
+/* Narrows a contains match down to the contacts holding every trigram
+ * of the term, so that the LIKE only runs on a few candidate rows.  An
+ * ends-with match is narrowed the same way, unless the reversed column
+ * of a suffix index serves it already.  Returns NULL if the field has
+ * no substring index or the term is too short to have any trigrams. */
+static gchar *
+substring_filter (EBookBackendSqliteDB *ebsdb,
+                  const gchar *folderid,
+                  const gchar *field_name_input,
+                  const gchar *query_term_input,
+                  MatchType match)
 {
-	BuildQueryData *qdata = (BuildQueryData *) data;
-	EBookBackendSqliteDB *ebsdb = qdata->ebsdb;
-	ESExpResult *r;
-	gchar *str = NULL;
+	GHashTable *trigrams;
+	GHashTableIter iter;
+	GString *string;
+	gpointer trigram;
+	gchar *normal, *table, *tmp;
+	gint summary_index;
+	guint n_trigrams;
 
-	/* are we inside a match-all? */
-	if (argc > 1 && argv[0]->type == ESEXP_RES_STRING) {
-		const gchar *field;
+	summary_index = summary_index_from_field_name (ebsdb, field_name_input);
+	if (summary_index < 0)
+		return NULL;
 
-		/* only a subset of headers are supported .. */
-		field = argv[0]->value.string;
+	if ((ebsdb->priv->summary_fields[summary_index].index & INDEX_SUBSTRING) == 0)
+		return NULL;
 
-		if (argv[1]->type == ESEXP_RES_STRING && argv[1]->value.string[0] != 0) {
+	if (match != MATCH_CONTAINS &&
+	    (match != MATCH_ENDS_WITH ||
+	     (ebsdb->priv->summary_fields[summary_index].index & INDEX_SUFFIX) != 0))
+		return NULL;
+
+	trigrams = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	normal = e_util_utf8_normalize (query_term_input);
+	collect_trigrams (trigrams, normal);
+	g_free (normal);
+
+	n_trigrams = g_hash_table_size (trigrams);
+	if (n_trigrams == 0) {
+		g_hash_table_destroy (trigrams);
+		return NULL;
+	}
+
+	table = trigram_table_name (
+		folderid, ebsdb->priv->summary_fields[summary_index].dbname);
+	tmp = sqlite3_mprintf ("summary.uid IN (SELECT uid FROM %Q WHERE trigram IN (", table);
+	string = g_string_new (tmp);
+	sqlite3_free (tmp);
+	g_free (table);
+
+	g_hash_table_iter_init (&iter, trigrams);
+	while (g_hash_table_iter_next (&iter, &trigram, NULL)) {
+		tmp = sqlite3_mprintf ("%Q", trigram);
+		if (string->str[string->len - 1] != '(')
+			g_string_append (string, ", ");
+		g_string_append (string, tmp);
+		sqlite3_free (tmp);
+	}
+
+	g_string_append_printf (
+		string, ") GROUP BY uid HAVING count(*) = %u) AND ", n_trigrams);
+
+	g_hash_table_destroy (trigrams);
+
+	return g_string_free (string, FALSE);
+}
+
+static ESExpResult *
+convert_match_exp (struct _ESExp *f,
+                   gint argc,
+                   struct _ESExpResult **argv,
+                   gpointer data,
+                   MatchType match)
+{
+	BuildQueryData *qdata = (BuildQueryData *) data;
+	EBookBackendSqliteDB *ebsdb = qdata->ebsdb;
+	ESExpResult *r;
+	gchar *str = NULL;
+
+	/* are we inside a match-all? */
+	if (argc > 1 && argv[0]->type == ESEXP_RES_STRING) {
+		const gchar *field;
+
+		/* only a subset of headers are supported .. */
+		field = argv[0]->value.string;
+
+		if (argv[1]->type == ESEXP_RES_STRING && argv[1]->value.string[0] != 0) {
 			const gchar *const oper = field_oper (match);
-			gchar *field_name, *query_term, *extra_term;
+			gchar *field_name, *query_term, *extra_term, *filter;
 
 			if (!g_ascii_strcasecmp (field, "full_name")) {
 				GString *names = g_string_new (NULL);
@@ -3416,9 +4425,14 @@ convert_match_exp (struct _ESExp *f,
 					ebsdb, qdata->folderid, "full_name",
 					argv[1]->value.string, NULL,
 					match, NULL, &query_term, NULL);
+				filter = substring_filter (
+					ebsdb, qdata->folderid, "full_name",
+					argv[1]->value.string, match);
 				g_string_append_printf (
-					names, "(%s IS NOT NULL AND %s %s %s)",
+					names, "(%s%s IS NOT NULL AND %s %s %s)",
+					filter ? filter : "",
 					field_name, field_name, oper, query_term);
+				g_free (filter);
 				g_free (field_name);
 				g_free (query_term);
 
@@ -3427,9 +4441,14 @@ convert_match_exp (struct _ESExp *f,
 						ebsdb, qdata->folderid, "family_name",
 						argv[1]->value.string, NULL,
 						match, NULL, &query_term, NULL);
+					filter = substring_filter (
+						ebsdb, qdata->folderid, "family_name",
+						argv[1]->value.string, match);
 					g_string_append_printf (
-						names, " OR (%s IS NOT NULL AND %s %s %s)",
+						names, " OR (%s%s IS NOT NULL AND %s %s %s)",
+						filter ? filter : "",
 						field_name, field_name, oper, query_term);
+					g_free (filter);
 					g_free (field_name);
 					g_free (query_term);
 				}
@@ -3439,9 +4458,14 @@ convert_match_exp (struct _ESExp *f,
 						ebsdb, qdata->folderid, "given_name",
 						argv[1]->value.string, NULL,
 						match, NULL, &query_term, NULL);
+					filter = substring_filter (
+						ebsdb, qdata->folderid, "given_name",
+						argv[1]->value.string, match);
 					g_string_append_printf (
-						names, " OR (%s IS NOT NULL AND %s %s %s)",
+						names, " OR (%s%s IS NOT NULL AND %s %s %s)",
+						filter ? filter : "",
 						field_name, field_name, oper, query_term);
+					g_free (filter);
 					g_free (field_name);
 					g_free (query_term);
 				}
@@ -3451,9 +4475,14 @@ convert_match_exp (struct _ESExp *f,
 						ebsdb, qdata->folderid, "nickname",
 						argv[1]->value.string, NULL,
 						match, NULL, &query_term, NULL);
+					filter = substring_filter (
+						ebsdb, qdata->folderid, "nickname",
+						argv[1]->value.string, match);
 					g_string_append_printf (
-						names, " OR (%s IS NOT NULL AND %s %s %s)",
+						names, " OR (%s%s IS NOT NULL AND %s %s %s)",
+						filter ? filter : "",
 						field_name, field_name, oper, query_term);
+					g_free (filter);
 					g_free (field_name);
 					g_free (query_term);
 				}
@@ -3478,21 +4507,28 @@ convert_match_exp (struct _ESExp *f,
 				 * should reduce the result set first before applying any user functions. This
 				 * is done by applying a seemingly redundant suffix match first.
 				 */
+				filter = substring_filter (
+					ebsdb, qdata->folderid, field,
+					argv[1]->value.string, match);
+
 				if (is_list) {
 					gchar *tmp;
 
 					tmp = sqlite3_mprintf ("multi.field = %Q", field);
 					str = g_strdup_printf (
-						"(%s AND (%s %s %s%s))",
+						"(%s%s AND (%s %s %s%s))",
+						filter ? filter : "",
 						tmp, field_name, oper, query_term,
 						extra_term ? extra_term : "");
 					sqlite3_free (tmp);
 				} else
 					str = g_strdup_printf (
-						"(%s IS NOT NULL AND (%s %s %s%s))",
+						"(%s%s IS NOT NULL AND (%s %s %s%s))",
+						filter ? filter : "",
 						field_name, field_name, oper, query_term,
 						extra_term ? extra_term : "");
 
+				g_free (filter);
 				g_free (field_name);
 				g_free (query_term);
 
@@ -3751,7 +4787,7 @@ book_backend_sqlitedb_search_query (EBookBackendSqliteDB *ebsdb,
 					"SELECT uid, vcard, bdata FROM %Q as summary WHERE %s", folderid, sql);
 			}
 
-			success = book_backend_sql_exec (
+			success = book_backend_sql_select (
 				ebsdb->priv->db, stmt,
 				addto_vcard_list_cb , &vcard_data, error);
 
@@ -3759,7 +4795,7 @@ book_backend_sqlitedb_search_query (EBookBackendSqliteDB *ebsdb,
 		} else {
 			stmt = sqlite3_mprintf (
 				"SELECT uid, vcard, bdata FROM %Q", folderid);
-			success = book_backend_sql_exec (
+			success = book_backend_sql_select (
 				ebsdb->priv->db, stmt,
 				addto_vcard_list_cb , &vcard_data, error);
 			sqlite3_free (stmt);
@@ -3796,7 +4832,7 @@ book_backend_sqlitedb_search_full (EBookBackendSqliteDB *ebsdb,
 	gchar *stmt;
 
 	stmt = sqlite3_mprintf ("SELECT uid, vcard, bdata FROM %Q", folderid);
-	success = book_backend_sql_exec (
+	success = book_backend_sql_select (
 		ebsdb->priv->db, stmt, addto_vcard_list_cb , &all, error);
 	sqlite3_free (stmt);
 
@@ -4085,6 +5121,50 @@ e_book_backend_sqlitedb_get_uids_and_rev (EBookBackendSqliteDB *ebsdb,
 	return uids_and_rev;
 }
 
+/**
+ * e_book_backend_sqlitedb_set_compress_vcards:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @compress_vcards: whether to compress the stored vCards
+ *
+ * Sets whether the full vCards of contacts added from now on are stored
+ * compressed. Compressed and plain vCards can be mixed in the same
+ * address-book, they are returned as plain vCard strings either way.
+ *
+ * Compression pays off most once inline photos are moved out of the
+ * vCards, as the file backend does before adding contacts.
+ *
+ * Since: 3.12
+ **/
+void
+e_book_backend_sqlitedb_set_compress_vcards (EBookBackendSqliteDB *ebsdb,
+                                             gboolean compress_vcards)
+{
+	g_return_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb));
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+	ebsdb->priv->compress_vcards = compress_vcards;
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+}
+
+/**
+ * e_book_backend_sqlitedb_get_compress_vcards:
+ * @ebsdb: An #EBookBackendSqliteDB
+ *
+ * Returns whether the full vCards of added contacts are stored compressed,
+ * see e_book_backend_sqlitedb_set_compress_vcards().
+ *
+ * Returns: %TRUE if vCards are compressed.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_get_compress_vcards (EBookBackendSqliteDB *ebsdb)
+{
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+
+	return ebsdb->priv->compress_vcards;
+}
+
 /**
  * e_book_backend_sqlitedb_get_is_populated:
  *
@@ -4162,6 +5242,83 @@ e_book_backend_sqlitedb_set_is_populated (EBookBackendSqliteDB *ebsdb,
 	return success;
 }
 
+/**
+ * e_book_backend_sqlitedb_set_locale:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @folderid: folder id of the address-book
+ * @error: A location to store any error that may have occurred
+ *
+ * Regenerates the collation keys used to sort cursors of the address-book
+ * indicated by @folderid, if they were made for another LC_COLLATE locale
+ * than the one the calling process runs in.
+ *
+ * Opening an address-book never does this by itself, since clients reading
+ * it directly may run in other locales, or lack write access.  Only the
+ * backend owning the address-book should call this, when its locale changed.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_set_locale (EBookBackendSqliteDB *ebsdb,
+                                    const gchar *folderid,
+                                    GError **error)
+{
+	const gchar *lc_collate;
+	gchar *stored_lc_collate = NULL;
+	gchar *stmt;
+	gboolean success;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+	g_return_val_if_fail (folderid != NULL, FALSE);
+
+	lc_collate = setlocale (LC_COLLATE, NULL);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+
+	stmt = sqlite3_mprintf (
+		"SELECT lc_collate FROM folders WHERE folder_id = %Q", folderid);
+	success = book_backend_sql_exec (
+		ebsdb->priv->db, stmt, get_string_cb, &stored_lc_collate, error);
+	sqlite3_free (stmt);
+
+	if (!success || g_strcmp0 (stored_lc_collate, lc_collate) == 0) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		g_free (stored_lc_collate);
+		return success;
+	}
+
+	if (!book_backend_sqlitedb_start_transaction (ebsdb, error)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		g_free (stored_lc_collate);
+		return FALSE;
+	}
+
+	success = upgrade_contacts_table (ebsdb, folderid, error);
+
+	if (success) {
+		stmt = sqlite3_mprintf (
+			"UPDATE folders SET lc_collate = %Q WHERE folder_id = %Q",
+			lc_collate, folderid);
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+	}
+
+	if (success)
+		success = book_backend_sqlitedb_commit_transaction (ebsdb, error);
+	else
+		/* The GError is already set. */
+		book_backend_sqlitedb_rollback_transaction (ebsdb, NULL);
+
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	g_free (stored_lc_collate);
+
+	return success;
+}
+
 /**
  * e_book_backend_sqlitedb_get_revision:
  * @ebsdb: An #EBookBackendSqliteDB
@@ -4625,6 +5782,7 @@ e_book_backend_sqlitedb_delete_addressbook (EBookBackendSqliteDB *ebsdb,
 {
 	gchar *stmt;
 	gboolean success;
+	gint i;
 
 	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
 	g_return_val_if_fail (folderid != NULL, FALSE);
@@ -4636,6 +5794,24 @@ e_book_backend_sqlitedb_delete_addressbook (EBookBackendSqliteDB *ebsdb,
 		return FALSE;
 	}
 
+	/* delete the substring index tables, they reference the contacts table */
+	for (i = 0; i < ebsdb->priv->n_summary_fields; i++) {
+		gchar *table;
+
+		if ((ebsdb->priv->summary_fields[i].index & INDEX_SUBSTRING) == 0)
+			continue;
+
+		table = trigram_table_name (folderid, ebsdb->priv->summary_fields[i].dbname);
+		stmt = sqlite3_mprintf ("DROP TABLE IF EXISTS %Q", table);
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, stmt, NULL, NULL, error);
+		sqlite3_free (stmt);
+		g_free (table);
+
+		if (!success)
+			goto rollback;
+	}
+
 	/* delete the contacts table */
 	stmt = sqlite3_mprintf ("DROP TABLE %Q ", folderid);
 	success = book_backend_sql_exec (
@@ -4652,6 +5828,16 @@ e_book_backend_sqlitedb_delete_addressbook (EBookBackendSqliteDB *ebsdb,
 		ebsdb->priv->db, stmt, NULL, NULL, error);
 	sqlite3_free (stmt);
 
+	if (!success)
+		goto rollback;
+
+	/* and the indexes of an unfinished bulk load */
+	stmt = sqlite3_mprintf (
+		"DELETE FROM bulk_load_indexes WHERE folder_id = %Q", folderid);
+	success = book_backend_sql_exec (
+		ebsdb->priv->db, stmt, NULL, NULL, error);
+	sqlite3_free (stmt);
+
 	if (!success)
 		goto rollback;
 
@@ -4717,6 +5903,16 @@ e_book_backend_sqlitedb_remove (EBookBackendSqliteDB *ebsdb,
 
 	sqlite3_close (ebsdb->priv->db);
 
+	/* The write-ahead log and its index are normally removed when the
+	 * last connection closes, but may be left behind by direct readers */
+	filename = g_build_filename (ebsdb->priv->path, DB_FILENAME "-wal", NULL);
+	g_unlink (filename);
+	g_free (filename);
+
+	filename = g_build_filename (ebsdb->priv->path, DB_FILENAME "-shm", NULL);
+	g_unlink (filename);
+	g_free (filename);
+
 	filename = g_build_filename (ebsdb->priv->path, DB_FILENAME, NULL);
 	ret = g_unlink (filename);
 	g_free (filename);
@@ -4751,7 +5947,7 @@ upgrade_contacts_table (EBookBackendSqliteDB *ebsdb,
 	gchar *default_region = NULL;
 
 	stmt = sqlite3_mprintf ("SELECT uid, vcard, NULL FROM %Q", folderid);
-	success = book_backend_sql_exec (
+	success = book_backend_sql_select (
 		ebsdb->priv->db, stmt, addto_vcard_list_cb, &vcard_data, error);
 	sqlite3_free (stmt);
 
@@ -4793,3 +5989,671 @@ upgrade_contacts_table (EBookBackendSqliteDB *ebsdb,
 
 	return success;
 }
+
+/******************************************************************
+ *                          Cursor API                            *
+ ******************************************************************/
+
+typedef struct {
+	gchar **values;            /* The collation keys of the current position */
+	gchar  *last_uid;          /* The UID of the current contact, NULL if the
+	                            * position was set by an alphabetic index */
+	EBookCursorOrigin position; /* Whether the state is at the beginning,
+	                            * the end or somewhere in between */
+} CursorState;
+
+struct _EbSdbCursor {
+	gchar               *folderid;
+	gchar               *sexp;          /* The original sexp, or NULL */
+	gchar               *query;         /* The SQL for the sexp, or NULL */
+	gboolean             with_list_attrs;
+
+	EContactField       *sort_fields;
+	EBookCursorSortType *sort_types;
+	gchar              **columns;       /* The collation key column of each sort field */
+	gint                 n_sort_fields;
+
+	CursorState          state;
+};
+
+typedef struct {
+	GSList *results; /* EbSdbSearchData, in reverse order */
+	gchar **values;  /* The collation keys of the last row */
+	gchar  *uid;     /* The UID of the last row */
+	gint    n_keys;
+	gint    n_rows;
+} CursorStepData;
+
+static gpointer
+sqlitedb_alphabet_init (gpointer unused)
+{
+	/* Translators: This is the list of labels used to navigate
+	 * the address book alphabetically, separated by spaces and
+	 * listed in the sort order of your locale. */
+	return g_strsplit (_("A B C D E F G H I J K L M N O P Q R S T U V W X Y Z"), " ", -1);
+}
+
+static const gchar * const *
+sqlitedb_get_alphabet (void)
+{
+	static GOnce alphabet_once = G_ONCE_INIT;
+
+	g_once (&alphabet_once, sqlitedb_alphabet_init, NULL);
+
+	return alphabet_once.retval;
+}
+
+static void
+cursor_state_clear (EbSdbCursor *cursor,
+                    CursorState *state,
+                    EBookCursorOrigin position)
+{
+	gint i;
+
+	for (i = 0; i < cursor->n_sort_fields; i++) {
+		g_free (state->values[i]);
+		state->values[i] = NULL;
+	}
+
+	g_free (state->last_uid);
+	state->last_uid = NULL;
+	state->position = position;
+}
+
+/* Builds the condition matching the contacts which come after
+ * the cursor state in the given direction, in sort order */
+static gchar *
+cursor_constraint (EbSdbCursor *cursor,
+                   CursorState *state,
+                   gboolean forward)
+{
+	gchar *constraint;
+	gint i;
+
+	g_return_val_if_fail (state->position == E_BOOK_CURSOR_ORIGIN_CURRENT, NULL);
+
+	/* A position set by an alphabetic index sits in between contacts,
+	 * right before those sorting at or after the key */
+	if (state->last_uid == NULL) {
+		gboolean key_ascending;
+
+		key_ascending = forward ==
+			(cursor->sort_types[0] == E_BOOK_CURSOR_SORT_ASCENDING);
+
+		if (state->values[0] == NULL)
+			return sqlite3_mprintf ("%s", key_ascending ? "0" : "1");
+
+		return sqlite3_mprintf (
+			"summary.%s %s %Q", cursor->columns[0],
+			key_ascending ? ">=" : "<", state->values[0]);
+	}
+
+	/* Otherwise compare the tuple of the sort keys lexicographically,
+	 * with the UID breaking any remaining ties */
+	constraint = sqlite3_mprintf (
+		"summary.uid %s %Q", forward ? ">" : "<", state->last_uid);
+
+	for (i = cursor->n_sort_fields - 1; i >= 0; i--) {
+		gchar *tmp = constraint;
+		const gchar *op;
+
+		if (forward == (cursor->sort_types[i] == E_BOOK_CURSOR_SORT_ASCENDING))
+			op = ">";
+		else
+			op = "<";
+
+		constraint = sqlite3_mprintf (
+			"(summary.%s %s %Q OR (summary.%s = %Q AND %s))",
+			cursor->columns[i], op, state->values[i],
+			cursor->columns[i], state->values[i], tmp);
+		sqlite3_free (tmp);
+	}
+
+	return constraint;
+}
+
+static void
+cursor_append_from_clause (EbSdbCursor *cursor,
+                           GString *string)
+{
+	gchar *str;
+
+	if (cursor->with_list_attrs) {
+		gchar *list_table = g_strconcat (cursor->folderid, "_lists", NULL);
+
+		str = sqlite3_mprintf (
+			" FROM %Q AS summary "
+			"LEFT OUTER JOIN %Q AS multi ON summary.uid = multi.uid",
+			cursor->folderid, list_table);
+		g_free (list_table);
+	} else {
+		str = sqlite3_mprintf (" FROM %Q AS summary", cursor->folderid);
+	}
+
+	g_string_append (string, str);
+	sqlite3_free (str);
+}
+
+static gint
+cursor_step_cb (gpointer ref,
+                gint col,
+                gchar **cols,
+                gchar **name)
+{
+	CursorStepData *data = ref;
+	EbSdbSearchData *s_data = g_slice_new0 (EbSdbSearchData);
+	gint i;
+
+	s_data->uid = g_strdup (cols[0]);
+	s_data->vcard = g_strdup (cols[1]);
+	s_data->bdata = g_strdup (cols[2]);
+
+	data->results = g_slist_prepend (data->results, s_data);
+
+	for (i = 0; i < data->n_keys; i++) {
+		g_free (data->values[i]);
+		data->values[i] = g_strdup (cols[3 + i]);
+	}
+
+	g_free (data->uid);
+	data->uid = g_strdup (cols[0]);
+	data->n_rows++;
+
+	return 0;
+}
+
+static gint
+cursor_count_cb (gpointer ref,
+                 gint col,
+                 gchar **cols,
+                 gchar **name)
+{
+	gint *ret = ref;
+
+	*ret = cols[0] ? strtoul (cols[0], NULL, 10) : 0;
+
+	return 0;
+}
+
+static gboolean
+cursor_set_sexp_locked (EBookBackendSqliteDB *ebsdb,
+                        EbSdbCursor *cursor,
+                        const gchar *sexp,
+                        GError **error)
+{
+	gboolean with_list_attrs = FALSE;
+	gboolean unsupported = FALSE;
+	gboolean invalid = FALSE;
+
+	if (sexp && !*sexp)
+		sexp = NULL;
+
+	if (sexp && !e_book_backend_sqlitedb_check_summary_query_locked (
+		ebsdb, sexp, &with_list_attrs, &unsupported, &invalid)) {
+		if (invalid)
+			g_set_error (
+				error, E_BOOK_SDB_ERROR, E_BOOK_SDB_ERROR_INVALID_QUERY,
+				_("Invalid Query"));
+		else
+			g_set_error (
+				error, E_BOOK_SDB_ERROR, E_BOOK_SDB_ERROR_NOT_SUPPORTED,
+				_("Only summary queries are supported by cursors"));
+		return FALSE;
+	}
+
+	g_free (cursor->sexp);
+	g_free (cursor->query);
+
+	cursor->sexp = g_strdup (sexp);
+	cursor->query = sexp ? sexp_to_sql_query (ebsdb, cursor->folderid, sexp) : NULL;
+	cursor->with_list_attrs = with_list_attrs;
+
+	return TRUE;
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_new:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @folderid: folder id of the address-book
+ * @sexp: (allow-none): a summary query to filter the contacts with
+ * @sort_fields: (array length=n_sort_fields): the fields to sort by
+ * @sort_types: (array length=n_sort_fields): the sort direction of each field
+ * @n_sort_fields: the number of fields to sort by
+ * @error: A location to store any error that may have occurred
+ *
+ * Creates a cursor which traverses the contacts matching @sexp in the
+ * order given by @sort_fields, compared with the collation rules of the
+ * current locale. The sort fields must be string fields which are part
+ * of the summary, and @sexp must be a summary query.
+ *
+ * The cursor initially sits at %E_BOOK_CURSOR_ORIGIN_BEGIN, use
+ * e_book_backend_sqlitedb_cursor_step() to traverse the contacts.
+ *
+ * Returns: (transfer full): A newly allocated #EbSdbCursor, to be freed with
+ * e_book_backend_sqlitedb_cursor_free(), or %NULL on error.
+ *
+ * Since: 3.12
+ **/
+EbSdbCursor *
+e_book_backend_sqlitedb_cursor_new (EBookBackendSqliteDB *ebsdb,
+                                    const gchar *folderid,
+                                    const gchar *sexp,
+                                    const EContactField *sort_fields,
+                                    const EBookCursorSortType *sort_types,
+                                    guint n_sort_fields,
+                                    GError **error)
+{
+	EbSdbCursor *cursor;
+	gint i, j;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), NULL);
+	g_return_val_if_fail (folderid != NULL, NULL);
+	g_return_val_if_fail (sort_fields != NULL, NULL);
+	g_return_val_if_fail (sort_types != NULL, NULL);
+	g_return_val_if_fail (n_sort_fields > 0, NULL);
+
+	if (!ebsdb->priv->store_vcard) {
+		g_set_error (
+			error, E_BOOK_SDB_ERROR, E_BOOK_SDB_ERROR_NOT_SUPPORTED,
+			_("Cannot create a cursor without stored vCards"));
+		return NULL;
+	}
+
+	for (i = 0; i < n_sort_fields; i++) {
+		for (j = 0; j < ebsdb->priv->n_summary_fields; j++) {
+			if (ebsdb->priv->summary_fields[j].field == sort_fields[i])
+				break;
+		}
+
+		if (j == ebsdb->priv->n_summary_fields ||
+		    !SUMMARY_FIELD_HAS_KEY (&ebsdb->priv->summary_fields[j])) {
+			g_set_error (
+				error, E_BOOK_SDB_ERROR, E_BOOK_SDB_ERROR_NOT_SUPPORTED,
+				_("Cannot sort by a field which is not a string in the summary: %s"),
+				e_contact_field_name (sort_fields[i]));
+			return NULL;
+		}
+	}
+
+	cursor = g_slice_new0 (EbSdbCursor);
+	cursor->folderid = g_strdup (folderid);
+	cursor->n_sort_fields = n_sort_fields;
+	cursor->sort_fields = g_memdup (sort_fields, sizeof (EContactField) * n_sort_fields);
+	cursor->sort_types = g_memdup (sort_types, sizeof (EBookCursorSortType) * n_sort_fields);
+	cursor->columns = g_new0 (gchar *, n_sort_fields + 1);
+	cursor->state.values = g_new0 (gchar *, n_sort_fields);
+	cursor->state.position = E_BOOK_CURSOR_ORIGIN_BEGIN;
+
+	for (i = 0; i < n_sort_fields; i++)
+		cursor->columns[i] = g_strconcat (
+			summary_dbname_from_field (ebsdb, sort_fields[i]),
+			"_localized", NULL);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+
+	if (!cursor_set_sexp_locked (ebsdb, cursor, sexp, error)) {
+		UNLOCK_MUTEX (&ebsdb->priv->lock);
+		e_book_backend_sqlitedb_cursor_free (ebsdb, cursor);
+		return NULL;
+	}
+
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	return cursor;
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_free:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @cursor: The #EbSdbCursor to free
+ *
+ * Frees @cursor.
+ *
+ * Since: 3.12
+ **/
+void
+e_book_backend_sqlitedb_cursor_free (EBookBackendSqliteDB *ebsdb,
+                                     EbSdbCursor *cursor)
+{
+	g_return_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb));
+
+	if (cursor) {
+		cursor_state_clear (cursor, &cursor->state, E_BOOK_CURSOR_ORIGIN_BEGIN);
+		g_free (cursor->state.values);
+
+		g_free (cursor->folderid);
+		g_free (cursor->sexp);
+		g_free (cursor->query);
+		g_free (cursor->sort_fields);
+		g_free (cursor->sort_types);
+		g_strfreev (cursor->columns);
+
+		g_slice_free (EbSdbCursor, cursor);
+	}
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_set_sexp:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @cursor: The #EbSdbCursor to modify
+ * @sexp: (allow-none): the new summary query, or %NULL to match all contacts
+ * @error: A location to store any error that may have occurred
+ *
+ * Changes the query which filters the contacts traversed by @cursor.
+ * The position of the cursor is preserved.
+ *
+ * Returns: %TRUE on success, otherwise %FALSE is returned and @error is set.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_cursor_set_sexp (EBookBackendSqliteDB *ebsdb,
+                                         EbSdbCursor *cursor,
+                                         const gchar *sexp,
+                                         GError **error)
+{
+	gboolean success;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+	g_return_val_if_fail (cursor != NULL, FALSE);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+	success = cursor_set_sexp_locked (ebsdb, cursor, sexp, error);
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	return success;
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_step:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @cursor: The #EbSdbCursor to use
+ * @flags: The #EBookCursorStepFlags for this step
+ * @origin: The #EBookCursorOrigin from whence to step
+ * @count: A positive or negative amount of contacts to try and fetch
+ * @results: (out) (allow-none) (element-type EbSdbSearchData) (transfer full):
+ *   A return location to store the results, or %NULL if %E_BOOK_CURSOR_STEP_FETCH
+ *   is not specified in %flags
+ * @error: A location to store any error that may have occurred
+ *
+ * Steps @cursor through its sorted query by a maximum of @count contacts
+ * starting from @origin. A positive @count steps forward, a negative one
+ * backward through the sort order.
+ *
+ * If %E_BOOK_CURSOR_STEP_FETCH is specified, the traversed contacts are
+ * returned in @results, in the order they were traversed. The list should
+ * be freed with e_book_backend_sqlitedb_search_data_free() on each element.
+ *
+ * If %E_BOOK_CURSOR_STEP_MOVE is specified, the cursor is left on the last
+ * traversed contact, or at the end (or beginning) if the query ran out of
+ * contacts before @count was reached.
+ *
+ * The queries are evaluated against the database as it is at the time of
+ * the step, so a cursor is never invalidated by changes in the address
+ * book; contacts added or removed before its position are simply skipped.
+ *
+ * Returns: The number of contacts traversed, or -1 on error.
+ *
+ * Since: 3.12
+ **/
+gint
+e_book_backend_sqlitedb_cursor_step (EBookBackendSqliteDB *ebsdb,
+                                     EbSdbCursor *cursor,
+                                     EBookCursorStepFlags flags,
+                                     EBookCursorOrigin origin,
+                                     gint count,
+                                     GSList **results,
+                                     GError **error)
+{
+	CursorState *state;
+	CursorStepData data = { NULL, };
+	GString *string;
+	gboolean forward = count > 0;
+	gboolean success;
+	gchar *constraint = NULL;
+	gint i;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), -1);
+	g_return_val_if_fail (cursor != NULL, -1);
+	g_return_val_if_fail ((flags & E_BOOK_CURSOR_STEP_FETCH) == 0 ||
+			      (results != NULL && *results == NULL), -1);
+
+	state = &cursor->state;
+
+	/* Reset the cursor state to the requested origin */
+	if (origin != E_BOOK_CURSOR_ORIGIN_CURRENT &&
+	    (flags & E_BOOK_CURSOR_STEP_MOVE) != 0)
+		cursor_state_clear (cursor, state, origin);
+	else if (origin == E_BOOK_CURSOR_ORIGIN_CURRENT)
+		origin = state->position;
+
+	/* Nothing to traverse beyond the ends */
+	if (count == 0 ||
+	    (forward && origin == E_BOOK_CURSOR_ORIGIN_END) ||
+	    (!forward && origin == E_BOOK_CURSOR_ORIGIN_BEGIN))
+		return 0;
+
+	if (origin == E_BOOK_CURSOR_ORIGIN_CURRENT)
+		constraint = cursor_constraint (cursor, state, forward);
+
+	string = g_string_new (
+		cursor->with_list_attrs ? "SELECT DISTINCT " : "SELECT ");
+	g_string_append (string, "summary.uid, summary.vcard, summary.bdata");
+	for (i = 0; i < cursor->n_sort_fields; i++)
+		g_string_append_printf (string, ", summary.%s", cursor->columns[i]);
+
+	cursor_append_from_clause (cursor, string);
+
+	if (cursor->query && constraint)
+		g_string_append_printf (string, " WHERE (%s) AND (%s)", cursor->query, constraint);
+	else if (cursor->query)
+		g_string_append_printf (string, " WHERE %s", cursor->query);
+	else if (constraint)
+		g_string_append_printf (string, " WHERE %s", constraint);
+
+	g_string_append (string, " ORDER BY ");
+	for (i = 0; i < cursor->n_sort_fields; i++) {
+		gboolean ascending;
+
+		ascending = forward ==
+			(cursor->sort_types[i] == E_BOOK_CURSOR_SORT_ASCENDING);
+
+		g_string_append_printf (
+			string, "summary.%s %s, ", cursor->columns[i],
+			ascending ? "ASC" : "DESC");
+	}
+	g_string_append_printf (
+		string, "summary.uid %s LIMIT %d",
+		forward ? "ASC" : "DESC", ABS (count));
+
+	sqlite3_free (constraint);
+
+	data.n_keys = cursor->n_sort_fields;
+	data.values = g_new0 (gchar *, cursor->n_sort_fields);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+	success = book_backend_sql_select (
+		ebsdb->priv->db, string->str, cursor_step_cb, &data, error);
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	g_string_free (string, TRUE);
+
+	if (success && (flags & E_BOOK_CURSOR_STEP_MOVE) != 0) {
+		if (data.n_rows < ABS (count)) {
+			cursor_state_clear (
+				cursor, state, forward ?
+				E_BOOK_CURSOR_ORIGIN_END :
+				E_BOOK_CURSOR_ORIGIN_BEGIN);
+		} else {
+			cursor_state_clear (cursor, state, E_BOOK_CURSOR_ORIGIN_CURRENT);
+
+			for (i = 0; i < cursor->n_sort_fields; i++) {
+				state->values[i] = data.values[i];
+				data.values[i] = NULL;
+			}
+
+			state->last_uid = data.uid;
+			data.uid = NULL;
+		}
+	}
+
+	if (success && (flags & E_BOOK_CURSOR_STEP_FETCH) != 0) {
+		*results = g_slist_reverse (data.results);
+		data.results = NULL;
+	}
+
+	g_slist_free_full (
+		data.results,
+		(GDestroyNotify) e_book_backend_sqlitedb_search_data_free);
+	for (i = 0; i < cursor->n_sort_fields; i++)
+		g_free (data.values[i]);
+	g_free (data.values);
+	g_free (data.uid);
+
+	return success ? data.n_rows : -1;
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_set_target_alphabetic_index:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @cursor: The #EbSdbCursor to modify
+ * @idx: The alphabetic index
+ *
+ * Positions @cursor right before the contacts whose primary sort key
+ * starts with the label at @idx of the alphabet returned by
+ * e_book_backend_sqlitedb_get_alphabet(), so that the next step forward
+ * fetches them first.
+ *
+ * Since: 3.12
+ **/
+void
+e_book_backend_sqlitedb_cursor_set_target_alphabetic_index (EBookBackendSqliteDB *ebsdb,
+                                                            EbSdbCursor *cursor,
+                                                            gint idx)
+{
+	const gchar * const *alphabet;
+	gint n_labels;
+
+	g_return_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb));
+	g_return_if_fail (cursor != NULL);
+
+	alphabet = e_book_backend_sqlitedb_get_alphabet (ebsdb, &n_labels);
+	g_return_if_fail (idx >= 0 && idx < n_labels);
+
+	cursor_state_clear (cursor, &cursor->state, E_BOOK_CURSOR_ORIGIN_CURRENT);
+
+	/* When sorting in descending order, the contacts starting with
+	 * the label sort right before those starting with the next one */
+	if (cursor->sort_types[0] == E_BOOK_CURSOR_SORT_DESCENDING)
+		idx++;
+
+	if (idx < n_labels)
+		cursor->state.values[0] = summary_collation_key (alphabet[idx]);
+}
+
+/**
+ * e_book_backend_sqlitedb_cursor_calculate:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @cursor: The #EbSdbCursor
+ * @total: (out) (allow-none): A return location to store the total result set for this cursor
+ * @position: (out) (allow-none): A return location to store the cursor position
+ * @error: A location to store any error that may have occurred
+ *
+ * Calculates the total amount of contacts matching the query of @cursor,
+ * and the position of @cursor in them. The position is 0 at the
+ * beginning, @total + 1 at the end, and otherwise the number of contacts
+ * up to and including the one @cursor sits on.
+ *
+ * Returns: %TRUE on success, otherwise %FALSE is returned and @error is set.
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_book_backend_sqlitedb_cursor_calculate (EBookBackendSqliteDB *ebsdb,
+                                          EbSdbCursor *cursor,
+                                          gint *total,
+                                          gint *position,
+                                          GError **error)
+{
+	GString *string;
+	gint local_total = 0;
+	gint local_position = 0;
+	gboolean success;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), FALSE);
+	g_return_val_if_fail (cursor != NULL, FALSE);
+
+	string = g_string_new ("SELECT count(DISTINCT summary.uid)");
+	cursor_append_from_clause (cursor, string);
+	if (cursor->query)
+		g_string_append_printf (string, " WHERE %s", cursor->query);
+
+	LOCK_MUTEX (&ebsdb->priv->lock);
+
+	/* Keep the two counts consistent with each other */
+	success = book_backend_sqlitedb_start_transaction (ebsdb, error);
+
+	if (success)
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, string->str, cursor_count_cb, &local_total, error);
+
+	if (success && cursor->state.position == E_BOOK_CURSOR_ORIGIN_CURRENT) {
+		gchar *constraint;
+
+		/* Everything not coming after the cursor is at or before it */
+		constraint = cursor_constraint (cursor, &cursor->state, TRUE);
+		g_string_append_printf (
+			string, " %s NOT (%s)",
+			cursor->query ? "AND" : "WHERE", constraint);
+		sqlite3_free (constraint);
+
+		success = book_backend_sql_exec (
+			ebsdb->priv->db, string->str, cursor_count_cb, &local_position, error);
+	} else if (cursor->state.position == E_BOOK_CURSOR_ORIGIN_END) {
+		local_position = local_total + 1;
+	}
+
+	if (success)
+		success = book_backend_sqlitedb_commit_transaction (ebsdb, error);
+	else
+		book_backend_sqlitedb_rollback_transaction (ebsdb, NULL);
+
+	UNLOCK_MUTEX (&ebsdb->priv->lock);
+
+	g_string_free (string, TRUE);
+
+	if (success && total)
+		*total = local_total;
+	if (success && position)
+		*position = local_position;
+
+	return success;
+}
+
+/**
+ * e_book_backend_sqlitedb_get_alphabet:
+ * @ebsdb: An #EBookBackendSqliteDB
+ * @n_labels: (out): A return location for the number of labels
+ *
+ * Fetches the labels of the alphabet used for
+ * e_book_backend_sqlitedb_cursor_set_target_alphabetic_index(),
+ * in the sort order of the current locale.
+ *
+ * Returns: (array length=n_labels) (transfer none): The alphabet labels
+ *
+ * Since: 3.12
+ **/
+const gchar * const *
+e_book_backend_sqlitedb_get_alphabet (EBookBackendSqliteDB *ebsdb,
+                                      gint *n_labels)
+{
+	const gchar * const *alphabet;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), NULL);
+	g_return_val_if_fail (n_labels != NULL, NULL);
+
+	alphabet = sqlitedb_get_alphabet ();
+	*n_labels = g_strv_length ((gchar **) alphabet);
+
+	return alphabet;
+}
@@ -115,6 +115,15 @@ typedef struct {
 	gchar *bdata;
 } EbSdbSearchData;
 
+/**
+ * EbSdbCursor:
+ *
+ * An opaque cursor pointer, created with e_book_backend_sqlitedb_cursor_new().
+ *
+ * Since: 3.12
+ **/
+typedef struct _EbSdbCursor EbSdbCursor;
+
 GType		e_book_backend_sqlitedb_get_type
 						(void) G_GNUC_CONST;
 GQuark          e_book_backend_sqlitedb_error_quark
@@ -154,6 +163,14 @@ gboolean	e_book_backend_sqlitedb_new_contacts
 						 GSList *contacts,
 						 gboolean replace_existing,
 						 GError **error);
+gboolean	e_book_backend_sqlitedb_begin_bulk_load
+						(EBookBackendSqliteDB *ebsdb,
+						 const gchar *folderid,
+						 GError **error);
+gboolean	e_book_backend_sqlitedb_end_bulk_load
+						(EBookBackendSqliteDB *ebsdb,
+						 const gchar *folderid,
+						 GError **error);
 gboolean	e_book_backend_sqlitedb_remove_contact
 						(EBookBackendSqliteDB *ebsdb,
 						 const gchar *folderid,
@@ -201,6 +218,11 @@ GHashTable *	e_book_backend_sqlitedb_get_uids_and_rev
 						(EBookBackendSqliteDB *ebsdb,
 						 const gchar *folderid,
 						 GError **error);
+void		e_book_backend_sqlitedb_set_compress_vcards
+						(EBookBackendSqliteDB *ebsdb,
+						 gboolean compress_vcards);
+gboolean	e_book_backend_sqlitedb_get_compress_vcards
+						(EBookBackendSqliteDB *ebsdb);
 gboolean	e_book_backend_sqlitedb_get_is_populated
 						(EBookBackendSqliteDB *ebsdb,
 						 const gchar *folderid,
@@ -210,6 +232,10 @@ gboolean	e_book_backend_sqlitedb_set_is_populated
 						 const gchar *folderid,
 						 gboolean populated,
 						 GError **error);
+gboolean	e_book_backend_sqlitedb_set_locale
+						(EBookBackendSqliteDB *ebsdb,
+						 const gchar *folderid,
+						 GError **error);
 gboolean	e_book_backend_sqlitedb_get_revision
 						(EBookBackendSqliteDB *ebsdb,
 						 const gchar *folderid,
@@ -280,6 +306,47 @@ gboolean        e_book_backend_sqlitedb_check_summary_fields
                                                 (EBookBackendSqliteDB *ebsdb,
 						 GHashTable *fields_of_interest);
 
+
+/* Cursor API */
+EbSdbCursor *	e_book_backend_sqlitedb_cursor_new
+						(EBookBackendSqliteDB *ebsdb,
+						 const gchar *folderid,
+						 const gchar *sexp,
+						 const EContactField *sort_fields,
+						 const EBookCursorSortType *sort_types,
+						 guint n_sort_fields,
+						 GError **error);
+void		e_book_backend_sqlitedb_cursor_free
+						(EBookBackendSqliteDB *ebsdb,
+						 EbSdbCursor *cursor);
+gboolean	e_book_backend_sqlitedb_cursor_set_sexp
+						(EBookBackendSqliteDB *ebsdb,
+						 EbSdbCursor *cursor,
+						 const gchar *sexp,
+						 GError **error);
+gint		e_book_backend_sqlitedb_cursor_step
+						(EBookBackendSqliteDB *ebsdb,
+						 EbSdbCursor *cursor,
+						 EBookCursorStepFlags flags,
+						 EBookCursorOrigin origin,
+						 gint count,
+						 GSList **results,
+						 GError **error);
+void		e_book_backend_sqlitedb_cursor_set_target_alphabetic_index
+						(EBookBackendSqliteDB *ebsdb,
+						 EbSdbCursor *cursor,
+						 gint idx);
+gboolean	e_book_backend_sqlitedb_cursor_calculate
+						(EBookBackendSqliteDB *ebsdb,
+						 EbSdbCursor *cursor,
+						 gint *total,
+						 gint *position,
+						 GError **error);
+const gchar * const *
+		e_book_backend_sqlitedb_get_alphabet
+						(EBookBackendSqliteDB *ebsdb,
+						 gint *n_labels);
+
 #ifndef EDS_DISABLE_DEPRECATED
 gboolean	e_book_backend_sqlitedb_is_summary_query
 						(const gchar *query);
@@ -3094,6 +3094,52 @@ e_book_backend_configure_direct (EBookBackend *backend,
 		E_BOOK_BACKEND_GET_CLASS (backend)->configure_direct (backend, config);
 }
 
+/**
+ * e_book_backend_create_cursor:
+ * @backend: an #EBookBackend
+ * @sort_fields: (array length=n_fields): the fields to sort the contacts by
+ * @sort_types: (array length=n_fields): the sort direction of each field
+ * @n_fields: the number of fields to sort by
+ * @error: return location for a #GError, or %NULL
+ *
+ * Creates an #EDataBookCursor which traverses the contacts of @backend
+ * sorted by @sort_fields. If @backend does not support cursors, the
+ * function will set an %E_CLIENT_ERROR_NOT_SUPPORTED error and return
+ * %NULL.
+ *
+ * Returns: (transfer full): a new #EDataBookCursor, or %NULL on failure
+ *
+ * Since: 3.12
+ **/
+EDataBookCursor *
+e_book_backend_create_cursor (EBookBackend *backend,
+                              const EContactField *sort_fields,
+                              const EBookCursorSortType *sort_types,
+                              guint n_fields,
+                              GError **error)
+{
+	EBookBackendClass *class;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND (backend), NULL);
+	g_return_val_if_fail (sort_fields != NULL, NULL);
+	g_return_val_if_fail (sort_types != NULL, NULL);
+	g_return_val_if_fail (n_fields > 0, NULL);
+
+	class = E_BOOK_BACKEND_GET_CLASS (backend);
+
+	if (class->create_cursor == NULL) {
+		g_set_error_literal (
+			error, E_CLIENT_ERROR,
+			E_CLIENT_ERROR_NOT_SUPPORTED,
+			e_client_error_to_string (
+			E_CLIENT_ERROR_NOT_SUPPORTED));
+		return NULL;
+	}
+
+	return class->create_cursor (
+		backend, sort_fields, sort_types, n_fields, error);
+}
+
 /**
  * e_book_backend_sync:
  * @backend: an #EBookbackend
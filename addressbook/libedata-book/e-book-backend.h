@@ -35,6 +35,7 @@
 #include <libedata-book/e-data-book.h>
 #include <libedata-book/e-data-book-view.h>
 #include <libedata-book/e-data-book-direct.h>
+#include <libedata-book/e-data-book-cursor.h>
 
 /* Standard GObject macros */
 #define E_TYPE_BOOK_BACKEND \
@@ -221,6 +222,16 @@ struct _EBookBackendClass {
 	void		(*closed)		(EBookBackend *backend,
 						 const gchar *sender);
 	void		(*shutdown)		(EBookBackend *backend);
+
+	/* This method is optional.  Backends which can traverse
+	 * their contacts in a sorted order implement it, see
+	 * EDataBookCursorSqlite for backends using a summary. */
+	EDataBookCursor *
+			(*create_cursor)	(EBookBackend *backend,
+						 const EContactField *sort_fields,
+						 const EBookCursorSortType *sort_types,
+						 guint n_fields,
+						 GError **error);
 };
 
 GType		e_book_backend_get_type		(void) G_GNUC_CONST;
@@ -383,6 +394,13 @@ EDataBookDirect *
 void		e_book_backend_configure_direct	(EBookBackend *backend,
 						 const gchar *config);
 
+EDataBookCursor *
+		e_book_backend_create_cursor	(EBookBackend *backend,
+						 const EContactField *sort_fields,
+						 const EBookCursorSortType *sort_types,
+						 guint n_fields,
+						 GError **error);
+
 void		e_book_backend_sync		(EBookBackend *backend);
 
 GSimpleAsyncResult *
@@ -0,0 +1,272 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 2.1 of the GNU Lesser General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * SECTION: e-data-book-cursor-sqlite
+ * @include: libedata-book/libedata-book.h
+ * @short_description: A cursor over the contacts of an #EBookBackendSqliteDB
+ *
+ * An #EDataBookCursorSqlite implements #EDataBookCursor for backends which
+ * store their contacts in an #EBookBackendSqliteDB, using the collation
+ * keys stored in its summary. Only summary fields can be sorted by, and
+ * only summary queries can filter the contacts.
+ **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "e-data-book-cursor-sqlite.h"
+#include "e-book-backend.h"
+
+#define E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), E_TYPE_DATA_BOOK_CURSOR_SQLITE, EDataBookCursorSqlitePrivate))
+
+struct _EDataBookCursorSqlitePrivate {
+	EBookBackendSqliteDB *ebsdb;
+	EbSdbCursor *cursor;
+};
+
+G_DEFINE_TYPE (
+	EDataBookCursorSqlite,
+	e_data_book_cursor_sqlite,
+	E_TYPE_DATA_BOOK_CURSOR)
+
+/* Converts the errors which are the caller's fault to client errors */
+static void
+data_book_cursor_sqlite_propagate_error (GError *local_error,
+                                         GError **error)
+{
+	if (g_error_matches (local_error,
+			     E_BOOK_SDB_ERROR,
+			     E_BOOK_SDB_ERROR_NOT_SUPPORTED)) {
+		g_set_error_literal (
+			error, E_CLIENT_ERROR,
+			E_CLIENT_ERROR_NOT_SUPPORTED,
+			local_error->message);
+		g_error_free (local_error);
+
+	} else if (g_error_matches (local_error,
+			     E_BOOK_SDB_ERROR,
+			     E_BOOK_SDB_ERROR_INVALID_QUERY)) {
+		g_set_error_literal (
+			error, E_CLIENT_ERROR,
+			E_CLIENT_ERROR_INVALID_QUERY,
+			local_error->message);
+		g_error_free (local_error);
+
+	} else {
+		g_propagate_error (error, local_error);
+	}
+}
+
+static void
+data_book_cursor_sqlite_finalize (GObject *object)
+{
+	EDataBookCursorSqlitePrivate *priv;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (object);
+
+	if (priv->cursor != NULL)
+		e_book_backend_sqlitedb_cursor_free (priv->ebsdb, priv->cursor);
+
+	g_clear_object (&priv->ebsdb);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (e_data_book_cursor_sqlite_parent_class)->finalize (object);
+}
+
+static gboolean
+data_book_cursor_sqlite_set_sexp (EDataBookCursor *cursor,
+                                  const gchar *sexp,
+                                  GError **error)
+{
+	EDataBookCursorSqlitePrivate *priv;
+	GError *local_error = NULL;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+
+	if (!e_book_backend_sqlitedb_cursor_set_sexp (
+		priv->ebsdb, priv->cursor, sexp, &local_error)) {
+		data_book_cursor_sqlite_propagate_error (local_error, error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gint
+data_book_cursor_sqlite_step (EDataBookCursor *cursor,
+                              EBookCursorStepFlags flags,
+                              EBookCursorOrigin origin,
+                              gint count,
+                              GSList **results,
+                              GCancellable *cancellable,
+                              GError **error)
+{
+	EDataBookCursorSqlitePrivate *priv;
+	GSList *local_results = NULL, *link;
+	GError *local_error = NULL;
+	gint n_traversed;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+
+	n_traversed = e_book_backend_sqlitedb_cursor_step (
+		priv->ebsdb, priv->cursor, flags, origin, count,
+		(flags & E_BOOK_CURSOR_STEP_FETCH) != 0 ? &local_results : NULL,
+		&local_error);
+
+	if (n_traversed < 0) {
+		data_book_cursor_sqlite_propagate_error (local_error, error);
+		return -1;
+	}
+
+	/* Steal the vCard strings from the search data */
+	for (link = local_results; link != NULL; link = g_slist_next (link)) {
+		EbSdbSearchData *data = link->data;
+
+		link->data = data->vcard;
+		data->vcard = NULL;
+
+		e_book_backend_sqlitedb_search_data_free (data);
+	}
+
+	if (results != NULL)
+		*results = local_results;
+	else
+		g_slist_free_full (local_results, (GDestroyNotify) g_free);
+
+	return n_traversed;
+}
+
+static void
+data_book_cursor_sqlite_set_alphabetic_index (EDataBookCursor *cursor,
+                                              gint index)
+{
+	EDataBookCursorSqlitePrivate *priv;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+
+	e_book_backend_sqlitedb_cursor_set_target_alphabetic_index (
+		priv->ebsdb, priv->cursor, index);
+}
+
+static gboolean
+data_book_cursor_sqlite_get_position (EDataBookCursor *cursor,
+                                      gint *total,
+                                      gint *position,
+                                      GCancellable *cancellable,
+                                      GError **error)
+{
+	EDataBookCursorSqlitePrivate *priv;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+
+	return e_book_backend_sqlitedb_cursor_calculate (
+		priv->ebsdb, priv->cursor, total, position, error);
+}
+
+static const gchar * const *
+data_book_cursor_sqlite_get_alphabet (EDataBookCursor *cursor,
+                                      gint *n_labels)
+{
+	EDataBookCursorSqlitePrivate *priv;
+
+	priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+
+	return e_book_backend_sqlitedb_get_alphabet (priv->ebsdb, n_labels);
+}
+
+static void
+e_data_book_cursor_sqlite_class_init (EDataBookCursorSqliteClass *class)
+{
+	GObjectClass *object_class;
+	EDataBookCursorClass *cursor_class;
+
+	g_type_class_add_private (class, sizeof (EDataBookCursorSqlitePrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = data_book_cursor_sqlite_finalize;
+
+	cursor_class = E_DATA_BOOK_CURSOR_CLASS (class);
+	cursor_class->set_sexp = data_book_cursor_sqlite_set_sexp;
+	cursor_class->step = data_book_cursor_sqlite_step;
+	cursor_class->set_alphabetic_index = data_book_cursor_sqlite_set_alphabetic_index;
+	cursor_class->get_position = data_book_cursor_sqlite_get_position;
+	cursor_class->get_alphabet = data_book_cursor_sqlite_get_alphabet;
+}
+
+static void
+e_data_book_cursor_sqlite_init (EDataBookCursorSqlite *cursor)
+{
+	cursor->priv = E_DATA_BOOK_CURSOR_SQLITE_GET_PRIVATE (cursor);
+}
+
+/**
+ * e_data_book_cursor_sqlite_new:
+ * @backend: the #EBookBackend creating this cursor
+ * @ebsdb: the #EBookBackendSqliteDB storing the contacts
+ * @folder_id: the folder id of the address book in @ebsdb
+ * @sort_fields: (array length=n_fields): the summary fields to sort by
+ * @sort_types: (array length=n_fields): the sort direction of each field
+ * @n_fields: the number of fields to sort by
+ * @error: return location for a #GError, or %NULL
+ *
+ * Creates a cursor for @backend over the contacts stored in @ebsdb,
+ * initially matching all contacts and positioned at the beginning.
+ * Backends implement #EBookBackendClass.create_cursor() with this.
+ *
+ * Returns: (transfer full): a new #EDataBookCursor, or %NULL on failure
+ *
+ * Since: 3.12
+ **/
+EDataBookCursor *
+e_data_book_cursor_sqlite_new (EBookBackend *backend,
+                               EBookBackendSqliteDB *ebsdb,
+                               const gchar *folder_id,
+                               const EContactField *sort_fields,
+                               const EBookCursorSortType *sort_types,
+                               guint n_fields,
+                               GError **error)
+{
+	EDataBookCursorSqlite *cursor;
+	EbSdbCursor *sdb_cursor;
+	GError *local_error = NULL;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND (backend), NULL);
+	g_return_val_if_fail (E_IS_BOOK_BACKEND_SQLITEDB (ebsdb), NULL);
+	g_return_val_if_fail (folder_id != NULL, NULL);
+
+	sdb_cursor = e_book_backend_sqlitedb_cursor_new (
+		ebsdb, folder_id, NULL,
+		sort_fields, sort_types, n_fields,
+		&local_error);
+
+	if (sdb_cursor == NULL) {
+		data_book_cursor_sqlite_propagate_error (local_error, error);
+		return NULL;
+	}
+
+	cursor = g_object_new (
+		E_TYPE_DATA_BOOK_CURSOR_SQLITE,
+		"backend", backend, NULL);
+
+	cursor->priv->ebsdb = g_object_ref (ebsdb);
+	cursor->priv->cursor = sdb_cursor;
+
+	return E_DATA_BOOK_CURSOR (cursor);
+}
@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 2.1 of the GNU Lesser General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * SECTION: e-data-book-cursor
+ * @include: libedata-book/libedata-book.h
+ * @short_description: An abstract cursor over the sorted contacts of a backend
+ *
+ * An #EDataBookCursor traverses the contacts of an #EBookBackend in a
+ * stable sort order, a number of contacts at a time, without ever loading
+ * the whole result set. Cursors are created with e_book_backend_create_cursor()
+ * by backends which support them.
+ *
+ * The position of a cursor is stored in terms of the sort keys of the last
+ * traversed contact, so a cursor stays valid while the address book
+ * changes underneath it. Cursor methods are not thread safe, a cursor
+ * should only be used from one thread at a time.
+ **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "e-data-book-cursor.h"
+#include "e-book-backend.h"
+
+#define E_DATA_BOOK_CURSOR_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), E_TYPE_DATA_BOOK_CURSOR, EDataBookCursorPrivate))
+
+struct _EDataBookCursorPrivate {
+	EBookBackend *backend;
+};
+
+enum {
+	PROP_0,
+	PROP_BACKEND
+};
+
+G_DEFINE_ABSTRACT_TYPE (
+	EDataBookCursor,
+	e_data_book_cursor,
+	G_TYPE_OBJECT)
+
+static void
+data_book_cursor_set_backend (EDataBookCursor *cursor,
+                              EBookBackend *backend)
+{
+	g_return_if_fail (E_IS_BOOK_BACKEND (backend));
+	g_return_if_fail (cursor->priv->backend == NULL);
+
+	cursor->priv->backend = g_object_ref (backend);
+}
+
+static void
+data_book_cursor_set_property (GObject *object,
+                               guint property_id,
+                               const GValue *value,
+                               GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_BACKEND:
+			data_book_cursor_set_backend (
+				E_DATA_BOOK_CURSOR (object),
+				g_value_get_object (value));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+data_book_cursor_get_property (GObject *object,
+                               guint property_id,
+                               GValue *value,
+                               GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_BACKEND:
+			g_value_set_object (
+				value,
+				e_data_book_cursor_get_backend (
+				E_DATA_BOOK_CURSOR (object)));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+data_book_cursor_dispose (GObject *object)
+{
+	EDataBookCursorPrivate *priv;
+
+	priv = E_DATA_BOOK_CURSOR_GET_PRIVATE (object);
+
+	g_clear_object (&priv->backend);
+
+	/* Chain up to parent's dispose() method. */
+	G_OBJECT_CLASS (e_data_book_cursor_parent_class)->dispose (object);
+}
+
+static void
+e_data_book_cursor_class_init (EDataBookCursorClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (EDataBookCursorPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->set_property = data_book_cursor_set_property;
+	object_class->get_property = data_book_cursor_get_property;
+	object_class->dispose = data_book_cursor_dispose;
+
+	g_object_class_install_property (
+		object_class,
+		PROP_BACKEND,
+		g_param_spec_object (
+			"backend",
+			"Backend",
+			"The backend whose contacts are traversed",
+			E_TYPE_BOOK_BACKEND,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT_ONLY |
+			G_PARAM_STATIC_STRINGS));
+}
+
+static void
+e_data_book_cursor_init (EDataBookCursor *cursor)
+{
+	cursor->priv = E_DATA_BOOK_CURSOR_GET_PRIVATE (cursor);
+}
+
+/**
+ * e_data_book_cursor_get_backend:
+ * @cursor: an #EDataBookCursor
+ *
+ * Gets the backend whose contacts @cursor traverses.
+ *
+ * Returns: (transfer none): The associated #EBookBackend.
+ *
+ * Since: 3.12
+ **/
+EBookBackend *
+e_data_book_cursor_get_backend (EDataBookCursor *cursor)
+{
+	g_return_val_if_fail (E_IS_DATA_BOOK_CURSOR (cursor), NULL);
+
+	return cursor->priv->backend;
+}
+
+/**
+ * e_data_book_cursor_set_sexp:
+ * @cursor: an #EDataBookCursor
+ * @sexp: (allow-none): the search expression, or %NULL to match all contacts
+ * @error: return location for a #GError, or %NULL
+ *
+ * Changes the search expression filtering the contacts traversed by
+ * @cursor. The position of @cursor is preserved.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_data_book_cursor_set_sexp (EDataBookCursor *cursor,
+                             const gchar *sexp,
+                             GError **error)
+{
+	EDataBookCursorClass *class;
+
+	g_return_val_if_fail (E_IS_DATA_BOOK_CURSOR (cursor), FALSE);
+
+	class = E_DATA_BOOK_CURSOR_GET_CLASS (cursor);
+	g_return_val_if_fail (class->set_sexp != NULL, FALSE);
+
+	return class->set_sexp (cursor, sexp, error);
+}
+
+/**
+ * e_data_book_cursor_step:
+ * @cursor: an #EDataBookCursor
+ * @flags: the #EBookCursorStepFlags for this step
+ * @origin: the #EBookCursorOrigin from whence to step
+ * @count: a positive or negative amount of contacts to traverse
+ * @results: (out) (allow-none) (element-type utf8) (transfer full):
+ *   return location for the traversed vCard strings, if
+ *   %E_BOOK_CURSOR_STEP_FETCH is specified in @flags
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Traverses up to @count contacts from @origin, forward for a positive
+ * @count and backward for a negative one. See #EBookCursorStepFlags for
+ * whether the contacts are fetched and whether @cursor is moved.
+ *
+ * Free the returned list with g_slist_free_full() and g_free().
+ *
+ * Returns: the number of contacts traversed, or -1 on failure
+ *
+ * Since: 3.12
+ **/
+gint
+e_data_book_cursor_step (EDataBookCursor *cursor,
+                         EBookCursorStepFlags flags,
+                         EBookCursorOrigin origin,
+                         gint count,
+                         GSList **results,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	EDataBookCursorClass *class;
+
+	g_return_val_if_fail (E_IS_DATA_BOOK_CURSOR (cursor), -1);
+
+	class = E_DATA_BOOK_CURSOR_GET_CLASS (cursor);
+	g_return_val_if_fail (class->step != NULL, -1);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return -1;
+
+	return class->step (
+		cursor, flags, origin, count,
+		results, cancellable, error);
+}
+
+/**
+ * e_data_book_cursor_set_alphabetic_index:
+ * @cursor: an #EDataBookCursor
+ * @index: the index into the labels returned by e_data_book_cursor_get_alphabet()
+ *
+ * Positions @cursor right before the contacts whose primary sort key
+ * starts with the label at @index, so that the next step forward
+ * traverses them first.
+ *
+ * Since: 3.12
+ **/
+void
+e_data_book_cursor_set_alphabetic_index (EDataBookCursor *cursor,
+                                         gint index)
+{
+	EDataBookCursorClass *class;
+
+	g_return_if_fail (E_IS_DATA_BOOK_CURSOR (cursor));
+
+	class = E_DATA_BOOK_CURSOR_GET_CLASS (cursor);
+	g_return_if_fail (class->set_alphabetic_index != NULL);
+
+	class->set_alphabetic_index (cursor, index);
+}
+
+/**
+ * e_data_book_cursor_get_position:
+ * @cursor: an #EDataBookCursor
+ * @total: (out) (allow-none): return location for the number of matching contacts
+ * @position: (out) (allow-none): return location for the position of @cursor
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Calculates the number of contacts matching the search expression of
+ * @cursor and the position of @cursor in them. The position is 0 at the
+ * beginning, @total + 1 at the end, and otherwise the number of contacts
+ * up to and including the current one.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.12
+ **/
+gboolean
+e_data_book_cursor_get_position (EDataBookCursor *cursor,
+                                 gint *total,
+                                 gint *position,
+                                 GCancellable *cancellable,
+                                 GError **error)
+{
+	EDataBookCursorClass *class;
+
+	g_return_val_if_fail (E_IS_DATA_BOOK_CURSOR (cursor), FALSE);
+
+	class = E_DATA_BOOK_CURSOR_GET_CLASS (cursor);
+	g_return_val_if_fail (class->get_position != NULL, FALSE);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	return class->get_position (
+		cursor, total, position, cancellable, error);
+}
+
+/**
+ * e_data_book_cursor_get_alphabet:
+ * @cursor: an #EDataBookCursor
+ * @n_labels: (out): return location for the number of labels
+ *
+ * Fetches the labels of the alphabetic indexes usable with
+ * e_data_book_cursor_set_alphabetic_index(), in sort order.
+ *
+ * Returns: (array length=n_labels) (transfer none): the alphabet labels
+ *
+ * Since: 3.12
+ **/
+const gchar * const *
+e_data_book_cursor_get_alphabet (EDataBookCursor *cursor,
+                                 gint *n_labels)
+{
+	EDataBookCursorClass *class;
+
+	g_return_val_if_fail (E_IS_DATA_BOOK_CURSOR (cursor), NULL);
+	g_return_val_if_fail (n_labels != NULL, NULL);
+
+	class = E_DATA_BOOK_CURSOR_GET_CLASS (cursor);
+	g_return_val_if_fail (class->get_alphabet != NULL, NULL);
+
+	return class->get_alphabet (cursor, n_labels);
+}
@@ -0,0 +1,132 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 2.1 of the GNU Lesser General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if !defined (__LIBEDATA_BOOK_H_INSIDE__) && !defined (LIBEDATA_BOOK_COMPILATION)
+#error "Only <libedata-book/libedata-book.h> should be included directly."
+#endif
+
+#ifndef E_DATA_BOOK_CURSOR_H
+#define E_DATA_BOOK_CURSOR_H
+
+#include <gio/gio.h>
+#include <libebook-contacts/libebook-contacts.h>
+
+/* Standard GObject macros */
+#define E_TYPE_DATA_BOOK_CURSOR \
+	(e_data_book_cursor_get_type ())
+#define E_DATA_BOOK_CURSOR(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), E_TYPE_DATA_BOOK_CURSOR, EDataBookCursor))
+#define E_DATA_BOOK_CURSOR_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), E_TYPE_DATA_BOOK_CURSOR, EDataBookCursorClass))
+#define E_IS_DATA_BOOK_CURSOR(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), E_TYPE_DATA_BOOK_CURSOR))
+#define E_IS_DATA_BOOK_CURSOR_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), E_TYPE_DATA_BOOK_CURSOR))
+#define E_DATA_BOOK_CURSOR_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), E_TYPE_DATA_BOOK_CURSOR, EDataBookCursorClass))
+
+G_BEGIN_DECLS
+
+struct _EBookBackend;
+
+typedef struct _EDataBookCursor EDataBookCursor;
+typedef struct _EDataBookCursorClass EDataBookCursorClass;
+typedef struct _EDataBookCursorPrivate EDataBookCursorPrivate;
+
+/**
+ * EDataBookCursor:
+ *
+ * An abstract cursor traversing the sorted contacts of an #EBookBackend.
+ * Backends supporting cursors return a concrete implementation from
+ * e_book_backend_create_cursor().
+ *
+ * Since: 3.12
+ **/
+struct _EDataBookCursor {
+	GObject parent;
+	EDataBookCursorPrivate *priv;
+};
+
+/**
+ * EDataBookCursorClass:
+ * @set_sexp: Changes the query filtering the traversed contacts
+ * @step: Traverses the contacts, returning them as vCard strings
+ * @set_alphabetic_index: Positions the cursor at an alphabetic index
+ * @get_position: Calculates the total and the current position
+ * @get_alphabet: Fetches the labels of the alphabetic indexes
+ *
+ * Methods to implement for a concrete cursor.
+ *
+ * Since: 3.12
+ **/
+struct _EDataBookCursorClass {
+	GObjectClass parent_class;
+
+	gboolean	(*set_sexp)		(EDataBookCursor *cursor,
+						 const gchar *sexp,
+						 GError **error);
+	gint		(*step)			(EDataBookCursor *cursor,
+						 EBookCursorStepFlags flags,
+						 EBookCursorOrigin origin,
+						 gint count,
+						 GSList **results,
+						 GCancellable *cancellable,
+						 GError **error);
+	void		(*set_alphabetic_index)	(EDataBookCursor *cursor,
+						 gint index);
+	gboolean	(*get_position)		(EDataBookCursor *cursor,
+						 gint *total,
+						 gint *position,
+						 GCancellable *cancellable,
+						 GError **error);
+	const gchar * const *
+			(*get_alphabet)		(EDataBookCursor *cursor,
+						 gint *n_labels);
+};
+
+GType		e_data_book_cursor_get_type	(void) G_GNUC_CONST;
+struct _EBookBackend *
+		e_data_book_cursor_get_backend	(EDataBookCursor *cursor);
+gboolean	e_data_book_cursor_set_sexp	(EDataBookCursor *cursor,
+						 const gchar *sexp,
+						 GError **error);
+gint		e_data_book_cursor_step		(EDataBookCursor *cursor,
+						 EBookCursorStepFlags flags,
+						 EBookCursorOrigin origin,
+						 gint count,
+						 GSList **results,
+						 GCancellable *cancellable,
+						 GError **error);
+void		e_data_book_cursor_set_alphabetic_index
+						(EDataBookCursor *cursor,
+						 gint index);
+gboolean	e_data_book_cursor_get_position	(EDataBookCursor *cursor,
+						 gint *total,
+						 gint *position,
+						 GCancellable *cancellable,
+						 GError **error);
+const gchar * const *
+		e_data_book_cursor_get_alphabet	(EDataBookCursor *cursor,
+						 gint *n_labels);
+
+G_END_DECLS
+
+#endif /* E_DATA_BOOK_CURSOR_H */
@@ -37,11 +37,17 @@
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), E_TYPE_DATA_BOOK_VIEW, EDataBookViewPrivate))
 
-/* how many items can be hold in a cache, before propagated to UI */
-#define THRESHOLD_ITEMS 32
-
-/* how long to wait until notifications are propagated to UI; in seconds */
-#define THRESHOLD_SECONDS 2
+/* How many items can be hold in a cache, before propagated to UI.
+ * The limit doubles each time a batch fills up, so bulk updates
+ * are sent in few large signals, and halves again when the view
+ * gets quiet. */
+#define THRESHOLD_ITEMS_MIN 32
+#define THRESHOLD_ITEMS_MAX 1024
+
+/* How long to wait until notifications are propagated to UI;
+ * in milliseconds. Adapts to the load like the item limit. */
+#define THRESHOLD_INTERVAL_MIN 100
+#define THRESHOLD_INTERVAL_MAX 2000
 
 struct _EDataBookViewPrivate {
 	GDBusConnection *connection;
@@ -64,10 +70,16 @@ struct _EDataBookViewPrivate {
 	GHashTable *ids;
 
 	guint flush_id;
+	guint threshold_items;
+	guint threshold_interval;
 
 	/* which fields is listener interested in */
 	GHashTable *fields_of_interest;
 	gboolean send_uids_only;
+
+	/* vCard attributes of the fields of interest, or NULL
+	 * to send whole vCards; see filter_vcard() */
+	GHashTable *attributes_of_interest;
 };
 
 enum {
@@ -143,6 +155,31 @@ reset_array (GArray *array)
 	g_array_set_size (array, 0);
 }
 
+/* Number of strings queued per contact in the adds and changes arrays */
+static guint
+pending_stride (EDataBookView *view)
+{
+	return view->priv->send_uids_only ? 1 : 2;
+}
+
+static gboolean
+pending_is_full (EDataBookView *view,
+                 GArray *array,
+                 guint stride)
+{
+	if (array->len < view->priv->threshold_items * stride)
+		return FALSE;
+
+	/* Notifications arrive faster than they are flushed,
+	 * use larger batches and wait longer for them */
+	view->priv->threshold_items = MIN (
+		view->priv->threshold_items * 2, THRESHOLD_ITEMS_MAX);
+	view->priv->threshold_interval = MIN (
+		view->priv->threshold_interval * 2, THRESHOLD_INTERVAL_MAX);
+
+	return TRUE;
+}
+
 static void
 send_pending_adds (EDataBookView *view)
 {
@@ -183,11 +220,25 @@ static gboolean
 pending_flush_timeout_cb (gpointer data)
 {
 	EDataBookView *view = data;
+	guint n_pending;
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
 	view->priv->flush_id = 0;
 
+	n_pending =
+		(view->priv->adds->len + view->priv->changes->len) /
+		pending_stride (view) + view->priv->removes->len;
+
+	/* The batch did not get anywhere near full, go back
+	 * towards small batches sent with little delay */
+	if (n_pending < view->priv->threshold_items / 4) {
+		view->priv->threshold_items = MAX (
+			view->priv->threshold_items / 2, THRESHOLD_ITEMS_MIN);
+		view->priv->threshold_interval = MAX (
+			view->priv->threshold_interval / 2, THRESHOLD_INTERVAL_MIN);
+	}
+
 	send_pending_adds (view);
 	send_pending_changes (view);
 	send_pending_removes (view);
@@ -203,8 +254,9 @@ ensure_pending_flush_timeout (EDataBookView *view)
 	if (view->priv->flush_id > 0)
 		return;
 
-	view->priv->flush_id = g_timeout_add_seconds (
-		THRESHOLD_SECONDS, pending_flush_timeout_cb, view);
+	view->priv->flush_id = g_timeout_add (
+		view->priv->threshold_interval,
+		pending_flush_timeout_cb, view);
 }
 
 static gpointer
@@ -296,21 +348,54 @@ impl_DataBookView_dispose (EGdbusBookView *object,
 	return TRUE;
 }
 
+/* Returns the vCard attribute holding @field, or NULL for synthetic
+ * fields, like "name_or_org", which are computed from several
+ * attributes, and for fields we do not know */
+static const gchar *
+field_vcard_attribute (const gchar *field)
+{
+	EContactField field_id;
+	const gchar *attr_name;
+
+	field_id = e_contact_field_id (field);
+	if (field_id == 0)
+		return NULL;
+
+	attr_name = e_contact_vcard_attribute (field_id);
+	if (attr_name == NULL || *attr_name == '\0')
+		return NULL;
+
+	return attr_name;
+}
+
 static gboolean
 impl_DataBookView_set_fields_of_interest (EGdbusBookView *object,
                                           GDBusMethodInvocation *invocation,
                                           const gchar * const *in_fields_of_interest,
                                           EDataBookView *view)
 {
+	gboolean can_filter = TRUE;
 	gint ii;
 
 	g_return_val_if_fail (in_fields_of_interest != NULL, TRUE);
 
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	/* Pending notifications were queued for the old fields */
+	send_pending_adds (view);
+	send_pending_changes (view);
+	send_pending_removes (view);
+
 	if (view->priv->fields_of_interest != NULL) {
 		g_hash_table_destroy (view->priv->fields_of_interest);
 		view->priv->fields_of_interest = NULL;
 	}
 
+	if (view->priv->attributes_of_interest != NULL) {
+		g_hash_table_destroy (view->priv->attributes_of_interest);
+		view->priv->attributes_of_interest = NULL;
+	}
+
 	view->priv->send_uids_only = FALSE;
 
 	for (ii = 0; in_fields_of_interest[ii]; ii++) {
@@ -335,8 +420,38 @@ impl_DataBookView_set_fields_of_interest (EGdbusBookView *object,
 		g_hash_table_insert (
 			view->priv->fields_of_interest,
 			g_strdup (field), GINT_TO_POINTER (1));
+
+		if (can_filter) {
+			const gchar *attr_name;
+
+			attr_name = field_vcard_attribute (field);
+			if (attr_name == NULL) {
+				can_filter = FALSE;
+			} else {
+				if (view->priv->attributes_of_interest == NULL) {
+					view->priv->attributes_of_interest =
+						g_hash_table_new (
+							(GHashFunc) str_ic_hash,
+							(GEqualFunc) str_ic_equal);
+					g_hash_table_add (
+						view->priv->attributes_of_interest,
+						(gpointer) EVC_UID);
+				}
+
+				g_hash_table_add (
+					view->priv->attributes_of_interest,
+					(gpointer) attr_name);
+			}
+		}
 	}
 
+	if (!can_filter && view->priv->attributes_of_interest != NULL) {
+		g_hash_table_destroy (view->priv->attributes_of_interest);
+		view->priv->attributes_of_interest = NULL;
+	}
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+
 	e_gdbus_book_view_complete_set_fields_of_interest (
 		object, invocation, NULL);
 
@@ -501,6 +616,9 @@ data_book_view_finalize (GObject *object)
 	if (priv->fields_of_interest)
 		g_hash_table_destroy (priv->fields_of_interest);
 
+	if (priv->attributes_of_interest)
+		g_hash_table_destroy (priv->attributes_of_interest);
+
 	g_mutex_clear (&priv->pending_mutex);
 
 	g_hash_table_destroy (priv->ids);
@@ -624,21 +742,25 @@ e_data_book_view_init (EDataBookView *view)
 	view->priv->complete = FALSE;
 	g_mutex_init (&view->priv->pending_mutex);
 
-	/* THRESHOLD_ITEMS * 2 because we store UID and vcard */
+	/* THRESHOLD_ITEMS_MIN * 2 because we store UID and vcard */
 	view->priv->adds = g_array_sized_new (
-		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS * 2);
+		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS_MIN * 2);
 	view->priv->changes = g_array_sized_new (
-		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS * 2);
+		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS_MIN * 2);
 	view->priv->removes = g_array_sized_new (
-		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS);
+		TRUE, TRUE, sizeof (gchar *), THRESHOLD_ITEMS_MIN);
 
+	/* Maps the UIDs in the view to a checksum of the vCard last
+	 * sent for them in a change, or NULL, see notify_change() */
 	view->priv->ids = g_hash_table_new_full (
 		(GHashFunc) g_str_hash,
 		(GEqualFunc) g_str_equal,
 		(GDestroyNotify) g_free,
-		(GDestroyNotify) NULL);
+		(GDestroyNotify) g_free);
 
 	view->priv->flush_id = 0;
+	view->priv->threshold_items = THRESHOLD_ITEMS_MIN;
+	view->priv->threshold_interval = THRESHOLD_INTERVAL_MIN;
 }
 
 /**
@@ -765,6 +887,44 @@ e_data_book_view_get_flags (EDataBookView *view)
 	return view->priv->flags;
 }
 
+/*
+ * Strips @vcard down to the attributes of the fields of interest,
+ * the listener would not use the others anyway.
+ */
+static gchar *
+filter_vcard (EDataBookView *view,
+              const gchar *vcard)
+{
+	EVCard *source, *filtered;
+	GList *link;
+	gchar *filtered_vcard, *utf8_vcard;
+
+	if (view->priv->attributes_of_interest == NULL)
+		return e_util_utf8_make_valid (vcard);
+
+	source = e_vcard_new_from_string (vcard);
+	filtered = e_vcard_new ();
+
+	for (link = e_vcard_get_attributes (source); link; link = link->next) {
+		EVCardAttribute *attr = link->data;
+
+		if (g_hash_table_contains (
+			view->priv->attributes_of_interest,
+			e_vcard_attribute_get_name (attr)))
+			e_vcard_append_attribute (
+				filtered, e_vcard_attribute_copy (attr));
+	}
+
+	filtered_vcard = e_vcard_to_string (filtered, EVC_FORMAT_VCARD_30);
+	utf8_vcard = e_util_utf8_make_valid (filtered_vcard);
+
+	g_free (filtered_vcard);
+	g_object_unref (filtered);
+	g_object_unref (source);
+
+	return utf8_vcard;
+}
+
 /*
  * Queue @vcard to be sent as a change notification.
  */
@@ -773,21 +933,44 @@ notify_change (EDataBookView *view,
                const gchar *id,
                const gchar *vcard)
 {
-	gchar *utf8_vcard, *utf8_id;
+	gchar *utf8_vcard = NULL, *utf8_id;
+
+	utf8_id = e_util_utf8_make_valid (id);
+
+	/* Only the UID is sent otherwise, there is no payload to compare */
+	if (view->priv->send_uids_only == FALSE) {
+		gchar *checksum;
+		gpointer last_checksum = NULL;
+
+		utf8_vcard = filter_vcard (view, vcard);
+
+		/* Nothing the listener is interested in has changed. Adds
+		 * leave no checksum, so the first change is always sent. */
+		checksum = g_compute_checksum_for_string (
+			G_CHECKSUM_MD5, utf8_vcard, -1);
+		g_hash_table_lookup_extended (
+			view->priv->ids, utf8_id, NULL, &last_checksum);
+		if (g_strcmp0 (checksum, last_checksum) == 0) {
+			g_free (checksum);
+			g_free (utf8_vcard);
+			g_free (utf8_id);
+			return;
+		}
+
+		g_hash_table_insert (
+			view->priv->ids, g_strdup (utf8_id), checksum);
+	}
 
 	send_pending_adds (view);
 	send_pending_removes (view);
 
-	if (view->priv->changes->len == THRESHOLD_ITEMS * 2) {
+	if (pending_is_full (view, view->priv->changes, pending_stride (view))) {
 		send_pending_changes (view);
 	}
 
-	if (view->priv->send_uids_only == FALSE) {
-		utf8_vcard = e_util_utf8_make_valid (vcard);
+	if (utf8_vcard != NULL)
 		g_array_append_val (view->priv->changes, utf8_vcard);
-	}
 
-	utf8_id = e_util_utf8_make_valid (id);
 	g_array_append_val (view->priv->changes, utf8_id);
 
 	ensure_pending_flush_timeout (view);
@@ -805,7 +988,7 @@ notify_remove (EDataBookView *view,
 	send_pending_adds (view);
 	send_pending_changes (view);
 
-	if (view->priv->removes->len == THRESHOLD_ITEMS) {
+	if (pending_is_full (view, view->priv->removes, 1)) {
 		send_pending_removes (view);
 	}
 
@@ -825,7 +1008,7 @@ notify_add (EDataBookView *view,
             const gchar *vcard)
 {
 	EBookClientViewFlags flags;
-	gchar *utf8_vcard, *utf8_id;
+	gchar *utf8_id;
 
 	send_pending_changes (view);
 	send_pending_removes (view);
@@ -837,12 +1020,13 @@ notify_add (EDataBookView *view,
 	if (view->priv->complete || (flags & E_BOOK_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL) != 0) {
 		gchar *utf8_id_copy = g_strdup (utf8_id);
 
-		if (view->priv->adds->len == THRESHOLD_ITEMS) {
+		if (pending_is_full (view, view->priv->adds, pending_stride (view))) {
 			send_pending_adds (view);
 		}
 
 		if (view->priv->send_uids_only == FALSE) {
-			utf8_vcard = e_util_utf8_make_valid (vcard);
+			gchar *utf8_vcard = filter_vcard (view, vcard);
+
 			g_array_append_val (view->priv->adds, utf8_vcard);
 		}
 
@@ -851,7 +1035,9 @@ notify_add (EDataBookView *view,
 		ensure_pending_flush_timeout (view);
 	}
 
-	g_hash_table_insert (view->priv->ids, utf8_id, GUINT_TO_POINTER (1));
+	/* The checksum of the payload is only computed once a change
+	 * notification for the contact has something to compare */
+	g_hash_table_insert (view->priv->ids, utf8_id, NULL);
 }
 
 static gboolean
@@ -865,7 +1051,7 @@ id_is_in_view (EDataBookView *view,
 	g_return_val_if_fail (id != NULL, FALSE);
 
 	valid_id = e_util_utf8_make_valid (id);
-	res = g_hash_table_lookup (view->priv->ids, valid_id) != NULL;
+	res = g_hash_table_contains (view->priv->ids, valid_id);
 	g_free (valid_id);
 
 	return res;
@@ -1124,6 +1310,8 @@ e_data_book_view_notify_progress (EDataBookView *view,
  * Returns: Hash table of field names which the listener is interested in.
  * Backends can return fully populated objects, but the listener advertised
  * that it will use only these. Returns %NULL for all available fields.
+ * Notifications sent to the listener carry only the vCard attributes
+ * of these fields, unless one of them is a synthetic field.
  *
  * Note: The data pointer in the hash table has no special meaning, it's
  * only GINT_TO_POINTER(1) for easier checking. Also, field names are
@@ -31,6 +31,8 @@
 #include <libedata-book/e-book-backend-sqlitedb.h>
 #include <libedata-book/e-book-backend-summary.h>
 #include <libedata-book/e-book-backend.h>
+#include <libedata-book/e-data-book-cursor.h>
+#include <libedata-book/e-data-book-cursor-sqlite.h>
 #include <libedata-book/e-data-book-factory.h>
 #include <libedata-book/e-data-book-direct.h>
 #include <libedata-book/e-data-book-view.h>
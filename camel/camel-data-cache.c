@@ -28,12 +28,14 @@
 #include <ctype.h>
 #include <errno.h>
 #include <string.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <glib/gstdio.h>
 #include <glib/gi18n-lib.h>
 
 #include "camel-data-cache.h"
+#include "camel-debug.h"
 #include "camel-object-bag.h"
 #include "camel-stream-fs.h"
 #include "camel-stream-mem.h"
@@ -53,6 +55,30 @@
  * once an hour should be enough */
 #define CAMEL_DATA_CACHE_CYCLE_TIME (60*60)
 
+/* With a size limit set, every item is recorded in an index kept in the
+ * cache's base directory, most recently used first, so that eviction
+ * never needs to walk or stat the cache.  The index is written back at
+ * most this often, and when the cache is finalized. */
+#define CAMEL_DATA_CACHE_INDEX_NAME ".ev-cache-index"
+#define CAMEL_DATA_CACHE_INDEX_HEADER "CamelDataCacheIndex 1"
+#define CAMEL_DATA_CACHE_INDEX_SAVE_TIME (60)
+
+typedef struct _DataCacheEntry DataCacheEntry;
+typedef struct _DataCacheWrite DataCacheWrite;
+
+struct _DataCacheEntry {
+	GList link;		/* in priv->lru, data points back to us */
+	gchar *name;		/* relative to priv->path */
+	goffset size;
+	gint64 atime;
+};
+
+/* an item being written through a stream from camel_data_cache_add() */
+struct _DataCacheWrite {
+	CamelDataCache *cdc;
+	gchar *name;
+};
+
 struct _CamelDataCachePrivate {
 	CamelObjectBag *busy_bag;
 
@@ -62,6 +88,16 @@ struct _CamelDataCachePrivate {
 	time_t expire_access;
 
 	time_t expire_last[1 << CAMEL_DATA_CACHE_BITS];
+
+	GRecMutex index_lock;
+	GHashTable *index;	/* name -> DataCacheEntry, NULL without a limit */
+	GQueue lru;		/* DataCacheEntry, most recently used first */
+	goffset max_size;
+	goffset total_size;
+	gboolean index_dirty;
+	time_t index_saved;
+	guint64 hits;
+	guint64 misses;
 };
 
 enum {
@@ -71,6 +107,320 @@ enum {
 
 G_DEFINE_TYPE (CamelDataCache, camel_data_cache, CAMEL_TYPE_OBJECT)
 
+static void
+data_cache_entry_free (DataCacheEntry *entry)
+{
+	g_free (entry->name);
+	g_slice_free (DataCacheEntry, entry);
+}
+
+/* Returns the part of @filename below the cache's base directory. */
+static const gchar *
+data_cache_relative_name (CamelDataCache *cdc,
+                          const gchar *filename)
+{
+	gsize len = strlen (cdc->priv->path);
+
+	if (strncmp (filename, cdc->priv->path, len) != 0)
+		return filename;
+
+	filename += len;
+	while (G_IS_DIR_SEPARATOR (*filename))
+		filename++;
+
+	return filename;
+}
+
+/* Call with the index lock held, and the index enabled.  A new entry
+ * takes the size of whatever is already on disk under that name, so
+ * files which were put in place behind the cache's back are counted. */
+static DataCacheEntry *
+data_cache_index_touch (CamelDataCache *cdc,
+                        const gchar *name)
+{
+	DataCacheEntry *entry;
+
+	entry = g_hash_table_lookup (cdc->priv->index, name);
+	if (entry == NULL) {
+		struct stat st;
+		gchar *filename;
+
+		entry = g_slice_new0 (DataCacheEntry);
+		entry->link.data = entry;
+		entry->name = g_strdup (name);
+		g_hash_table_insert (cdc->priv->index, entry->name, entry);
+
+		filename = g_build_filename (cdc->priv->path, name, NULL);
+		if (g_stat (filename, &st) == 0 && S_ISREG (st.st_mode)) {
+			entry->size = st.st_size;
+			cdc->priv->total_size += entry->size;
+		}
+		g_free (filename);
+	} else {
+		g_queue_unlink (&cdc->priv->lru, &entry->link);
+	}
+
+	g_queue_push_head_link (&cdc->priv->lru, &entry->link);
+	entry->atime = time (NULL);
+	cdc->priv->index_dirty = TRUE;
+
+	return entry;
+}
+
+/* Call with the index lock held, and the index enabled. */
+static void
+data_cache_index_remove (CamelDataCache *cdc,
+                         const gchar *name)
+{
+	DataCacheEntry *entry;
+
+	entry = g_hash_table_lookup (cdc->priv->index, name);
+	if (entry == NULL)
+		return;
+
+	g_queue_unlink (&cdc->priv->lru, &entry->link);
+	g_hash_table_remove (cdc->priv->index, name);
+	cdc->priv->total_size -= entry->size;
+	cdc->priv->index_dirty = TRUE;
+
+	data_cache_entry_free (entry);
+}
+
+static void
+data_cache_index_set_size (CamelDataCache *cdc,
+                           DataCacheEntry *entry,
+                           goffset size)
+{
+	cdc->priv->total_size += size - entry->size;
+	entry->size = size;
+	cdc->priv->index_dirty = TRUE;
+}
+
+/* Builds the index from what is on disk, the one time a walk of the
+ * whole cache is needed: when a limit is first set on an existing one. */
+static void
+data_cache_index_scan (CamelDataCache *cdc)
+{
+	GDir *dir, *subdir, *bucket;
+	const gchar *dname, *sname, *bname;
+
+	dir = g_dir_open (cdc->priv->path, 0, NULL);
+	if (dir == NULL)
+		return;
+
+	while ((dname = g_dir_read_name (dir))) {
+		gchar *dpath;
+
+		dpath = g_build_filename (cdc->priv->path, dname, NULL);
+		subdir = g_dir_open (dpath, 0, NULL);
+
+		while (subdir && (sname = g_dir_read_name (subdir))) {
+			gchar *spath;
+
+			spath = g_build_filename (dpath, sname, NULL);
+			bucket = g_dir_open (spath, 0, NULL);
+
+			while (bucket && (bname = g_dir_read_name (bucket))) {
+				DataCacheEntry *entry;
+				struct stat st;
+				gchar *bpath;
+
+				bpath = g_build_filename (spath, bname, NULL);
+
+				if (g_stat (bpath, &st) == 0 && S_ISREG (st.st_mode)) {
+					entry = data_cache_index_touch (
+						cdc, data_cache_relative_name (cdc, bpath));
+					entry->atime = st.st_atime;
+					data_cache_index_set_size (cdc, entry, st.st_size);
+				}
+
+				g_free (bpath);
+			}
+
+			if (bucket)
+				g_dir_close (bucket);
+			g_free (spath);
+		}
+
+		if (subdir)
+			g_dir_close (subdir);
+		g_free (dpath);
+	}
+
+	g_dir_close (dir);
+}
+
+static gint
+data_cache_entry_cmp_atime (gconstpointer a,
+                            gconstpointer b)
+{
+	const DataCacheEntry *ea = a, *eb = b;
+
+	return (ea->atime < eb->atime) - (ea->atime > eb->atime);
+}
+
+static void
+data_cache_index_load (CamelDataCache *cdc)
+{
+	gchar *filename, *contents = NULL;
+	gchar **lines = NULL;
+	gboolean valid = FALSE;
+	guint ii;
+
+	filename = g_build_filename (
+		cdc->priv->path, CAMEL_DATA_CACHE_INDEX_NAME, NULL);
+
+	if (g_file_get_contents (filename, &contents, NULL, NULL)) {
+		lines = g_strsplit (contents, "\n", -1);
+		valid = lines[0] && strcmp (lines[0], CAMEL_DATA_CACHE_INDEX_HEADER) == 0;
+		g_free (contents);
+	}
+
+	/* Each line is "size atime name", most recently used first. */
+	for (ii = 1; valid && lines[ii]; ii++) {
+		DataCacheEntry *entry;
+		gchar *name, *end;
+		gint64 size, atime;
+
+		size = g_ascii_strtoll (lines[ii], &end, 10);
+		if (end == lines[ii] || *end != ' ')
+			continue;
+		atime = g_ascii_strtoll (end + 1, &name, 10);
+		if (*name != ' ' || name[1] == '\0')
+			continue;
+		name++;
+
+		if (g_hash_table_lookup (cdc->priv->index, name) != NULL)
+			continue;
+
+		entry = g_slice_new0 (DataCacheEntry);
+		entry->link.data = entry;
+		entry->name = g_strdup (name);
+		entry->size = size;
+		entry->atime = atime;
+		g_hash_table_insert (cdc->priv->index, entry->name, entry);
+		g_queue_push_tail_link (&cdc->priv->lru, &entry->link);
+		cdc->priv->total_size += size;
+	}
+
+	if (!valid) {
+		data_cache_index_scan (cdc);
+		g_queue_sort (&cdc->priv->lru, data_cache_entry_cmp_atime, NULL);
+	}
+
+	cdc->priv->index_dirty = !valid;
+	cdc->priv->index_saved = time (NULL);
+
+	g_strfreev (lines);
+	g_free (filename);
+}
+
+/* Call with the index lock held, and the index enabled. */
+static void
+data_cache_index_save (CamelDataCache *cdc)
+{
+	GString *buffer;
+	GList *link;
+	gchar *filename;
+
+	buffer = g_string_new (CAMEL_DATA_CACHE_INDEX_HEADER "\n");
+
+	for (link = g_queue_peek_head_link (&cdc->priv->lru); link; link = g_list_next (link)) {
+		DataCacheEntry *entry = link->data;
+
+		g_string_append_printf (
+			buffer, "%" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s\n",
+			(gint64) entry->size, entry->atime, entry->name);
+	}
+
+	filename = g_build_filename (
+		cdc->priv->path, CAMEL_DATA_CACHE_INDEX_NAME, NULL);
+
+	if (g_file_set_contents (filename, buffer->str, buffer->len, NULL))
+		cdc->priv->index_dirty = FALSE;
+
+	cdc->priv->index_saved = time (NULL);
+
+	g_free (filename);
+	g_string_free (buffer, TRUE);
+}
+
+/* Drops least recently used items until the cache is back under its
+ * limit, leaving some room so this does not run on every addition.
+ * Call with the index lock held, and the index enabled. */
+static void
+data_cache_index_evict (CamelDataCache *cdc)
+{
+	goffset target;
+	GList *link, *prev;
+
+	if (cdc->priv->total_size > cdc->priv->max_size) {
+		target = cdc->priv->max_size - cdc->priv->max_size / 10;
+
+		for (link = g_queue_peek_tail_link (&cdc->priv->lru);
+		     link && cdc->priv->total_size > target; link = prev) {
+			DataCacheEntry *entry = link->data;
+			CamelStream *stream;
+			gchar *filename;
+
+			prev = g_list_previous (link);
+
+			filename = g_build_filename (cdc->priv->path, entry->name, NULL);
+
+			d (printf ("evicting '%s' (%" G_GINT64_FORMAT " bytes)\n", filename, (gint64) entry->size));
+
+			data_cache_index_remove (cdc, entry->name);
+
+			g_unlink (filename);
+			stream = camel_object_bag_get (cdc->priv->busy_bag, filename);
+			if (stream) {
+				camel_object_bag_remove (cdc->priv->busy_bag, stream);
+				g_object_unref (stream);
+			}
+
+			g_free (filename);
+		}
+	}
+
+	if (cdc->priv->index_dirty &&
+	    cdc->priv->index_saved + CAMEL_DATA_CACHE_INDEX_SAVE_TIME < time (NULL))
+		data_cache_index_save (cdc);
+}
+
+/* Records the final size of an item once the stream
+ * it was written through from camel_data_cache_add() is gone. */
+static void
+data_cache_write_done (gpointer user_data,
+                       GObject *where_the_object_was)
+{
+	DataCacheWrite *write = user_data;
+	CamelDataCache *cdc = write->cdc;
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (cdc->priv->index != NULL) {
+		DataCacheEntry *entry;
+		struct stat st;
+		gchar *filename;
+
+		entry = g_hash_table_lookup (cdc->priv->index, write->name);
+		filename = g_build_filename (cdc->priv->path, write->name, NULL);
+
+		if (entry != NULL && g_stat (filename, &st) == 0) {
+			data_cache_index_set_size (cdc, entry, st.st_size);
+			data_cache_index_evict (cdc);
+		}
+
+		g_free (filename);
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
+	g_object_unref (write->cdc);
+	g_free (write->name);
+	g_slice_free (DataCacheWrite, write);
+}
+
 static void
 data_cache_set_property (GObject *object,
                          guint property_id,
@@ -112,6 +462,23 @@ data_cache_finalize (GObject *object)
 
 	priv = CAMEL_DATA_CACHE_GET_PRIVATE (object);
 
+	if (priv->index != NULL) {
+		if (priv->index_dirty)
+			data_cache_index_save (CAMEL_DATA_CACHE (object));
+
+		if (camel_debug ("datacache"))
+			printf (
+				"CamelDataCache '%s': %" G_GUINT64_FORMAT " hits, "
+				"%" G_GUINT64_FORMAT " misses, %" G_GINT64_FORMAT " bytes\n",
+				priv->path, priv->hits, priv->misses,
+				(gint64) priv->total_size);
+
+		g_queue_foreach (&priv->lru, (GFunc) data_cache_entry_free, NULL);
+		g_hash_table_destroy (priv->index);
+	}
+
+	g_rec_mutex_clear (&priv->index_lock);
+
 	camel_object_bag_destroy (priv->busy_bag);
 	g_free (priv->path);
 
@@ -157,6 +524,8 @@ camel_data_cache_init (CamelDataCache *data_cache)
 	data_cache->priv->busy_bag = busy_bag;
 	data_cache->priv->expire_age = -1;
 	data_cache->priv->expire_access = -1;
+
+	g_rec_mutex_init (&data_cache->priv->index_lock);
 }
 
 /**
@@ -272,6 +641,118 @@ camel_data_cache_set_expire_access (CamelDataCache *cdc,
 	cdc->priv->expire_access = when;
 }
 
+/**
+ * camel_data_cache_set_max_size:
+ * @cdc: a #CamelDataCache
+ * @max_size: the most bytes the cache may use, or 0 for no limit
+ *
+ * Limits the total size of the items in the cache.  Once the cache
+ * grows beyond @max_size, the least recently used items are removed
+ * until it is comfortably below it again.
+ *
+ * With a limit set, the cache keeps an index of its items, their sizes
+ * and the order they were used in, which is saved along with the cache.
+ * Setting a limit on an existing cache without an index builds one from
+ * the files on disk.
+ *
+ * Since: 3.12
+ **/
+void
+camel_data_cache_set_max_size (CamelDataCache *cdc,
+                               goffset max_size)
+{
+	g_return_if_fail (CAMEL_IS_DATA_CACHE (cdc));
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (max_size > 0) {
+		if (cdc->priv->index == NULL) {
+			cdc->priv->index = g_hash_table_new (g_str_hash, g_str_equal);
+			data_cache_index_load (cdc);
+		}
+
+		cdc->priv->max_size = max_size;
+		data_cache_index_evict (cdc);
+	} else if (cdc->priv->index != NULL) {
+		gchar *filename;
+
+		/* The index goes stale without a limit;
+		 * have it rebuilt if one is set again. */
+		filename = g_build_filename (
+			cdc->priv->path, CAMEL_DATA_CACHE_INDEX_NAME, NULL);
+		g_unlink (filename);
+		g_free (filename);
+
+		g_queue_foreach (&cdc->priv->lru, (GFunc) data_cache_entry_free, NULL);
+		g_queue_init (&cdc->priv->lru);
+		g_hash_table_destroy (cdc->priv->index);
+		cdc->priv->index = NULL;
+		cdc->priv->max_size = 0;
+		cdc->priv->total_size = 0;
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+}
+
+/**
+ * camel_data_cache_get_max_size:
+ * @cdc: a #CamelDataCache
+ *
+ * Returns the limit set with camel_data_cache_set_max_size().
+ *
+ * Returns: the most bytes the cache may use, or 0 for no limit
+ *
+ * Since: 3.12
+ **/
+goffset
+camel_data_cache_get_max_size (CamelDataCache *cdc)
+{
+	goffset max_size;
+
+	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), 0);
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+	max_size = cdc->priv->max_size;
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
+	return max_size;
+}
+
+/**
+ * camel_data_cache_get_statistics:
+ * @cdc: a #CamelDataCache
+ * @total_size: (out) (allow-none): return location for the size of
+ *   the items in the cache, or %NULL
+ * @hits: (out) (allow-none): return location for the number of
+ *   successful lookups, or %NULL
+ * @misses: (out) (allow-none): return location for the number of
+ *   failed lookups, or %NULL
+ *
+ * Reports how well the cache is doing since it was created.  The
+ * @total_size is only tracked with a limit set, and is 0 otherwise.
+ *
+ * Since: 3.12
+ **/
+void
+camel_data_cache_get_statistics (CamelDataCache *cdc,
+                                 goffset *total_size,
+                                 guint64 *hits,
+                                 guint64 *misses)
+{
+	g_return_if_fail (CAMEL_IS_DATA_CACHE (cdc));
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (total_size != NULL)
+		*total_size = cdc->priv->total_size;
+	if (hits != NULL)
+		*hits = cdc->priv->hits;
+	if (misses != NULL)
+		*misses = cdc->priv->misses;
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+}
+
 static void
 data_cache_expire (CamelDataCache *cdc,
                    const gchar *path,
@@ -301,6 +782,12 @@ data_cache_expire (CamelDataCache *cdc,
 		    && (expire_all
 			|| (cdc->priv->expire_age != -1 && st.st_mtime + cdc->priv->expire_age < now)
 			|| (cdc->priv->expire_access != -1 && st.st_atime + cdc->priv->expire_access < now))) {
+			g_rec_mutex_lock (&cdc->priv->index_lock);
+			if (cdc->priv->index != NULL)
+				data_cache_index_remove (
+					cdc, data_cache_relative_name (cdc, dpath));
+			g_rec_mutex_unlock (&cdc->priv->index_lock);
+
 			g_unlink (dpath);
 			stream = camel_object_bag_get (cdc->priv->busy_bag, dpath);
 			if (stream) {
@@ -402,6 +889,26 @@ camel_data_cache_add (CamelDataCache *cdc,
 	else
 		camel_object_bag_abort (cdc->priv->busy_bag, real);
 
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (stream != NULL && cdc->priv->index != NULL) {
+		DataCacheEntry *entry;
+		DataCacheWrite *write;
+		const gchar *name;
+
+		name = data_cache_relative_name (cdc, real);
+		entry = data_cache_index_touch (cdc, name);
+		data_cache_index_set_size (cdc, entry, 0);
+
+		/* the size is only known once the caller is done */
+		write = g_slice_new (DataCacheWrite);
+		write->cdc = g_object_ref (cdc);
+		write->name = g_strdup (name);
+		g_object_weak_ref (G_OBJECT (stream), data_cache_write_done, write);
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
 	g_free (real);
 
 	return stream;
@@ -450,6 +957,22 @@ camel_data_cache_get (CamelDataCache *cdc,
 		else
 			camel_object_bag_abort (cdc->priv->busy_bag, real);
 	}
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (stream != NULL) {
+		cdc->priv->hits++;
+		if (cdc->priv->index != NULL) {
+			data_cache_index_touch (
+				cdc, data_cache_relative_name (cdc, real));
+			data_cache_index_evict (cdc);
+		}
+	} else {
+		cdc->priv->misses++;
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
 	g_free (real);
 
 	return stream;
@@ -475,6 +998,68 @@ camel_data_cache_get_filename (CamelDataCache *cdc,
 	return data_cache_path (cdc, FALSE, path, key);
 }
 
+/**
+ * camel_data_cache_contains:
+ * @cdc: a #CamelDataCache
+ * @path: Path to the (sub) cache the item exists in.
+ * @key: Key for the cache item.
+ *
+ * Checks whether the cache holds a non-empty item for @key, without
+ * opening it or counting it as used.  With a limit set, see
+ * camel_data_cache_set_max_size(), this is answered from the index
+ * without touching the disk.
+ *
+ * Returns: %TRUE if the item is in the cache
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_data_cache_contains (CamelDataCache *cdc,
+                           const gchar *path,
+                           const gchar *key)
+{
+	gboolean contains = FALSE;
+	gboolean indexed = FALSE;
+
+	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+	g_return_val_if_fail (key != NULL, FALSE);
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (cdc->priv->index != NULL) {
+		DataCacheEntry *entry;
+		gchar *name, *tmp;
+		guint32 hash;
+
+		/* Same layout as data_cache_path(), relative to the base. */
+		hash = g_str_hash (key);
+		hash = (hash >> 5) &CAMEL_DATA_CACHE_MASK;
+		tmp = camel_file_util_safe_filename (key);
+		name = g_strdup_printf ("%s/%02x/%s", path, hash, tmp);
+
+		entry = g_hash_table_lookup (cdc->priv->index, name);
+		contains = entry != NULL && entry->size > 0;
+		indexed = TRUE;
+
+		g_free (name);
+		g_free (tmp);
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
+	if (!indexed) {
+		struct stat st;
+		gchar *real;
+
+		real = data_cache_path (cdc, FALSE, path, key);
+		contains = g_stat (real, &st) == 0 && st.st_size > 0;
+		g_free (real);
+	}
+
+	return contains;
+}
+
 /**
  * camel_data_cache_remove:
  * @cdc: A #CamelDataCache
@@ -503,6 +1088,12 @@ camel_data_cache_remove (CamelDataCache *cdc,
 		g_object_unref (stream);
 	}
 
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+	if (cdc->priv->index != NULL)
+		data_cache_index_remove (
+			cdc, data_cache_relative_name (cdc, real));
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
 	/* maybe we were a mem stream */
 	if (g_unlink (real) == -1 && errno != ENOENT) {
 		g_set_error (
@@ -520,6 +1111,86 @@ camel_data_cache_remove (CamelDataCache *cdc,
 	return ret;
 }
 
+/**
+ * camel_data_cache_rename:
+ * @cdc: a #CamelDataCache
+ * @old_path: Path to the (sub) cache the item exists in.
+ * @old_key: Key of the item to move.
+ * @new_path: Path to the (sub) cache to move the item to.
+ * @new_key: Key to store the item under.
+ * @error: return location for a #GError, or %NULL
+ *
+ * Moves an item within the cache, replacing any item already stored
+ * under @new_path and @new_key.  The item keeps its size and place in
+ * the index, so it still counts against the cache limit.  Use this
+ * rather than renaming the file returned by
+ * camel_data_cache_get_filename().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_data_cache_rename (CamelDataCache *cdc,
+                         const gchar *old_path,
+                         const gchar *old_key,
+                         const gchar *new_path,
+                         const gchar *new_key,
+                         GError **error)
+{
+	CamelStream *stream;
+	gchar *old_real, *new_real;
+	gboolean success = TRUE;
+
+	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), FALSE);
+	g_return_val_if_fail (old_path != NULL, FALSE);
+	g_return_val_if_fail (old_key != NULL, FALSE);
+	g_return_val_if_fail (new_path != NULL, FALSE);
+	g_return_val_if_fail (new_key != NULL, FALSE);
+
+	old_real = data_cache_path (cdc, FALSE, old_path, old_key);
+	new_real = data_cache_path (cdc, TRUE, new_path, new_key);
+
+	/* Streams still open on either name no longer match the file. */
+	stream = camel_object_bag_get (cdc->priv->busy_bag, old_real);
+	if (stream) {
+		camel_object_bag_remove (cdc->priv->busy_bag, stream);
+		g_object_unref (stream);
+	}
+	stream = camel_object_bag_get (cdc->priv->busy_bag, new_real);
+	if (stream) {
+		camel_object_bag_remove (cdc->priv->busy_bag, stream);
+		g_object_unref (stream);
+	}
+
+	g_rec_mutex_lock (&cdc->priv->index_lock);
+
+	if (g_rename (old_real, new_real) == -1) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Could not rename cache entry: %s: %s"),
+			old_real, g_strerror (errno));
+		success = FALSE;
+	} else if (cdc->priv->index != NULL) {
+		data_cache_index_remove (
+			cdc, data_cache_relative_name (cdc, old_real));
+		data_cache_index_remove (
+			cdc, data_cache_relative_name (cdc, new_real));
+		/* Picks up the size from the file on disk. */
+		data_cache_index_touch (
+			cdc, data_cache_relative_name (cdc, new_real));
+		data_cache_index_evict (cdc);
+	}
+
+	g_rec_mutex_unlock (&cdc->priv->index_lock);
+
+	g_free (old_real);
+	g_free (new_real);
+
+	return success;
+}
+
 /**
  * camel_data_cache_clear:
  * @cdc: a #CamelDataCache
@@ -74,6 +74,13 @@ void		camel_data_cache_set_expire_age	(CamelDataCache *cdc,
 void		camel_data_cache_set_expire_access
 						(CamelDataCache *cdc,
 						 time_t when);
+void		camel_data_cache_set_max_size	(CamelDataCache *cdc,
+						 goffset max_size);
+goffset		camel_data_cache_get_max_size	(CamelDataCache *cdc);
+void		camel_data_cache_get_statistics	(CamelDataCache *cdc,
+						 goffset *total_size,
+						 guint64 *hits,
+						 guint64 *misses);
 CamelStream *	camel_data_cache_add		(CamelDataCache *cdc,
 						 const gchar *path,
 						 const gchar *key,
@@ -89,6 +96,15 @@ gint		camel_data_cache_remove		(CamelDataCache *cdc,
 gchar *		camel_data_cache_get_filename	(CamelDataCache *cdc,
 						 const gchar *path,
 						 const gchar *key);
+gboolean	camel_data_cache_contains	(CamelDataCache *cdc,
+						 const gchar *path,
+						 const gchar *key);
+gboolean	camel_data_cache_rename		(CamelDataCache *cdc,
+						 const gchar *old_path,
+						 const gchar *old_key,
+						 const gchar *new_path,
+						 const gchar *new_key,
+						 GError **error);
 void		camel_data_cache_clear		(CamelDataCache *cdc,
 						 const gchar *path);
 
@@ -132,8 +132,9 @@ cdf_folder_changed (CamelFolder *folder,
 		camel_folder_change_info_cat (data->changes, changes);
 		data->folder = g_object_ref (folder);
 
-		camel_session_submit_job (
-			session,
+		camel_session_submit_job_full (
+			session, CAMEL_SERVICE (parent_store),
+			CAMEL_SESSION_JOB_PRIORITY_BACKGROUND, NULL,
 			(CamelSessionCallback) cdf_sync_offline,
 			data, (GDestroyNotify) cdf_sync_free);
 	}
@@ -289,6 +289,22 @@ typedef enum {
 	CAMEL_NETWORK_SECURITY_METHOD_STARTTLS_ON_STANDARD_PORT
 } CamelNetworkSecurityMethod;
 
+/**
+ * CamelDownsyncPolicy:
+ * @CAMEL_DOWNSYNC_POLICY_NEWEST_FIRST:
+ *   Download the most recently received messages first.
+ * @CAMEL_DOWNSYNC_POLICY_SMALLEST_FIRST:
+ *   Download the smallest messages first.
+ *
+ * The order in which messages are downloaded for offline use.
+ *
+ * Since: 3.12
+ **/
+typedef enum {
+	CAMEL_DOWNSYNC_POLICY_NEWEST_FIRST,
+	CAMEL_DOWNSYNC_POLICY_SMALLEST_FIRST
+} CamelDownsyncPolicy;
+
 typedef enum {
 	CAMEL_PROVIDER_CONF_END,
 	CAMEL_PROVIDER_CONF_SECTION_START,
@@ -387,6 +403,25 @@ typedef enum {
 	CAMEL_SESSION_ALERT_ERROR
 } CamelSessionAlertType;
 
+/**
+ * CamelSessionJobPriority:
+ * @CAMEL_SESSION_JOB_PRIORITY_NORMAL:
+ *   Regular jobs, such as filtering newly arrived messages.
+ * @CAMEL_SESSION_JOB_PRIORITY_BACKGROUND:
+ *   Bulk maintenance, such as downloading messages for offline
+ *   use or regenerating previews.  These only run when nothing
+ *   more important is waiting for the same service.
+ *
+ * Scheduling class of a job submitted with
+ * camel_session_submit_job_full().
+ *
+ * Since: 3.12
+ **/
+typedef enum {
+	CAMEL_SESSION_JOB_PRIORITY_NORMAL,
+	CAMEL_SESSION_JOB_PRIORITY_BACKGROUND
+} CamelSessionJobPriority;
+
 /**
  * CamelSortType:
  * @CAMEL_SORT_ASCENDING:
@@ -55,6 +55,11 @@
 /* an invalid pointer */
 #define FOLDER_INVALID ((gpointer)~0)
 
+/* how many messages camel_filter_driver_filter_folder() filters
+ * before it flushes the transfers it has batched up so far; this is
+ * also how often the UID cache is saved, as it was before batching */
+#define FILTER_BATCH_SIZE 10
+
 #define CAMEL_FILTER_DRIVER_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), CAMEL_TYPE_FILTER_DRIVER, CamelFilterDriverPrivate))
@@ -74,6 +79,14 @@ struct _filter_rule {
 	gchar *name;
 };
 
+/* messages waiting to be transferred to one destination folder */
+struct _filter_transfer {
+	CamelFolder *source;
+	CamelFolder *destination;
+	gboolean delete_originals;
+	GPtrArray *uids;
+};
+
 struct _CamelFilterDriverPrivate {
 	GHashTable *globals;       /* global variables */
 
@@ -102,6 +115,13 @@ struct _CamelFilterDriverPrivate {
 	gint closed;		   /* close count */
 	GHashTable *only_once;     /* actions to run only-once */
 
+	gboolean batch;            /* collect transfers instead of running them */
+	GQueue transfers;          /* queue of _filter_transfer structs */
+	gchar *queued_uid;         /* message with the last queued transfer */
+	gboolean queued_delete;    /* a queued transfer of it deletes the original */
+	GHashTable *failed_uids;   /* messages with a transfer which failed */
+	GHashTable *junk_test_results; /* uid -> junk-test result + 1 */
+
 	gboolean terminated;       /* message processing was terminated */
 	gboolean deleted;          /* message was marked for deletion */
 	gboolean copied;           /* message was copied to some folder or another */
@@ -127,6 +147,9 @@ static void camel_filter_driver_log (CamelFilterDriver *driver, enum filter_log_
 
 static CamelFolder *open_folder (CamelFilterDriver *d, const gchar *folder_url);
 static gint close_folders (CamelFilterDriver *d);
+static void transfer_message (CamelFilterDriver *d, CamelFolder *destination, gboolean delete_originals, GCancellable *cancellable);
+static gboolean flush_transfers (CamelFilterDriver *d, GCancellable *cancellable, GError **error);
+static void free_transfers (CamelFilterDriver *d);
 
 static CamelSExpResult *do_delete (struct _CamelSExp *f, gint argc, struct _CamelSExpResult **argv, CamelFilterDriver *);
 static CamelSExpResult *do_forward_to (struct _CamelSExp *f, gint argc, struct _CamelSExpResult **argv, CamelFilterDriver *);
@@ -218,6 +241,13 @@ filter_driver_finalize (GObject *object)
 
 	priv = CAMEL_FILTER_DRIVER_GET_PRIVATE (object);
 
+	/* drop anything left over from an aborted batch */
+	free_transfers (CAMEL_FILTER_DRIVER (object));
+	if (priv->failed_uids != NULL)
+		g_hash_table_destroy (priv->failed_uids);
+	if (priv->junk_test_results != NULL)
+		g_hash_table_destroy (priv->junk_test_results);
+
 	/* close all folders that were opened for appending */
 	close_folders (CAMEL_FILTER_DRIVER (object));
 	g_hash_table_destroy (priv->folders);
@@ -261,6 +291,7 @@ camel_filter_driver_init (CamelFilterDriver *filter_driver)
 	filter_driver->priv = CAMEL_FILTER_DRIVER_GET_PRIVATE (filter_driver);
 
 	g_queue_init (&filter_driver->priv->rules);
+	g_queue_init (&filter_driver->priv->transfers);
 
 	filter_driver->priv->eval = camel_sexp_new ();
 
@@ -534,17 +565,8 @@ do_copy (struct _CamelSExp *f,
 			    driver->priv->source != NULL &&
 			    camel_folder_has_summary_capability (
 					driver->priv->source)) {
-				GPtrArray *uids;
-
-				uids = g_ptr_array_new ();
-				g_ptr_array_add (
-					uids, (gchar *) driver->priv->uid);
 				/* FIXME Pass a GCancellable */
-				camel_folder_transfer_messages_to_sync (
-					driver->priv->source,
-					uids, outbox, FALSE, NULL, NULL,
-					&driver->priv->error);
-				g_ptr_array_free (uids, TRUE);
+				transfer_message (driver, outbox, FALSE, NULL);
 			} else {
 				if (driver->priv->message == NULL)
 					/* FIXME Pass a GCancellable */
@@ -603,15 +625,8 @@ do_move (struct _CamelSExp *f,
 			last = (i == argc - 1);
 
 			if (!driver->priv->modified && driver->priv->uid && driver->priv->source && camel_folder_has_summary_capability (driver->priv->source)) {
-				GPtrArray *uids;
-
-				uids = g_ptr_array_new ();
-				g_ptr_array_add (uids, (gchar *) driver->priv->uid);
 				/* FIXME Pass a GCancellable */
-				camel_folder_transfer_messages_to_sync (
-					driver->priv->source, uids, outbox, last,
-					NULL, NULL, &driver->priv->error);
-				g_ptr_array_free (uids, TRUE);
+				transfer_message (driver, outbox, last, NULL);
 			} else {
 				if (driver->priv->message == NULL)
 					/* FIXME Pass a GCancellable */
@@ -1171,6 +1186,143 @@ close_folder (gpointer key,
 		driver->priv->closed, _("Syncing folders"));
 }
 
+/* Transfers the current message from its source folder to @destination.
+ * While filtering a whole folder the transfer is only queued, so all the
+ * messages going to the same folder end up in one transfer call. */
+static void
+transfer_message (CamelFilterDriver *driver,
+                  CamelFolder *destination,
+                  gboolean delete_originals,
+                  GCancellable *cancellable)
+{
+	struct _filter_transfer *transfer = NULL;
+	GList *link;
+
+	if (!driver->priv->batch) {
+		GPtrArray *uids;
+
+		uids = g_ptr_array_new ();
+		g_ptr_array_add (uids, (gchar *) driver->priv->uid);
+		camel_folder_transfer_messages_to_sync (
+			driver->priv->source, uids, destination,
+			delete_originals, NULL, cancellable,
+			&driver->priv->error);
+		g_ptr_array_free (uids, TRUE);
+		return;
+	}
+
+	/* Transfers are grouped by destination, which can reorder them.
+	 * A transfer deleting the original must neither overtake nor be
+	 * overtaken by another transfer of the same message, so run what
+	 * is queued first. */
+	if ((delete_originals || driver->priv->queued_delete) &&
+	    g_strcmp0 (driver->priv->queued_uid, driver->priv->uid) == 0) {
+		if (!flush_transfers (
+			driver, cancellable,
+			(driver->priv->error != NULL) ?
+			NULL : &driver->priv->error))
+			return;
+	}
+
+	link = g_queue_peek_head_link (&driver->priv->transfers);
+	for (; link != NULL; link = g_list_next (link)) {
+		struct _filter_transfer *candidate = link->data;
+
+		if (candidate->source == driver->priv->source &&
+		    candidate->destination == destination &&
+		    candidate->delete_originals == delete_originals) {
+			transfer = candidate;
+			break;
+		}
+	}
+
+	if (transfer == NULL) {
+		transfer = g_new0 (struct _filter_transfer, 1);
+		transfer->source = g_object_ref (driver->priv->source);
+		transfer->destination = g_object_ref (destination);
+		transfer->delete_originals = delete_originals;
+		transfer->uids = g_ptr_array_new_with_free_func (g_free);
+		g_queue_push_tail (&driver->priv->transfers, transfer);
+	}
+
+	g_ptr_array_add (transfer->uids, g_strdup (driver->priv->uid));
+
+	if (g_strcmp0 (driver->priv->queued_uid, driver->priv->uid) != 0) {
+		g_free (driver->priv->queued_uid);
+		driver->priv->queued_uid = g_strdup (driver->priv->uid);
+		driver->priv->queued_delete = FALSE;
+	}
+
+	if (delete_originals)
+		driver->priv->queued_delete = TRUE;
+}
+
+static void
+filter_transfer_free (struct _filter_transfer *transfer)
+{
+	g_object_unref (transfer->source);
+	g_object_unref (transfer->destination);
+	g_ptr_array_free (transfer->uids, TRUE);
+	g_free (transfer);
+}
+
+/* Runs all queued transfers, one call per destination folder, in the
+ * order they were queued.  Stops transferring at the first error and
+ * remembers the messages of the failed and skipped transfers in
+ * failed_uids, but always empties the queue. */
+static gboolean
+flush_transfers (CamelFilterDriver *driver,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	struct _filter_transfer *transfer;
+	gboolean success = TRUE;
+
+	while ((transfer = g_queue_pop_head (&driver->priv->transfers)) != NULL) {
+		if (success)
+			success = camel_folder_transfer_messages_to_sync (
+				transfer->source, transfer->uids,
+				transfer->destination,
+				transfer->delete_originals,
+				NULL, cancellable, error);
+
+		if (!success) {
+			guint ii;
+
+			if (driver->priv->failed_uids == NULL)
+				driver->priv->failed_uids = g_hash_table_new_full (
+					g_str_hash, g_str_equal, g_free, NULL);
+
+			for (ii = 0; ii < transfer->uids->len; ii++)
+				g_hash_table_add (
+					driver->priv->failed_uids,
+					g_strdup (transfer->uids->pdata[ii]));
+		}
+
+		filter_transfer_free (transfer);
+	}
+
+	g_free (driver->priv->queued_uid);
+	driver->priv->queued_uid = NULL;
+	driver->priv->queued_delete = FALSE;
+
+	return success;
+}
+
+/* Empties the transfer queue without running anything. */
+static void
+free_transfers (CamelFilterDriver *driver)
+{
+	struct _filter_transfer *transfer;
+
+	while ((transfer = g_queue_pop_head (&driver->priv->transfers)) != NULL)
+		filter_transfer_free (transfer);
+
+	g_free (driver->priv->queued_uid);
+	driver->priv->queued_uid = NULL;
+	driver->priv->queued_delete = FALSE;
+}
+
 /* flush/close all folders */
 static gint
 close_folders (CamelFilterDriver *driver)
@@ -1485,6 +1637,43 @@ fail:
 	return ret;
 }
 
+/* Called once the transfers queued for @pending have been run: the
+ * messages whose transfers all went through are marked for removal
+ * and remembered as filtered, those with a failed one are not. */
+static void
+filter_folder_commit (CamelFilterDriver *driver,
+                      CamelFolder *folder,
+                      CamelUIDCache *cache,
+                      GPtrArray *pending,
+                      gboolean remove)
+{
+	GHashTable *failed_uids = driver->priv->failed_uids;
+	guint ii;
+
+	for (ii = 0; ii < pending->len; ii++) {
+		if (failed_uids != NULL &&
+		    g_hash_table_contains (failed_uids, pending->pdata[ii]))
+			continue;
+
+		if (remove)
+			camel_folder_set_message_flags (
+				folder, pending->pdata[ii],
+				CAMEL_MESSAGE_DELETED |
+				CAMEL_MESSAGE_SEEN, ~0);
+
+		if (cache)
+			camel_uid_cache_save_uid (cache, pending->pdata[ii]);
+	}
+
+	if (cache)
+		camel_uid_cache_save (cache);
+
+	g_ptr_array_set_size (pending, 0);
+
+	if (failed_uids != NULL)
+		g_hash_table_remove_all (failed_uids);
+}
+
 /**
  * camel_filter_driver_filter_folder:
  * @driver: CamelFilterDriver
@@ -1499,6 +1688,11 @@ fail:
  * Filters a folder based on rules defined in the FilterDriver
  * object.
  *
+ * Messages copied or moved to the same folder are collected and
+ * transferred together, so the destination folders see fewer, larger
+ * transfers instead of one per message.  Messages are only marked for
+ * removal and added to @cache once all their transfers have succeeded.
+ *
  * Returns: -1 if errors were encountered during filtering,
  * otherwise returns 0.
  *
@@ -1516,6 +1710,8 @@ camel_filter_driver_filter_folder (CamelFilterDriver *driver,
 	CamelMessageInfo *info;
 	CamelStore *parent_store;
 	const gchar *store_uid;
+	GPtrArray *pending;
+	GError *local_error = NULL;
 	gint status = 0;
 	gint i;
 
@@ -1527,9 +1723,24 @@ camel_filter_driver_filter_folder (CamelFilterDriver *driver,
 		freeuids = TRUE;
 	}
 
+	/* Copies and moves are collected and carried out in batches,
+	 * with one transfer per destination folder rather than one
+	 * per message. */
+	driver->priv->batch = TRUE;
+	pending = g_ptr_array_new ();
+
 	for (i = 0; i < uids->len; i++) {
 		gint pc = (100 * i) / uids->len;
-		GError *local_error = NULL;
+
+		if (pending->len >= FILTER_BATCH_SIZE) {
+			gboolean success;
+
+			success = flush_transfers (driver, cancellable, &local_error);
+			filter_folder_commit (driver, folder, cache, pending, remove);
+
+			if (!success)
+				break;
+		}
 
 		camel_operation_progress (cancellable, pc);
 
@@ -1550,34 +1761,35 @@ camel_filter_driver_filter_folder (CamelFilterDriver *driver,
 		if (camel_folder_has_summary_capability (folder))
 			camel_folder_free_message_info (folder, info);
 
-		if (local_error != NULL || status == -1) {
-			report_status (
-				driver, CAMEL_FILTER_STATUS_END, 100,
-				_("Failed at message %d of %d"),
-				i + 1, uids->len);
-			g_propagate_error (error, local_error);
-			status = -1;
+		if (local_error != NULL || status == -1)
 			break;
-		}
 
-		if (remove)
-			camel_folder_set_message_flags (
-				folder, uids->pdata[i],
-				CAMEL_MESSAGE_DELETED |
-				CAMEL_MESSAGE_SEEN, ~0);
+		g_ptr_array_add (pending, uids->pdata[i]);
+	}
 
-		if (cache)
-			camel_uid_cache_save_uid (cache, uids->pdata[i]);
-		if (cache && (i % 10) == 0)
-			camel_uid_cache_save (cache);
+	driver->priv->batch = FALSE;
+
+	/* Messages filtered before a failure were acted upon already,
+	 * so carry out whatever was queued for them in any case. */
+	if (!flush_transfers (
+		driver, cancellable,
+		(local_error != NULL) ? NULL : &local_error))
+		status = -1;
+
+	filter_folder_commit (driver, folder, cache, pending, remove);
+	g_ptr_array_free (pending, TRUE);
+
+	if (local_error != NULL || status == -1) {
+		report_status (
+			driver, CAMEL_FILTER_STATUS_END, 100,
+			_("Failed at message %d of %d"),
+			MIN (i + 1, uids->len), uids->len);
+		g_propagate_error (error, local_error);
+		status = -1;
 	}
 
 	camel_operation_progress (cancellable, 100);
 
-	/* Save the cache of any pending mails. */
-	if (cache)
-		camel_uid_cache_save (cache);
-
 	if (driver->priv->defaultfolder) {
 		report_status (
 			driver, CAMEL_FILTER_STATUS_PROGRESS,
@@ -1586,7 +1798,7 @@ camel_filter_driver_filter_folder (CamelFilterDriver *driver,
 			driver->priv->defaultfolder, FALSE, cancellable, NULL);
 	}
 
-	if (i == uids->len)
+	if (status != -1)
 		report_status (
 			driver, CAMEL_FILTER_STATUS_END,
 			100, _("Complete"));
@@ -1597,6 +1809,65 @@ camel_filter_driver_filter_folder (CamelFilterDriver *driver,
 	return status;
 }
 
+/**
+ * camel_filter_driver_junk_test_messages:
+ * @driver: a #CamelFilterDriver
+ * @folder: the #CamelFolder holding the messages
+ * @uids: UIDs of messages in @folder about to be filtered
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Runs the <literal>junk-test</literal> filter function over @uids at
+ * once, with camel_filter_search_junk_test_messages(), so the junk
+ * filter can classify the messages in batches.  The results are kept
+ * for the next camel_filter_driver_filter_message() call on each of
+ * the messages, which then does not ask the junk filter again.
+ *
+ * Returns: %TRUE on success, %FALSE if @error was set
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_filter_driver_junk_test_messages (CamelFilterDriver *driver,
+                                        CamelFolder *folder,
+                                        GPtrArray *uids,
+                                        GCancellable *cancellable,
+                                        GError **error)
+{
+	gint *results;
+	gboolean success;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_FILTER_DRIVER (driver), FALSE);
+	g_return_val_if_fail (CAMEL_IS_FOLDER (folder), FALSE);
+	g_return_val_if_fail (uids != NULL, FALSE);
+
+	results = g_new (gint, uids->len);
+
+	success = camel_filter_search_junk_test_messages (
+		driver->priv->session, folder, uids,
+		results, cancellable, error);
+
+	if (driver->priv->junk_test_results == NULL)
+		driver->priv->junk_test_results = g_hash_table_new_full (
+			g_str_hash, g_str_equal, g_free, NULL);
+
+	/* Keep what was tested even on failure. */
+	for (ii = 0; ii < uids->len; ii++) {
+		if (results[ii] == -1)
+			continue;
+
+		g_hash_table_insert (
+			driver->priv->junk_test_results,
+			g_strdup (uids->pdata[ii]),
+			GINT_TO_POINTER (results[ii] + 1));
+	}
+
+	g_free (results);
+
+	return success;
+}
+
 struct _get_message {
 	struct _CamelFilterDriverPrivate *priv;
 	const gchar *store_uid;
@@ -1668,6 +1939,7 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 	gboolean filtered = FALSE;
 	CamelSExpResult *r;
 	GList *list, *link;
+	gint junk_test_result = -1;
 	gint result;
 
 	/* FIXME: make me into a g_return_if_fail/g_assert or whatever... */
@@ -1723,6 +1995,20 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 		original_store_uid = NULL;
 	}
 
+	/* Use a junk test done by camel_filter_driver_junk_test_messages(),
+	 * for every rule but for this message only. */
+	if (uid != NULL && driver->priv->junk_test_results != NULL) {
+		gpointer value;
+
+		value = g_hash_table_lookup (
+			driver->priv->junk_test_results, uid);
+		if (value != NULL) {
+			junk_test_result = GPOINTER_TO_INT (value) - 1;
+			g_hash_table_remove (
+				driver->priv->junk_test_results, uid);
+		}
+	}
+
 	list = g_queue_peek_head_link (&driver->priv->rules);
 	result = CAMEL_SEARCH_NOMATCH;
 
@@ -1741,9 +2027,10 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 		if (original_store_uid == NULL)
 			original_store_uid = store_uid;
 
-		result = camel_filter_search_match (
+		result = camel_filter_search_match_full (
 			driver->priv->session, get_message_cb, &data, driver->priv->info,
-			original_store_uid, rule->match, &driver->priv->error);
+			original_store_uid, junk_test_result, rule->match,
+			&driver->priv->error);
 
 		switch (result) {
 		case CAMEL_SEARCH_ERROR:
@@ -1799,6 +2086,15 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 
 	/* *Now* we can set the DELETED flag... */
 	if (driver->priv->deleted) {
+		/* ...once the transfers queued for the message have run */
+		if (driver->priv->batch &&
+		    g_strcmp0 (driver->priv->queued_uid, driver->priv->uid) == 0 &&
+		    !flush_transfers (
+			driver, cancellable,
+			(driver->priv->error != NULL) ?
+			NULL : &driver->priv->error))
+			goto error;
+
 		if (driver->priv->source && driver->priv->uid && camel_folder_has_summary_capability (driver->priv->source))
 			camel_folder_set_message_flags (
 				driver->priv->source, driver->priv->uid,
@@ -1820,14 +2116,9 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 			"Copy to default folder");
 
 		if (!driver->priv->modified && driver->priv->uid && driver->priv->source && camel_folder_has_summary_capability (driver->priv->source)) {
-			GPtrArray *uids;
-
-			uids = g_ptr_array_new ();
-			g_ptr_array_add (uids, (gchar *) driver->priv->uid);
-			camel_folder_transfer_messages_to_sync (
-				driver->priv->source, uids, driver->priv->defaultfolder,
-				FALSE, NULL, cancellable, &driver->priv->error);
-			g_ptr_array_free (uids, TRUE);
+			transfer_message (
+				driver, driver->priv->defaultfolder,
+				FALSE, cancellable);
 		} else {
 			if (driver->priv->message == NULL) {
 				driver->priv->message = camel_folder_get_message_sync (
@@ -130,6 +130,12 @@ gint		camel_filter_driver_filter_folder
 						 gboolean remove,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	camel_filter_driver_junk_test_messages
+						(CamelFilterDriver *driver,
+						 CamelFolder *folder,
+						 GPtrArray *uids,
+						 GCancellable *cancellable,
+						 GError **error);
 
 G_END_DECLS
 
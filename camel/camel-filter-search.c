@@ -56,6 +56,10 @@
 #include "camel-string-utils.h"
 #include "camel-url.h"
 
+/* How many messages are handed to the junk filter at once, see
+ * camel_filter_search_junk_test_messages() */
+#define JUNK_TEST_BATCH_SIZE 32
+
 #define d(x)
 
 typedef struct {
@@ -65,6 +69,7 @@ typedef struct {
 	CamelMimeMessage *message;
 	CamelMessageInfo *info;
 	const gchar *source;
+	gint junk_test_result;
 	GError **error;
 } FilterMessageSearch;
 
@@ -858,27 +863,20 @@ pipe_message (struct _CamelSExp *f,
 	return r;
 }
 
-static CamelSExpResult *
-junk_test (struct _CamelSExp *f,
-           gint argc,
-           struct _CamelSExpResult **argv,
-           FilterMessageSearch *fms)
+/* The checks junk-test makes before consulting the junk filter, which
+ * settle most messages.  Returns TRUE with the verdict in @is_junk if
+ * they do, FALSE if the junk filter has to decide. */
+static gboolean
+junk_test_precheck (CamelSession *session,
+                    CamelMessageInfo *info,
+                    gboolean *is_junk)
 {
-	CamelSExpResult *r;
-	CamelMessageInfo *info = fms->info;
-	CamelJunkFilter *junk_filter;
 	CamelMessageFlags flags;
-	CamelMimeMessage *message;
-	CamelJunkStatus status;
 	const GHashTable *ht;
 	const struct _camel_header_param *node;
 	gboolean sender_is_known;
-	gboolean message_is_junk = FALSE;
-	GError *error = NULL;
 
-	junk_filter = camel_session_get_junk_filter (fms->session);
-	if (junk_filter == NULL)
-		goto exit;
+	*is_junk = FALSE;
 
 	/* Check if the message is already classified. */
 
@@ -889,7 +887,7 @@ junk_test (struct _CamelSExp *f,
 			printf (
 				"Message has a Junk flag set already, "
 				"skipping junk test...\n");
-		goto exit;
+		return TRUE;
 	}
 
 	if (flags & CAMEL_MESSAGE_NOTJUNK) {
@@ -897,12 +895,12 @@ junk_test (struct _CamelSExp *f,
 			printf (
 				"Message has a NotJunk flag set already, "
 				"skipping junk test...\n");
-		goto exit;
+		return TRUE;
 	}
 
 	/* Check the headers for a junk designation. */
 
-	ht = camel_session_get_junk_headers (fms->session);
+	ht = camel_session_get_junk_headers (session);
 	node = camel_message_info_headers (info);
 
 	while (node != NULL) {
@@ -912,16 +910,16 @@ junk_test (struct _CamelSExp *f,
 			value = g_hash_table_lookup (
 				(GHashTable *) ht, node->name);
 
-		message_is_junk =
+		*is_junk =
 			(value != NULL) &&
 			(camel_strstrcase (node->value, value) != NULL);
 
-		if (message_is_junk) {
+		if (*is_junk) {
 			if (camel_debug ("junk"))
 				printf (
 					"Message contains \"%s: %s\"",
 					node->name, value);
-			goto done;
+			return TRUE;
 		}
 
 		node = node->next;
@@ -930,56 +928,91 @@ junk_test (struct _CamelSExp *f,
 	/* If the sender is known, the message is not junk. */
 
 	sender_is_known = camel_session_lookup_addressbook (
-		fms->session, camel_message_info_from (info));
+		session, camel_message_info_from (info));
 	if (camel_debug ("junk"))
 		printf (
 			"Sender '%s' in book? %d\n",
 			camel_message_info_from (info),
 			sender_is_known);
-	if (sender_is_known)
-		goto done;
 
-	/* Consult 3rd party junk filtering software. */
+	return sender_is_known;
+}
 
-	message = camel_filter_search_get_message (fms, f);
-	status = camel_junk_filter_classify (
-		junk_filter, message, NULL, &error);
-
-	if (error == NULL) {
-		const gchar *status_desc;
-
-		switch (status) {
-			case CAMEL_JUNK_STATUS_INCONCLUSIVE:
-				status_desc = "inconclusive";
-				message_is_junk = FALSE;
-				break;
-			case CAMEL_JUNK_STATUS_MESSAGE_IS_JUNK:
-				status_desc = "junk";
-				message_is_junk = TRUE;
-				break;
-			case CAMEL_JUNK_STATUS_MESSAGE_IS_NOT_JUNK:
-				status_desc = "not junk";
-				message_is_junk = FALSE;
-				break;
-			default:
-				g_warn_if_reached ();
-				status_desc = "invalid";
-				message_is_junk = FALSE;
-				break;
-		}
+/* Turns what the junk filter said about a message into the verdict. */
+static gboolean
+junk_test_status_is_junk (CamelJunkStatus status,
+                          const GError *error)
+{
+	const gchar *status_desc;
+	gboolean is_junk;
 
-		if (camel_debug ("junk"))
-			g_print (
-				"Junk filter classification: %s\n",
-				status_desc);
-	} else {
+	if (error != NULL) {
 		g_warn_if_fail (status == CAMEL_JUNK_STATUS_ERROR);
 		g_warning ("%s: %s", G_STRFUNC, error->message);
-		g_error_free (error);
-		message_is_junk = FALSE;
+		return FALSE;
+	}
+
+	switch (status) {
+		case CAMEL_JUNK_STATUS_INCONCLUSIVE:
+			status_desc = "inconclusive";
+			is_junk = FALSE;
+			break;
+		case CAMEL_JUNK_STATUS_MESSAGE_IS_JUNK:
+			status_desc = "junk";
+			is_junk = TRUE;
+			break;
+		case CAMEL_JUNK_STATUS_MESSAGE_IS_NOT_JUNK:
+			status_desc = "not junk";
+			is_junk = FALSE;
+			break;
+		default:
+			g_warn_if_reached ();
+			status_desc = "invalid";
+			is_junk = FALSE;
+			break;
+	}
+
+	if (camel_debug ("junk"))
+		g_print (
+			"Junk filter classification: %s\n",
+			status_desc);
+
+	return is_junk;
+}
+
+static CamelSExpResult *
+junk_test (struct _CamelSExp *f,
+           gint argc,
+           struct _CamelSExpResult **argv,
+           FilterMessageSearch *fms)
+{
+	CamelSExpResult *r;
+	CamelJunkFilter *junk_filter;
+	gboolean message_is_junk = FALSE;
+
+	junk_filter = camel_session_get_junk_filter (fms->session);
+	if (junk_filter == NULL)
+		goto exit;
+
+	/* Tested along with other messages already,
+	 * see camel_filter_search_junk_test_messages() */
+	if (fms->junk_test_result != -1) {
+		message_is_junk = fms->junk_test_result;
+	} else if (!junk_test_precheck (fms->session, fms->info, &message_is_junk)) {
+		CamelMimeMessage *message;
+		CamelJunkStatus status;
+		GError *error = NULL;
+
+		/* Consult 3rd party junk filtering software. */
+
+		message = camel_filter_search_get_message (fms, f);
+		status = camel_junk_filter_classify (
+			junk_filter, message, NULL, &error);
+
+		message_is_junk = junk_test_status_is_junk (status, error);
+		g_clear_error (&error);
 	}
 
-done:
 	if (camel_debug ("junk"))
 		printf (
 			"Message is determined to be %s\n",
@@ -1013,6 +1046,43 @@ camel_filter_search_match (CamelSession *session,
                            const gchar *source,
                            const gchar *expression,
                            GError **error)
+{
+	return camel_filter_search_match_full (
+		session, get_message, data, info, source,
+		-1, expression, error);
+}
+
+/**
+ * camel_filter_search_match_full:
+ * @session: a #CamelSession
+ * @get_message: function to retrieve the message if necessary
+ * @data: data for above
+ * @info: the #CamelMessageInfo of the message
+ * @source: the source of the message, or %NULL
+ * @junk_test_result: what <literal>junk-test</literal> gives for the
+ *                    message, as found by
+ *                    camel_filter_search_junk_test_messages(), or -1
+ *                    to have it test the message itself
+ * @expression: the filter expression
+ * @error: return location for a #GError, or %NULL
+ *
+ * Like camel_filter_search_match(), for a message whose junk test
+ * has already been done.
+ *
+ * Returns: one of CAMEL_SEARCH_MATCHED, CAMEL_SEARCH_NOMATCH, or
+ * CAMEL_SEARCH_ERROR.
+ *
+ * Since: 3.12
+ **/
+gint
+camel_filter_search_match_full (CamelSession *session,
+                                CamelFilterSearchGetMessageFunc get_message,
+                                gpointer data,
+                                CamelMessageInfo *info,
+                                const gchar *source,
+                                gint junk_test_result,
+                                const gchar *expression,
+                                GError **error)
 {
 	FilterMessageSearch fms;
 	CamelSExp *sexp;
@@ -1026,6 +1096,7 @@ camel_filter_search_match (CamelSession *session,
 	fms.message = NULL;
 	fms.info = info;
 	fms.source = source;
+	fms.junk_test_result = junk_test_result;
 	fms.error = error;
 
 	sexp = camel_sexp_new ();
@@ -1078,3 +1149,137 @@ camel_filter_search_match (CamelSession *session,
 
 	return CAMEL_SEARCH_ERROR;
 }
+
+/* Classifies the messages of a batch, and records the verdicts. */
+static gboolean
+junk_test_classify_batch (CamelJunkFilter *junk_filter,
+                          GPtrArray *messages,
+                          GArray *positions,
+                          gint *out_results,
+                          GCancellable *cancellable,
+                          GError **error)
+{
+	CamelJunkStatus *statuses;
+	gboolean success;
+	guint ii;
+
+	statuses = g_new0 (CamelJunkStatus, messages->len);
+
+	success = camel_junk_filter_classify_messages (
+		junk_filter, messages, statuses, cancellable, error);
+
+	for (ii = 0; ii < messages->len; ii++) {
+		if (statuses[ii] != CAMEL_JUNK_STATUS_ERROR)
+			out_results[g_array_index (positions, guint, ii)] =
+				junk_test_status_is_junk (statuses[ii], NULL);
+	}
+
+	g_free (statuses);
+
+	g_ptr_array_set_size (messages, 0);
+	g_array_set_size (positions, 0);
+
+	return success;
+}
+
+/**
+ * camel_filter_search_junk_test_messages:
+ * @session: a #CamelSession
+ * @folder: the #CamelFolder holding the messages
+ * @uids: UIDs of messages in @folder
+ * @out_results: return location for one result per UID, with room
+ *               for at least @uids->len elements
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Does what the <literal>junk-test</literal> filter function does, for
+ * several messages at once.  The messages which it cannot settle from
+ * their flags, headers or sender go to the junk filter in batches,
+ * through camel_junk_filter_classify_messages(), so a slow junk filter
+ * is not asked about them one at a time.
+ *
+ * Each result is %TRUE for junk and %FALSE for clean; pass it on to
+ * camel_filter_search_match_full() when filtering the message.  It is
+ * -1 for a message which could not be tested, for which
+ * <literal>junk-test</literal> will try again.
+ *
+ * Returns: %TRUE on success, %FALSE if @error was set
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_filter_search_junk_test_messages (CamelSession *session,
+                                        CamelFolder *folder,
+                                        GPtrArray *uids,
+                                        gint *out_results,
+                                        GCancellable *cancellable,
+                                        GError **error)
+{
+	CamelJunkFilter *junk_filter;
+	GPtrArray *messages;
+	GArray *positions;
+	gboolean success = TRUE;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (CAMEL_IS_FOLDER (folder), FALSE);
+	g_return_val_if_fail (uids != NULL, FALSE);
+	g_return_val_if_fail (out_results != NULL, FALSE);
+
+	for (ii = 0; ii < uids->len; ii++)
+		out_results[ii] = -1;
+
+	junk_filter = camel_session_get_junk_filter (session);
+	if (junk_filter == NULL)
+		return TRUE;
+
+	messages = g_ptr_array_new_with_free_func (g_object_unref);
+	positions = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	for (ii = 0; success && ii < uids->len; ii++) {
+		CamelMessageInfo *info;
+		CamelMimeMessage *message;
+		gboolean is_junk, settled;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+			success = FALSE;
+			break;
+		}
+
+		info = camel_folder_get_message_info (folder, uids->pdata[ii]);
+		if (info == NULL)
+			continue;
+
+		settled = junk_test_precheck (session, info, &is_junk);
+		camel_folder_free_message_info (folder, info);
+
+		if (settled) {
+			out_results[ii] = is_junk;
+			continue;
+		}
+
+		/* Left for junk-test to try again. */
+		message = camel_folder_get_message_sync (
+			folder, uids->pdata[ii], cancellable, NULL);
+		if (message == NULL)
+			continue;
+
+		g_ptr_array_add (messages, message);
+		g_array_append_val (positions, ii);
+
+		if (messages->len == JUNK_TEST_BATCH_SIZE)
+			success = junk_test_classify_batch (
+				junk_filter, messages, positions,
+				out_results, cancellable, error);
+	}
+
+	if (success && messages->len > 0)
+		success = junk_test_classify_batch (
+			junk_filter, messages, positions,
+			out_results, cancellable, error);
+
+	g_ptr_array_unref (messages);
+	g_array_unref (positions);
+
+	return success;
+}
@@ -30,6 +30,7 @@
 
 #include <camel/camel-mime-message.h>
 #include <camel/camel-folder-summary.h>
+#include <camel/camel-folder.h>
 
 G_BEGIN_DECLS
 
@@ -47,6 +48,15 @@ gint camel_filter_search_match (struct _CamelSession *session,
 			       CamelFilterSearchGetMessageFunc get_message, gpointer data,
 			       CamelMessageInfo *info, const gchar *source,
 			       const gchar *expression, GError **error);
+gint camel_filter_search_match_full (struct _CamelSession *session,
+				    CamelFilterSearchGetMessageFunc get_message, gpointer data,
+				    CamelMessageInfo *info, const gchar *source,
+				    gint junk_test_result,
+				    const gchar *expression, GError **error);
+gboolean camel_filter_search_junk_test_messages (struct _CamelSession *session,
+						 CamelFolder *folder, GPtrArray *uids,
+						 gint *out_results,
+						 GCancellable *cancellable, GError **error);
 
 G_END_DECLS
 
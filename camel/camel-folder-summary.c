@@ -2124,8 +2124,11 @@ cfs_try_release_memory (CamelFolderSummary *summary)
 	parent_store = camel_folder_get_parent_store (summary->priv->folder);
 	session = camel_service_ref_session (CAMEL_SERVICE (parent_store));
 
-	camel_session_submit_job (
-		session,
+	/* Not a background job: those can be held back for a long
+	 * time, while this one is what gives the memory back. */
+	camel_session_submit_job_full (
+		session, NULL,
+		CAMEL_SESSION_JOB_PRIORITY_NORMAL, NULL,
 		(CamelSessionCallback) remove_cache,
 		g_object_ref (summary),
 		(GDestroyNotify) g_object_unref);
@@ -2320,8 +2323,9 @@ cfs_reload_from_db (CamelFolderSummary *summary,
 	cfs_schedule_info_release_timer (summary);
 
 	if (summary->priv->need_preview)
-		camel_session_submit_job (
-			session,
+		camel_session_submit_job_full (
+			session, CAMEL_SERVICE (parent_store),
+			CAMEL_SESSION_JOB_PRIORITY_BACKGROUND, NULL,
 			(CamelSessionCallback) preview_update,
 			g_object_ref (summary->priv->folder),
 			(GDestroyNotify) g_object_unref);
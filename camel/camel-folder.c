@@ -280,6 +280,142 @@ prepare_folder_filter_data_free (FolderFilterData *data)
 	g_thread_unref (thread);
 }
 
+/* How many messages are handed to the junk filter at once
+ * when learning from messages the user marked. */
+#define JUNK_LEARN_BATCH_SIZE 32
+
+typedef struct _JunkLearnBatch JunkLearnBatch;
+
+struct _JunkLearnBatch {
+	CamelJunkFilter *junk_filter;
+	GPtrArray *messages;
+	gboolean junk;
+	GCancellable *cancellable;
+	gboolean success;
+	GError *error;
+};
+
+static gpointer
+folder_filter_learn_thread (gpointer user_data)
+{
+	JunkLearnBatch *batch = user_data;
+
+	if (batch->junk)
+		batch->success = camel_junk_filter_learn_junk_messages (
+			batch->junk_filter, batch->messages,
+			batch->cancellable, &batch->error);
+	else
+		batch->success = camel_junk_filter_learn_not_junk_messages (
+			batch->junk_filter, batch->messages,
+			batch->cancellable, &batch->error);
+
+	return NULL;
+}
+
+/* Waits for a batch started by folder_filter_learn() and frees it. */
+static gboolean
+folder_filter_learn_finish (GThread *thread,
+                            JunkLearnBatch *batch,
+                            GError **error)
+{
+	gboolean success;
+
+	g_thread_join (thread);
+
+	success = batch->success;
+	if (batch->error != NULL)
+		g_propagate_error (error, batch->error);
+
+	g_ptr_array_free (batch->messages, TRUE);
+	if (batch->cancellable != NULL)
+		g_object_unref (batch->cancellable);
+	g_slice_free (JunkLearnBatch, batch);
+
+	return success;
+}
+
+/* Teaches the junk filter about the messages in @uids.  Messages
+ * are handed over in batches, and each batch is learned in its own
+ * thread while the messages of the next one are being fetched, so
+ * slow junk filters and slow message downloads overlap. */
+static gboolean
+folder_filter_learn (CamelFolder *folder,
+                     CamelJunkFilter *junk_filter,
+                     GPtrArray *uids,
+                     gboolean junk,
+                     gboolean *out_learned,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+	JunkLearnBatch *batch = NULL;
+	GThread *thread = NULL;
+	GPtrArray *messages;
+	gboolean success = TRUE;
+	guint ii;
+
+	messages = g_ptr_array_new_with_free_func (g_object_unref);
+
+	for (ii = 0; success && ii < uids->len; ii++) {
+		CamelMimeMessage *message;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+			success = FALSE;
+			break;
+		}
+
+		message = camel_folder_get_message_sync (
+			folder, uids->pdata[ii], cancellable, error);
+
+		if (message == NULL) {
+			success = FALSE;
+			break;
+		}
+
+		g_ptr_array_add (messages, message);
+		camel_operation_progress (cancellable, 100 * ii / uids->len);
+
+		if (messages->len < JUNK_LEARN_BATCH_SIZE && ii + 1 < uids->len)
+			continue;
+
+		if (thread != NULL) {
+			success = folder_filter_learn_finish (
+				thread, batch, error);
+			*out_learned |= success;
+			thread = NULL;
+
+			if (!success)
+				break;
+		}
+
+		batch = g_slice_new0 (JunkLearnBatch);
+		batch->junk_filter = junk_filter;
+		batch->messages = messages;
+		batch->junk = junk;
+		if (cancellable != NULL)
+			batch->cancellable = g_object_ref (cancellable);
+
+		thread = g_thread_new (
+			"camel-junk-learn",
+			folder_filter_learn_thread, batch);
+
+		messages = g_ptr_array_new_with_free_func (g_object_unref);
+	}
+
+	if (thread != NULL) {
+		gboolean learned;
+
+		/* Do not let a learning error replace an earlier one. */
+		learned = folder_filter_learn_finish (
+			thread, batch, success ? error : NULL);
+		*out_learned |= learned;
+		success = success && learned;
+	}
+
+	g_ptr_array_free (messages, TRUE);
+
+	return success;
+}
+
 static void
 folder_filter (CamelSession *session,
                GCancellable *cancellable,
@@ -302,8 +438,6 @@ folder_filter (CamelSession *session,
 		g_object_ref (junk_filter);
 
 	if (data->junk) {
-		gboolean success = TRUE;
-
 		/* Translators: The %s is replaced with the
 		 * folder name where the operation is running. */
 		camel_operation_push_message (
@@ -312,28 +446,9 @@ folder_filter (CamelSession *session,
 			"Learning new spam messages in '%s'",
 			data->junk->len), display_name);
 
-		for (i = 0; success && i < data->junk->len; i++) {
-			CamelMimeMessage *message;
-			gint pc = 100 * i / data->junk->len;
-
-			if (g_cancellable_set_error_if_cancelled (
-				cancellable, error))
-				break;
-
-			message = camel_folder_get_message_sync (
-				data->folder, data->junk->pdata[i],
-				cancellable, error);
-
-			if (message == NULL)
-				break;
-
-			camel_operation_progress (cancellable, pc);
-			success = camel_junk_filter_learn_junk (
-				junk_filter, message, cancellable, error);
-			g_object_unref (message);
-
-			synchronize |= success;
-		}
+		folder_filter_learn (
+			data->folder, junk_filter, data->junk, TRUE,
+			&synchronize, cancellable, error);
 
 		camel_operation_pop_message (cancellable);
 	}
@@ -342,8 +457,6 @@ folder_filter (CamelSession *session,
 		goto exit;
 
 	if (data->notjunk) {
-		gboolean success = TRUE;
-
 		/* Translators: The %s is replaced with the
 		 * folder name where the operation is running. */
 		camel_operation_push_message (
@@ -352,28 +465,9 @@ folder_filter (CamelSession *session,
 			"Learning new ham messages in '%s'",
 			data->notjunk->len), display_name);
 
-		for (i = 0; success && i < data->notjunk->len; i++) {
-			CamelMimeMessage *message;
-			gint pc = 100 * i / data->notjunk->len;
-
-			if (g_cancellable_set_error_if_cancelled (
-				cancellable, error))
-				break;
-
-			message = camel_folder_get_message_sync (
-				data->folder, data->notjunk->pdata[i],
-				cancellable, error);
-
-			if (message == NULL)
-				break;
-
-			camel_operation_progress (cancellable, pc);
-			success = camel_junk_filter_learn_not_junk (
-				junk_filter, message, cancellable, error);
-			g_object_unref (message);
-
-			synchronize |= success;
-		}
+		folder_filter_learn (
+			data->folder, junk_filter, data->notjunk, FALSE,
+			&synchronize, cancellable, error);
 
 		camel_operation_pop_message (cancellable);
 	}
@@ -403,6 +497,25 @@ folder_filter (CamelSession *session,
 		service = CAMEL_SERVICE (parent_store);
 		store_uid = camel_service_get_uid (service);
 
+		/* Let the junk filter classify the new messages in
+		 * batches; the junk-test rules then use its verdicts. */
+		if (junk_filter != NULL &&
+		    (data->folder->folder_flags & CAMEL_FOLDER_FILTER_JUNK)) {
+			GError *local_error = NULL;
+
+			camel_filter_driver_junk_test_messages (
+				data->driver, data->folder, data->recents,
+				cancellable, &local_error);
+
+			/* Not fatal, junk-test tests the rest one by one. */
+			if (local_error != NULL) {
+				g_warning (
+					"%s: %s", G_STRFUNC,
+					local_error->message);
+				g_error_free (local_error);
+			}
+		}
+
 		for (i = 0; status == 0 && i < data->recents->len; i++) {
 			gchar *uid = data->recents->pdata[i];
 			gint pc = 100 * i / data->recents->len;
@@ -1807,8 +1920,10 @@ folder_changed (CamelFolder *folder,
 			folder->priv->changed_frozen, info);
 		camel_folder_unlock (folder, CAMEL_FOLDER_CHANGE_LOCK);
 
-		camel_session_submit_job (
-			session, (CamelSessionCallback) folder_filter,
+		camel_session_submit_job_full (
+			session, CAMEL_SERVICE (parent_store),
+			CAMEL_SESSION_JOB_PRIORITY_NORMAL, NULL,
+			(CamelSessionCallback) folder_filter,
 			data, (GDestroyNotify) prepare_folder_filter_data_free);
 
 		g_signal_stop_emission (folder, signals[CHANGED], 0);
@@ -427,6 +427,29 @@ imapx_get_filename (CamelFolder *folder,
 		imapx_folder->cache, "cache", uid);
 }
 
+static GPtrArray *
+imapx_get_uncached_uids (CamelFolder *folder,
+                         GPtrArray *uids,
+                         GError **error)
+{
+	CamelIMAPXFolder *imapx_folder;
+	GPtrArray *result;
+	guint ii;
+
+	imapx_folder = CAMEL_IMAPX_FOLDER (folder);
+	result = g_ptr_array_sized_new (uids->len);
+
+	for (ii = 0; ii < uids->len; ii++) {
+		const gchar *uid = uids->pdata[ii];
+
+		if (!camel_data_cache_contains (imapx_folder->cache, "cur", uid))
+			g_ptr_array_add (
+				result, (gpointer) camel_pstring_strdup (uid));
+	}
+
+	return result;
+}
+
 static gboolean
 imapx_append_message_sync (CamelFolder *folder,
                            CamelMimeMessage *message,
@@ -905,6 +928,33 @@ imapx_synchronize_message_sync (CamelFolder *folder,
 	return success;
 }
 
+static gboolean
+imapx_synchronize_messages_sync (CamelOfflineFolder *folder,
+                                 GPtrArray *uids,
+                                 GCancellable *cancellable,
+                                 GError **error)
+{
+	CamelStore *store;
+	CamelIMAPXStore *imapx_store;
+	CamelIMAPXServer *imapx_server;
+	gboolean success = FALSE;
+
+	store = camel_folder_get_parent_store (CAMEL_FOLDER (folder));
+
+	imapx_store = CAMEL_IMAPX_STORE (store);
+	imapx_server = camel_imapx_store_ref_server (imapx_store, error);
+
+	if (imapx_server != NULL) {
+		success = camel_imapx_server_sync_messages (
+			imapx_server, CAMEL_FOLDER (folder),
+			uids, cancellable, error);
+	}
+
+	g_clear_object (&imapx_server);
+
+	return success;
+}
+
 static gboolean
 imapx_transfer_messages_to_sync (CamelFolder *source,
                                  GPtrArray *uids,
@@ -972,6 +1022,7 @@ camel_imapx_folder_class_init (CamelIMAPXFolderClass *class)
 {
 	GObjectClass *object_class;
 	CamelFolderClass *folder_class;
+	CamelOfflineFolderClass *offline_folder_class;
 
 	g_type_class_add_private (class, sizeof (CamelIMAPXFolderPrivate));
 
@@ -988,6 +1039,7 @@ camel_imapx_folder_class_init (CamelIMAPXFolderClass *class)
 	folder_class->count_by_expression = imapx_count_by_expression;
 	folder_class->search_free = imapx_search_free;
 	folder_class->get_filename = imapx_get_filename;
+	folder_class->get_uncached_uids = imapx_get_uncached_uids;
 	folder_class->append_message_sync = imapx_append_message_sync;
 	folder_class->expunge_sync = imapx_expunge_sync;
 	folder_class->fetch_messages_sync = imapx_fetch_messages_sync;
@@ -999,6 +1051,9 @@ camel_imapx_folder_class_init (CamelIMAPXFolderClass *class)
 	folder_class->synchronize_message_sync = imapx_synchronize_message_sync;
 	folder_class->transfer_messages_to_sync = imapx_transfer_messages_to_sync;
 
+	offline_folder_class = CAMEL_OFFLINE_FOLDER_CLASS (class);
+	offline_folder_class->synchronize_messages_sync = imapx_synchronize_messages_sync;
+
 	g_object_class_install_property (
 		object_class,
 		PROP_APPLY_FILTERS,
@@ -1062,6 +1117,19 @@ camel_imapx_folder_init (CamelIMAPXFolder *imapx_folder)
 	imapx_folder->priv->move_to_real_trash_uids = move_to_real_trash_uids;
 }
 
+static void
+imapx_folder_update_cache_size (CamelIMAPXSettings *settings,
+                                GParamSpec *param,
+                                CamelIMAPXFolder *imapx_folder)
+{
+	guint megabytes;
+
+	megabytes = camel_imapx_settings_get_folder_cache_size (settings);
+
+	camel_data_cache_set_max_size (
+		imapx_folder->cache, (goffset) megabytes * 1024 * 1024);
+}
+
 CamelFolder *
 camel_imapx_folder_new (CamelStore *store,
                         const gchar *folder_dir,
@@ -1125,6 +1193,18 @@ camel_imapx_folder_new (CamelStore *store,
 		return NULL;
 	}
 
+	settings = camel_service_ref_settings (service);
+
+	imapx_folder_update_cache_size (
+		CAMEL_IMAPX_SETTINGS (settings), NULL, imapx_folder);
+
+	g_signal_connect_object (
+		settings, "notify::folder-cache-size",
+		G_CALLBACK (imapx_folder_update_cache_size),
+		imapx_folder, 0);
+
+	g_object_unref (settings);
+
 	state_file = g_build_filename (folder_dir, "cmeta", NULL);
 	camel_object_set_state_filename (CAMEL_OBJECT (folder), state_file);
 	g_free (state_file);
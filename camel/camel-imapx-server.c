@@ -4443,37 +4443,20 @@ imapx_command_fetch_message_done (CamelIMAPXServer *is,
 	}
 
 	if (local_error == NULL) {
-		gchar *cur_filename;
-		gchar *tmp_filename;
-		gchar *dirname;
-
-		cur_filename = camel_data_cache_get_filename (
-			ifolder->cache, "cur", data->uid);
-
-		tmp_filename = camel_data_cache_get_filename (
-			ifolder->cache, "tmp", data->uid);
-
-		dirname = g_path_get_dirname (cur_filename);
-		g_mkdir_with_parents (dirname, 0700);
-		g_free (dirname);
-
-		if (g_rename (tmp_filename, cur_filename) == 0) {
+		/* Move through the cache so the index keeps the size. */
+		if (camel_data_cache_rename (
+			ifolder->cache, "tmp", data->uid,
+			"cur", data->uid, &local_error)) {
 			/* Exchange the "tmp" stream for the "cur" stream. */
 			g_clear_object (&data->stream);
 			data->stream = camel_data_cache_get (
 				ifolder->cache, "cur",
 				data->uid, &local_error);
 		} else {
-			g_set_error (
-				&local_error, G_FILE_ERROR,
-				g_file_error_from_errno (errno),
-				"%s: %s",
-				_("Failed to copy the tmp file"),
-				g_strerror (errno));
+			g_prefix_error (
+				&local_error, "%s: ",
+				_("Failed to copy the tmp file"));
 		}
-
-		g_free (cur_filename);
-		g_free (tmp_filename);
 	}
 
 	camel_data_cache_remove (ifolder->cache, "tmp", data->uid, NULL);
@@ -4738,7 +4721,7 @@ imapx_command_append_message_done (CamelIMAPXServer *is,
 	CamelFolder *folder;
 	CamelMessageInfo *mi;
 	AppendMessageData *data;
-	gchar *cur, *old_uid;
+	gchar *old_uid;
 	GError *local_error = NULL;
 
 	job = camel_imapx_command_get_job (ic);
@@ -4775,8 +4758,9 @@ imapx_command_append_message_done (CamelIMAPXServer *is,
 			data->appended_uid = g_strdup_printf ("%u", (guint) ic->status->u.appenduid.uid);
 			mi->uid = camel_pstring_add (data->appended_uid, FALSE);
 
-			cur = camel_data_cache_get_filename  (ifolder->cache, "cur", mi->uid);
-			g_rename (data->path, cur);
+			camel_data_cache_rename (
+				ifolder->cache, "new", old_uid,
+				"cur", mi->uid, NULL);
 
 			/* should we update the message count ? */
 			imapx_set_message_info_flags_for_new_message (
@@ -4789,8 +4773,6 @@ imapx_command_append_message_done (CamelIMAPXServer *is,
 			camel_folder_change_info_add_uid (changes, mi->uid);
 			camel_folder_changed (folder, changes);
 			camel_folder_change_info_free (changes);
-
-			g_free (cur);
 		} else {
 			c (is->tagprefix, "but uidvalidity changed \n");
 		}
@@ -7426,6 +7408,138 @@ camel_imapx_server_sync_message (CamelIMAPXServer *is,
 	return TRUE;
 }
 
+static void
+imapx_server_sync_messages_cancelled_cb (GCancellable *cancellable,
+                                         CamelIMAPXJob *job)
+{
+	/* Unblock camel_imapx_job_wait() below, as
+	 * camel_imapx_job_run() does for a single job. */
+	camel_imapx_job_done (job);
+}
+
+/* Fetches several messages into the cache, with all the requests queued
+ * before waiting on any of them, so the server works on them together.
+ * Messages already cached, or already being fetched, are not requested
+ * again.  A message which fails does not stop the others; the first
+ * error is returned once they are all done. */
+gboolean
+camel_imapx_server_sync_messages (CamelIMAPXServer *is,
+                                  CamelFolder *folder,
+                                  GPtrArray *uids,
+                                  GCancellable *cancellable,
+                                  GError **error)
+{
+	CamelIMAPXFolder *ifolder = (CamelIMAPXFolder *) folder;
+	GPtrArray *jobs;
+	GError *local_error = NULL;
+	gulong cancel_id;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_IMAPX_SERVER (is), FALSE);
+	g_return_val_if_fail (CAMEL_IS_FOLDER (folder), FALSE);
+	g_return_val_if_fail (uids != NULL, FALSE);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	jobs = g_ptr_array_new_with_free_func (
+		(GDestroyNotify) camel_imapx_job_unref);
+
+	for (ii = 0; ii < uids->len && local_error == NULL; ii++) {
+		const gchar *uid = uids->pdata[ii];
+		CamelIMAPXJob *job;
+		CamelMessageInfo *mi;
+		GetMessageData *data;
+
+		if (camel_data_cache_contains (ifolder->cache, "cur", uid))
+			continue;
+
+		QUEUE_LOCK (is);
+
+		/* Someone else is fetching it already. */
+		job = imapx_is_job_in_queue (is, folder, IMAPX_JOB_GET_MESSAGE, uid);
+		if (job != NULL) {
+			if (IMAPX_PRIORITY_SYNC_MESSAGE > job->pri)
+				job->pri = IMAPX_PRIORITY_SYNC_MESSAGE;
+			QUEUE_UNLOCK (is);
+			continue;
+		}
+
+		/* Gone from the folder since the list was made. */
+		mi = camel_folder_summary_get (folder->summary, uid);
+		if (mi == NULL) {
+			QUEUE_UNLOCK (is);
+			continue;
+		}
+
+		data = g_slice_new0 (GetMessageData);
+		data->uid = g_strdup (uid);
+		data->stream = camel_data_cache_add (ifolder->cache, "tmp", uid, NULL);
+		data->size = ((CamelMessageInfoBase *) mi)->size;
+		if (data->size > MULTI_SIZE)
+			data->use_multi_fetch = TRUE;
+
+		camel_message_info_free (mi);
+
+		job = camel_imapx_job_new (cancellable);
+		job->pri = IMAPX_PRIORITY_SYNC_MESSAGE;
+		job->type = IMAPX_JOB_GET_MESSAGE;
+		job->start = imapx_job_get_message_start;
+		job->matches = imapx_job_get_message_matches;
+
+		camel_imapx_job_set_folder (job, folder);
+
+		camel_imapx_job_set_data (
+			job, data, (GDestroyNotify) get_message_data_free);
+
+		if (!imapx_register_job (is, job, &local_error)) {
+			QUEUE_UNLOCK (is);
+			camel_imapx_job_unref (job);
+			break;
+		}
+
+		QUEUE_UNLOCK (is);
+
+		/* Only queues the FETCH commands; the waiting is below. */
+		if (job->start (job, is, cancellable, &local_error))
+			g_ptr_array_add (jobs, job);
+		else
+			camel_imapx_job_unref (job);
+	}
+
+	for (ii = 0; ii < jobs->len; ii++) {
+		CamelIMAPXJob *job = jobs->pdata[ii];
+		GError *job_error = NULL;
+
+		cancel_id = 0;
+		if (G_IS_CANCELLABLE (cancellable))
+			cancel_id = g_cancellable_connect (
+				cancellable,
+				G_CALLBACK (imapx_server_sync_messages_cancelled_cb),
+				camel_imapx_job_ref (job),
+				(GDestroyNotify) camel_imapx_job_unref);
+
+		camel_imapx_job_wait (job, &job_error);
+
+		if (cancel_id > 0)
+			g_cancellable_disconnect (cancellable, cancel_id);
+
+		if (local_error == NULL)
+			local_error = job_error;
+		else
+			g_clear_error (&job_error);
+	}
+
+	g_ptr_array_unref (jobs);
+
+	if (local_error != NULL) {
+		g_propagate_error (error, local_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 gboolean
 camel_imapx_server_copy_message (CamelIMAPXServer *is,
                                  CamelFolder *source,
@@ -208,6 +208,12 @@ gboolean	camel_imapx_server_sync_message	(CamelIMAPXServer *is,
 						 const gchar *uid,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	camel_imapx_server_sync_messages
+						(CamelIMAPXServer *is,
+						 CamelFolder *folder,
+						 GPtrArray *uids,
+						 GCancellable *cancellable,
+						 GError **error);
 gboolean	camel_imapx_server_manage_subscription
 						(CamelIMAPXServer *is,
 						 const gchar *folder_name,
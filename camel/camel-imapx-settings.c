@@ -33,6 +33,7 @@ struct _CamelIMAPXSettingsPrivate {
 	gchar *shell_command;
 
 	guint batch_fetch_count;
+	guint folder_cache_size;
 
 	gboolean check_all;
 	gboolean check_subscribed;
@@ -62,6 +63,7 @@ enum {
 	PROP_FILTER_ALL,
 	PROP_FILTER_JUNK,
 	PROP_FILTER_JUNK_INBOX,
+	PROP_FOLDER_CACHE_SIZE,
 	PROP_HOST,
 	PROP_MOBILE_MODE,
 	PROP_NAMESPACE,
@@ -142,6 +144,12 @@ imapx_settings_set_property (GObject *object,
 				g_value_get_boolean (value));
 			return;
 
+		case PROP_FOLDER_CACHE_SIZE:
+			camel_imapx_settings_set_folder_cache_size (
+				CAMEL_IMAPX_SETTINGS (object),
+				g_value_get_uint (value));
+			return;
+
 		case PROP_HOST:
 			camel_network_settings_set_host (
 				CAMEL_NETWORK_SETTINGS (object),
@@ -305,6 +313,13 @@ imapx_settings_get_property (GObject *object,
 				CAMEL_IMAPX_SETTINGS (object)));
 			return;
 
+		case PROP_FOLDER_CACHE_SIZE:
+			g_value_set_uint (
+				value,
+				camel_imapx_settings_get_folder_cache_size (
+				CAMEL_IMAPX_SETTINGS (object)));
+			return;
+
 		case PROP_HOST:
 			g_value_take_string (
 				value,
@@ -542,6 +557,21 @@ camel_imapx_settings_class_init (CamelIMAPXSettingsClass *class)
 			G_PARAM_CONSTRUCT |
 			G_PARAM_STATIC_STRINGS));
 
+	g_object_class_install_property (
+		object_class,
+		PROP_FOLDER_CACHE_SIZE,
+		g_param_spec_uint (
+			"folder-cache-size",
+			"Folder Cache Size",
+			"Most megabytes of messages cached per folder, "
+			"or 0 for no limit",
+			0,
+			G_MAXUINT,
+			0,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
 	g_object_class_install_property (
 		object_class,
 		PROP_MOBILE_MODE,
@@ -1020,6 +1050,50 @@ camel_imapx_settings_set_filter_junk_inbox (CamelIMAPXSettings *settings,
 	g_object_notify (G_OBJECT (settings), "filter-junk-inbox");
 }
 
+/**
+ * camel_imapx_settings_get_folder_cache_size:
+ * @settings: a #CamelIMAPXSettings
+ *
+ * Returns the most megabytes of message content cached for each folder.
+ * When a folder's cache grows beyond it, the least recently used messages
+ * are removed from it.  Zero means there is no limit.
+ *
+ * Returns: the folder cache size limit in megabytes, or 0
+ *
+ * Since: 3.12
+ **/
+guint
+camel_imapx_settings_get_folder_cache_size (CamelIMAPXSettings *settings)
+{
+	g_return_val_if_fail (CAMEL_IS_IMAPX_SETTINGS (settings), 0);
+
+	return settings->priv->folder_cache_size;
+}
+
+/**
+ * camel_imapx_settings_set_folder_cache_size:
+ * @settings: a #CamelIMAPXSettings
+ * @folder_cache_size: the folder cache size limit in megabytes, or 0
+ *
+ * Sets the most megabytes of message content cached for each folder.
+ * Zero means there is no limit.
+ *
+ * Since: 3.12
+ **/
+void
+camel_imapx_settings_set_folder_cache_size (CamelIMAPXSettings *settings,
+                                            guint folder_cache_size)
+{
+	g_return_if_fail (CAMEL_IS_IMAPX_SETTINGS (settings));
+
+	if (settings->priv->folder_cache_size == folder_cache_size)
+		return;
+
+	settings->priv->folder_cache_size = folder_cache_size;
+
+	g_object_notify (G_OBJECT (settings), "folder-cache-size");
+}
+
 /**
  * camel_imapx_settings_get_mobile_mode:
  * @settings: a #CamelIMAPXSettings
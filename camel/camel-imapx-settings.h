@@ -95,6 +95,11 @@ gboolean	camel_imapx_settings_get_filter_junk_inbox
 void		camel_imapx_settings_set_filter_junk_inbox
 						(CamelIMAPXSettings *settings,
 						 gboolean filter_junk_inbox);
+guint		camel_imapx_settings_get_folder_cache_size
+						(CamelIMAPXSettings *settings);
+void		camel_imapx_settings_set_folder_cache_size
+						(CamelIMAPXSettings *settings,
+						 guint folder_cache_size);
 gboolean	camel_imapx_settings_get_mobile_mode
 						(CamelIMAPXSettings *settings);
 void		camel_imapx_settings_set_mobile_mode
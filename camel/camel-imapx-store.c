@@ -1620,17 +1620,26 @@ imapx_store_get_folder_info_sync (CamelStore *store,
 
 		if (time_since_last_refresh > FINFO_REFRESH_INTERVAL) {
 			CamelSession *session;
+			gchar *key;
 
 			imapx_store->priv->last_refresh_time = time (NULL);
 
 			session = camel_service_ref_session (service);
 
-			camel_session_submit_job (
-				session, (CamelSessionCallback)
-				imapx_refresh_finfo,
+			/* One folder list refresh at a time is enough. */
+			key = g_strdup_printf (
+				"imapx-refresh-finfo:%s",
+				camel_service_get_uid (service));
+
+			camel_session_submit_job_full (
+				session, service,
+				CAMEL_SESSION_JOB_PRIORITY_BACKGROUND, key,
+				(CamelSessionCallback) imapx_refresh_finfo,
 				g_object_ref (store),
 				(GDestroyNotify) g_object_unref);
 
+			g_free (key);
+
 			g_object_unref (session);
 		}
 
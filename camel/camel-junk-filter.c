@@ -19,8 +19,10 @@
 #include "camel-junk-filter.h"
 
 #include <config.h>
+#include <stdio.h>
 #include <glib/gi18n-lib.h>
 
+#include "camel-debug.h"
 #include "camel-operation.h"
 
 G_DEFINE_INTERFACE (CamelJunkFilter, camel_junk_filter, G_TYPE_OBJECT)
@@ -30,6 +32,25 @@ camel_junk_filter_default_init (CamelJunkFilterInterface *interface)
 {
 }
 
+static void
+junk_filter_report_batch (const gchar *what,
+                          guint n_messages,
+                          gint64 started)
+{
+	gint64 elapsed;
+
+	if (!camel_debug ("junk"))
+		return;
+
+	elapsed = g_get_monotonic_time () - started;
+
+	printf (
+		"Junk filter: %s %u message%s in %" G_GINT64_FORMAT
+		" ms (%" G_GINT64_FORMAT " us per message)\n",
+		what, n_messages, n_messages == 1 ? "" : "s",
+		elapsed / 1000, n_messages > 0 ? elapsed / n_messages : 0);
+}
+
 /**
  * camel_junk_filter_classify:
  * @junk_filter: a #CamelJunkFilter
@@ -176,3 +197,166 @@ camel_junk_filter_synchronize (CamelJunkFilter *junk_filter,
 	return success;
 }
 
+
+/**
+ * camel_junk_filter_classify_messages:
+ * @junk_filter: a #CamelJunkFilter
+ * @messages: an array of #CamelMimeMessage
+ * @out_statuses: return location for one #CamelJunkStatus per message,
+ *                with room for at least @messages->len elements
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Classifies every message in @messages, like camel_junk_filter_classify()
+ * does for a single message.  Junk filters which can score several
+ * messages at once, for example by talking to an external scorer only
+ * once per batch, implement this directly; for the others each message
+ * is classified in turn.
+ *
+ * If an error occurs, the function sets @error and returns %FALSE.
+ * Messages which could not be classified have their status set to
+ * %CAMEL_JUNK_STATUS_ERROR.
+ *
+ * Returns: %TRUE if all the messages were classified
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_junk_filter_classify_messages (CamelJunkFilter *junk_filter,
+                                     GPtrArray *messages,
+                                     CamelJunkStatus *out_statuses,
+                                     GCancellable *cancellable,
+                                     GError **error)
+{
+	CamelJunkFilterInterface *interface;
+	gboolean success = TRUE;
+	gint64 started;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_JUNK_FILTER (junk_filter), FALSE);
+	g_return_val_if_fail (messages != NULL, FALSE);
+	g_return_val_if_fail (out_statuses != NULL, FALSE);
+
+	for (ii = 0; ii < messages->len; ii++)
+		out_statuses[ii] = CAMEL_JUNK_STATUS_ERROR;
+
+	interface = CAMEL_JUNK_FILTER_GET_INTERFACE (junk_filter);
+	started = g_get_monotonic_time ();
+
+	if (interface->classify_messages != NULL) {
+		success = interface->classify_messages (
+			junk_filter, messages, out_statuses,
+			cancellable, error);
+	} else {
+		for (ii = 0; success && ii < messages->len; ii++) {
+			out_statuses[ii] = camel_junk_filter_classify (
+				junk_filter, messages->pdata[ii],
+				cancellable, error);
+			success = (out_statuses[ii] != CAMEL_JUNK_STATUS_ERROR);
+		}
+	}
+
+	junk_filter_report_batch ("classified", messages->len, started);
+
+	return success;
+}
+
+/**
+ * camel_junk_filter_learn_junk_messages:
+ * @junk_filter: a #CamelJunkFilter
+ * @messages: an array of #CamelMimeMessage
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Instructs @junk_filter to classify every message in @messages as
+ * junk, like camel_junk_filter_learn_junk() does for a single message.
+ * Junk filters without a batch implementation train on each message
+ * in turn.
+ *
+ * If an error occurs, the function sets @error and returns %FALSE.
+ *
+ * Returns: %TRUE if all the messages were successfully learned
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_junk_filter_learn_junk_messages (CamelJunkFilter *junk_filter,
+                                       GPtrArray *messages,
+                                       GCancellable *cancellable,
+                                       GError **error)
+{
+	CamelJunkFilterInterface *interface;
+	gboolean success = TRUE;
+	gint64 started;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_JUNK_FILTER (junk_filter), FALSE);
+	g_return_val_if_fail (messages != NULL, FALSE);
+
+	interface = CAMEL_JUNK_FILTER_GET_INTERFACE (junk_filter);
+	started = g_get_monotonic_time ();
+
+	if (interface->learn_junk_messages != NULL) {
+		success = interface->learn_junk_messages (
+			junk_filter, messages, cancellable, error);
+	} else {
+		for (ii = 0; success && ii < messages->len; ii++)
+			success = camel_junk_filter_learn_junk (
+				junk_filter, messages->pdata[ii],
+				cancellable, error);
+	}
+
+	junk_filter_report_batch ("learned junk from", messages->len, started);
+
+	return success;
+}
+
+/**
+ * camel_junk_filter_learn_not_junk_messages:
+ * @junk_filter: a #CamelJunkFilter
+ * @messages: an array of #CamelMimeMessage
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Instructs @junk_filter to classify every message in @messages as not
+ * junk, like camel_junk_filter_learn_not_junk() does for a single
+ * message.  Junk filters without a batch implementation train on each
+ * message in turn.
+ *
+ * If an error occurs, the function sets @error and returns %FALSE.
+ *
+ * Returns: %TRUE if all the messages were successfully learned
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_junk_filter_learn_not_junk_messages (CamelJunkFilter *junk_filter,
+                                           GPtrArray *messages,
+                                           GCancellable *cancellable,
+                                           GError **error)
+{
+	CamelJunkFilterInterface *interface;
+	gboolean success = TRUE;
+	gint64 started;
+	guint ii;
+
+	g_return_val_if_fail (CAMEL_IS_JUNK_FILTER (junk_filter), FALSE);
+	g_return_val_if_fail (messages != NULL, FALSE);
+
+	interface = CAMEL_JUNK_FILTER_GET_INTERFACE (junk_filter);
+	started = g_get_monotonic_time ();
+
+	if (interface->learn_not_junk_messages != NULL) {
+		success = interface->learn_not_junk_messages (
+			junk_filter, messages, cancellable, error);
+	} else {
+		for (ii = 0; success && ii < messages->len; ii++)
+			success = camel_junk_filter_learn_not_junk (
+				junk_filter, messages->pdata[ii],
+				cancellable, error);
+	}
+
+	junk_filter_report_batch ("learned not junk from", messages->len, started);
+
+	return success;
+}
@@ -76,6 +76,23 @@ struct _CamelJunkFilterInterface {
 	gboolean	(*synchronize)		(CamelJunkFilter *junk_filter,
 						 GCancellable *cancellable,
 						 GError **error);
+
+	/* Optional batch methods, for filters which can
+	 * score or train on many messages in one go. */
+	gboolean	(*classify_messages)	(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 CamelJunkStatus *out_statuses,
+						 GCancellable *cancellable,
+						 GError **error);
+	gboolean	(*learn_junk_messages)	(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 GCancellable *cancellable,
+						 GError **error);
+	gboolean	(*learn_not_junk_messages)
+						(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 GCancellable *cancellable,
+						 GError **error);
 };
 
 GType		camel_junk_filter_get_type	(void) G_GNUC_CONST;
@@ -95,6 +112,22 @@ gboolean	camel_junk_filter_learn_not_junk
 gboolean	camel_junk_filter_synchronize	(CamelJunkFilter *junk_filter,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	camel_junk_filter_classify_messages
+						(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 CamelJunkStatus *out_statuses,
+						 GCancellable *cancellable,
+						 GError **error);
+gboolean	camel_junk_filter_learn_junk_messages
+						(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 GCancellable *cancellable,
+						 GError **error);
+gboolean	camel_junk_filter_learn_not_junk_messages
+						(CamelJunkFilter *junk_filter,
+						 GPtrArray *messages,
+						 GCancellable *cancellable,
+						 GError **error);
 
 G_END_DECLS
 
@@ -107,6 +107,13 @@ struct _header_scan_state {
     /* per message/part info */
 	struct _header_scan_stack *parts;
 
+#ifdef MEMPOOL
+	/* a header pool kept from the last finished part, reused by the
+	 * next one so scanning a large mailbox does not allocate and free
+	 * a pool for every single message */
+	CamelMemPool *spare_pool;
+#endif
+
 };
 
 struct _header_scan_stack {
@@ -118,6 +125,7 @@ struct _header_scan_stack {
 	CamelMemPool *pool;	/* memory pool to keep track of headers/etc at this level */
 #endif
 	struct _camel_header_raw *headers;	/* headers for this part */
+	struct _camel_header_raw *headers_last;	/* last header, for fast appends */
 
 	CamelContentType *content_type;
 
@@ -1033,7 +1041,12 @@ folder_pull_part (struct _header_scan_state *s)
 		s->parts = h->parent;
 		g_free (h->boundary);
 #ifdef MEMPOOL
-		camel_mempool_destroy (h->pool);
+		if (s->spare_pool == NULL) {
+			camel_mempool_flush (h->pool, FALSE);
+			s->spare_pool = h->pool;
+		} else {
+			camel_mempool_destroy (h->pool);
+		}
 #else
 		camel_header_raw_clear (&h->headers);
 #endif
@@ -1164,11 +1177,11 @@ header_append_mempool (struct _header_scan_state *s,
 
 		n->offset = offset;
 
-		l = (struct _camel_header_raw *) &h->headers;
-		while (l->next) {
-			l = l->next;
-		}
+		l = h->headers_last;
+		if (l == NULL)
+			l = (struct _camel_header_raw *) &h->headers;
 		l->next = n;
+		h->headers_last = n;
 	}
 
 }
@@ -1219,7 +1232,12 @@ folder_scan_header (struct _header_scan_state *s,
 
 	h = g_malloc0 (sizeof (*h));
 #ifdef MEMPOOL
-	h->pool = camel_mempool_new (8192, 4096, CAMEL_MEMPOOL_ALIGN_STRUCT);
+	if (s->spare_pool != NULL) {
+		h->pool = s->spare_pool;
+		s->spare_pool = NULL;
+	} else {
+		h->pool = camel_mempool_new (8192, 4096, CAMEL_MEMPOOL_ALIGN_STRUCT);
+	}
 #endif
 
 	if (s->parts)
@@ -1453,6 +1471,9 @@ folder_scan_close (struct _header_scan_state *s)
 	g_free (s->outbuf);
 	while (s->parts)
 		folder_pull_part (s);
+#ifdef MEMPOOL
+	camel_mempool_destroy (s->spare_pool);
+#endif
 	if (s->fd != -1)
 		close (s->fd);
 	if (s->stream) {
@@ -1500,6 +1521,9 @@ folder_scan_init (void)
 	s->filterid = 1;
 
 	s->parts = NULL;
+#ifdef MEMPOOL
+	s->spare_pool = NULL;
+#endif
 
 	s->state = CAMEL_MIME_PARSER_STATE_INITIAL;
 	return s;
@@ -24,6 +24,8 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
 #include <glib/gi18n-lib.h>
 
 #include "camel-debug.h"
@@ -37,8 +39,15 @@
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), CAMEL_TYPE_OFFLINE_FOLDER, CamelOfflineFolderPrivate))
 
+/* How many messages to request at once, for folders that allow it. */
+#define DOWNSYNC_JOBS (4)
+
+/* How often the progress and throughput are reported while downloading. */
+#define DOWNSYNC_STATUS_INTERVAL (G_USEC_PER_SEC)
+
 typedef struct _AsyncContext AsyncContext;
 typedef struct _OfflineDownsyncData OfflineDownsyncData;
+typedef struct _DownsyncItem DownsyncItem;
 
 struct _CamelOfflineFolderPrivate {
 	gboolean offline_sync;
@@ -54,6 +63,12 @@ struct _OfflineDownsyncData {
 	CamelFolderChangeInfo *changes;
 };
 
+struct _DownsyncItem {
+	const gchar *uid;
+	guint32 size;
+	time_t date;
+};
+
 /* The custom property ID is a CamelArg artifact.
  * It still identifies the property in state files. */
 enum {
@@ -82,35 +97,237 @@ offline_downsync_data_free (OfflineDownsyncData *data)
 	g_slice_free (OfflineDownsyncData, data);
 }
 
+static gint
+downsync_item_cmp_newest (gconstpointer a,
+                          gconstpointer b)
+{
+	const DownsyncItem *item_a = a, *item_b = b;
+
+	return (item_a->date < item_b->date) - (item_a->date > item_b->date);
+}
+
+static gint
+downsync_item_cmp_smallest (gconstpointer a,
+                            gconstpointer b)
+{
+	const DownsyncItem *item_a = a, *item_b = b;
+
+	return (item_a->size > item_b->size) - (item_a->size < item_b->size);
+}
+
 static void
-offline_folder_downsync_background (CamelSession *session,
-                                    GCancellable *cancellable,
-                                    OfflineDownsyncData *data,
-                                    GError **error)
+offline_folder_downsync_status (CamelFolder *folder,
+                                GCancellable *cancellable,
+                                guint n_done,
+                                guint n_total,
+                                guint64 bytes_done,
+                                guint64 bytes_total,
+                                gint64 started,
+                                gint64 *last_status)
 {
+	const gchar *display_name;
+	gchar *rate;
+	gint64 now;
+	gint percent;
+
+	now = g_get_monotonic_time ();
+	if (now - *last_status < DOWNSYNC_STATUS_INTERVAL)
+		return;
+
+	*last_status = now;
+
+	if (bytes_total > 0)
+		percent = bytes_done * 100 / bytes_total;
+	else
+		percent = n_done * 100 / n_total;
+
+	rate = g_format_size (
+		bytes_done * G_USEC_PER_SEC / MAX (now - started, 1));
+	display_name = camel_folder_get_display_name (folder);
+
+	camel_operation_pop_message (cancellable);
 	camel_operation_push_message (
 		cancellable,
-		_("Downloading new messages for offline mode"));
+		_("Syncing messages in folder '%s' to disk (%s/s)"),
+		display_name, rate);
+	camel_operation_progress (cancellable, percent);
 
-	if (data->changes) {
-		GPtrArray *uid_added;
-		gboolean success = TRUE;
-		gint ii;
+	g_free (rate);
+}
+
+/* Downloads the given messages for offline use, in the order the store's
+ * downsync policy asks for and within its bandwidth limit.  Whatever has
+ * been downloaded is in the folder's message cache, which
+ * camel_folder_get_uncached_uids() consults, so an interrupted run
+ * resumes where it stopped rather than starting over.
+ *
+ * A message which fails to download does not stop the others; it stays
+ * uncached for the next run to pick up.  The first such error is still
+ * reported once the rest are done. */
+static gboolean
+offline_folder_downsync_uids (CamelFolder *folder,
+                              GPtrArray *uids,
+                              GCancellable *cancellable,
+                              GError **error)
+{
+	CamelOfflineFolderClass *class;
+	CamelStore *parent_store;
+	CamelSettings *settings;
+	CamelDownsyncPolicy policy = CAMEL_DOWNSYNC_POLICY_NEWEST_FIRST;
+	DownsyncItem *items;
+	GPtrArray *batch;
+	GError *local_error = NULL;
+	guint64 bytes_total = 0;
+	guint64 bytes_done = 0;
+	guint64 bandwidth = 0;
+	gint64 started, last_status;
+	guint ii, n_batch, max_batch = 1;
+
+	if (uids->len == 0)
+		return TRUE;
+
+	/* Folders which can fetch several messages at once get them in
+	 * small batches, all requested before any is waited for. */
+	class = CAMEL_OFFLINE_FOLDER_GET_CLASS (folder);
+	if (class->synchronize_messages_sync != NULL)
+		max_batch = DOWNSYNC_JOBS;
+
+	parent_store = camel_folder_get_parent_store (folder);
+
+	settings = camel_service_ref_settings (CAMEL_SERVICE (parent_store));
+	if (CAMEL_IS_OFFLINE_SETTINGS (settings)) {
+		CamelOfflineSettings *offline_settings;
 
-		uid_added = data->changes->uid_added;
+		offline_settings = CAMEL_OFFLINE_SETTINGS (settings);
+		policy = camel_offline_settings_get_downsync_policy (
+			offline_settings);
+		bandwidth = camel_offline_settings_get_downsync_bandwidth (
+			offline_settings) * 1024;
+	}
+	g_object_unref (settings);
 
-		for (ii = 0; success && ii < uid_added->len; ii++) {
-			const gchar *uid;
-			gint percent;
+	items = g_new0 (DownsyncItem, uids->len);
 
-			percent = ii * 100 / uid_added->len;
-			uid = g_ptr_array_index (uid_added, ii);
+	for (ii = 0; ii < uids->len; ii++) {
+		CamelMessageInfo *info;
 
-			camel_operation_progress (cancellable, percent);
+		items[ii].uid = uids->pdata[ii];
 
-			success = camel_folder_synchronize_message_sync (
-				data->folder, uid, cancellable, error);
+		info = camel_folder_get_message_info (folder, items[ii].uid);
+		if (info != NULL) {
+			items[ii].size = camel_message_info_size (info);
+			items[ii].date = camel_message_info_date_received (info);
+			if (items[ii].date <= 0)
+				items[ii].date = camel_message_info_date_sent (info);
+			camel_folder_free_message_info (folder, info);
 		}
+
+		bytes_total += items[ii].size;
+	}
+
+	qsort (
+		items, uids->len, sizeof (DownsyncItem),
+		policy == CAMEL_DOWNSYNC_POLICY_SMALLEST_FIRST ?
+		downsync_item_cmp_smallest : downsync_item_cmp_newest);
+
+	camel_operation_push_message (
+		cancellable, _("Syncing messages in folder '%s' to disk"),
+		camel_folder_get_display_name (folder));
+
+	batch = g_ptr_array_sized_new (max_batch);
+
+	started = last_status = g_get_monotonic_time ();
+
+	for (ii = 0; ii < uids->len; ii += n_batch) {
+		GError *message_error = NULL;
+		guint jj;
+
+		/* Hold each batch back until everything downloaded
+		 * so far fits the bandwidth limit, waking up now and
+		 * then to notice cancellation. */
+		if (bandwidth > 0) {
+			gint64 due, now;
+
+			due = started + bytes_done * G_USEC_PER_SEC / bandwidth;
+
+			while ((now = g_get_monotonic_time ()) < due &&
+			       !g_cancellable_is_cancelled (cancellable)) {
+				g_usleep (MIN (due - now, DOWNSYNC_STATUS_INTERVAL));
+
+				offline_folder_downsync_status (
+					folder, cancellable, ii, uids->len,
+					bytes_done, bytes_total,
+					started, &last_status);
+			}
+		}
+
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+
+		n_batch = MIN (max_batch, uids->len - ii);
+
+		if (class->synchronize_messages_sync != NULL) {
+			g_ptr_array_set_size (batch, 0);
+			for (jj = 0; jj < n_batch; jj++)
+				g_ptr_array_add (batch, (gpointer) items[ii + jj].uid);
+
+			camel_folder_lock (folder, CAMEL_FOLDER_REC_LOCK);
+			class->synchronize_messages_sync (
+				CAMEL_OFFLINE_FOLDER (folder), batch,
+				cancellable, &message_error);
+			camel_folder_unlock (folder, CAMEL_FOLDER_REC_LOCK);
+		} else {
+			camel_folder_synchronize_message_sync (
+				folder, items[ii].uid,
+				cancellable, &message_error);
+		}
+
+		if (local_error == NULL)
+			local_error = message_error;
+		else
+			g_clear_error (&message_error);
+
+		for (jj = 0; jj < n_batch; jj++)
+			bytes_done += items[ii + jj].size;
+
+		offline_folder_downsync_status (
+			folder, cancellable, ii + n_batch, uids->len,
+			bytes_done, bytes_total, started, &last_status);
+	}
+
+	g_ptr_array_free (batch, TRUE);
+
+	camel_operation_pop_message (cancellable);
+
+	g_free (items);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+		g_clear_error (&local_error);
+		return FALSE;
+	}
+
+	if (local_error != NULL) {
+		g_propagate_error (error, local_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+offline_folder_downsync_background (CamelSession *session,
+                                    GCancellable *cancellable,
+                                    OfflineDownsyncData *data,
+                                    GError **error)
+{
+	camel_operation_push_message (
+		cancellable,
+		_("Downloading new messages for offline mode"));
+
+	if (data->changes) {
+		offline_folder_downsync_uids (
+			data->folder, data->changes->uid_added,
+			cancellable, error);
 	} else {
 		camel_offline_folder_downsync_sync (
 			CAMEL_OFFLINE_FOLDER (data->folder),
@@ -154,8 +371,10 @@ offline_folder_changed (CamelFolder *folder,
 		camel_folder_change_info_cat (data->changes, changes);
 		data->folder = g_object_ref (folder);
 
-		camel_session_submit_job (
-			session, (CamelSessionCallback)
+		camel_session_submit_job_full (
+			session, CAMEL_SERVICE (parent_store),
+			CAMEL_SESSION_JOB_PRIORITY_BACKGROUND, NULL,
+			(CamelSessionCallback)
 			offline_folder_downsync_background, data,
 			(GDestroyNotify) offline_downsync_data_free);
 	}
@@ -205,13 +424,7 @@ offline_folder_downsync_sync (CamelOfflineFolder *offline,
 {
 	CamelFolder *folder = (CamelFolder *) offline;
 	GPtrArray *uids, *uncached_uids = NULL;
-	const gchar *display_name;
-	const gchar *message;
-	gint i;
-
-	message = _("Syncing messages in folder '%s' to disk");
-	display_name = camel_folder_get_display_name (folder);
-	camel_operation_push_message (cancellable, message, display_name);
+	gboolean success = TRUE;
 
 	if (expression)
 		uids = camel_folder_search_by_expression (folder, expression, cancellable, NULL);
@@ -231,20 +444,14 @@ offline_folder_downsync_sync (CamelOfflineFolder *offline,
 	if (!uncached_uids)
 		goto done;
 
-	for (i = 0; i < uncached_uids->len; i++) {
-		camel_folder_synchronize_message_sync (
-			folder, uncached_uids->pdata[i], cancellable, NULL);
-		camel_operation_progress (
-			cancellable, i * 100 / uncached_uids->len);
-	}
+	success = offline_folder_downsync_uids (
+		folder, uncached_uids, cancellable, error);
 
 done:
 	if (uncached_uids)
 		camel_folder_free_uids (folder, uncached_uids);
 
-	camel_operation_pop_message (cancellable);
-
-	return TRUE;
+	return success;
 }
 
 static void
@@ -395,6 +602,12 @@ camel_offline_folder_set_offline_sync (CamelOfflineFolder *folder,
  * Synchronizes messages in @folder described by the search @expression to
  * the local machine for offline availability.
  *
+ * Messages are downloaded in the order given by the store's
+ * #CamelOfflineSettings:downsync-policy, within its
+ * #CamelOfflineSettings:downsync-bandwidth.  A message which fails to
+ * download does not stop the others; the first such error is returned
+ * once they are done.
+ *
  * Returns: %TRUE on success, %FALSE on error
  *
  * Since: 3.0
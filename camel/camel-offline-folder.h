@@ -78,6 +78,14 @@ struct _CamelOfflineFolderClass {
 	gboolean	(*downsync_finish)	(CamelOfflineFolder *folder,
 						 GAsyncResult *result,
 						 GError **error);
+
+	/* Optional; fetches several messages for offline use at once.
+	 * Called with the folder's CAMEL_FOLDER_REC_LOCK held. */
+	gboolean	(*synchronize_messages_sync)
+						(CamelOfflineFolder *folder,
+						 GPtrArray *uids,
+						 GCancellable *cancellable,
+						 GError **error);
 };
 
 GType		camel_offline_folder_get_type	(void);
@@ -18,6 +18,7 @@
 
 #include "camel-offline-settings.h"
 
+#include <camel/camel-enumtypes.h>
 #include <camel/camel-store-settings.h>
 
 #define CAMEL_OFFLINE_SETTINGS_GET_PRIVATE(obj) \
@@ -26,10 +27,14 @@
 
 struct _CamelOfflineSettingsPrivate {
 	gboolean stay_synchronized;
+	CamelDownsyncPolicy downsync_policy;
+	guint downsync_bandwidth;
 };
 
 enum {
 	PROP_0,
+	PROP_DOWNSYNC_BANDWIDTH,
+	PROP_DOWNSYNC_POLICY,
 	PROP_STAY_SYNCHRONIZED
 };
 
@@ -45,6 +50,18 @@ offline_settings_set_property (GObject *object,
                              GParamSpec *pspec)
 {
 	switch (property_id) {
+		case PROP_DOWNSYNC_BANDWIDTH:
+			camel_offline_settings_set_downsync_bandwidth (
+				CAMEL_OFFLINE_SETTINGS (object),
+				g_value_get_uint (value));
+			return;
+
+		case PROP_DOWNSYNC_POLICY:
+			camel_offline_settings_set_downsync_policy (
+				CAMEL_OFFLINE_SETTINGS (object),
+				g_value_get_enum (value));
+			return;
+
 		case PROP_STAY_SYNCHRONIZED:
 			camel_offline_settings_set_stay_synchronized (
 				CAMEL_OFFLINE_SETTINGS (object),
@@ -62,6 +79,20 @@ offline_settings_get_property (GObject *object,
                              GParamSpec *pspec)
 {
 	switch (property_id) {
+		case PROP_DOWNSYNC_BANDWIDTH:
+			g_value_set_uint (
+				value,
+				camel_offline_settings_get_downsync_bandwidth (
+				CAMEL_OFFLINE_SETTINGS (object)));
+			return;
+
+		case PROP_DOWNSYNC_POLICY:
+			g_value_set_enum (
+				value,
+				camel_offline_settings_get_downsync_policy (
+				CAMEL_OFFLINE_SETTINGS (object)));
+			return;
+
 		case PROP_STAY_SYNCHRONIZED:
 			g_value_set_boolean (
 				value,
@@ -84,6 +115,32 @@ camel_offline_settings_class_init (CamelOfflineSettingsClass *class)
 	object_class->set_property = offline_settings_set_property;
 	object_class->get_property = offline_settings_get_property;
 
+	g_object_class_install_property (
+		object_class,
+		PROP_DOWNSYNC_BANDWIDTH,
+		g_param_spec_uint (
+			"downsync-bandwidth",
+			"Downsync Bandwidth",
+			"Kilobytes per second to use for offline "
+			"downloads, or 0 for no limit",
+			0, G_MAXUINT, 0,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_DOWNSYNC_POLICY,
+		g_param_spec_enum (
+			"downsync-policy",
+			"Downsync Policy",
+			"Order in which messages are downloaded for offline use",
+			CAMEL_TYPE_DOWNSYNC_POLICY,
+			CAMEL_DOWNSYNC_POLICY_NEWEST_FIRST,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
 	g_object_class_install_property (
 		object_class,
 		PROP_STAY_SYNCHRONIZED,
@@ -147,3 +204,89 @@ camel_offline_settings_set_stay_synchronized (CamelOfflineSettings *settings,
 
 	g_object_notify (G_OBJECT (settings), "stay-synchronized");
 }
+
+/**
+ * camel_offline_settings_get_downsync_policy:
+ * @settings: a #CamelOfflineSettings
+ *
+ * Returns the order in which messages are downloaded for offline use.
+ *
+ * Returns: a #CamelDownsyncPolicy
+ *
+ * Since: 3.12
+ **/
+CamelDownsyncPolicy
+camel_offline_settings_get_downsync_policy (CamelOfflineSettings *settings)
+{
+	g_return_val_if_fail (
+		CAMEL_IS_OFFLINE_SETTINGS (settings),
+		CAMEL_DOWNSYNC_POLICY_NEWEST_FIRST);
+
+	return settings->priv->downsync_policy;
+}
+
+/**
+ * camel_offline_settings_set_downsync_policy:
+ * @settings: a #CamelOfflineSettings
+ * @downsync_policy: a #CamelDownsyncPolicy
+ *
+ * Sets the order in which messages are downloaded for offline use.
+ *
+ * Since: 3.12
+ **/
+void
+camel_offline_settings_set_downsync_policy (CamelOfflineSettings *settings,
+                                            CamelDownsyncPolicy downsync_policy)
+{
+	g_return_if_fail (CAMEL_IS_OFFLINE_SETTINGS (settings));
+
+	if (settings->priv->downsync_policy == downsync_policy)
+		return;
+
+	settings->priv->downsync_policy = downsync_policy;
+
+	g_object_notify (G_OBJECT (settings), "downsync-policy");
+}
+
+/**
+ * camel_offline_settings_get_downsync_bandwidth:
+ * @settings: a #CamelOfflineSettings
+ *
+ * Returns how many kilobytes per second downloads for offline use
+ * may take, so they do not starve interactive use of the connection.
+ *
+ * Returns: the bandwidth limit in kilobytes per second, or 0 for no limit
+ *
+ * Since: 3.12
+ **/
+guint
+camel_offline_settings_get_downsync_bandwidth (CamelOfflineSettings *settings)
+{
+	g_return_val_if_fail (CAMEL_IS_OFFLINE_SETTINGS (settings), 0);
+
+	return settings->priv->downsync_bandwidth;
+}
+
+/**
+ * camel_offline_settings_set_downsync_bandwidth:
+ * @settings: a #CamelOfflineSettings
+ * @downsync_bandwidth: the bandwidth limit in kilobytes per second,
+ *                      or 0 for no limit
+ *
+ * Sets how many kilobytes per second downloads for offline use may take.
+ *
+ * Since: 3.12
+ **/
+void
+camel_offline_settings_set_downsync_bandwidth (CamelOfflineSettings *settings,
+                                               guint downsync_bandwidth)
+{
+	g_return_if_fail (CAMEL_IS_OFFLINE_SETTINGS (settings));
+
+	if (settings->priv->downsync_bandwidth == downsync_bandwidth)
+		return;
+
+	settings->priv->downsync_bandwidth = downsync_bandwidth;
+
+	g_object_notify (G_OBJECT (settings), "downsync-bandwidth");
+}
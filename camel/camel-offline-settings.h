@@ -23,6 +23,7 @@
 #ifndef CAMEL_OFFLINE_SETTINGS_H
 #define CAMEL_OFFLINE_SETTINGS_H
 
+#include <camel/camel-enums.h>
 #include <camel/camel-store-settings.h>
 
 /* Standard GObject macros */
@@ -74,6 +75,17 @@ gboolean	camel_offline_settings_get_stay_synchronized
 void		camel_offline_settings_set_stay_synchronized
 					(CamelOfflineSettings *settings,
 					 gboolean stay_synchronized);
+CamelDownsyncPolicy
+		camel_offline_settings_get_downsync_policy
+					(CamelOfflineSettings *settings);
+void		camel_offline_settings_set_downsync_policy
+					(CamelOfflineSettings *settings,
+					 CamelDownsyncPolicy downsync_policy);
+guint		camel_offline_settings_get_downsync_bandwidth
+					(CamelOfflineSettings *settings);
+void		camel_offline_settings_set_downsync_bandwidth
+					(CamelOfflineSettings *settings,
+					 guint downsync_bandwidth);
 
 G_END_DECLS
 
@@ -55,6 +55,11 @@
 /* Prioritize ahead of GTK+ redraws. */
 #define JOB_PRIORITY G_PRIORITY_HIGH_IDLE
 
+/* How many jobs may run at once for a single service, and how many
+ * background jobs may run at once in total. */
+#define JOB_SERVICE_LIMIT 2
+#define JOB_BACKGROUND_LIMIT 2
+
 #define d(x)
 
 typedef struct _AsyncContext AsyncContext;
@@ -72,6 +77,14 @@ struct _CamelSessionPrivate {
 
 	GMainContext *main_context;
 
+	/* job scheduler, see camel_session_submit_job_full() */
+	GMutex jobs_lock;
+	GQueue pending_jobs;		/* JobData, by priority */
+	GList *running_jobs;		/* JobData */
+	GHashTable *running_per_service;	/* CamelService -> count */
+	guint running_background;
+	guint dispatch_scheduled : 1;
+
 	guint check_junk : 1;
 	guint network_available : 1;
 	guint online : 1;
@@ -91,6 +104,10 @@ struct _JobData {
 	CamelSessionCallback callback;
 	gpointer user_data;
 	GDestroyNotify notify;
+
+	CamelService *service;
+	CamelSessionJobPriority priority;
+	gchar *key;
 };
 
 enum {
@@ -138,12 +155,108 @@ job_data_free (JobData *job_data)
 	g_object_unref (job_data->session);
 	g_object_unref (job_data->cancellable);
 
+	if (job_data->service != NULL)
+		g_object_unref (job_data->service);
+
 	if (job_data->notify != NULL)
 		job_data->notify (job_data->user_data);
 
+	g_free (job_data->key);
+
 	g_slice_free (JobData, job_data);
 }
 
+static gint
+job_data_compare_priority (gconstpointer a,
+                           gconstpointer b,
+                           gpointer user_data)
+{
+	const JobData *job_a = a;
+	const JobData *job_b = b;
+
+	/* Equal priorities compare as "after", which keeps
+	 * g_queue_insert_sorted() first-in, first-out. */
+	return (job_a->priority < job_b->priority) ? -1 : 1;
+}
+
+static gboolean session_dispatch_jobs_cb (gpointer user_data);
+
+/* Call with the jobs_lock held. */
+static void
+session_schedule_dispatch_locked (CamelSession *session)
+{
+	if (session->priv->dispatch_scheduled)
+		return;
+
+	session->priv->dispatch_scheduled = TRUE;
+
+	camel_session_idle_add (
+		session, JOB_PRIORITY,
+		session_dispatch_jobs_cb,
+		g_object_ref (session),
+		(GDestroyNotify) g_object_unref);
+}
+
+/* Call with the jobs_lock held. */
+static gboolean
+session_job_can_start_locked (CamelSession *session,
+                              JobData *job_data)
+{
+	guint running = 0;
+
+	if (job_data->service != NULL)
+		running = GPOINTER_TO_UINT (g_hash_table_lookup (
+			session->priv->running_per_service,
+			job_data->service));
+
+	if (job_data->priority == CAMEL_SESSION_JOB_PRIORITY_BACKGROUND) {
+		/* Leave the service's other slot free for
+		 * anything more urgent which comes along. */
+		if (running > 0)
+			return FALSE;
+
+		return session->priv->running_background < JOB_BACKGROUND_LIMIT;
+	}
+
+	return running < JOB_SERVICE_LIMIT;
+}
+
+/* Call with the jobs_lock held. */
+static void
+session_job_account_locked (CamelSession *session,
+                            JobData *job_data,
+                            gint delta)
+{
+	if (job_data->service != NULL) {
+		guint running;
+
+		running = GPOINTER_TO_UINT (g_hash_table_lookup (
+			session->priv->running_per_service,
+			job_data->service));
+		running += delta;
+
+		if (running > 0)
+			g_hash_table_insert (
+				session->priv->running_per_service,
+				job_data->service,
+				GUINT_TO_POINTER (running));
+		else
+			g_hash_table_remove (
+				session->priv->running_per_service,
+				job_data->service);
+	}
+
+	if (job_data->priority == CAMEL_SESSION_JOB_PRIORITY_BACKGROUND)
+		session->priv->running_background += delta;
+
+	if (delta > 0)
+		session->priv->running_jobs = g_list_prepend (
+			session->priv->running_jobs, job_data);
+	else
+		session->priv->running_jobs = g_list_remove (
+			session->priv->running_jobs, job_data);
+}
+
 static void
 session_finish_job_cb (CamelSession *session,
                        GSimpleAsyncResult *simple)
@@ -160,6 +273,13 @@ session_finish_job_cb (CamelSession *session,
 		job_data->cancellable, error);
 
 	g_clear_error (&error);
+
+	/* Free the slot and let the next job in. */
+	g_mutex_lock (&session->priv->jobs_lock);
+	session_job_account_locked (session, job_data, -1);
+	if (!g_queue_is_empty (&session->priv->pending_jobs))
+		session_schedule_dispatch_locked (session);
+	g_mutex_unlock (&session->priv->jobs_lock);
 }
 
 static void
@@ -180,11 +300,11 @@ session_do_job_cb (GSimpleAsyncResult *simple,
 		g_simple_async_result_take_error (simple, error);
 }
 
-static gboolean
-session_start_job_cb (gpointer user_data)
+static void
+session_start_job (JobData *job_data)
 {
-	JobData *job_data = user_data;
 	GSimpleAsyncResult *simple;
+	gint io_priority;
 
 	g_signal_emit (
 		job_data->session,
@@ -202,12 +322,62 @@ session_start_job_cb (gpointer user_data)
 	g_simple_async_result_set_op_res_gpointer (
 		simple, job_data, (GDestroyNotify) job_data_free);
 
+	switch (job_data->priority) {
+		case CAMEL_SESSION_JOB_PRIORITY_BACKGROUND:
+			io_priority = G_PRIORITY_LOW;
+			break;
+		default:
+			io_priority = JOB_PRIORITY;
+			break;
+	}
+
 	g_simple_async_result_run_in_thread (
 		simple, (GSimpleAsyncThreadFunc)
-		session_do_job_cb, JOB_PRIORITY,
+		session_do_job_cb, io_priority,
 		job_data->cancellable);
 
 	g_object_unref (simple);
+}
+
+static gboolean
+session_dispatch_jobs_cb (gpointer user_data)
+{
+	CamelSession *session = user_data;
+	GQueue startable = G_QUEUE_INIT;
+	GQueue dropped = G_QUEUE_INIT;
+	JobData *job_data;
+	GList *link;
+
+	g_mutex_lock (&session->priv->jobs_lock);
+
+	session->priv->dispatch_scheduled = FALSE;
+
+	link = g_queue_peek_head_link (&session->priv->pending_jobs);
+
+	while (link != NULL) {
+		GList *next = g_list_next (link);
+
+		job_data = link->data;
+
+		if (g_cancellable_is_cancelled (job_data->cancellable)) {
+			g_queue_delete_link (&session->priv->pending_jobs, link);
+			g_queue_push_tail (&dropped, job_data);
+		} else if (session_job_can_start_locked (session, job_data)) {
+			g_queue_delete_link (&session->priv->pending_jobs, link);
+			session_job_account_locked (session, job_data, 1);
+			g_queue_push_tail (&startable, job_data);
+		}
+
+		link = next;
+	}
+
+	g_mutex_unlock (&session->priv->jobs_lock);
+
+	while ((job_data = g_queue_pop_head (&dropped)) != NULL)
+		job_data_free (job_data);
+
+	while ((job_data = g_queue_pop_head (&startable)) != NULL)
+		session_start_job (job_data);
 
 	return FALSE;
 }
@@ -367,6 +537,9 @@ session_finalize (GObject *object)
 
 	g_mutex_clear (&priv->services_lock);
 
+	g_hash_table_destroy (priv->running_per_service);
+	g_mutex_clear (&priv->jobs_lock);
+
 	if (priv->junk_headers) {
 		g_hash_table_remove_all (priv->junk_headers);
 		g_hash_table_destroy (priv->junk_headers);
@@ -862,6 +1035,11 @@ camel_session_init (CamelSession *session)
 	g_mutex_init (&session->priv->services_lock);
 	session->priv->junk_headers = NULL;
 
+	g_mutex_init (&session->priv->jobs_lock);
+	g_queue_init (&session->priv->pending_jobs);
+	session->priv->running_per_service =
+		g_hash_table_new (g_direct_hash, g_direct_equal);
+
 	session->priv->main_context = g_main_context_ref_thread_default ();
 }
 
@@ -1625,6 +1803,9 @@ camel_session_idle_add (CamelSession *session,
  * 4) Finally if a @notify function was provided, it is invoked and
  *    passed @user_data so that @user_data can be freed.
  *
+ * The job is scheduled with %CAMEL_SESSION_JOB_PRIORITY_NORMAL; use
+ * camel_session_submit_job_full() to choose a priority.
+ *
  * Since: 3.2
  **/
 void
@@ -1632,23 +1813,158 @@ camel_session_submit_job (CamelSession *session,
                           CamelSessionCallback callback,
                           gpointer user_data,
                           GDestroyNotify notify)
+{
+	g_return_if_fail (CAMEL_IS_SESSION (session));
+	g_return_if_fail (callback != NULL);
+
+	camel_session_submit_job_full (
+		session, NULL, CAMEL_SESSION_JOB_PRIORITY_NORMAL,
+		NULL, callback, user_data, notify);
+}
+
+/**
+ * camel_session_submit_job_full:
+ * @session: a #CamelSession
+ * @service: the #CamelService the job works with, or %NULL
+ * @priority: a #CamelSessionJobPriority
+ * @key: a key identifying the job, or %NULL
+ * @callback: a #CamelSessionCallback
+ * @user_data: user data passed to the callback
+ * @notify: a #GDestroyNotify function
+ *
+ * Like camel_session_submit_job(), but lets @session decide when to
+ * run the job based on @priority and on what else is running.
+ *
+ * Waiting jobs are started highest @priority first.  Jobs for the same
+ * @service are limited to two at a time, and background jobs only start
+ * while nothing else runs for their @service, so a long running bulk
+ * job never keeps a normal one waiting.
+ *
+ * If @key is given and a job with the same key is still waiting to be
+ * started, the new job is dropped: @notify is called right away and
+ * @callback is never invoked.  Waiting and running jobs can also be
+ * cancelled by their key with camel_session_cancel_jobs().
+ *
+ * Since: 3.12
+ **/
+void
+camel_session_submit_job_full (CamelSession *session,
+                               CamelService *service,
+                               CamelSessionJobPriority priority,
+                               const gchar *key,
+                               CamelSessionCallback callback,
+                               gpointer user_data,
+                               GDestroyNotify notify)
 {
 	JobData *job_data;
+	GList *link;
 
 	g_return_if_fail (CAMEL_IS_SESSION (session));
+	g_return_if_fail (service == NULL || CAMEL_IS_SERVICE (service));
 	g_return_if_fail (callback != NULL);
 
+	g_mutex_lock (&session->priv->jobs_lock);
+
+	if (key != NULL) {
+		link = g_queue_peek_head_link (&session->priv->pending_jobs);
+
+		for (; link != NULL; link = g_list_next (link)) {
+			job_data = link->data;
+
+			if (g_strcmp0 (job_data->key, key) == 0) {
+				g_mutex_unlock (&session->priv->jobs_lock);
+
+				if (notify != NULL)
+					notify (user_data);
+
+				return;
+			}
+		}
+	}
+
 	job_data = g_slice_new0 (JobData);
 	job_data->session = g_object_ref (session);
 	job_data->cancellable = camel_operation_new ();
 	job_data->callback = callback;
 	job_data->user_data = user_data;
 	job_data->notify = notify;
+	job_data->priority = priority;
+	job_data->key = g_strdup (key);
 
-	camel_session_idle_add (
-		session, JOB_PRIORITY,
-		session_start_job_cb,
-		job_data, (GDestroyNotify) NULL);
+	if (service != NULL)
+		job_data->service = g_object_ref (service);
+
+	g_queue_insert_sorted (
+		&session->priv->pending_jobs, job_data,
+		job_data_compare_priority, NULL);
+
+	session_schedule_dispatch_locked (session);
+
+	g_mutex_unlock (&session->priv->jobs_lock);
+}
+
+/**
+ * camel_session_cancel_jobs:
+ * @session: a #CamelSession
+ * @key: the key the jobs were submitted with
+ *
+ * Cancels all jobs submitted to @session with camel_session_submit_job_full()
+ * under @key.  Jobs which did not start yet are dropped without their
+ * callback ever being invoked; running jobs have their #GCancellable
+ * cancelled.
+ *
+ * Returns: the number of jobs which were cancelled
+ *
+ * Since: 3.12
+ **/
+guint
+camel_session_cancel_jobs (CamelSession *session,
+                           const gchar *key)
+{
+	GQueue dropped = G_QUEUE_INIT;
+	JobData *job_data;
+	GList *link;
+	guint n_cancelled = 0;
+
+	g_return_val_if_fail (CAMEL_IS_SESSION (session), 0);
+	g_return_val_if_fail (key != NULL, 0);
+
+	g_mutex_lock (&session->priv->jobs_lock);
+
+	link = g_queue_peek_head_link (&session->priv->pending_jobs);
+
+	while (link != NULL) {
+		GList *next = g_list_next (link);
+
+		job_data = link->data;
+
+		if (g_strcmp0 (job_data->key, key) == 0) {
+			g_queue_delete_link (&session->priv->pending_jobs, link);
+			g_queue_push_tail (&dropped, job_data);
+		}
+
+		link = next;
+	}
+
+	link = session->priv->running_jobs;
+
+	for (; link != NULL; link = g_list_next (link)) {
+		job_data = link->data;
+
+		if (g_strcmp0 (job_data->key, key) == 0) {
+			g_cancellable_cancel (job_data->cancellable);
+			n_cancelled++;
+		}
+	}
+
+	g_mutex_unlock (&session->priv->jobs_lock);
+
+	while ((job_data = g_queue_pop_head (&dropped)) != NULL) {
+		job_data_free (job_data);
+		n_cancelled++;
+	}
+
+	return n_cancelled;
 }
 
 /**
@@ -251,6 +251,15 @@ void		camel_session_submit_job	(CamelSession *session,
 						 CamelSessionCallback callback,
 						 gpointer user_data,
 						 GDestroyNotify notify);
+void		camel_session_submit_job_full	(CamelSession *session,
+						 CamelService *service,
+						 CamelSessionJobPriority priority,
+						 const gchar *key,
+						 CamelSessionCallback callback,
+						 gpointer user_data,
+						 GDestroyNotify notify);
+guint		camel_session_cancel_jobs	(CamelSession *session,
+						 const gchar *key);
 gboolean	camel_session_get_network_available
 						(CamelSession *session);
 void		camel_session_set_network_available
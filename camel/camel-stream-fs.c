@@ -27,11 +27,21 @@
 #endif
 
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#ifndef G_OS_WIN32
+#include <sys/uio.h>
+#endif
+
+#if defined (HAVE_SENDFILE) && defined (__linux__)
+#include <sys/sendfile.h>
+#define USE_SENDFILE 1
+#endif
+
 #include <glib/gstdio.h>
 
 #include "camel-file-utils.h"
@@ -43,6 +53,14 @@
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), CAMEL_TYPE_STREAM_FS, CamelStreamFsPrivate))
 
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+/* How much to hand to sendfile(2) at a time, so cancellation
+ * is still noticed reasonably quickly on very large files. */
+#define SENDFILE_CHUNK_SIZE (1024 * 1024)
+
 struct _CamelStreamFsPrivate {
 	gint fd;	/* file descriptor on the underlying file */
 };
@@ -102,6 +120,193 @@ stream_fs_write (CamelStream *stream,
 	return camel_write (priv->fd, buffer, n, cancellable, error);
 }
 
+#ifndef G_OS_WIN32
+static gssize
+stream_fs_readv (CamelStream *stream,
+                 GInputVector *vectors,
+                 gsize n_vectors,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	CamelStreamFsPrivate *priv;
+	struct iovec *iov;
+	gsize n_iov, requested = 0, ii;
+	gssize nread;
+
+	priv = CAMEL_STREAM_FS_GET_PRIVATE (stream);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return -1;
+
+	n_iov = MIN (n_vectors, IOV_MAX);
+	iov = g_newa (struct iovec, n_iov);
+	for (ii = 0; ii < n_iov; ii++) {
+		iov[ii].iov_base = vectors[ii].buffer;
+		iov[ii].iov_len = vectors[ii].size;
+		requested += vectors[ii].size;
+	}
+
+	do {
+		nread = readv (priv->fd, iov, n_iov);
+	} while (nread == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK));
+
+	if (nread == -1) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			"%s", g_strerror (errno));
+		return -1;
+	}
+
+	if (nread == 0 && requested > 0)
+		stream->eos = TRUE;
+
+	return nread;
+}
+
+static gssize
+stream_fs_writev (CamelStream *stream,
+                  const GOutputVector *vectors,
+                  gsize n_vectors,
+                  GCancellable *cancellable,
+                  GError **error)
+{
+	CamelStreamFsPrivate *priv;
+	struct iovec *iov;
+	gsize ii, first = 0;
+	gssize total = 0;
+
+	priv = CAMEL_STREAM_FS_GET_PRIVATE (stream);
+
+	iov = g_newa (struct iovec, MIN (n_vectors, IOV_MAX) + 1);
+
+	/* Skip leading empty vectors, and deal with partial writes
+	 * by advancing through the vector array ourselves. */
+	while (first < n_vectors) {
+		gsize n_iov, offset = 0;
+		gssize w;
+
+		if (vectors[first].size == 0) {
+			first++;
+			continue;
+		}
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return -1;
+
+		n_iov = MIN (n_vectors - first, IOV_MAX);
+		for (ii = 0; ii < n_iov; ii++) {
+			iov[ii].iov_base = (gpointer) vectors[first + ii].buffer;
+			iov[ii].iov_len = vectors[first + ii].size;
+		}
+
+		do {
+			w = writev (priv->fd, iov, n_iov);
+		} while (w == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK));
+
+		if (w == -1) {
+			g_set_error (
+				error, G_IO_ERROR,
+				g_io_error_from_errno (errno),
+				"%s", g_strerror (errno));
+			return -1;
+		}
+
+		total += w;
+
+		/* Drop the vectors which went out completely. */
+		while (first < n_vectors && (gsize) w >= vectors[first].size) {
+			w -= vectors[first].size;
+			first++;
+		}
+
+		/* Finish a partially written vector with plain writes. */
+		if (w > 0) {
+			const gchar *buffer = vectors[first].buffer;
+
+			offset = w;
+			w = camel_write (
+				priv->fd, buffer + offset,
+				vectors[first].size - offset,
+				cancellable, error);
+			if (w == -1)
+				return -1;
+
+			total += w;
+			first++;
+		}
+	}
+
+	return total;
+}
+#endif /* G_OS_WIN32 */
+
+#ifdef USE_SENDFILE
+static gssize
+stream_fs_write_to_stream (CamelStream *stream,
+                           CamelStream *output_stream,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	CamelStreamFsPrivate *priv;
+	gint out_fd;
+	gssize total = 0;
+
+	priv = CAMEL_STREAM_FS_GET_PRIVATE (stream);
+
+	/* Only a plain file descriptor on the other end lets
+	 * the kernel do the copy; anything else (filters, memory,
+	 * TLS sockets) needs the data in user space anyway. */
+	if (!CAMEL_IS_STREAM_FS (output_stream) || stream->eos)
+		goto fallback;
+
+	out_fd = camel_stream_fs_get_fd (CAMEL_STREAM_FS (output_stream));
+	if (priv->fd == -1 || out_fd == -1)
+		goto fallback;
+
+	while (TRUE) {
+		gssize n_bytes;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return -1;
+
+		do {
+			n_bytes = sendfile (
+				out_fd, priv->fd, NULL, SENDFILE_CHUNK_SIZE);
+		} while (n_bytes == -1 && (errno == EINTR || errno == EAGAIN));
+
+		if (n_bytes == 0) {
+			stream->eos = TRUE;
+			break;
+		}
+
+		if (n_bytes == -1) {
+			/* The descriptors are not suitable for sendfile()
+			 * (pipes, O_APPEND files on older kernels, ...),
+			 * so nothing was copied yet and the generic copy
+			 * can take over. */
+			if (total == 0 && (errno == EINVAL || errno == ENOSYS))
+				goto fallback;
+
+			g_set_error (
+				error, G_IO_ERROR,
+				g_io_error_from_errno (errno),
+				"%s", g_strerror (errno));
+			return -1;
+		}
+
+		total += n_bytes;
+	}
+
+	return total;
+
+fallback:
+	/* Chain up to parent's write_to_stream() method. */
+	return CAMEL_STREAM_CLASS (camel_stream_fs_parent_class)->
+		write_to_stream (stream, output_stream, cancellable, error);
+}
+#endif /* USE_SENDFILE */
+
 static gint
 stream_fs_flush (CamelStream *stream,
                  GCancellable *cancellable,
@@ -247,6 +452,13 @@ camel_stream_fs_class_init (CamelStreamFsClass *class)
 	stream_class->write = stream_fs_write;
 	stream_class->flush = stream_fs_flush;
 	stream_class->close = stream_fs_close;
+#ifndef G_OS_WIN32
+	stream_class->readv = stream_fs_readv;
+	stream_class->writev = stream_fs_writev;
+#endif
+#ifdef USE_SENDFILE
+	stream_class->write_to_stream = stream_fs_write_to_stream;
+#endif
 }
 
 static void
@@ -138,6 +138,68 @@ stream_mem_write (CamelStream *stream,
 	return nwrite;
 }
 
+static gssize
+stream_mem_writev (CamelStream *stream,
+                   const GOutputVector *vectors,
+                   gsize n_vectors,
+                   GCancellable *cancellable,
+                   GError **error)
+{
+	CamelStreamMemPrivate *priv;
+	gsize ii, n = 0;
+
+	priv = CAMEL_STREAM_MEM_GET_PRIVATE (stream);
+
+	for (ii = 0; ii < n_vectors; ii++)
+		n += vectors[ii].size;
+
+	/* Grow the buffer once, then copy each vector into place. */
+	if (priv->position + n > priv->buffer->len)
+		g_byte_array_set_size (priv->buffer, priv->position + n);
+
+	for (ii = 0; ii < n_vectors; ii++) {
+		if (vectors[ii].size == 0)
+			continue;
+		memcpy (
+			priv->buffer->data + priv->position,
+			vectors[ii].buffer, vectors[ii].size);
+		priv->position += vectors[ii].size;
+	}
+
+	return n;
+}
+
+static gssize
+stream_mem_write_to_stream (CamelStream *stream,
+                            CamelStream *output_stream,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+	CamelStreamMemPrivate *priv;
+	gssize total = 0;
+
+	priv = CAMEL_STREAM_MEM_GET_PRIVATE (stream);
+
+	/* Hand our buffer straight to the output stream rather
+	 * than bouncing it through an intermediate copy. */
+	while (priv->position < priv->buffer->len) {
+		gssize n_bytes;
+
+		n_bytes = camel_stream_write (
+			output_stream,
+			(const gchar *) priv->buffer->data + priv->position,
+			priv->buffer->len - priv->position,
+			cancellable, error);
+		if (n_bytes < 0)
+			return -1;
+
+		priv->position += n_bytes;
+		total += n_bytes;
+	}
+
+	return total;
+}
+
 static gboolean
 stream_mem_eos (CamelStream *stream)
 {
@@ -239,6 +301,8 @@ camel_stream_mem_class_init (CamelStreamMemClass *class)
 	stream_class->read = stream_mem_read;
 	stream_class->write = stream_mem_write;
 	stream_class->eos = stream_mem_eos;
+	stream_class->writev = stream_mem_writev;
+	stream_class->write_to_stream = stream_mem_write_to_stream;
 }
 
 static void
@@ -32,6 +32,12 @@
 #include "camel-debug.h"
 #include "camel-stream.h"
 
+/* Size of the bounce buffer used when copying between two streams
+ * which cannot hand their data over directly.  Large enough to keep
+ * the number of read/write round trips low for multi-megabyte
+ * messages, small enough to stay on the stack. */
+#define STREAM_COPY_BUFFER_SIZE (16 * 1024)
+
 G_DEFINE_ABSTRACT_TYPE (CamelStream, camel_stream, CAMEL_TYPE_OBJECT)
 
 static gssize
@@ -76,6 +82,108 @@ stream_eos (CamelStream *stream)
 	return stream->eos;
 }
 
+static gssize
+stream_readv (CamelStream *stream,
+              GInputVector *vectors,
+              gsize n_vectors,
+              GCancellable *cancellable,
+              GError **error)
+{
+	gssize total = 0;
+	gsize ii;
+
+	/* Fill each vector in turn, stopping at the first short read
+	 * so the caller sees the same semantics as readv(2). */
+	for (ii = 0; ii < n_vectors; ii++) {
+		gssize n_bytes;
+
+		if (vectors[ii].size == 0)
+			continue;
+
+		n_bytes = camel_stream_read (
+			stream, vectors[ii].buffer, vectors[ii].size,
+			cancellable, error);
+		if (n_bytes < 0)
+			return -1;
+
+		total += n_bytes;
+
+		if ((gsize) n_bytes < vectors[ii].size)
+			break;
+	}
+
+	return total;
+}
+
+static gssize
+stream_writev (CamelStream *stream,
+               const GOutputVector *vectors,
+               gsize n_vectors,
+               GCancellable *cancellable,
+               GError **error)
+{
+	gssize total = 0;
+	gsize ii;
+
+	for (ii = 0; ii < n_vectors; ii++) {
+		const gchar *buffer = vectors[ii].buffer;
+		gsize written = 0;
+
+		while (written < vectors[ii].size) {
+			gssize n_bytes;
+
+			n_bytes = camel_stream_write (
+				stream, buffer + written,
+				vectors[ii].size - written,
+				cancellable, error);
+			if (n_bytes < 0)
+				return -1;
+
+			written += n_bytes;
+		}
+
+		total += written;
+	}
+
+	return total;
+}
+
+static gssize
+stream_write_to_stream (CamelStream *stream,
+                        CamelStream *output_stream,
+                        GCancellable *cancellable,
+                        GError **error)
+{
+	gchar tmp_buf[STREAM_COPY_BUFFER_SIZE];
+	gssize total = 0;
+	gssize nb_read;
+	gssize nb_written;
+
+	while (!camel_stream_eos (stream)) {
+		nb_read = camel_stream_read (
+			stream, tmp_buf, sizeof (tmp_buf),
+			cancellable, error);
+		if (nb_read < 0)
+			return -1;
+		else if (nb_read > 0) {
+			nb_written = 0;
+
+			while (nb_written < nb_read) {
+				gssize len = camel_stream_write (
+					output_stream,
+					tmp_buf + nb_written,
+					nb_read - nb_written,
+					cancellable, error);
+				if (len < 0)
+					return -1;
+				nb_written += len;
+			}
+			total += nb_written;
+		}
+	}
+	return total;
+}
+
 static void
 camel_stream_class_init (CamelStreamClass *class)
 {
@@ -84,6 +192,9 @@ camel_stream_class_init (CamelStreamClass *class)
 	class->close = stream_close;
 	class->flush = stream_flush;
 	class->eos = stream_eos;
+	class->readv = stream_readv;
+	class->writev = stream_writev;
+	class->write_to_stream = stream_write_to_stream;
 }
 
 static void
@@ -241,6 +352,88 @@ camel_stream_eos (CamelStream *stream)
 	return class->eos (stream);
 }
 
+/**
+ * camel_stream_readv:
+ * @stream: a #CamelStream object
+ * @vectors: an array of #GInputVector buffers to fill
+ * @n_vectors: the number of elements in @vectors
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Attempts to fill the buffers described by @vectors from @stream,
+ * in order.  Like readv(2), a short read into one buffer ends the
+ * operation; the remaining buffers are left untouched.
+ *
+ * Streams backed by a file descriptor implement this with a single
+ * system call, other streams fall back to one camel_stream_read()
+ * per buffer.
+ *
+ * Returns: the total number of bytes read, or %-1 on error
+ *
+ * Since: 3.12
+ **/
+gssize
+camel_stream_readv (CamelStream *stream,
+                    GInputVector *vectors,
+                    gsize n_vectors,
+                    GCancellable *cancellable,
+                    GError **error)
+{
+	CamelStreamClass *class;
+	gssize n_bytes;
+
+	g_return_val_if_fail (CAMEL_IS_STREAM (stream), -1);
+	g_return_val_if_fail (n_vectors == 0 || vectors != NULL, -1);
+
+	class = CAMEL_STREAM_GET_CLASS (stream);
+	g_return_val_if_fail (class->readv != NULL, -1);
+
+	n_bytes = class->readv (stream, vectors, n_vectors, cancellable, error);
+	CAMEL_CHECK_GERROR (stream, readv, n_bytes >= 0, error);
+
+	return n_bytes;
+}
+
+/**
+ * camel_stream_writev:
+ * @stream: a #CamelStream object
+ * @vectors: an array of #GOutputVector buffers to write
+ * @n_vectors: the number of elements in @vectors
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes all the buffers described by @vectors to @stream, in order,
+ * without first gathering them into a single contiguous buffer.
+ *
+ * Streams backed by a file descriptor implement this with writev(2),
+ * other streams fall back to one camel_stream_write() per buffer.
+ *
+ * Returns: the total number of bytes written, or %-1 on error
+ *
+ * Since: 3.12
+ **/
+gssize
+camel_stream_writev (CamelStream *stream,
+                     const GOutputVector *vectors,
+                     gsize n_vectors,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+	CamelStreamClass *class;
+	gssize n_bytes;
+
+	g_return_val_if_fail (CAMEL_IS_STREAM (stream), -1);
+	g_return_val_if_fail (n_vectors == 0 || vectors != NULL, -1);
+
+	class = CAMEL_STREAM_GET_CLASS (stream);
+	g_return_val_if_fail (class->writev != NULL, -1);
+
+	n_bytes = class->writev (stream, vectors, n_vectors, cancellable, error);
+	CAMEL_CHECK_GERROR (stream, writev, n_bytes >= 0, error);
+
+	return n_bytes;
+}
+
 /***************** Utility functions ********************/
 
 /**
@@ -276,6 +469,11 @@ camel_stream_write_string (CamelStream *stream,
  * Write all of a stream (until eos) into another stream, in a
  * blocking fashion.
  *
+ * Stream implementations may provide a faster path than the generic
+ * read/write loop, for example by handing their own buffer directly
+ * to @output_stream, or by letting the kernel copy the data when both
+ * streams are backed by file descriptors.
+ *
  * Returns: %-1 on error, or the number of bytes succesfully
  * copied across streams.
  **/
@@ -285,35 +483,18 @@ camel_stream_write_to_stream (CamelStream *stream,
                               GCancellable *cancellable,
                               GError **error)
 {
-	gchar tmp_buf[4096];
-	gssize total = 0;
-	gssize nb_read;
-	gssize nb_written;
+	CamelStreamClass *class;
+	gssize n_bytes;
 
 	g_return_val_if_fail (CAMEL_IS_STREAM (stream), -1);
 	g_return_val_if_fail (CAMEL_IS_STREAM (output_stream), -1);
 
-	while (!camel_stream_eos (stream)) {
-		nb_read = camel_stream_read (
-			stream, tmp_buf, sizeof (tmp_buf),
-			cancellable, error);
-		if (nb_read < 0)
-			return -1;
-		else if (nb_read > 0) {
-			nb_written = 0;
+	class = CAMEL_STREAM_GET_CLASS (stream);
+	g_return_val_if_fail (class->write_to_stream != NULL, -1);
 
-			while (nb_written < nb_read) {
-				gssize len = camel_stream_write (
-					output_stream,
-					tmp_buf + nb_written,
-					nb_read - nb_written,
-					cancellable, error);
-				if (len < 0)
-					return -1;
-				nb_written += len;
-			}
-			total += nb_written;
-		}
-	}
-	return total;
+	n_bytes = class->write_to_stream (
+		stream, output_stream, cancellable, error);
+	CAMEL_CHECK_GERROR (stream, write_to_stream, n_bytes >= 0, error);
+
+	return n_bytes;
 }
@@ -83,6 +83,20 @@ struct _CamelStreamClass {
 						 GCancellable *cancellable,
 						 GError **error);
 	gboolean	(*eos)			(CamelStream *stream);
+	gssize		(*readv)		(CamelStream *stream,
+						 GInputVector *vectors,
+						 gsize n_vectors,
+						 GCancellable *cancellable,
+						 GError **error);
+	gssize		(*writev)		(CamelStream *stream,
+						 const GOutputVector *vectors,
+						 gsize n_vectors,
+						 GCancellable *cancellable,
+						 GError **error);
+	gssize		(*write_to_stream)	(CamelStream *stream,
+						 CamelStream *output_stream,
+						 GCancellable *cancellable,
+						 GError **error);
 };
 
 GType		camel_stream_get_type		(void);
@@ -103,6 +117,16 @@ gint		camel_stream_close		(CamelStream *stream,
 						 GCancellable *cancellable,
 						 GError **error);
 gboolean	camel_stream_eos		(CamelStream *stream);
+gssize		camel_stream_readv		(CamelStream *stream,
+						 GInputVector *vectors,
+						 gsize n_vectors,
+						 GCancellable *cancellable,
+						 GError **error);
+gssize		camel_stream_writev		(CamelStream *stream,
+						 const GOutputVector *vectors,
+						 gsize n_vectors,
+						 GCancellable *cancellable,
+						 GError **error);
 
 /* utility macros and funcs */
 gssize		camel_stream_write_string	(CamelStream *stream,
@@ -27,9 +27,12 @@
 #include <config.h>
 #endif
 
+#include <glib/gi18n-lib.h>
+
 #include "camel-address.h"
 #include "camel-debug.h"
 #include "camel-mime-message.h"
+#include "camel-operation.h"
 #include "camel-transport.h"
 
 #define CAMEL_TRANSPORT_GET_PRIVATE(obj) \
@@ -47,6 +50,7 @@ struct _AsyncContext {
 	CamelAddress *from;
 	CamelAddress *recipients;
 	CamelMimeMessage *message;
+	GPtrArray *queue;
 };
 
 G_DEFINE_ABSTRACT_TYPE (CamelTransport, camel_transport, CAMEL_TYPE_SERVICE)
@@ -63,6 +67,9 @@ async_context_free (AsyncContext *async_context)
 	if (async_context->message != NULL)
 		g_object_unref (async_context->message);
 
+	if (async_context->queue != NULL)
+		g_ptr_array_unref (async_context->queue);
+
 	g_slice_free (AsyncContext, async_context);
 }
 
@@ -147,6 +154,105 @@ transport_send_to_finish (CamelTransport *transport,
 	return !g_simple_async_result_propagate_error (simple, error);
 }
 
+static gboolean
+transport_send_queue_sync (CamelTransport *transport,
+                           GPtrArray *queue,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	CamelTransportClass *class;
+	guint ii;
+
+	class = CAMEL_TRANSPORT_GET_CLASS (transport);
+	g_return_val_if_fail (class->send_to_sync != NULL, FALSE);
+
+	/* Without any session to share, this is no better than
+	 * sending each message on its own.  Transports that can
+	 * keep a connection open across messages override this. */
+	for (ii = 0; ii < queue->len; ii++) {
+		CamelTransportQueueItem *item = queue->pdata[ii];
+		gint64 started;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return FALSE;
+
+		camel_operation_progress (
+			cancellable, ii * 100 / queue->len);
+
+		started = g_get_monotonic_time ();
+		item->sent = class->send_to_sync (
+			transport, item->message, item->from,
+			item->recipients, cancellable, &item->error);
+		item->elapsed = g_get_monotonic_time () - started;
+	}
+
+	return TRUE;
+}
+
+static void
+transport_send_queue_thread (GSimpleAsyncResult *simple,
+                             GObject *object,
+                             GCancellable *cancellable)
+{
+	AsyncContext *async_context;
+	GError *error = NULL;
+
+	async_context = g_simple_async_result_get_op_res_gpointer (simple);
+
+	camel_transport_send_queue_sync (
+		CAMEL_TRANSPORT (object), async_context->queue,
+		cancellable, &error);
+
+	if (error != NULL)
+		g_simple_async_result_take_error (simple, error);
+}
+
+static void
+transport_send_queue (CamelTransport *transport,
+                      GPtrArray *queue,
+                      gint io_priority,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+	GSimpleAsyncResult *simple;
+	AsyncContext *async_context;
+
+	async_context = g_slice_new0 (AsyncContext);
+	async_context->queue = g_ptr_array_ref (queue);
+
+	simple = g_simple_async_result_new (
+		G_OBJECT (transport), callback,
+		user_data, transport_send_queue);
+
+	g_simple_async_result_set_check_cancellable (simple, cancellable);
+
+	g_simple_async_result_set_op_res_gpointer (
+		simple, async_context, (GDestroyNotify) async_context_free);
+
+	g_simple_async_result_run_in_thread (
+		simple, transport_send_queue_thread, io_priority, cancellable);
+
+	g_object_unref (simple);
+}
+
+static gboolean
+transport_send_queue_finish (CamelTransport *transport,
+                             GAsyncResult *result,
+                             GError **error)
+{
+	GSimpleAsyncResult *simple;
+
+	g_return_val_if_fail (
+		g_simple_async_result_is_valid (
+		result, G_OBJECT (transport), transport_send_queue), FALSE);
+
+	simple = G_SIMPLE_ASYNC_RESULT (result);
+
+	/* Assume success unless a GError is set. */
+	return !g_simple_async_result_propagate_error (simple, error);
+}
+
 static void
 camel_transport_class_init (CamelTransportClass *class)
 {
@@ -157,8 +263,11 @@ camel_transport_class_init (CamelTransportClass *class)
 	object_class = G_OBJECT_CLASS (class);
 	object_class->finalize = transport_finalize;
 
+	class->send_queue_sync = transport_send_queue_sync;
 	class->send_to = transport_send_to;
 	class->send_to_finish = transport_send_to_finish;
+	class->send_queue = transport_send_queue;
+	class->send_queue_finish = transport_send_queue_finish;
 }
 
 static void
@@ -342,3 +451,192 @@ camel_transport_send_to_finish (CamelTransport *transport,
 
 	return class->send_to_finish (transport, result, error);
 }
+
+/**
+ * camel_transport_send_queue_sync:
+ * @transport: a #CamelTransport
+ * @queue: (element-type CamelTransportQueueItem): messages to send
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Sends every message in @queue, in order, sharing one session with
+ * the server where the transport supports it.  A message being refused
+ * does not stop the remaining ones from being sent; the outcome of each
+ * message is stored in its #CamelTransportQueueItem, along with the
+ * time it took to send.
+ *
+ * Returns %FALSE and sets @error only if the queue could not be
+ * drained, for example because the operation was cancelled or the
+ * connection could not be re-established.  Items that were not tried
+ * are left with @sent set to %FALSE and no error.
+ *
+ * Returns: %TRUE if every message was tried, %FALSE on error
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_transport_send_queue_sync (CamelTransport *transport,
+                                 GPtrArray *queue,
+                                 GCancellable *cancellable,
+                                 GError **error)
+{
+	CamelTransportClass *class;
+	gboolean success;
+
+	g_return_val_if_fail (CAMEL_IS_TRANSPORT (transport), FALSE);
+	g_return_val_if_fail (queue != NULL, FALSE);
+
+	class = CAMEL_TRANSPORT_GET_CLASS (transport);
+	g_return_val_if_fail (class->send_queue_sync != NULL, FALSE);
+
+	if (queue->len == 0)
+		return TRUE;
+
+	camel_transport_lock (transport, CAMEL_TRANSPORT_SEND_LOCK);
+
+	/* Check for cancellation after locking. */
+	if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+		camel_transport_unlock (transport, CAMEL_TRANSPORT_SEND_LOCK);
+		return FALSE;
+	}
+
+	camel_operation_push_message (
+		cancellable, dngettext (GETTEXT_PACKAGE,
+		"Sending %d message",
+		"Sending %d messages",
+		queue->len), queue->len);
+
+	success = class->send_queue_sync (
+		transport, queue, cancellable, error);
+	CAMEL_CHECK_GERROR (transport, send_queue_sync, success, error);
+
+	camel_operation_pop_message (cancellable);
+
+	camel_transport_unlock (transport, CAMEL_TRANSPORT_SEND_LOCK);
+
+	return success;
+}
+
+/**
+ * camel_transport_send_queue:
+ * @transport: a #CamelTransport
+ * @queue: (element-type CamelTransportQueueItem): messages to send
+ * @io_priority: the I/O priority of the request
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied
+ * @user_data: data to pass to the callback function
+ *
+ * Asynchronously sends every message in @queue.  See
+ * camel_transport_send_queue_sync() for details.  The items in @queue
+ * are updated in place and must not be touched until @callback has
+ * been called.
+ *
+ * When the operation is finished, @callback will be called.  You can then
+ * call camel_transport_send_queue_finish() to get the result of the
+ * operation.
+ *
+ * Since: 3.12
+ **/
+void
+camel_transport_send_queue (CamelTransport *transport,
+                            GPtrArray *queue,
+                            gint io_priority,
+                            GCancellable *cancellable,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data)
+{
+	CamelTransportClass *class;
+
+	g_return_if_fail (CAMEL_IS_TRANSPORT (transport));
+	g_return_if_fail (queue != NULL);
+
+	class = CAMEL_TRANSPORT_GET_CLASS (transport);
+	g_return_if_fail (class->send_queue != NULL);
+
+	class->send_queue (
+		transport, queue, io_priority,
+		cancellable, callback, user_data);
+}
+
+/**
+ * camel_transport_send_queue_finish:
+ * @transport: a #CamelTransport
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes the operation started with camel_transport_send_queue().
+ *
+ * Returns: %TRUE if every message was tried, %FALSE on error
+ *
+ * Since: 3.12
+ **/
+gboolean
+camel_transport_send_queue_finish (CamelTransport *transport,
+                                   GAsyncResult *result,
+                                   GError **error)
+{
+	CamelTransportClass *class;
+
+	g_return_val_if_fail (CAMEL_IS_TRANSPORT (transport), FALSE);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (result), FALSE);
+
+	class = CAMEL_TRANSPORT_GET_CLASS (transport);
+	g_return_val_if_fail (class->send_queue_finish != NULL, FALSE);
+
+	return class->send_queue_finish (transport, result, error);
+}
+
+/**
+ * camel_transport_queue_item_new:
+ * @message: a #CamelMimeMessage to send
+ * @from: a #CamelAddress to send from
+ * @recipients: a #CamelAddress containing all recipients
+ *
+ * Creates a new #CamelTransportQueueItem for use with
+ * camel_transport_send_queue_sync().  Free it with
+ * camel_transport_queue_item_free().
+ *
+ * Returns: a new #CamelTransportQueueItem
+ *
+ * Since: 3.12
+ **/
+CamelTransportQueueItem *
+camel_transport_queue_item_new (CamelMimeMessage *message,
+                                CamelAddress *from,
+                                CamelAddress *recipients)
+{
+	CamelTransportQueueItem *item;
+
+	g_return_val_if_fail (CAMEL_IS_MIME_MESSAGE (message), NULL);
+	g_return_val_if_fail (CAMEL_IS_ADDRESS (from), NULL);
+	g_return_val_if_fail (CAMEL_IS_ADDRESS (recipients), NULL);
+
+	item = g_slice_new0 (CamelTransportQueueItem);
+	item->message = g_object_ref (message);
+	item->from = g_object_ref (from);
+	item->recipients = g_object_ref (recipients);
+
+	return item;
+}
+
+/**
+ * camel_transport_queue_item_free:
+ * @item: a #CamelTransportQueueItem
+ *
+ * Frees @item and everything it references.
+ *
+ * Since: 3.12
+ **/
+void
+camel_transport_queue_item_free (CamelTransportQueueItem *item)
+{
+	if (item == NULL)
+		return;
+
+	g_object_unref (item->message);
+	g_object_unref (item->from);
+	g_object_unref (item->recipients);
+	g_clear_error (&item->error);
+
+	g_slice_free (CamelTransportQueueItem, item);
+}
@@ -58,6 +58,7 @@ G_BEGIN_DECLS
 typedef struct _CamelTransport CamelTransport;
 typedef struct _CamelTransportClass CamelTransportClass;
 typedef struct _CamelTransportPrivate CamelTransportPrivate;
+typedef struct _CamelTransportQueueItem CamelTransportQueueItem;
 
 /**
  * CamelTransportLock:
@@ -68,6 +69,29 @@ typedef enum {
 	CAMEL_TRANSPORT_SEND_LOCK
 } CamelTransportLock;
 
+/**
+ * CamelTransportQueueItem:
+ * @message: the #CamelMimeMessage to send
+ * @from: the #CamelAddress to send from
+ * @recipients: a #CamelAddress containing all recipients
+ * @sent: whether the message was accepted by the transport
+ * @error: why the message was not sent, or %NULL
+ * @elapsed: time spent sending the message, in microseconds
+ *
+ * One entry of a queue passed to camel_transport_send_queue_sync().
+ * The transport fills in @sent, @error and @elapsed.
+ *
+ * Since: 3.12
+ **/
+struct _CamelTransportQueueItem {
+	CamelMimeMessage *message;
+	CamelAddress *from;
+	CamelAddress *recipients;
+	gboolean sent;
+	GError *error;
+	gint64 elapsed;
+};
+
 struct _CamelTransport {
 	CamelService parent;
 	CamelTransportPrivate *priv;
@@ -96,6 +120,21 @@ struct _CamelTransportClass {
 	gboolean	(*send_to_finish)	(CamelTransport *transport,
 						 GAsyncResult *result,
 						 GError **error);
+
+	/* Appended to keep the offsets of the methods above */
+	gboolean	(*send_queue_sync)	(CamelTransport *transport,
+						 GPtrArray *queue,
+						 GCancellable *cancellable,
+						 GError **error);
+	void		(*send_queue)		(CamelTransport *transport,
+						 GPtrArray *queue,
+						 gint io_priority,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+	gboolean	(*send_queue_finish)	(CamelTransport *transport,
+						 GAsyncResult *result,
+						 GError **error);
 };
 
 GType		camel_transport_get_type	(void);
@@ -121,6 +160,26 @@ void		camel_transport_send_to		(CamelTransport *transport,
 gboolean	camel_transport_send_to_finish	(CamelTransport *transport,
 						 GAsyncResult *result,
 						 GError **error);
+gboolean	camel_transport_send_queue_sync	(CamelTransport *transport,
+						 GPtrArray *queue,
+						 GCancellable *cancellable,
+						 GError **error);
+void		camel_transport_send_queue	(CamelTransport *transport,
+						 GPtrArray *queue,
+						 gint io_priority,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	camel_transport_send_queue_finish
+						(CamelTransport *transport,
+						 GAsyncResult *result,
+						 GError **error);
+
+CamelTransportQueueItem *
+		camel_transport_queue_item_new	(CamelMimeMessage *message,
+						 CamelAddress *from,
+						 CamelAddress *recipients);
+void		camel_transport_queue_item_free	(CamelTransportQueueItem *item);
 
 G_END_DECLS
 
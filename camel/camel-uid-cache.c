@@ -38,9 +38,16 @@
 #include "camel-uid-cache.h"
 #include "camel-win32.h"
 
+/* The cache file is a list of UIDs, one per line, which saving only
+ * appends to.  It is rewritten from scratch once the UIDs no longer
+ * wanted (gone from the server, or duplicated) take up more room than
+ * the live ones, and at least UID_CACHE_COMPACT_MIN bytes. */
+#define UID_CACHE_COMPACT_MIN (16 * 1024)
+
 struct _uid_state {
 	gint level;
 	gboolean save;
+	gboolean on_disk;
 };
 
 /**
@@ -94,7 +101,7 @@ camel_uid_cache_new (const gchar *filename)
 	cache->filename = g_strdup (filename);
 	cache->level = 1;
 	cache->expired = 0;
-	cache->size = 0;
+	cache->size = st.st_size;
 	cache->fd = -1;
 
 	uids = g_strsplit (buf, "\n", 0);
@@ -102,9 +109,17 @@ camel_uid_cache_new (const gchar *filename)
 	for (i = 0; uids[i]; i++) {
 		struct _uid_state *state;
 
+		/* Empty lines and UIDs appended twice only count
+		 * towards the next compaction. */
+		if (*uids[i] == '\0' || g_hash_table_lookup (cache->uids, uids[i]) != NULL) {
+			g_free (uids[i]);
+			continue;
+		}
+
 		state = g_new (struct _uid_state, 1);
 		state->level = cache->level;
 		state->save = TRUE;
+		state->on_disk = TRUE;
 
 		g_hash_table_insert (cache->uids, uids[i], state);
 	}
@@ -139,16 +154,64 @@ maybe_write_uid (gpointer key,
 	}
 }
 
-/**
- * camel_uid_cache_save:
- * @cache: a CamelUIDCache
- *
- * Attempts to save @cache back to disk.
- *
- * Returns: success or failure
- **/
-gboolean
-camel_uid_cache_save (CamelUIDCache *cache)
+static gboolean
+uid_cache_is_live (CamelUIDCache *cache,
+                   struct _uid_state *state)
+{
+	return state->level == cache->level && state->save;
+}
+
+/* Appends the UIDs in @buffer to the cache file. */
+static gboolean
+uid_cache_append (CamelUIDCache *cache,
+                  GString *buffer)
+{
+	struct stat st;
+	gchar last;
+	gint fd;
+
+	if ((fd = g_open (cache->filename, O_RDWR | O_CREAT | O_BINARY, 0666)) == -1)
+		return FALSE;
+
+	if (fstat (fd, &st) == -1)
+		goto exception;
+
+	/* A save interrupted halfway may have left a partial
+	 * line behind; never run a new UID into it. */
+	if (st.st_size > 0) {
+		if (lseek (fd, st.st_size - 1, SEEK_SET) == -1 ||
+		    camel_read (fd, &last, 1, NULL, NULL) != 1)
+			goto exception;
+		if (last != '\n')
+			g_string_prepend_c (buffer, '\n');
+	}
+
+	if (lseek (fd, st.st_size, SEEK_SET) == -1)
+		goto exception;
+
+	if (camel_write (fd, buffer->str, buffer->len, NULL, NULL) == -1 ||
+	    fsync (fd) == -1) {
+		/* drop whatever made it, so the file stays line based */
+		if (ftruncate (fd, st.st_size) == -1)
+			g_warning ("%s: Failed to truncate '%s': %s", G_STRFUNC, cache->filename, g_strerror (errno));
+		goto exception;
+	}
+
+	close (fd);
+
+	cache->size = st.st_size + buffer->len;
+
+	return TRUE;
+
+ exception:
+	close (fd);
+
+	return FALSE;
+}
+
+/* Rewrites the cache file with just the live UIDs. */
+static gboolean
+uid_cache_compact (CamelUIDCache *cache)
 {
 	gchar *filename;
 	gint errnosav;
@@ -177,6 +240,8 @@ camel_uid_cache_save (CamelUIDCache *cache)
 
 	g_free (filename);
 
+	cache->expired = 0;
+
 	return TRUE;
 
  exception:
@@ -229,6 +294,77 @@ camel_uid_cache_save (CamelUIDCache *cache)
 	return FALSE;
 }
 
+/**
+ * camel_uid_cache_save:
+ * @cache: a CamelUIDCache
+ *
+ * Attempts to save @cache back to disk.  Only the UIDs which are not
+ * on disk yet get appended to the file; it is rewritten as a whole
+ * only once UIDs no longer wanted make up most of it.
+ *
+ * Returns: success or failure
+ **/
+gboolean
+camel_uid_cache_save (CamelUIDCache *cache)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GString *buffer;
+	gsize live = 0, live_on_disk = 0;
+	gboolean success = TRUE;
+
+	buffer = g_string_new (NULL);
+
+	/* Work out what the file is missing and how much of it is dead. */
+	g_hash_table_iter_init (&iter, cache->uids);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		struct _uid_state *state = value;
+		gsize len = strlen (key) + 1;
+
+		if (!uid_cache_is_live (cache, state))
+			continue;
+
+		live += len;
+
+		if (state->on_disk) {
+			live_on_disk += len;
+		} else {
+			g_string_append_len (buffer, key, len - 1);
+			g_string_append_c (buffer, '\n');
+		}
+	}
+
+	cache->expired = cache->size > live_on_disk ? cache->size - live_on_disk : 0;
+
+	if (cache->expired >= UID_CACHE_COMPACT_MIN && cache->expired > live) {
+		gsize old_size = cache->size;
+
+		/* the old file is still in place if this fails */
+		success = uid_cache_compact (cache);
+		if (!success)
+			cache->size = old_size;
+	} else if (buffer->len > 0)
+		success = uid_cache_append (cache, buffer);
+
+	g_string_free (buffer, TRUE);
+
+	if (!success)
+		return FALSE;
+
+	/* the file now holds exactly the live UIDs */
+	g_hash_table_iter_init (&iter, cache->uids);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		struct _uid_state *state = value;
+
+		if (uid_cache_is_live (cache, state))
+			state->on_disk = TRUE;
+		else if (cache->expired == 0)
+			state->on_disk = FALSE;
+	}
+
+	return TRUE;
+}
+
 static void
 free_uid (gpointer key,
           gpointer value,
@@ -269,28 +405,28 @@ camel_uid_cache_get_new_uids (CamelUIDCache *cache,
                               GPtrArray *uids)
 {
 	GPtrArray *new_uids;
-	gpointer old_uid;
 	gchar *uid;
 	gint i;
 
 	new_uids = g_ptr_array_new ();
 	cache->level++;
 
+	/* A single lookup per UID; known UIDs only get their
+	 * level bumped, without reallocating their entry. */
 	for (i = 0; i < uids->len; i++) {
 		struct _uid_state *state;
 
 		uid = uids->pdata[i];
-		if (g_hash_table_lookup_extended (cache->uids, uid, (gpointer *) &old_uid, (gpointer *) &state)) {
-			g_hash_table_remove (cache->uids, uid);
-			g_free (old_uid);
-		} else {
+		state = g_hash_table_lookup (cache->uids, uid);
+		if (state == NULL) {
 			g_ptr_array_add (new_uids, g_strdup (uid));
 			state = g_new (struct _uid_state, 1);
 			state->save = FALSE;
+			state->on_disk = FALSE;
+			g_hash_table_insert (cache->uids, g_strdup (uid), state);
 		}
 
 		state->level = cache->level;
-		g_hash_table_insert (cache->uids, g_strdup (uid), state);
 	}
 
 	return new_uids;
@@ -319,6 +455,7 @@ camel_uid_cache_save_uid (CamelUIDCache *cache,
 		state = g_new (struct _uid_state, 1);
 		state->save = TRUE;
 		state->level = cache->level;
+		state->on_disk = FALSE;
 
 		g_hash_table_insert (cache->uids, g_strdup (uid), state);
 	}
@@ -24,9 +24,34 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
 
 #include "camel-local-private.h"
 
+/* how many files may be read ahead of the one being summarised */
+#define PREFETCH_WINDOW (64)
+#define PREFETCH_MAX_THREADS (8)
+/* larger files are left for the summary to read itself */
+#define PREFETCH_MAX_SIZE (1024 * 1024)
+
+struct _CamelLocalPrefetch {
+	gchar *dir_path;
+	GPtrArray *names;
+
+	GMutex lock;
+	GCond cond;
+	GByteArray **contents;
+	gboolean *done;
+
+	guint next_push;
+	guint next_take;
+
+	GThreadPool *pool;
+};
+
 gint
 camel_local_frompos_sort (gpointer enc,
                           gint len1,
@@ -54,3 +79,159 @@ camel_local_frompos_sort (gpointer enc,
 
 	return a1 - a2;
 }
+
+static void
+local_prefetch_read (gpointer data,
+                     gpointer user_data)
+{
+	CamelLocalPrefetch *prefetch = user_data;
+	guint index = GPOINTER_TO_UINT (data) - 1;
+	GByteArray *content = NULL;
+	gchar *filename, *buffer = NULL;
+	gsize length = 0;
+	struct stat st;
+
+	filename = g_build_filename (
+		prefetch->dir_path,
+		(const gchar *) g_ptr_array_index (prefetch->names, index), NULL);
+
+	/* a failure is left for the summary to report when it opens the file */
+	if (g_stat (filename, &st) == 0 && st.st_size <= PREFETCH_MAX_SIZE &&
+	    g_file_get_contents (filename, &buffer, &length, NULL))
+		content = g_byte_array_new_take ((guint8 *) buffer, length);
+
+	g_free (filename);
+
+	g_mutex_lock (&prefetch->lock);
+	prefetch->contents[index] = content;
+	prefetch->done[index] = TRUE;
+	g_cond_broadcast (&prefetch->cond);
+	g_mutex_unlock (&prefetch->lock);
+}
+
+static void
+local_prefetch_fill (CamelLocalPrefetch *prefetch)
+{
+	while (prefetch->next_push < prefetch->names->len &&
+	       prefetch->next_push < prefetch->next_take + PREFETCH_WINDOW) {
+		prefetch->next_push++;
+		g_thread_pool_push (
+			prefetch->pool,
+			GUINT_TO_POINTER (prefetch->next_push), NULL);
+	}
+}
+
+/**
+ * camel_local_prefetch_new:
+ * @dir_path: directory holding the files
+ * @names: (transfer full): file names, relative to @dir_path, in the
+ *         order they will be consumed
+ *
+ * Starts reading the files in @names on a pool of worker threads,
+ * keeping at most a fixed window of them in memory at a time.  Files
+ * which are too large to be worth holding in memory are skipped, and
+ * come back with %NULL content.
+ *
+ * Returns: a new #CamelLocalPrefetch, free it with
+ * camel_local_prefetch_free()
+ **/
+CamelLocalPrefetch *
+camel_local_prefetch_new (const gchar *dir_path,
+                          GPtrArray *names)
+{
+	CamelLocalPrefetch *prefetch;
+	gint max_threads = 2;
+
+	g_return_val_if_fail (dir_path != NULL, NULL);
+	g_return_val_if_fail (names != NULL, NULL);
+
+#ifdef _SC_NPROCESSORS_ONLN
+	max_threads = CLAMP (sysconf (_SC_NPROCESSORS_ONLN), 2, PREFETCH_MAX_THREADS);
+#endif
+
+	prefetch = g_new0 (CamelLocalPrefetch, 1);
+	prefetch->dir_path = g_strdup (dir_path);
+	prefetch->names = names;
+	prefetch->contents = g_new0 (GByteArray *, MAX (names->len, 1));
+	prefetch->done = g_new0 (gboolean, MAX (names->len, 1));
+	g_mutex_init (&prefetch->lock);
+	g_cond_init (&prefetch->cond);
+
+	prefetch->pool = g_thread_pool_new (
+		local_prefetch_read, prefetch, max_threads, FALSE, NULL);
+
+	local_prefetch_fill (prefetch);
+
+	return prefetch;
+}
+
+/**
+ * camel_local_prefetch_next:
+ * @prefetch: a #CamelLocalPrefetch
+ * @out_name: (out): return location for the file name
+ * @out_content: (out) (transfer full): return location for the file
+ *               content, %NULL if it could not be read
+ *
+ * Waits for the next file in order to be read.
+ *
+ * Returns: %FALSE when all the files have been consumed
+ **/
+gboolean
+camel_local_prefetch_next (CamelLocalPrefetch *prefetch,
+                           const gchar **out_name,
+                           GByteArray **out_content)
+{
+	guint index;
+
+	g_return_val_if_fail (prefetch != NULL, FALSE);
+	g_return_val_if_fail (out_name != NULL, FALSE);
+	g_return_val_if_fail (out_content != NULL, FALSE);
+
+	index = prefetch->next_take;
+	if (index >= prefetch->names->len)
+		return FALSE;
+
+	g_mutex_lock (&prefetch->lock);
+	while (!prefetch->done[index])
+		g_cond_wait (&prefetch->cond, &prefetch->lock);
+	*out_content = prefetch->contents[index];
+	prefetch->contents[index] = NULL;
+	g_mutex_unlock (&prefetch->lock);
+
+	*out_name = g_ptr_array_index (prefetch->names, index);
+
+	prefetch->next_take++;
+	local_prefetch_fill (prefetch);
+
+	return TRUE;
+}
+
+/**
+ * camel_local_prefetch_free:
+ * @prefetch: a #CamelLocalPrefetch
+ *
+ * Drops the files which were not consumed and frees @prefetch.
+ **/
+void
+camel_local_prefetch_free (CamelLocalPrefetch *prefetch)
+{
+	guint ii;
+
+	g_return_if_fail (prefetch != NULL);
+
+	/* drop what is still queued, wait for what is being read */
+	g_thread_pool_free (prefetch->pool, TRUE, TRUE);
+
+	for (ii = 0; ii < prefetch->names->len; ii++) {
+		if (prefetch->contents[ii])
+			g_byte_array_unref (prefetch->contents[ii]);
+	}
+
+	g_mutex_clear (&prefetch->lock);
+	g_cond_clear (&prefetch->cond);
+	g_ptr_array_unref (prefetch->names);
+	g_free (prefetch->contents);
+	g_free (prefetch->done);
+	g_free (prefetch->dir_path);
+	g_free (prefetch);
+}
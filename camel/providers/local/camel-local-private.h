@@ -49,6 +49,18 @@ gint		camel_local_frompos_sort	(gpointer enc,
 						 gint len2,
 						 gpointer data2);
 
+/* Reads message files ahead of the summary rebuild on a worker pool,
+ * handing them back one at a time in the order they were given. */
+typedef struct _CamelLocalPrefetch CamelLocalPrefetch;
+
+CamelLocalPrefetch *
+		camel_local_prefetch_new	(const gchar *dir_path,
+						 GPtrArray *names);
+gboolean	camel_local_prefetch_next	(CamelLocalPrefetch *prefetch,
+						 const gchar **out_name,
+						 GByteArray **out_content);
+void		camel_local_prefetch_free	(CamelLocalPrefetch *prefetch);
+
 G_END_DECLS
 
 #endif /* CAMEL_LOCAL_PRIVATE_H */
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -37,9 +38,15 @@
 #include <winsock2.h>
 #endif
 
+#if defined (HAVE_SYS_INOTIFY_H) && !defined (G_OS_WIN32)
+#include <sys/inotify.h>
+#define USE_INOTIFY 1
+#endif
+
 #include <glib/gstdio.h>
 #include <glib/gi18n-lib.h>
 
+#include "camel-local-private.h"
 #include "camel-maildir-summary.h"
 
 #define CAMEL_MAILDIR_SUMMARY_GET_PRIVATE(obj) \
@@ -86,6 +93,9 @@ static gint	maildir_summary_decode_x_evolution
 static gchar *	maildir_summary_encode_x_evolution
 						(CamelLocalSummary *cls,
 						 const CamelLocalMessageInfo *mi);
+#ifdef USE_INOTIFY
+static void	maildir_summary_unwatch		(CamelMaildirSummary *mds);
+#endif
 
 struct _CamelMaildirSummaryPrivate {
 	gchar *current_file;
@@ -93,8 +103,31 @@ struct _CamelMaildirSummaryPrivate {
 
 	GHashTable *load_map;
 	GMutex summary_lock;
+
+	/* Change journal for cur/ and new/, so that a check only has to
+	 * look at the files which changed since the previous one.  The
+	 * watches live in an inotify instance shared by all folders, see
+	 * maildir_watcher; the fields other than journal_valid are guarded
+	 * by its lock. */
+	gint cur_wd;
+	gint new_wd;
+	GHashTable *journal; /* uid -> MaildirJournalEntry */
+	gboolean new_changed;
+	gboolean journal_overflow;
+	gboolean journal_valid;
+
+	/* Fallback when inotify is not available: skip rescanning
+	 * a directory whose modification time did not change. */
+	time_t cur_mtime;
+	time_t new_mtime;
 };
 
+/* A single journalled change in cur/, keyed by uid. */
+typedef struct _MaildirJournalEntry {
+	gchar *name;
+	gboolean present;
+} MaildirJournalEntry;
+
 G_DEFINE_TYPE (CamelMaildirSummary, camel_maildir_summary, CAMEL_TYPE_LOCAL_SUMMARY)
 
 static void
@@ -107,6 +140,13 @@ maildir_summary_finalize (GObject *object)
 	g_free (priv->hostname);
 	g_mutex_clear (&priv->summary_lock);
 
+#ifdef USE_INOTIFY
+	maildir_summary_unwatch (CAMEL_MAILDIR_SUMMARY (object));
+
+	if (priv->journal != NULL)
+		g_hash_table_destroy (priv->journal);
+#endif
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (camel_maildir_summary_parent_class)->finalize (object);
 }
@@ -160,6 +200,9 @@ camel_maildir_summary_init (CamelMaildirSummary *maildir_summary)
 		maildir_summary->priv->hostname = g_strdup ("localhost");
 	}
 	g_mutex_init (&maildir_summary->priv->summary_lock);
+
+	maildir_summary->priv->cur_wd = -1;
+	maildir_summary->priv->new_wd = -1;
 }
 
 /**
@@ -495,9 +538,11 @@ maildir_summary_load (CamelLocalSummary *cls,
 	return ret;
 }
 
+/* @content, if not %NULL, is the already read file; it is consumed */
 static gint
 camel_maildir_summary_add (CamelLocalSummary *cls,
                            const gchar *name,
+                           GByteArray *content,
                            gint forceindex,
                            GCancellable *cancellable)
 {
@@ -508,15 +553,25 @@ camel_maildir_summary_add (CamelLocalSummary *cls,
 
 	d (printf ("summarising: %s\n", name));
 
-	fd = open (filename, O_RDONLY | O_LARGEFILE);
-	if (fd == -1) {
-		g_warning ("Cannot summarise/index: %s: %s", filename, g_strerror (errno));
-		g_free (filename);
-		return -1;
-	}
 	mp = camel_mime_parser_new ();
 	camel_mime_parser_scan_from (mp, FALSE);
-	camel_mime_parser_init_with_fd (mp, fd);
+
+	if (content != NULL) {
+		CamelStream *stream;
+
+		stream = camel_stream_mem_new_with_byte_array (content);
+		camel_mime_parser_init_with_stream (mp, stream, NULL);
+		g_object_unref (stream);
+	} else {
+		fd = open (filename, O_RDONLY | O_LARGEFILE);
+		if (fd == -1) {
+			g_warning ("Cannot summarise/index: %s: %s", filename, g_strerror (errno));
+			g_object_unref (mp);
+			g_free (filename);
+			return -1;
+		}
+		camel_mime_parser_init_with_fd (mp, fd);
+	}
 	if (cls->index && (forceindex || !camel_index_has_name (cls->index, name))) {
 		d (printf ("forcing indexing of message content\n"));
 		camel_folder_summary_set_index ((CamelFolderSummary *) maildirs, cls->index);
@@ -551,11 +606,327 @@ remove_summary (gchar *key,
 	camel_message_info_free (info);
 }
 
+#ifdef USE_INOTIFY
+/* One inotify instance is shared by the maildir folders of the whole
+ * process, each adding watches for its cur/ and new/.  A user only gets
+ * a few instances (128 by default), while a store may hold hundreds of
+ * folders.  The events read by any folder's check are sorted into the
+ * journals of the folders they belong to. */
+G_LOCK_DEFINE_STATIC (maildir_watcher);
+static gint maildir_watcher_fd = -1;
+static GHashTable *maildir_watcher_wds; /* wd -> CamelMaildirSummary, not referenced */
+
+static void
+maildir_journal_entry_free (MaildirJournalEntry *entry)
+{
+	g_free (entry->name);
+	g_free (entry);
+}
+
+/* Call with the maildir_watcher lock held. */
+static void
+maildir_watcher_release_if_unused (void)
+{
+	if (maildir_watcher_fd == -1 || g_hash_table_size (maildir_watcher_wds) > 0)
+		return;
+
+	close (maildir_watcher_fd);
+	maildir_watcher_fd = -1;
+	g_hash_table_destroy (maildir_watcher_wds);
+	maildir_watcher_wds = NULL;
+}
+
+/* Call with the maildir_watcher lock held. */
+static void
+maildir_watcher_remove (CamelMaildirSummary *mds)
+{
+	if (mds->priv->cur_wd != -1) {
+		inotify_rm_watch (maildir_watcher_fd, mds->priv->cur_wd);
+		g_hash_table_remove (maildir_watcher_wds, GINT_TO_POINTER (mds->priv->cur_wd));
+	}
+	if (mds->priv->new_wd != -1) {
+		inotify_rm_watch (maildir_watcher_fd, mds->priv->new_wd);
+		g_hash_table_remove (maildir_watcher_wds, GINT_TO_POINTER (mds->priv->new_wd));
+	}
+
+	mds->priv->cur_wd = -1;
+	mds->priv->new_wd = -1;
+	mds->priv->new_changed = FALSE;
+	mds->priv->journal_overflow = FALSE;
+	if (mds->priv->journal)
+		g_hash_table_remove_all (mds->priv->journal);
+
+	maildir_watcher_release_if_unused ();
+}
+
+/* Call with the maildir_watcher lock held. */
+static void
+maildir_watcher_overflow (void)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init (&iter, maildir_watcher_wds);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		CamelMaildirSummary *mds = value;
+
+		mds->priv->journal_overflow = TRUE;
+	}
+}
+
+/* Records a change of @mds, keeping only the last known state of each
+ * uid in cur/.  Call with the maildir_watcher lock held. */
+static void
+maildir_watcher_journal_event (CamelMaildirSummary *mds,
+                               const struct inotify_event *ev)
+{
+	MaildirJournalEntry *entry, *prev;
+	gchar *uid;
+
+	if (ev->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
+		mds->priv->journal_overflow = TRUE;
+		return;
+	}
+
+	if (ev->wd == mds->priv->new_wd) {
+		mds->priv->new_changed = TRUE;
+		return;
+	}
+
+	if (ev->len == 0 || (ev->mask & IN_ISDIR) != 0 || ev->name[0] == '.')
+		return;
+
+	uid = strchr (ev->name, ':');
+	if (uid)
+		uid = g_strndup (ev->name, uid - ev->name);
+	else
+		uid = g_strdup (ev->name);
+
+	entry = g_new0 (MaildirJournalEntry, 1);
+	entry->name = g_strdup (ev->name);
+	entry->present = (ev->mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+
+	/* link() the new name, then unlink() the old one:
+	 * the removal must not hide the earlier creation */
+	prev = g_hash_table_lookup (mds->priv->journal, uid);
+	if (!entry->present && prev && prev->present &&
+	    strcmp (prev->name, entry->name) != 0) {
+		maildir_journal_entry_free (entry);
+		g_free (uid);
+		return;
+	}
+
+	g_hash_table_replace (mds->priv->journal, uid, entry);
+}
+
+/* Drains the pending inotify events into the journals of the folders
+ * they belong to.  Call with the maildir_watcher lock held. */
+static void
+maildir_watcher_read (void)
+{
+	gchar buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+	const struct inotify_event *ev;
+	gssize len;
+	gchar *p;
+
+	while (TRUE) {
+		len = read (maildir_watcher_fd, buf, sizeof (buf));
+		if (len == -1 && errno == EINTR)
+			continue;
+		if (len == -1 && errno == EAGAIN)
+			return;
+		if (len <= 0) {
+			maildir_watcher_overflow ();
+			return;
+		}
+
+		for (p = buf; p < buf + len; p += sizeof (struct inotify_event) + ev->len) {
+			CamelMaildirSummary *mds;
+
+			ev = (const struct inotify_event *) p;
+
+			if (ev->mask & IN_Q_OVERFLOW) {
+				maildir_watcher_overflow ();
+				continue;
+			}
+
+			/* NULL for watches removed in the meantime */
+			mds = g_hash_table_lookup (maildir_watcher_wds, GINT_TO_POINTER (ev->wd));
+			if (mds != NULL)
+				maildir_watcher_journal_event (mds, ev);
+		}
+	}
+}
+
+static void
+maildir_summary_unwatch (CamelMaildirSummary *mds)
+{
+	G_LOCK (maildir_watcher);
+	maildir_watcher_remove (mds);
+	G_UNLOCK (maildir_watcher);
+
+	mds->priv->journal_valid = FALSE;
+}
+
+/* Starts watching cur/ and new/.  This has to happen before the full
+ * scan which makes the journal valid, so that no change can slip in
+ * between the scan and the watch. */
+static gboolean
+maildir_summary_watch (CamelMaildirSummary *mds,
+                       const gchar *cur,
+                       const gchar *new)
+{
+	const guint32 mask =
+		IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+		IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+	gboolean cur_taken, new_taken;
+	gint cur_wd, new_wd;
+
+	if (mds->priv->cur_wd != -1)
+		return TRUE;
+
+	G_LOCK (maildir_watcher);
+
+	if (maildir_watcher_fd == -1) {
+		maildir_watcher_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+		if (maildir_watcher_fd == -1) {
+			d (printf ("inotify not available: %s\n", g_strerror (errno)));
+			G_UNLOCK (maildir_watcher);
+			return FALSE;
+		}
+
+		maildir_watcher_wds = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+
+	cur_wd = inotify_add_watch (maildir_watcher_fd, cur, mask);
+	new_wd = inotify_add_watch (maildir_watcher_fd, new, mask);
+
+	/* A directory some other summary watches already gives back
+	 * that summary's descriptor; leave this one to the scan. */
+	cur_taken = g_hash_table_lookup (maildir_watcher_wds, GINT_TO_POINTER (cur_wd)) != NULL;
+	new_taken = g_hash_table_lookup (maildir_watcher_wds, GINT_TO_POINTER (new_wd)) != NULL;
+
+	if (cur_wd == -1 || new_wd == -1 || cur_taken || new_taken) {
+		d (printf ("cannot watch maildir %s: %s\n", cur, g_strerror (errno)));
+		if (cur_wd != -1 && !cur_taken)
+			inotify_rm_watch (maildir_watcher_fd, cur_wd);
+		if (new_wd != -1 && !new_taken)
+			inotify_rm_watch (maildir_watcher_fd, new_wd);
+		maildir_watcher_release_if_unused ();
+		G_UNLOCK (maildir_watcher);
+		return FALSE;
+	}
+
+	g_hash_table_insert (maildir_watcher_wds, GINT_TO_POINTER (cur_wd), mds);
+	g_hash_table_insert (maildir_watcher_wds, GINT_TO_POINTER (new_wd), mds);
+	mds->priv->cur_wd = cur_wd;
+	mds->priv->new_wd = new_wd;
+
+	if (mds->priv->journal == NULL)
+		mds->priv->journal = g_hash_table_new_full (
+			g_str_hash, g_str_equal, g_free,
+			(GDestroyNotify) maildir_journal_entry_free);
+
+	G_UNLOCK (maildir_watcher);
+
+	return TRUE;
+}
+
+/* Takes the changes journalled for @mds since the previous call into
+ * @journal.  Returns FALSE if the journal cannot be trusted (queue
+ * overflow, directory gone), in which case a full scan is needed. */
+static gboolean
+maildir_summary_read_journal (CamelMaildirSummary *mds,
+                              GHashTable **journal,
+                              gboolean *new_changed)
+{
+	gboolean valid;
+
+	G_LOCK (maildir_watcher);
+
+	maildir_watcher_read ();
+
+	valid = !mds->priv->journal_overflow;
+	*new_changed = mds->priv->new_changed;
+	*journal = mds->priv->journal;
+
+	mds->priv->new_changed = FALSE;
+	mds->priv->journal = g_hash_table_new_full (
+		g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify) maildir_journal_entry_free);
+
+	G_UNLOCK (maildir_watcher);
+
+	return valid;
+}
+
+/* Feeds the journalled changes of cur/ into the summary. */
+static void
+maildir_summary_apply_journal (CamelLocalSummary *cls,
+                               GHashTable *journal,
+                               CamelFolderChangeInfo *changes,
+                               GCancellable *cancellable)
+{
+	CamelFolderSummary *s = (CamelFolderSummary *) cls;
+	struct _remove_data rd = { cls, changes };
+	GHashTableIter iter;
+	gpointer key, value;
+	gint count = 0, total;
+
+	total = g_hash_table_size (journal);
+
+	g_hash_table_iter_init (&iter, journal);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		const gchar *uid = key;
+		MaildirJournalEntry *entry = value;
+		CamelMessageInfo *info;
+		const gchar *filename;
+
+		camel_operation_progress (cancellable, count * 100 / total);
+		count++;
+
+		info = camel_folder_summary_get (s, uid);
+		filename = info ? camel_maildir_info_filename ((CamelMaildirMessageInfo *) info) : NULL;
+
+		if (entry->present) {
+			if (info == NULL) {
+				if (camel_maildir_summary_add (cls, entry->name, NULL, FALSE, cancellable) == 0)
+					if (changes)
+						camel_folder_change_info_add_uid (changes, uid);
+			} else if (filename == NULL || strcmp (filename, entry->name) != 0) {
+				CamelMaildirMessageInfo *mdi = (CamelMaildirMessageInfo *) info;
+
+				g_free (mdi->filename);
+				mdi->filename = g_strdup (entry->name);
+			}
+		} else if (info != NULL && (filename == NULL || strcmp (filename, entry->name) == 0)) {
+			/* remove_summary() frees the info */
+			remove_summary ((gchar *) uid, info, &rd);
+			continue;
+		}
+
+		if (info)
+			camel_message_info_free (info);
+	}
+}
+#endif
+
 static gint
-maildir_summary_check (CamelLocalSummary *cls,
-                       CamelFolderChangeInfo *changes,
-                       GCancellable *cancellable,
-                       GError **error)
+maildir_summary_name_cmp (gconstpointer a,
+                          gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* Scans all of cur/, check for mail files not in the index, or index
+ * entries that no longer exist. */
+static gint
+maildir_summary_scan_cur (CamelLocalSummary *cls,
+                          const gchar *cur,
+                          CamelFolderChangeInfo *changes,
+                          gint *forceindex,
+                          GCancellable *cancellable,
+                          GError **error)
 {
 	DIR *dir;
 	struct dirent *d;
@@ -565,24 +936,14 @@ maildir_summary_check (CamelLocalSummary *cls,
 	CamelFolderSummary *s = (CamelFolderSummary *) cls;
 	GHashTable *left;
 	gint i, count, total;
-	gint forceindex;
-	gchar *new, *cur;
 	gchar *uid;
 	struct _remove_data rd = { cls, changes };
 	GPtrArray *known_uids;
+	GPtrArray *pending;
+	CamelLocalPrefetch *prefetch;
+	GByteArray *content;
+	const gchar *name;
 
-	g_mutex_lock (&((CamelMaildirSummary *) cls)->priv->summary_lock);
-
-	new = g_strdup_printf ("%s/new", cls->folder_path);
-	cur = g_strdup_printf ("%s/cur", cls->folder_path);
-
-	d (printf ("checking summary ...\n"));
-
-	camel_operation_push_message (
-		cancellable, _("Checking folder consistency"));
-
-	/* scan the directory, check for mail files not in the index, or index entries that
-	 * no longer exist */
 	dir = opendir (cur);
 	if (dir == NULL) {
 		g_set_error (
@@ -590,10 +951,6 @@ maildir_summary_check (CamelLocalSummary *cls,
 			g_io_error_from_errno (errno),
 			_("Cannot open maildir directory path: %s: %s"),
 			cls->folder_path, g_strerror (errno));
-		g_free (cur);
-		g_free (new);
-		camel_operation_pop_message (cancellable);
-		g_mutex_unlock (&((CamelMaildirSummary *) cls)->priv->summary_lock);
 		return -1;
 	}
 
@@ -601,7 +958,7 @@ maildir_summary_check (CamelLocalSummary *cls,
 	left = g_hash_table_new (g_str_hash, g_str_equal);
 	camel_folder_summary_prepare_fetch_all (s, error);
 	known_uids = camel_folder_summary_get_array (s);
-	forceindex = !known_uids || known_uids->len == 0;
+	*forceindex = !known_uids || known_uids->len == 0;
 	for (i = 0; known_uids && i < known_uids->len; i++) {
 		info = camel_folder_summary_get ((CamelFolderSummary *) cls, g_ptr_array_index (known_uids, i));
 		if (info) {
@@ -609,19 +966,10 @@ maildir_summary_check (CamelLocalSummary *cls,
 		}
 	}
 
-	/* joy, use this to pre-count the total, so we can report progress meaningfully */
-	total = 0;
-	count = 0;
-	while (readdir (dir))
-		total++;
-	rewinddir (dir);
+	/* files to (re)summarise, read ahead in parallel further below */
+	pending = g_ptr_array_new_with_free_func (g_free);
 
 	while ((d = readdir (dir))) {
-		gint pc = count * 100 / total;
-
-		camel_operation_progress (cancellable, pc);
-		count++;
-
 		/* FIXME: also run stat to check for regular file */
 		p = d->d_name;
 		if (p[0] == '.')
@@ -643,15 +991,13 @@ maildir_summary_check (CamelLocalSummary *cls,
 		info = camel_folder_summary_get ((CamelFolderSummary *) cls, uid);
 		if (info == NULL) {
 			/* must be a message incorporated by another client, this is not a 'recent' uid */
-			if (camel_maildir_summary_add (cls, d->d_name, forceindex, cancellable) == 0)
-				if (changes)
-					camel_folder_change_info_add_uid (changes, uid);
+			g_ptr_array_add (pending, g_strdup (d->d_name));
 		} else {
 			const gchar *filename;
 
 			if (cls->index && (!camel_index_has_name (cls->index, uid))) {
 				/* message_info_new will handle duplicates */
-				camel_maildir_summary_add (cls, d->d_name, forceindex, cancellable);
+				g_ptr_array_add (pending, g_strdup (d->d_name));
 			}
 
 			mdi = (CamelMaildirMessageInfo *) info;
@@ -669,79 +1015,265 @@ maildir_summary_check (CamelLocalSummary *cls,
 	g_hash_table_foreach (left, (GHFunc) remove_summary, &rd);
 	g_hash_table_destroy (left);
 
-	camel_operation_pop_message (cancellable);
+	camel_folder_summary_free_array (known_uids);
 
-	camel_operation_push_message (
-		cancellable, _("Checking for new messages"));
+	/* Reading and parsing are split: the files are read on a worker
+	 * pool, while the summary is fed in uid order from this thread. */
+	g_ptr_array_sort (pending, maildir_summary_name_cmp);
+
+	total = pending->len;
+	count = 0;
+	prefetch = camel_local_prefetch_new (cur, pending);
+	while (camel_local_prefetch_next (prefetch, &name, &content)) {
+		gboolean is_new;
+
+		camel_operation_progress (cancellable, count * 100 / total);
+		count++;
+
+		uid = strchr (name, ':');
+		if (uid)
+			uid = g_strndup (name, uid - name);
+		else
+			uid = g_strdup (name);
+
+		is_new = !camel_folder_summary_check_uid (s, uid);
+		if (camel_maildir_summary_add (cls, name, content, *forceindex, cancellable) == 0)
+			if (is_new && changes)
+				camel_folder_change_info_add_uid (changes, uid);
+
+		g_free (uid);
+	}
+	camel_local_prefetch_free (prefetch);
+
+	return 0;
+}
+
+/* Moves everything from new/ into cur/ and adds it to the summary.
+ * Returns the number of messages moved. */
+static gint
+maildir_summary_scan_new (CamelLocalSummary *cls,
+                          const gchar *new,
+                          const gchar *cur,
+                          CamelFolderChangeInfo *changes,
+                          gint forceindex,
+                          GCancellable *cancellable)
+{
+	DIR *dir;
+	struct dirent *d;
+	CamelMessageInfo *info;
+	CamelFolderSummary *s = (CamelFolderSummary *) cls;
+	gint count, total, moved = 0;
 
-	/* now, scan new for new messages, and copy them to cur, and so forth */
 	dir = opendir (new);
-	if (dir != NULL) {
-		total = 0;
-		count = 0;
-		while (readdir (dir))
-			total++;
-		rewinddir (dir);
-
-		while ((d = readdir (dir))) {
-			gchar *name, *newname, *destname, *destfilename;
-			gchar *src, *dest;
-			gint pc = count * 100 / total;
-
-			camel_operation_progress (cancellable, pc);
-			count++;
-
-			name = d->d_name;
-			if (name[0] == '.')
-				continue;
+	if (dir == NULL)
+		return 0;
 
-			/* already in summary?  shouldn't happen, but just incase ... */
-			if ((info = camel_folder_summary_get ((CamelFolderSummary *) cls, name))) {
-				camel_message_info_free (info);
-				newname = destname = camel_folder_summary_next_uid_string (s);
-			} else {
-				gchar *nm;
-				newname = g_strdup (name);
-				nm =strrchr (newname, ':');
-				if (nm)
-					*nm = '\0';
-				destname = newname;
-			}
+	total = 0;
+	count = 0;
+	while (readdir (dir))
+		total++;
+	rewinddir (dir);
 
-			/* copy this to the destination folder, use 'standard' semantics for maildir info field */
-			src = g_strdup_printf ("%s/%s", new, name);
-			destfilename = g_strdup_printf ("%s:2,", destname);
-			dest = g_strdup_printf ("%s/%s", cur, destfilename);
+	while ((d = readdir (dir))) {
+		gchar *name, *newname, *destname, *destfilename;
+		gchar *src, *dest;
+		gint pc = count * 100 / total;
 
-			/* FIXME: This should probably use link/unlink */
+		camel_operation_progress (cancellable, pc);
+		count++;
 
-			if (g_rename (src, dest) == 0) {
-				camel_maildir_summary_add (cls, destfilename, forceindex, cancellable);
-				if (changes) {
-					camel_folder_change_info_add_uid (changes, destname);
-					camel_folder_change_info_recent_uid (changes, destname);
-				}
-			} else {
-				/* else?  we should probably care about failures, but wont */
-				g_warning ("Failed to move new maildir message %s to cur %s", src, dest);
+		name = d->d_name;
+		if (name[0] == '.')
+			continue;
+
+		/* already in summary?  shouldn't happen, but just incase ... */
+		if ((info = camel_folder_summary_get ((CamelFolderSummary *) cls, name))) {
+			camel_message_info_free (info);
+			newname = destname = camel_folder_summary_next_uid_string (s);
+		} else {
+			gchar *nm;
+			newname = g_strdup (name);
+			nm =strrchr (newname, ':');
+			if (nm)
+				*nm = '\0';
+			destname = newname;
+		}
+
+		/* copy this to the destination folder, use 'standard' semantics for maildir info field */
+		src = g_strdup_printf ("%s/%s", new, name);
+		destfilename = g_strdup_printf ("%s:2,", destname);
+		dest = g_strdup_printf ("%s/%s", cur, destfilename);
+
+		/* FIXME: This should probably use link/unlink */
+
+		if (g_rename (src, dest) == 0) {
+			camel_maildir_summary_add (cls, destfilename, NULL, forceindex, cancellable);
+			if (changes) {
+				camel_folder_change_info_add_uid (changes, destname);
+				camel_folder_change_info_recent_uid (changes, destname);
 			}
+			moved++;
+		} else {
+			/* else?  we should probably care about failures, but wont */
+			g_warning ("Failed to move new maildir message %s to cur %s", src, dest);
+		}
+
+		/* c strings are painful to work with ... */
+		g_free (destfilename);
+		g_free (newname);
+		g_free (src);
+		g_free (dest);
+	}
+
+	closedir (dir);
+
+	return moved;
+}
+
+/* Returns the directory's modification time if it is safe to compare
+ * against on the next check, that is, if it is older than @now; changes
+ * within the same second would otherwise go unnoticed.  Returns 0 if it
+ * is not. */
+static time_t
+maildir_summary_dir_mtime (const gchar *path,
+                           time_t now)
+{
+	struct stat st;
+
+	if (g_stat (path, &st) == -1 || st.st_mtime >= now)
+		return 0;
+
+	return st.st_mtime;
+}
+
+static gboolean
+maildir_summary_dir_unchanged (const gchar *path,
+                               time_t mtime)
+{
+	struct stat st;
+
+	return mtime != 0 && g_stat (path, &st) == 0 && st.st_mtime == mtime;
+}
+
+static gint
+maildir_summary_check (CamelLocalSummary *cls,
+                       CamelFolderChangeInfo *changes,
+                       GCancellable *cancellable,
+                       GError **error)
+{
+	CamelMaildirSummary *mds = (CamelMaildirSummary *) cls;
+	CamelFolderSummary *s = (CamelFolderSummary *) cls;
+	gboolean scan_cur = TRUE, scan_new = TRUE;
+	gint forceindex;
+	gchar *new, *cur;
+	time_t now;
+#ifdef USE_INOTIFY
+	GHashTable *journal = NULL;
+#endif
 
-			/* c strings are painful to work with ... */
-			g_free (destfilename);
-			g_free (newname);
-			g_free (src);
-			g_free (dest);
+	g_mutex_lock (&mds->priv->summary_lock);
+
+	new = g_strdup_printf ("%s/new", cls->folder_path);
+	cur = g_strdup_printf ("%s/cur", cls->folder_path);
+
+	d (printf ("checking summary ...\n"));
+
+	camel_operation_push_message (
+		cancellable, _("Checking folder consistency"));
+
+	now = time (NULL);
+	forceindex = camel_folder_summary_count (s) == 0;
+
+	/* an empty summary was either never filled or has been
+	 * cleared; neither the journal nor the mtimes cover that */
+	if (forceindex) {
+		mds->priv->journal_valid = FALSE;
+		mds->priv->cur_mtime = 0;
+		mds->priv->new_mtime = 0;
+	}
+
+#ifdef USE_INOTIFY
+	if (mds->priv->journal_valid) {
+		if (maildir_summary_read_journal (mds, &journal, &scan_new)) {
+			scan_cur = FALSE;
+		} else {
+			/* start over with a fresh queue */
+			maildir_summary_unwatch (mds);
+			g_hash_table_destroy (journal);
+			journal = NULL;
+			scan_new = TRUE;
 		}
+	}
 
-		camel_operation_pop_message (cancellable);
-		closedir (dir);
+	if (scan_cur && maildir_summary_watch (mds, cur, new)) {
+		/* the mtime shortcut is not needed with a journal */
+		mds->priv->cur_mtime = 0;
+		mds->priv->new_mtime = 0;
 	}
+#endif
+
+	if (scan_cur && maildir_summary_dir_unchanged (cur, mds->priv->cur_mtime))
+		scan_cur = FALSE;
+	if (scan_new && maildir_summary_dir_unchanged (new, mds->priv->new_mtime))
+		scan_new = FALSE;
+
+#ifdef USE_INOTIFY
+	if (journal) {
+		d (printf ("applying %d journalled changes\n", g_hash_table_size (journal)));
+		maildir_summary_apply_journal (cls, journal, changes, cancellable);
+		g_hash_table_destroy (journal);
+	}
+#endif
+
+	if (scan_cur) {
+		time_t cur_mtime = 0;
+
+		if (mds->priv->cur_wd == -1)
+			cur_mtime = maildir_summary_dir_mtime (cur, now);
+
+		if (maildir_summary_scan_cur (cls, cur, changes, &forceindex, cancellable, error) == -1) {
+#ifdef USE_INOTIFY
+			maildir_summary_unwatch (mds);
+#endif
+			mds->priv->cur_mtime = 0;
+			g_free (cur);
+			g_free (new);
+			camel_operation_pop_message (cancellable);
+			g_mutex_unlock (&mds->priv->summary_lock);
+			return -1;
+		}
+
+		mds->priv->cur_mtime = cur_mtime;
+#ifdef USE_INOTIFY
+		mds->priv->journal_valid = mds->priv->cur_wd != -1;
+#endif
+	}
+
+	camel_operation_pop_message (cancellable);
+
+	camel_operation_push_message (
+		cancellable, _("Checking for new messages"));
+
+	/* now, scan new for new messages, and copy them to cur, and so forth */
+	if (scan_new) {
+		time_t new_mtime = 0;
+
+		if (mds->priv->cur_wd == -1)
+			new_mtime = maildir_summary_dir_mtime (new, now);
+
+		/* moving messages into cur/ invalidates its mtime */
+		if (maildir_summary_scan_new (cls, new, cur, changes, forceindex, cancellable) > 0)
+			mds->priv->cur_mtime = 0;
+
+		mds->priv->new_mtime = new_mtime;
+	}
+
+	camel_operation_pop_message (cancellable);
 
 	g_free (new);
 	g_free (cur);
 
-	camel_folder_summary_free_array (known_uids);
-	g_mutex_unlock (&((CamelMaildirSummary *) cls)->priv->summary_lock);
+	g_mutex_unlock (&mds->priv->summary_lock);
 
 	return 0;
 }
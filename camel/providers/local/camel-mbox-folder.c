@@ -228,6 +228,8 @@ mbox_folder_append_message_sync (CamelFolder *folder,
 			camel_folder_summary_add_preview (folder->summary, mi);
 	}
 
+	camel_mbox_summary_offsets_append (mbs, ((CamelMboxMessageInfo *) mi)->frompos);
+
 	/* now we 'fudge' the summary  to tell it its uptodate, because its idea of uptodate has just changed */
 	/* the stat really shouldn't fail, we just wrote to it */
 	if (g_stat (lf->folder_path, &st) == 0) {
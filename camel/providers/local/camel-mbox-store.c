@@ -44,6 +44,7 @@ static const gchar *extensions[] = {
 	".msf",
 	".ev-summary",
 	".ev-summary-meta",
+	".ev-offsets",
 	".ibex.index",
 	".ibex.index.data",
 	".cmeta",
@@ -739,6 +740,21 @@ mbox_store_delete_folder_sync (CamelStore *store,
 
 	g_free (path);
 
+	path = camel_local_store_get_meta_path (
+		local_store, folder_name, ".ev-offsets");
+	if (g_unlink (path) == -1 && errno != ENOENT) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Could not delete folder summary file '%s': %s"),
+			path, g_strerror (errno));
+		g_free (path);
+		g_free (name);
+		return FALSE;
+	}
+
+	g_free (path);
+
 	path = camel_local_store_get_meta_path (
 		local_store, folder_name, ".ibex");
 	if (camel_text_index_remove (path) == -1 && errno != ENOENT) {
@@ -866,6 +882,11 @@ mbox_store_rename_folder_sync (CamelStore *store,
 		goto summary_failed;
 	}
 
+	if (xrename (store, old, new, ".ev-offsets", TRUE) == -1) {
+		errnosav = errno;
+		goto summary_failed;
+	}
+
 	if (xrename (store, old, new, ".cmeta", TRUE) == -1) {
 		errnosav = errno;
 		goto cmeta_failed;
@@ -896,6 +917,7 @@ subdir_failed:
 cmeta_failed:
 	xrename (store, new, old, ".ev-summary", TRUE);
 	xrename (store, new, old, ".ev-summary-meta", TRUE);
+	xrename (store, new, old, ".ev-offsets", TRUE);
 summary_failed:
 	if (folder) {
 		if (folder->index)
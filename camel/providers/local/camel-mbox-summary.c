@@ -35,12 +35,17 @@
 #include <glib/gi18n-lib.h>
 #include <glib/gstdio.h>
 
-#include "camel-mbox-summary.h"
 #include "camel-local-private.h"
+#include "camel-local-store.h"
+#include "camel-mbox-summary.h"
 
 #define io(x)
 #define d(x) /*(printf("%s(%d): ", __FILE__, __LINE__),(x))*/
 
+#define CAMEL_MBOX_SUMMARY_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), CAMEL_TYPE_MBOX_SUMMARY, CamelMboxSummaryPrivate))
+
 #define CAMEL_MBOX_SUMMARY_VERSION (1)
 
 static CamelFIRecord *
@@ -104,6 +109,36 @@ static void encode_status (guint32 flags, gchar status[8]);
 static guint32 decode_status (const gchar *status);
 #endif
 
+/* The offset index is a sidecar file next to the summary, holding the
+ * position and length of every message in the mbox.  It is only trusted
+ * while the mbox size and mtime match, and the checksum over the last
+ * MBOX_OFFSETS_TAIL bytes tells an append apart from a rewrite. */
+
+#define MBOX_OFFSETS_MAGIC (0x494f4d43)	/* "CMOI" */
+#define MBOX_OFFSETS_VERSION (1)
+#define MBOX_OFFSETS_TAIL (4096)
+
+typedef struct _MboxOffsetsHeader {
+	guint32 magic;
+	guint32 version;
+	guint64 mbox_size;
+	gint64 mbox_mtime;
+	guint32 tail_sum;
+	guint32 count;
+} MboxOffsetsHeader;
+
+typedef struct _MboxOffset {
+	guint64 frompos;
+	guint64 length;
+} MboxOffset;
+
+struct _CamelMboxSummaryPrivate {
+	gchar *offsets_path;
+	GArray *offsets;	/* MboxOffset, sorted by frompos */
+	MboxOffsetsHeader offsets_header;
+	gboolean offsets_loaded;
+};
+
 G_DEFINE_TYPE (CamelMboxSummary, camel_mbox_summary, CAMEL_TYPE_LOCAL_SUMMARY)
 
 static gboolean
@@ -152,12 +187,32 @@ mbox_info_set_flags (CamelMessageInfo *mi,
 }
 #endif
 
+static void
+mbox_summary_finalize (GObject *object)
+{
+	CamelMboxSummaryPrivate *priv;
+
+	priv = CAMEL_MBOX_SUMMARY_GET_PRIVATE (object);
+
+	g_free (priv->offsets_path);
+	g_array_free (priv->offsets, TRUE);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (camel_mbox_summary_parent_class)->finalize (object);
+}
+
 static void
 camel_mbox_summary_class_init (CamelMboxSummaryClass *class)
 {
+	GObjectClass *object_class;
 	CamelFolderSummaryClass *folder_summary_class;
 	CamelLocalSummaryClass *local_summary_class;
 
+	g_type_class_add_private (class, sizeof (CamelMboxSummaryPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = mbox_summary_finalize;
+
 	folder_summary_class = CAMEL_FOLDER_SUMMARY_CLASS (class);
 	folder_summary_class->message_info_size = sizeof (CamelMboxMessageInfo);
 	folder_summary_class->content_info_size = sizeof (CamelMboxMessageContentInfo);
@@ -192,6 +247,9 @@ camel_mbox_summary_init (CamelMboxSummary *mbox_summary)
 
 	folder_summary = CAMEL_FOLDER_SUMMARY (mbox_summary);
 
+	mbox_summary->priv = CAMEL_MBOX_SUMMARY_GET_PRIVATE (mbox_summary);
+	mbox_summary->priv->offsets = g_array_new (FALSE, FALSE, sizeof (MboxOffset));
+
 	/* and a unique file version */
 	folder_summary->version += CAMEL_MBOX_SUMMARY_VERSION;
 }
@@ -222,6 +280,10 @@ camel_mbox_summary_new (CamelFolder *folder,
 		summary->sort_by = "bdata";
 		summary->collate = "mbox_frompos_sort";
 
+		if (CAMEL_IS_LOCAL_STORE (parent_store))
+			new->priv->offsets_path = camel_local_store_get_meta_path (
+				CAMEL_LOCAL_STORE (parent_store),
+				camel_folder_get_full_name (folder), ".ev-offsets");
 	}
 	camel_local_summary_construct ((CamelLocalSummary *) new, mbox_name, index);
 	return new;
@@ -232,6 +294,416 @@ void camel_mbox_summary_xstatus (CamelMboxSummary *mbs, gint state)
 	mbs->xstatus = state;
 }
 
+static gssize
+mbox_read_at (gint fd,
+              gpointer buf,
+              gsize len,
+              goffset offset)
+{
+	gssize n;
+
+#ifndef G_OS_WIN32
+	do {
+		n = pread (fd, buf, len, offset);
+	} while (n == -1 && errno == EINTR);
+#else
+	if (lseek (fd, offset, SEEK_SET) == -1)
+		return -1;
+	do {
+		n = read (fd, buf, len);
+	} while (n == -1 && errno == EINTR);
+#endif
+
+	return n;
+}
+
+static gboolean
+mbox_write_at (gint fd,
+               gconstpointer buf,
+               gsize len,
+               goffset offset)
+{
+	const gchar *p = buf;
+
+#ifdef G_OS_WIN32
+	if (lseek (fd, offset, SEEK_SET) == -1)
+		return FALSE;
+#endif
+
+	while (len > 0) {
+		gssize n;
+
+#ifndef G_OS_WIN32
+		n = pwrite (fd, p, len, offset);
+#else
+		n = write (fd, p, len);
+#endif
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return FALSE;
+
+		p += n;
+		len -= n;
+		offset += n;
+	}
+
+	return TRUE;
+}
+
+static gint
+mbox_offset_cmp (gconstpointer a,
+                 gconstpointer b)
+{
+	const MboxOffset *oa = a, *ob = b;
+
+	return oa->frompos < ob->frompos ? -1 : oa->frompos > ob->frompos ? 1 : 0;
+}
+
+static guint32
+mbox_offsets_tail_sum (gint fd,
+                       goffset size,
+                       gboolean *ok)
+{
+	guchar buf[MBOX_OFFSETS_TAIL];
+	goffset start = MAX (0, size - MBOX_OFFSETS_TAIL);
+	guint32 sum = 2166136261u;
+	gssize len, i;
+
+	len = mbox_read_at (fd, buf, size - start, start);
+	*ok = len == size - start;
+
+	/* FNV-1a */
+	for (i = 0; *ok && i < len; i++) {
+		sum ^= buf[i];
+		sum *= 16777619u;
+	}
+
+	return sum;
+}
+
+static void
+mbox_offsets_invalidate (CamelMboxSummary *mbs)
+{
+	g_array_set_size (mbs->priv->offsets, 0);
+	memset (&mbs->priv->offsets_header, 0, sizeof (MboxOffsetsHeader));
+
+	if (mbs->priv->offsets_path != NULL)
+		g_unlink (mbs->priv->offsets_path);
+}
+
+static void
+mbox_offsets_load (CamelMboxSummary *mbs)
+{
+	MboxOffsetsHeader *header;
+	gchar *contents = NULL;
+	gsize length = 0;
+
+	if (mbs->priv->offsets_loaded || mbs->priv->offsets_path == NULL)
+		return;
+
+	mbs->priv->offsets_loaded = TRUE;
+	mbs->priv->offsets_header.magic = 0;
+
+	if (!g_file_get_contents (mbs->priv->offsets_path, &contents, &length, NULL))
+		return;
+
+	header = (MboxOffsetsHeader *) contents;
+	if (length >= sizeof (MboxOffsetsHeader)
+	    && header->magic == MBOX_OFFSETS_MAGIC
+	    && header->version == MBOX_OFFSETS_VERSION
+	    && length == sizeof (MboxOffsetsHeader) + header->count * sizeof (MboxOffset)) {
+		mbs->priv->offsets_header = *header;
+		g_array_set_size (mbs->priv->offsets, 0);
+		g_array_append_vals (
+			mbs->priv->offsets,
+			contents + sizeof (MboxOffsetsHeader), header->count);
+	} else {
+		d (printf ("ignoring invalid offset index %s\n", mbs->priv->offsets_path));
+	}
+
+	g_free (contents);
+}
+
+/* Fixes up the lengths from the positions and writes the index out,
+ * stamped with the current size and mtime of the mbox. */
+static void
+mbox_offsets_save (CamelMboxSummary *mbs)
+{
+	CamelLocalSummary *cls = (CamelLocalSummary *) mbs;
+	MboxOffsetsHeader *header = &mbs->priv->offsets_header;
+	GArray *offsets = mbs->priv->offsets;
+	GString *contents;
+	struct stat st;
+	gboolean ok;
+	gint fd, i;
+
+	if (mbs->priv->offsets_path == NULL)
+		return;
+
+	fd = g_open (cls->folder_path, O_LARGEFILE | O_RDONLY | O_BINARY, 0);
+	if (fd == -1)
+		goto fail;
+
+	if (fstat (fd, &st) == -1)
+		goto fail;
+
+	for (i = 0; i < offsets->len; i++) {
+		MboxOffset *offset = &g_array_index (offsets, MboxOffset, i);
+		guint64 end = i + 1 < offsets->len ?
+			g_array_index (offsets, MboxOffset, i + 1).frompos : (guint64) st.st_size;
+
+		if (end < offset->frompos)
+			goto fail;
+		offset->length = end - offset->frompos;
+	}
+
+	header->magic = MBOX_OFFSETS_MAGIC;
+	header->version = MBOX_OFFSETS_VERSION;
+	header->mbox_size = st.st_size;
+	header->mbox_mtime = st.st_mtime;
+	header->count = offsets->len;
+	header->tail_sum = mbox_offsets_tail_sum (fd, st.st_size, &ok);
+	if (!ok)
+		goto fail;
+
+	close (fd);
+	fd = -1;
+
+	contents = g_string_sized_new (sizeof (MboxOffsetsHeader) + offsets->len * sizeof (MboxOffset));
+	g_string_append_len (contents, (const gchar *) header, sizeof (MboxOffsetsHeader));
+	g_string_append_len (contents, offsets->data, offsets->len * sizeof (MboxOffset));
+	ok = g_file_set_contents (mbs->priv->offsets_path, contents->str, contents->len, NULL);
+	g_string_free (contents, TRUE);
+
+	if (ok)
+		return;
+
+ fail:
+	if (fd != -1)
+		close (fd);
+
+	mbox_offsets_invalidate (mbs);
+}
+
+/* Is the index a description of the mbox as described by @st? */
+static gboolean
+mbox_offsets_match (CamelMboxSummary *mbs,
+                    const struct stat *st)
+{
+	mbox_offsets_load (mbs);
+
+	return mbs->priv->offsets_header.magic == MBOX_OFFSETS_MAGIC
+		&& mbs->priv->offsets_header.mbox_size == (guint64) st->st_size
+		&& mbs->priv->offsets_header.mbox_mtime == (gint64) st->st_mtime;
+}
+
+/* Did the mbox only grow since the summary was last updated?  Without
+ * an index for that state, leave it to summary_update() to look for a
+ * From line at the old end; with one, the bytes the mbox ended with must
+ * also be unchanged, which catches rewrites that happen to grow it. */
+static gboolean
+mbox_offsets_is_append (CamelMboxSummary *mbs)
+{
+	CamelLocalSummary *cls = (CamelLocalSummary *) mbs;
+	MboxOffsetsHeader *header = &mbs->priv->offsets_header;
+	guint32 sum;
+	gboolean ok;
+	gint fd;
+
+	mbox_offsets_load (mbs);
+
+	if (header->magic != MBOX_OFFSETS_MAGIC
+	    || header->mbox_size != (guint64) mbs->folder_size)
+		return TRUE;
+
+	fd = g_open (cls->folder_path, O_LARGEFILE | O_RDONLY | O_BINARY, 0);
+	if (fd == -1)
+		return TRUE;
+
+	sum = mbox_offsets_tail_sum (fd, header->mbox_size, &ok);
+	close (fd);
+
+	return !ok || sum == header->tail_sum;
+}
+
+/* Rebuilds the index from the positions stored in the summary. */
+static void
+mbox_offsets_rebuild (CamelMboxSummary *mbs)
+{
+	CamelFolderSummary *s = (CamelFolderSummary *) mbs;
+	GPtrArray *known_uids;
+	gint i;
+
+	g_array_set_size (mbs->priv->offsets, 0);
+
+	camel_folder_summary_prepare_fetch_all (s, NULL);
+	known_uids = camel_folder_summary_get_array (s);
+	for (i = 0; known_uids && i < known_uids->len; i++) {
+		CamelMboxMessageInfo *info;
+		MboxOffset offset = { 0, 0 };
+
+		info = (CamelMboxMessageInfo *) camel_folder_summary_get (s, g_ptr_array_index (known_uids, i));
+		if (info == NULL)
+			continue;
+
+		if (info->frompos >= 0) {
+			offset.frompos = info->frompos;
+			g_array_append_val (mbs->priv->offsets, offset);
+		}
+
+		camel_message_info_free (info);
+	}
+	camel_folder_summary_free_array (known_uids);
+
+	g_array_sort (mbs->priv->offsets, mbox_offset_cmp);
+}
+
+static const MboxOffset *
+mbox_offsets_lookup (CamelMboxSummary *mbs,
+                     goffset frompos)
+{
+	GArray *offsets = mbs->priv->offsets;
+	guint lo = 0, hi = offsets->len;
+
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+		const MboxOffset *offset = &g_array_index (offsets, MboxOffset, mid);
+
+		if (offset->frompos == (guint64) frompos)
+			return offset;
+		else if (offset->frompos < (guint64) frompos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+/**
+ * camel_mbox_summary_offsets_append:
+ * @mbs: a #CamelMboxSummary
+ * @frompos: position of the From line of the appended message
+ *
+ * Records a message which was just appended to the end of the mbox in
+ * the offset index, so that the index stays valid without a rescan.
+ *
+ * Only the new record and the header are written, the index file is
+ * rewritten as a whole when the mbox is synced.
+ **/
+void
+camel_mbox_summary_offsets_append (CamelMboxSummary *mbs,
+                                   goffset frompos)
+{
+	CamelLocalSummary *cls = (CamelLocalSummary *) mbs;
+	MboxOffsetsHeader header;
+	MboxOffset offset = { frompos, 0 };
+	struct stat st;
+	gboolean ok;
+	gint fd, fdout = -1;
+
+	g_return_if_fail (CAMEL_IS_MBOX_SUMMARY (mbs));
+
+	mbox_offsets_load (mbs);
+	header = mbs->priv->offsets_header;
+
+	/* only extend an index which described the mbox up to here; the
+	 * length of its last record then already ends at @frompos */
+	if (header.magic != MBOX_OFFSETS_MAGIC
+	    || header.mbox_size != (guint64) frompos)
+		goto fail;
+
+	fd = g_open (cls->folder_path, O_LARGEFILE | O_RDONLY | O_BINARY, 0);
+	if (fd == -1)
+		goto fail;
+
+	ok = fstat (fd, &st) == 0 && st.st_size >= frompos;
+	if (ok) {
+		offset.length = st.st_size - frompos;
+		header.mbox_size = st.st_size;
+		header.mbox_mtime = st.st_mtime;
+		header.tail_sum = mbox_offsets_tail_sum (fd, st.st_size, &ok);
+		header.count++;
+	}
+	close (fd);
+
+	if (!ok)
+		goto fail;
+
+	fdout = g_open (mbs->priv->offsets_path, O_LARGEFILE | O_WRONLY | O_BINARY, 0);
+	if (fdout == -1)
+		goto fail;
+
+	/* The record goes first: should the header not follow, the count
+	 * no longer matches the file length and the index is dropped on
+	 * the next load. */
+	if (!mbox_write_at (
+		fdout, &offset, sizeof (MboxOffset),
+		sizeof (MboxOffsetsHeader) + (goffset) mbs->priv->offsets->len * sizeof (MboxOffset)) ||
+	    !mbox_write_at (fdout, &header, sizeof (MboxOffsetsHeader), 0))
+		goto fail;
+
+	close (fdout);
+
+	g_array_append_val (mbs->priv->offsets, offset);
+	mbs->priv->offsets_header = header;
+
+	return;
+
+ fail:
+	if (fdout != -1)
+		close (fdout);
+
+	mbox_offsets_invalidate (mbs);
+}
+
+/* Copies @length bytes at @offset in @fd to the current position of @fdout. */
+static gboolean
+mbox_copy_block (gint fd,
+                 goffset offset,
+                 goffset length,
+                 gint fdout)
+{
+	gchar buf[65536];
+
+	while (length > 0) {
+		gssize n, w;
+
+		n = mbox_read_at (fd, buf, MIN (length, (goffset) sizeof (buf)), offset);
+		if (n <= 0)
+			return FALSE;
+
+		for (w = 0; w < n;) {
+			gssize r = write (fdout, buf + w, n - w);
+
+			if (r == -1 && errno == EINTR)
+				continue;
+			if (r <= 0)
+				return FALSE;
+			w += r;
+		}
+
+		offset += n;
+		length -= n;
+	}
+
+	return TRUE;
+}
+
+/* Is there a From line at @frompos in @fd? */
+static gboolean
+mbox_has_from_at (gint fd,
+                  goffset frompos)
+{
+	gchar buf[5];
+	gssize n;
+
+	n = mbox_read_at (fd, buf, sizeof (buf), frompos);
+
+	return n == (gssize) sizeof (buf) && strncmp (buf, "From ", 5) == 0;
+}
+
 static gchar *
 mbox_summary_encode_x_evolution (CamelLocalSummary *cls,
                                  const CamelLocalMessageInfo *mi)
@@ -442,6 +914,7 @@ summary_update (CamelLocalSummary *cls,
 	goffset size = 0;
 	GList *del = NULL;
 	GPtrArray *known_uids;
+	gboolean offsets_complete;
 
 	d (printf ("Calling summary update, from pos %d\n", (gint) offset));
 
@@ -483,6 +956,12 @@ summary_update (CamelLocalSummary *cls,
 		}
 	}
 
+	/* an append extends the offset index, anything else rebuilds it */
+	mbox_offsets_load (mbs);
+	offsets_complete = offset == 0 || mbs->priv->offsets_header.mbox_size == (guint64) offset;
+	if (offset == 0)
+		g_array_set_size (mbs->priv->offsets, 0);
+
 	/* we mark messages as to whether we've seen them or not.
 	 * If we're not starting from the start, we must be starting
 	 * from the old end, so everything must be treated as new */
@@ -501,11 +980,14 @@ summary_update (CamelLocalSummary *cls,
 
 	while (camel_mime_parser_step (mp, NULL, NULL) == CAMEL_MIME_PARSER_STATE_FROM) {
 		CamelMessageInfo *info;
+		MboxOffset found = { camel_mime_parser_tell_start_from (mp), 0 };
 		goffset pc = camel_mime_parser_tell_start_from (mp) + 1;
 
 		camel_operation_progress (
 			cancellable, (gint) (((gfloat) pc / size) * 100));
 
+		g_array_append_val (mbs->priv->offsets, found);
+
 		info = camel_folder_summary_add_from_parser (s, mp);
 		if (info == NULL) {
 			gchar *pos_str;
@@ -575,6 +1057,11 @@ summary_update (CamelLocalSummary *cls,
 		}
 	}
 
+	if (ok != -1 && offsets_complete)
+		mbox_offsets_save (mbs);
+	else
+		mbox_offsets_invalidate (mbs);
+
 	camel_operation_pop_message (cancellable);
 	camel_folder_summary_unlock (s, CAMEL_FOLDER_SUMMARY_SUMMARY_LOCK);
 
@@ -630,16 +1117,17 @@ mbox_summary_check (CamelLocalSummary *cls,
 		}
 		camel_folder_summary_free_array (known_uids);
 		camel_folder_summary_clear (s, NULL);
+		mbox_offsets_invalidate (mbs);
 		ret = 0;
 	} else {
 		/* is the summary uptodate? */
 		if (st.st_size != mbs->folder_size || st.st_mtime != s->time) {
-			if (mbs->folder_size < st.st_size) {
+			if (mbs->folder_size < st.st_size && mbox_offsets_is_append (mbs)) {
 				/* this will automatically rescan from 0 if there is a problem */
 				d (printf ("folder grew, attempting to rebuild from %d\n", mbs->folder_size));
 				ret = summary_update (cls, mbs->folder_size, changes, cancellable, error);
 			} else {
-				d (printf ("folder shrank!  rebuilding from start\n"));
+				d (printf ("folder shrank or was rewritten!  rebuilding from start\n"));
 				 ret = summary_update (cls, 0, changes, cancellable, error);
 			}
 		} else {
@@ -1075,6 +1563,10 @@ mbox_summary_sync (CamelLocalSummary *cls,
 		s->time = st.st_mtime;
 		mbs->folder_size = st.st_size;
 		camel_folder_summary_touch (s);
+
+		/* messages moved, or at least the mtime changed */
+		mbox_offsets_rebuild (mbs);
+		mbox_offsets_save (mbs);
 	}
 
 	ret = CAMEL_LOCAL_SUMMARY_CLASS (camel_mbox_summary_parent_class)->sync (cls, expunge, changeinfo, cancellable, error);
@@ -1083,6 +1575,27 @@ mbox_summary_sync (CamelLocalSummary *cls,
 	return ret;
 }
 
+/* Removes an expunged message from the summary and the index; frees @info. */
+static void
+mbox_summary_sync_drop (CamelMboxSummary *cls,
+                        CamelMboxMessageInfo *info,
+                        CamelFolderChangeInfo *changeinfo,
+                        GList **del)
+{
+	const gchar *uid = camel_message_info_uid (info);
+
+	d (printf ("Deleting %s\n", uid));
+
+	if (((CamelLocalSummary *) cls)->index)
+		camel_index_delete_name (((CamelLocalSummary *) cls)->index, uid);
+
+	/* remove it from the change list */
+	camel_folder_change_info_remove_uid (changeinfo, uid);
+	camel_folder_summary_remove ((CamelFolderSummary *) cls, (CamelMessageInfo *) info);
+	*del = g_list_prepend (*del, (gpointer) camel_pstring_strdup (uid));
+	camel_message_info_free ((CamelMessageInfo *) info);
+}
+
 gint
 camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
                               guint32 flags,
@@ -1106,6 +1619,8 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 	gboolean touched = FALSE;
 	GList *del = NULL;
 	GPtrArray *known_uids = NULL;
+	struct stat st;
+	gboolean use_offsets;
 #ifdef STATUS_PINE
 	gchar statnew[8], xstatnew[8];
 #endif
@@ -1126,6 +1641,10 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 		return -1;
 	}
 
+	/* with a valid offset index, messages which are dropped or kept
+	 * unchanged are moved as raw blocks, without running the parser */
+	use_offsets = fstat (fd, &st) == 0 && mbox_offsets_match (mbs, &st);
+
 	mp = camel_mime_parser_new ();
 	camel_mime_parser_scan_from (mp, TRUE);
 	camel_mime_parser_scan_pre_from (mp, TRUE);
@@ -1155,6 +1674,41 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 			((CamelMessageInfo *) info)->uid,
 			(gint) info->frompos));
 
+		if (use_offsets && !(info->info.info.flags & (CAMEL_MESSAGE_FOLDER_NOXEV | CAMEL_MESSAGE_FOLDER_FLAGGED))) {
+			const MboxOffset *block = mbox_offsets_lookup (mbs, info->frompos);
+			gboolean drop = (flags & 1) && (info->info.info.flags & CAMEL_MESSAGE_DELETED);
+
+			/* the last message goes through the parser, which
+			 * takes care of the missing trailing newline */
+			if (block != NULL && (drop || block->frompos + block->length < (guint64) st.st_size)
+			    && mbox_has_from_at (fd, info->frompos)) {
+				if (drop) {
+					mbox_summary_sync_drop (cls, info, changeinfo, &del);
+					touched = TRUE;
+				} else {
+					goffset frompos = lseek (fdout, 0, SEEK_CUR);
+
+					if (!mbox_copy_block (fd, block->frompos, block->length, fdout)) {
+						g_set_error (
+							error, G_IO_ERROR,
+							g_io_error_from_errno (errno),
+							_("Writing to temporary mailbox failed: %s"),
+							g_strerror (errno));
+						goto error;
+					}
+
+					info->frompos = frompos;
+					((CamelMessageInfo *) info)->dirty = TRUE;
+					camel_message_info_free ((CamelMessageInfo *) info);
+				}
+
+				info = NULL;
+				/* the parser has to seek to the next message it handles */
+				lastdel = TRUE;
+				continue;
+			}
+		}
+
 		if (lastdel)
 			camel_mime_parser_seek (mp, info->frompos, SEEK_SET);
 
@@ -1179,17 +1733,7 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 
 		lastdel = FALSE;
 		if ((flags&1) && info->info.info.flags & CAMEL_MESSAGE_DELETED) {
-			const gchar *uid = camel_message_info_uid (info);
-			d (printf ("Deleting %s\n", uid));
-
-			if (((CamelLocalSummary *) cls)->index)
-				camel_index_delete_name (((CamelLocalSummary *) cls)->index, uid);
-
-			/* remove it from the change list */
-			camel_folder_change_info_remove_uid (changeinfo, uid);
-			camel_folder_summary_remove (s, (CamelMessageInfo *) info);
-			del = g_list_prepend (del, (gpointer) camel_pstring_strdup (uid));
-			camel_message_info_free ((CamelMessageInfo *) info);
+			mbox_summary_sync_drop (cls, info, changeinfo, &del);
 			info = NULL;
 			lastdel = TRUE;
 			touched = TRUE;
@@ -49,6 +49,7 @@ G_BEGIN_DECLS
 
 typedef struct _CamelMboxSummary CamelMboxSummary;
 typedef struct _CamelMboxSummaryClass CamelMboxSummaryClass;
+typedef struct _CamelMboxSummaryPrivate CamelMboxSummaryPrivate;
 
 typedef struct _CamelMboxMessageContentInfo {
 	CamelMessageContentInfo info;
@@ -62,6 +63,7 @@ typedef struct _CamelMboxMessageInfo {
 
 struct _CamelMboxSummary {
 	CamelLocalSummary parent;
+	CamelMboxSummaryPrivate *priv;
 
 	CamelFolderChangeInfo *changes;	/* used to build change sets */
 
@@ -99,6 +101,11 @@ CamelMboxSummary *
 void		camel_mbox_summary_xstatus	(CamelMboxSummary *mbs,
 						 gint state);
 
+/* record a message appended to the end of the mbox in the offset index */
+void		camel_mbox_summary_offsets_append
+						(CamelMboxSummary *mbs,
+						 goffset frompos);
+
 /* build a new mbox from an existing mbox storing summary information */
 gint		camel_mbox_summary_sync_mbox	(CamelMboxSummary *cls,
 						 guint32 flags,
@@ -150,9 +150,11 @@ mh_summary_next_uid_string (CamelFolderSummary *s)
 	return uidstr;
 }
 
+/* @content, if not %NULL, is the already read file; it is consumed */
 static gint
 camel_mh_summary_add (CamelLocalSummary *cls,
                       const gchar *name,
+                      GByteArray *content,
                       gint forceindex,
                       GCancellable *cancellable)
 {
@@ -163,15 +165,25 @@ camel_mh_summary_add (CamelLocalSummary *cls,
 
 	d (printf ("summarising: %s\n", name));
 
-	fd = open (filename, O_RDONLY | O_LARGEFILE);
-	if (fd == -1) {
-		g_warning ("Cannot summarise/index: %s: %s", filename, g_strerror (errno));
-		g_free (filename);
-		return -1;
-	}
 	mp = camel_mime_parser_new ();
 	camel_mime_parser_scan_from (mp, FALSE);
-	camel_mime_parser_init_with_fd (mp, fd);
+
+	if (content != NULL) {
+		CamelStream *stream;
+
+		stream = camel_stream_mem_new_with_byte_array (content);
+		camel_mime_parser_init_with_stream (mp, stream, NULL);
+		g_object_unref (stream);
+	} else {
+		fd = open (filename, O_RDONLY | O_LARGEFILE);
+		if (fd == -1) {
+			g_warning ("Cannot summarise/index: %s: %s", filename, g_strerror (errno));
+			g_object_unref (mp);
+			g_free (filename);
+			return -1;
+		}
+		camel_mime_parser_init_with_fd (mp, fd);
+	}
 	if (cls->index && (forceindex || !camel_index_has_name (cls->index, name))) {
 		d (printf ("forcing indexing of message content\n"));
 		camel_folder_summary_set_index ((CamelFolderSummary *) mhs, cls->index);
@@ -190,6 +202,17 @@ camel_mh_summary_add (CamelLocalSummary *cls,
 	return 0;
 }
 
+static gint
+mh_summary_name_cmp (gconstpointer a,
+                     gconstpointer b)
+{
+	/* MH names are message numbers */
+	gulong na = strtoul (*(const gchar **) a, NULL, 10);
+	gulong nb = strtoul (*(const gchar **) b, NULL, 10);
+
+	return na < nb ? -1 : na > nb ? 1 : 0;
+}
+
 static void
 remove_summary (gchar *key,
                 CamelMessageInfo *info,
@@ -217,6 +240,10 @@ mh_summary_check (CamelLocalSummary *cls,
 	gint i;
 	gboolean forceindex;
 	GPtrArray *known_uids;
+	GPtrArray *pending;
+	CamelLocalPrefetch *prefetch;
+	GByteArray *content;
+	const gchar *name;
 
 	/* FIXME: Handle changeinfo */
 
@@ -247,6 +274,9 @@ mh_summary_check (CamelLocalSummary *cls,
 	}
 	camel_folder_summary_free_array (known_uids);
 
+	/* files to (re)summarise */
+	pending = g_ptr_array_new_with_free_func (g_free);
+
 	while ((d = readdir (dir))) {
 		/* FIXME: also run stat to check for regular file */
 		p = d->d_name;
@@ -269,7 +299,7 @@ mh_summary_check (CamelLocalSummary *cls,
 					camel_folder_summary_remove ((CamelFolderSummary *) cls, info);
 					camel_message_info_free (info);
 				}
-				camel_mh_summary_add (cls, d->d_name, forceindex, cancellable);
+				g_ptr_array_add (pending, g_strdup (d->d_name));
 			} else {
 				const gchar *uid = camel_message_info_uid (info);
 				CamelMessageInfo *old = g_hash_table_lookup (left, uid);
@@ -286,6 +316,14 @@ mh_summary_check (CamelLocalSummary *cls,
 	g_hash_table_foreach (left, (GHFunc) remove_summary, cls);
 	g_hash_table_destroy (left);
 
+	/* read the files on a worker pool, summarise them in uid order here */
+	g_ptr_array_sort (pending, mh_summary_name_cmp);
+
+	prefetch = camel_local_prefetch_new (cls->folder_path, pending);
+	while (camel_local_prefetch_next (prefetch, &name, &content))
+		camel_mh_summary_add (cls, name, content, forceindex, cancellable);
+	camel_local_prefetch_free (prefetch);
+
 	/* sort the summary based on message number (uid), since the directory order is not useful */
 	camel_folder_summary_lock (s, CAMEL_FOLDER_SUMMARY_SUMMARY_LOCK);
 	camel_folder_summary_unlock (s, CAMEL_FOLDER_SUMMARY_SUMMARY_LOCK);
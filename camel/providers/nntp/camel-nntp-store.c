@@ -244,6 +244,10 @@ check_capabilities (CamelNNTPStore *nntp_store,
 			camel_nntp_store_add_capabilities (
 				nntp_store, CAMEL_NNTP_CAPABILITY_OVER);
 
+		if (len == 5 && g_ascii_strncasecmp (line, "XZVER", len) == 0)
+			camel_nntp_store_add_capabilities (
+				nntp_store, CAMEL_NNTP_CAPABILITY_XZVER);
+
 		if (len == 1 && g_ascii_strncasecmp (line, ".", len) == 0) {
 			ret = 0;
 			break;
@@ -71,7 +71,8 @@ struct _xover_header {
 
 /* names of supported capabilities on the server */
 typedef enum {
-	CAMEL_NNTP_CAPABILITY_OVER = 1 << 0  /* supports OVER command */
+	CAMEL_NNTP_CAPABILITY_OVER = 1 << 0,  /* supports OVER command */
+	CAMEL_NNTP_CAPABILITY_XZVER = 1 << 1  /* supports compressed XZVER */
 } CamelNNTPCapabilities;
 
 struct _CamelNNTPStore {
@@ -30,9 +30,12 @@
 #include <unistd.h>
 #include <sys/stat.h>
 
+#include <zlib.h>
+
 #include <glib/gi18n-lib.h>
 
 #include "camel-nntp-folder.h"
+#include "camel-nntp-resp-codes.h"
 #include "camel-nntp-store.h"
 #include "camel-nntp-stream.h"
 #include "camel-nntp-summary.h"
@@ -157,6 +160,558 @@ summary_header_to_db (CamelFolderSummary *s,
 
 /* ********************************************************************** */
 
+/* Ranges at least this many articles long are worth opening extra
+ * connections for; each extra connection fetches its own slice of the
+ * overview while the store's connection fetches the first one. */
+#define NNTP_OVER_WORKERS (3)
+#define NNTP_OVER_WORKER_MIN_RANGE (5000)
+
+typedef struct _NNTPOverEntry NNTPOverEntry;
+typedef struct _NNTPOverContext NNTPOverContext;
+typedef struct _NNTPOverWorker NNTPOverWorker;
+
+typedef void	(*NNTPOverFunc)			(gchar *line,
+						 gpointer user_data);
+
+struct _NNTPOverEntry {
+	guint n;
+	guint size;
+	gchar *uid;
+	struct _camel_header_raw *headers;
+};
+
+/* adding to the summary straight from the store's connection */
+struct _NNTPOverContext {
+	CamelNNTPSummary *cns;
+	struct _xover_header *xover;
+	CamelFolderChangeInfo *changes;
+	gboolean folder_filter_recent;
+	GCancellable *cancellable;
+	guint count, total;
+};
+
+/* fetching a slice of the range on a connection of its own */
+struct _NNTPOverWorker {
+	CamelNNTPStore *nntp_store;
+	struct _xover_header *xover;
+	gchar *group;
+	gchar *user;
+	gchar *password;
+	guint low, high;
+	gboolean compressed;
+	gboolean over;
+
+	GCancellable *cancellable;
+	GThread *thread;
+	GPtrArray *entries;
+	gboolean success;
+	GError *error;
+};
+
+/* Splits one overview line into headers following the server's
+ * overview.fmt.  Returns FALSE for a line we cannot use. */
+static gboolean
+nntp_over_parse_line (struct _xover_header *xover,
+                      gchar *line,
+                      guint *n,
+                      guint *size,
+                      gchar **uid,
+                      struct _camel_header_raw **headers)
+{
+	gchar *tab;
+
+	*size = 0;
+	*uid = NULL;
+	*headers = NULL;
+
+	*n = strtoul (line, &tab, 10);
+	if (*tab != '\t')
+		return FALSE;
+	tab++;
+
+	for (; tab[0] && xover; xover = xover->next) {
+		line = tab;
+		tab = strchr (line, '\t');
+		if (tab)
+			*tab++ = 0;
+		else
+			tab = line + strlen (line);
+
+		/* do we care about this column? */
+		if (xover->name) {
+			line += xover->skip;
+			if (line < tab) {
+				camel_header_raw_append (headers, xover->name, line, -1);
+				switch (xover->type) {
+				case XOVER_STRING:
+					break;
+				case XOVER_MSGID:
+					g_free (*uid);
+					*uid = g_strdup_printf ("%u,%s", *n, line);
+					break;
+				case XOVER_SIZE:
+					*size = strtoul (line, NULL, 10);
+					break;
+				}
+			}
+		}
+	}
+
+	/* skip headers we don't care about, incase the server doesn't actually send some it said it would. */
+	while (xover && xover->name == NULL)
+		xover = xover->next;
+
+	/* truncated line? ignore? */
+	if (xover != NULL) {
+		camel_header_raw_clear (headers);
+		g_free (*uid);
+		*uid = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Takes ownership of @uid. */
+static void
+nntp_over_summary_add (CamelNNTPSummary *cns,
+                       guint n,
+                       gchar *uid,
+                       guint size,
+                       struct _camel_header_raw *headers,
+                       CamelFolderChangeInfo *changes,
+                       gboolean folder_filter_recent)
+{
+	CamelFolderSummary *s = (CamelFolderSummary *) cns;
+	CamelMessageInfoBase *mi;
+
+	if (uid != NULL && !camel_folder_summary_check_uid (s, uid)) {
+		/* message_info_new_from_header() picks it up from here */
+		cns->priv->uid = uid;
+		uid = NULL;
+
+		mi = (CamelMessageInfoBase *)
+			camel_folder_summary_add_from_header (s, headers);
+		if (mi) {
+			mi->size = size;
+			cns->high = n;
+			camel_folder_change_info_add_uid (changes, camel_message_info_uid (mi));
+			if (folder_filter_recent)
+				camel_folder_change_info_recent_uid (changes, camel_message_info_uid (mi));
+		}
+	}
+
+	if (cns->priv->uid) {
+		g_free (cns->priv->uid);
+		cns->priv->uid = NULL;
+	}
+
+	g_free (uid);
+}
+
+static void
+nntp_over_context_add (gchar *line,
+                       gpointer user_data)
+{
+	NNTPOverContext *context = user_data;
+	struct _camel_header_raw *headers;
+	guint n, size;
+	gchar *uid;
+
+	camel_operation_progress (
+		context->cancellable,
+		(context->count * 100) / context->total);
+	context->count++;
+
+	if (!nntp_over_parse_line (context->xover, line, &n, &size, &uid, &headers))
+		return;
+
+	nntp_over_summary_add (
+		context->cns, n, uid, size, headers,
+		context->changes, context->folder_filter_recent);
+
+	camel_header_raw_clear (&headers);
+}
+
+static void
+nntp_over_worker_add (gchar *line,
+                      gpointer user_data)
+{
+	NNTPOverWorker *worker = user_data;
+	NNTPOverEntry *entry;
+
+	entry = g_slice_new0 (NNTPOverEntry);
+
+	if (nntp_over_parse_line (
+		worker->xover, line, &entry->n, &entry->size,
+		&entry->uid, &entry->headers))
+		g_ptr_array_add (worker->entries, entry);
+	else
+		g_slice_free (NNTPOverEntry, entry);
+}
+
+static void
+nntp_over_entry_free (NNTPOverEntry *entry)
+{
+	g_free (entry->uid);
+	camel_header_raw_clear (&entry->headers);
+	g_slice_free (NNTPOverEntry, entry);
+}
+
+/* Hands each complete line of inflated overview data to @func,
+ * keeping a partial last line in @pending for the next call. */
+static void
+nntp_over_split_lines (GString *pending,
+                       const guchar *data,
+                       gsize len,
+                       NNTPOverFunc func,
+                       gpointer user_data)
+{
+	const guchar *inptr = data, *inend = data + len, *nl;
+
+	while (inptr < inend && (nl = memchr (inptr, '\n', inend - inptr)) != NULL) {
+		g_string_append_len (pending, (const gchar *) inptr, nl - inptr);
+		if (pending->len > 0 && pending->str[pending->len - 1] == '\r')
+			g_string_truncate (pending, pending->len - 1);
+
+		func (pending->str, user_data);
+
+		g_string_truncate (pending, 0);
+		inptr = nl + 1;
+	}
+
+	g_string_append_len (pending, (const gchar *) inptr, inend - inptr);
+}
+
+/* XZVER sends the usual overview lines deflated and yEnc encoded, so
+ * undo both a line at a time as the data arrives. */
+static gint
+nntp_over_read_compressed (CamelNNTPStream *nntp_stream,
+                           NNTPOverFunc func,
+                           gpointer user_data,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	z_stream zs;
+	GByteArray *decoded;
+	GString *pending;
+	guchar out[16384];
+	guint32 pcrc = CAMEL_MIME_YENCODE_CRC_INIT;
+	guint32 crc = CAMEL_MIME_YENCODE_CRC_INIT;
+	gint ystate = CAMEL_MIME_YDECODE_STATE_INIT;
+	gboolean started = FALSE, finished = FALSE;
+	GError *local_error = NULL;
+	guchar *line;
+	guint len;
+	gint ret;
+
+	memset (&zs, 0, sizeof (zs));
+	decoded = g_byte_array_new ();
+	pending = g_string_sized_new (1024);
+
+	while ((ret = camel_nntp_stream_line (nntp_stream, &line, &len, cancellable, error)) > 0) {
+		gsize dlen;
+		gint zret;
+
+		/* the =ybegin/=yend framing carries no data, and once
+		 * we are done or have failed just drain the response */
+		if (finished || (len >= 2 && line[0] == '=' && line[1] == 'y'))
+			continue;
+
+		g_byte_array_set_size (decoded, len);
+		dlen = camel_ydecode_step (line, len, decoded->data, &ystate, &pcrc, &crc);
+		if (dlen == 0)
+			continue;
+
+		if (!started) {
+			gint window_bits = -MAX_WBITS;
+
+			/* usually zlib wrapped, but take raw deflate too */
+			if (dlen >= 2 && (decoded->data[0] & 0x0f) == Z_DEFLATED &&
+			    ((decoded->data[0] << 8) | decoded->data[1]) % 31 == 0)
+				window_bits = MAX_WBITS;
+
+			if (inflateInit2 (&zs, window_bits) != Z_OK) {
+				g_set_error (
+					&local_error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
+					_("Cannot decompress overview data"));
+				finished = TRUE;
+				continue;
+			}
+
+			started = TRUE;
+		}
+
+		zs.next_in = decoded->data;
+		zs.avail_in = dlen;
+
+		do {
+			zs.next_out = out;
+			zs.avail_out = sizeof (out);
+
+			zret = inflate (&zs, Z_NO_FLUSH);
+			if (zret != Z_OK && zret != Z_STREAM_END && zret != Z_BUF_ERROR) {
+				g_set_error (
+					&local_error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
+					_("Cannot decompress overview data: %s"),
+					zs.msg ? zs.msg : _("Unknown error"));
+				finished = TRUE;
+				break;
+			}
+
+			nntp_over_split_lines (
+				pending, out, sizeof (out) - zs.avail_out,
+				func, user_data);
+		} while (zs.avail_out == 0 && zret != Z_STREAM_END);
+
+		if (zret == Z_STREAM_END)
+			finished = TRUE;
+	}
+
+	if (ret == 0 && local_error != NULL) {
+		g_propagate_error (error, local_error);
+		local_error = NULL;
+		ret = -1;
+	} else if (ret == 0 && pending->len > 0) {
+		func (pending->str, user_data);
+	}
+
+	g_clear_error (&local_error);
+
+	if (started)
+		inflateEnd (&zs);
+
+	g_string_free (pending, TRUE);
+	g_byte_array_free (decoded, TRUE);
+
+	return ret;
+}
+
+/* Reads the body of an OVER, XOVER or XZVER response. */
+static gint
+nntp_over_read (CamelNNTPStream *nntp_stream,
+                gboolean compressed,
+                NNTPOverFunc func,
+                gpointer user_data,
+                GCancellable *cancellable,
+                GError **error)
+{
+	gchar *line;
+	guint len;
+	gint ret;
+
+	if (compressed)
+		return nntp_over_read_compressed (
+			nntp_stream, func, user_data, cancellable, error);
+
+	while ((ret = camel_nntp_stream_line (nntp_stream, (guchar **) &line, &len, cancellable, error)) > 0)
+		func (line, user_data);
+
+	return ret;
+}
+
+static gint
+nntp_over_worker_command (CamelNNTPStream *nntp_stream,
+                          GCancellable *cancellable,
+                          GError **error,
+                          gchar **line,
+                          const gchar *fmt,
+                          ...)
+{
+	gchar *buffer;
+	va_list ap;
+	guint len;
+	gint ret;
+
+	va_start (ap, fmt);
+	buffer = g_strdup_vprintf (fmt, ap);
+	va_end (ap);
+
+	camel_nntp_stream_set_mode (nntp_stream, CAMEL_NNTP_STREAM_LINE);
+
+	ret = camel_stream_write_string (
+		CAMEL_STREAM (nntp_stream), buffer, cancellable, error);
+
+	g_free (buffer);
+
+	if (ret == -1 || camel_nntp_stream_line (nntp_stream, (guchar **) line, &len, cancellable, error) == -1)
+		return -1;
+
+	return strtoul (*line, NULL, 10);
+}
+
+static gpointer
+nntp_over_worker_thread (gpointer user_data)
+{
+	NNTPOverWorker *worker = user_data;
+	GCancellable *cancellable = worker->cancellable;
+	CamelNNTPStream *nntp_stream = NULL;
+	CamelStream *tcp_stream;
+	gchar *line = NULL;
+	guint len;
+	gint ret;
+
+	tcp_stream = camel_network_service_connect_sync (
+		CAMEL_NETWORK_SERVICE (worker->nntp_store),
+		cancellable, &worker->error);
+	if (tcp_stream == NULL)
+		goto exit;
+
+	nntp_stream = camel_nntp_stream_new (tcp_stream);
+	g_object_unref (tcp_stream);
+
+	/* greeting */
+	if (camel_nntp_stream_line (nntp_stream, (guchar **) &line, &len, cancellable, &worker->error) == -1)
+		goto exit;
+	ret = strtoul (line, NULL, 10);
+	if (ret != 200 && ret != 201)
+		goto refused;
+
+	if (worker->user != NULL && worker->password != NULL) {
+		ret = nntp_over_worker_command (
+			nntp_stream, cancellable, &worker->error,
+			&line, "authinfo user %s\r\n", worker->user);
+		if (ret == NNTP_AUTH_CONTINUE)
+			ret = nntp_over_worker_command (
+				nntp_stream, cancellable, &worker->error,
+				&line, "authinfo pass %s\r\n", worker->password);
+		if (ret != NNTP_AUTH_ACCEPTED)
+			goto refused;
+	}
+
+	if (nntp_over_worker_command (
+		nntp_stream, cancellable, &worker->error,
+		&line, "mode reader\r\n") == -1)
+		goto exit;
+
+	ret = nntp_over_worker_command (
+		nntp_stream, cancellable, &worker->error,
+		&line, "group %s\r\n", worker->group);
+	if (ret != 211)
+		goto refused;
+
+	ret = nntp_over_worker_command (
+		nntp_stream, cancellable, &worker->error,
+		&line, "%s %u-%u\r\n",
+		worker->compressed ? "xzver" : worker->over ? "over" : "xover",
+		worker->low, worker->high);
+	if (ret != 224)
+		goto refused;
+
+	camel_nntp_stream_set_mode (nntp_stream, CAMEL_NNTP_STREAM_DATA);
+
+	if (nntp_over_read (
+		nntp_stream, worker->compressed,
+		nntp_over_worker_add, worker,
+		cancellable, &worker->error) == -1)
+		goto exit;
+
+	worker->success = TRUE;
+
+	nntp_over_worker_command (
+		nntp_stream, cancellable, NULL, &line, "quit\r\n");
+
+	goto exit;
+
+refused:
+	if (ret != -1)
+		g_set_error (
+			&worker->error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
+			_("Unexpected server response: %s"), line);
+
+exit:
+	g_clear_object (&nntp_stream);
+
+	return NULL;
+}
+
+static void
+nntp_over_worker_free (NNTPOverWorker *worker)
+{
+	if (worker->thread != NULL)
+		g_thread_join (worker->thread);
+
+	g_object_unref (worker->nntp_store);
+	g_free (worker->group);
+	g_free (worker->user);
+	g_free (worker->password);
+	g_ptr_array_unref (worker->entries);
+	g_clear_error (&worker->error);
+
+	g_slice_free (NNTPOverWorker, worker);
+}
+
+static void
+nntp_over_cancel_workers (GCancellable *cancellable,
+                          GCancellable *workers_cancellable)
+{
+	g_cancellable_cancel (workers_cancellable);
+}
+
+/* Fetches the overview for low..high on the store's own connection
+ * and adds it to the summary as it arrives. */
+/* Note: This will be called from camel_nntp_command, so only use camel_nntp_raw_command */
+static gint
+nntp_over_fetch (NNTPOverContext *context,
+                 CamelNNTPStore *nntp_store,
+                 guint high,
+                 guint low,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	CamelNNTPStream *nntp_stream;
+	gboolean compressed = FALSE;
+	gchar *line;
+	gint ret = -1;
+
+	if (camel_nntp_store_has_capabilities (nntp_store, CAMEL_NNTP_CAPABILITY_XZVER)) {
+		ret = camel_nntp_raw_command_auth (
+			nntp_store, cancellable, error,
+			&line, "xzver %r", low, high);
+		if (ret == -1)
+			return -1;
+		if (ret == 224)
+			compressed = TRUE;
+		else
+			camel_nntp_store_remove_capabilities (
+				nntp_store, CAMEL_NNTP_CAPABILITY_XZVER);
+	}
+
+	if (!compressed) {
+		if (camel_nntp_store_has_capabilities (nntp_store, CAMEL_NNTP_CAPABILITY_OVER))
+			ret = camel_nntp_raw_command_auth (
+				nntp_store, cancellable, error,
+				&line, "over %r", low, high);
+		else
+			ret = -1;
+		if (ret != 224) {
+			camel_nntp_store_remove_capabilities (nntp_store, CAMEL_NNTP_CAPABILITY_OVER);
+			ret = camel_nntp_raw_command_auth (
+				nntp_store, cancellable, error,
+				&line, "xover %r", low, high);
+		}
+	}
+
+	if (ret != 224) {
+		if (ret != -1)
+			g_set_error (
+				error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
+				_("Unexpected server response from xover: %s"), line);
+		return -1;
+	}
+
+	nntp_stream = camel_nntp_store_ref_stream (nntp_store);
+
+	ret = nntp_over_read (
+		nntp_stream, compressed,
+		nntp_over_context_add, context,
+		cancellable, error);
+
+	g_clear_object (&nntp_stream);
+
+	return ret;
+}
+
 /* Note: This will be called from camel_nntp_command, so only use camel_nntp_raw_command */
 static gint
 add_range_xover (CamelNNTPSummary *cns,
@@ -167,24 +722,27 @@ add_range_xover (CamelNNTPSummary *cns,
                  GCancellable *cancellable,
                  GError **error)
 {
-	CamelNNTPCapabilities capability = CAMEL_NNTP_CAPABILITY_OVER;
-	CamelNNTPStream *nntp_stream;
 	CamelNetworkSettings *network_settings;
 	CamelSettings *settings;
 	CamelService *service;
 	CamelFolderSummary *s;
-	CamelMessageInfoBase *mi;
-	struct _camel_header_raw *headers = NULL;
-	gchar *line, *tab;
-	gchar *host;
-	guint len;
+	NNTPOverContext context;
+	GCancellable *workers_cancellable = NULL;
+	GPtrArray *workers;
+	gulong cancel_id = 0;
+	gchar *host, *user;
+	guint n_workers, chunk, ii, jj;
 	gint ret;
-	guint n, count, total, size;
-	gboolean folder_filter_recent;
-	struct _xover_header *xover;
 
 	s = (CamelFolderSummary *) cns;
-	folder_filter_recent = camel_folder_summary_get_folder (s) &&
+
+	memset (&context, 0, sizeof (context));
+	context.cns = cns;
+	context.xover = nntp_store->xover;
+	context.changes = changes;
+	context.cancellable = cancellable;
+	context.total = high - low + 1;
+	context.folder_filter_recent = camel_folder_summary_get_folder (s) &&
 		(camel_folder_summary_get_folder (s)->folder_flags & CAMEL_FOLDER_FILTER_RECENT) != 0;
 
 	service = CAMEL_SERVICE (nntp_store);
@@ -193,6 +751,7 @@ add_range_xover (CamelNNTPSummary *cns,
 
 	network_settings = CAMEL_NETWORK_SETTINGS (settings);
 	host = camel_network_settings_dup_host (network_settings);
+	user = camel_network_settings_dup_user (network_settings);
 
 	g_object_unref (settings);
 
@@ -201,96 +760,115 @@ add_range_xover (CamelNNTPSummary *cns,
 
 	g_free (host);
 
-	if (camel_nntp_store_has_capabilities (nntp_store, capability))
-		ret = camel_nntp_raw_command_auth (
-			nntp_store, cancellable, error,
-			&line, "over %r", low, high);
-	else
-		ret = -1;
-	if (ret != 224) {
-		camel_nntp_store_remove_capabilities (nntp_store, capability);
-		ret = camel_nntp_raw_command_auth (
-			nntp_store, cancellable, error,
-			&line, "xover %r", low, high);
-	}
+	workers = g_ptr_array_new_with_free_func (
+		(GDestroyNotify) nntp_over_worker_free);
+
+	/* Split a large range across extra connections, each fetching a
+	 * slice while the store's connection fetches the first one.  The
+	 * slices are merged into the summary in article order, so that
+	 * cns->high only ever moves past articles we really have. */
+	n_workers = MIN (NNTP_OVER_WORKERS, context.total / NNTP_OVER_WORKER_MIN_RANGE);
+	if (getenv ("CAMEL_NNTP_DISABLE_PARALLEL_OVER") != NULL)
+		n_workers = 0;
+
+	if (n_workers > 0) {
+		const gchar *group;
+
+		group = camel_folder_get_full_name (camel_folder_summary_get_folder (s));
+		chunk = context.total / (n_workers + 1);
+
+		workers_cancellable = g_cancellable_new ();
+		if (cancellable != NULL)
+			cancel_id = g_cancellable_connect (
+				cancellable,
+				G_CALLBACK (nntp_over_cancel_workers),
+				workers_cancellable, NULL);
+
+		for (ii = 0; ii < n_workers; ii++) {
+			NNTPOverWorker *worker;
+
+			worker = g_slice_new0 (NNTPOverWorker);
+			worker->nntp_store = g_object_ref (nntp_store);
+			worker->xover = nntp_store->xover;
+			worker->group = g_strdup (group);
+			if (user != NULL && *user != '\0') {
+				worker->user = g_strdup (user);
+				worker->password = g_strdup (camel_service_get_password (service));
+			}
+			worker->low = low + chunk * (ii + 1);
+			worker->high = (ii + 1 == n_workers) ? high : worker->low + chunk - 1;
+			worker->compressed = camel_nntp_store_has_capabilities (
+				nntp_store, CAMEL_NNTP_CAPABILITY_XZVER);
+			worker->over = camel_nntp_store_has_capabilities (
+				nntp_store, CAMEL_NNTP_CAPABILITY_OVER);
+			worker->cancellable = workers_cancellable;
+			worker->entries = g_ptr_array_new_with_free_func (
+				(GDestroyNotify) nntp_over_entry_free);
+
+			/* if the thread cannot be started, the slice
+			 * is simply fetched on the store's connection */
+			worker->thread = g_thread_try_new (
+				"camel-nntp-over",
+				nntp_over_worker_thread, worker, NULL);
+
+			g_ptr_array_add (workers, worker);
+		}
 
-	if (ret != 224) {
-		camel_operation_pop_message (cancellable);
-		if (ret != -1)
-			g_set_error (
-				error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
-				_("Unexpected server response from xover: %s"), line);
-		return -1;
+		high = low + chunk - 1;
 	}
 
-	nntp_stream = camel_nntp_store_ref_stream (nntp_store);
+	ret = nntp_over_fetch (&context, nntp_store, high, low, cancellable, error);
 
-	count = 0;
-	total = high - low + 1;
-	while ((ret = camel_nntp_stream_line (nntp_stream, (guchar **) &line, &len, cancellable, error)) > 0) {
-		camel_operation_progress (cancellable, (count * 100) / total);
-		count++;
-		n = strtoul (line, &tab, 10);
-		if (*tab != '\t')
-			continue;
-		tab++;
-		xover = nntp_store->xover;
-		size = 0;
-		for (; tab[0] && xover; xover = xover->next) {
-			line = tab;
-			tab = strchr (line, '\t');
-			if (tab)
-				*tab++ = 0;
-			else
-				tab = line + strlen (line);
-
-			/* do we care about this column? */
-			if (xover->name) {
-				line += xover->skip;
-				if (line < tab) {
-					camel_header_raw_append (&headers, xover->name, line, -1);
-					switch (xover->type) {
-					case XOVER_STRING:
-						break;
-					case XOVER_MSGID:
-						cns->priv->uid = g_strdup_printf ("%u,%s", n, line);
-						break;
-					case XOVER_SIZE:
-						size = strtoul (line, NULL, 10);
-						break;
-					}
-				}
-			}
+	for (ii = 0; ii < workers->len && ret != -1; ii++) {
+		NNTPOverWorker *worker = workers->pdata[ii];
+
+		if (worker->thread != NULL) {
+			g_thread_join (worker->thread);
+			worker->thread = NULL;
 		}
 
-		/* skip headers we don't care about, incase the server doesn't actually send some it said it would. */
-		while (xover && xover->name == NULL)
-			xover = xover->next;
+		if (!worker->success) {
+			dd (printf (
+				"nntp_summary: worker for %u-%u failed (%s), fetching it here\n",
+				worker->low, worker->high,
+				worker->error ? worker->error->message : "not started"));
 
-		/* truncated line? ignore? */
-		if (xover == NULL) {
-			if (!camel_folder_summary_check_uid (s, cns->priv->uid)) {
-				mi = (CamelMessageInfoBase *)
-					camel_folder_summary_add_from_header (s, headers);
-				if (mi) {
-					mi->size = size;
-					cns->high = n;
-					camel_folder_change_info_add_uid (changes, camel_message_info_uid (mi));
-					if (folder_filter_recent)
-						camel_folder_change_info_recent_uid (changes, camel_message_info_uid (mi));
-				}
-			}
+			ret = nntp_over_fetch (
+				&context, nntp_store,
+				worker->high, worker->low,
+				cancellable, error);
+			continue;
 		}
 
-		if (cns->priv->uid) {
-			g_free (cns->priv->uid);
-			cns->priv->uid = NULL;
+		for (jj = 0; jj < worker->entries->len; jj++) {
+			NNTPOverEntry *entry = worker->entries->pdata[jj];
+
+			camel_operation_progress (
+				cancellable, (context.count * 100) / context.total);
+			context.count++;
+
+			nntp_over_summary_add (
+				cns, entry->n, entry->uid, entry->size,
+				entry->headers, changes,
+				context.folder_filter_recent);
+			entry->uid = NULL;
 		}
 
-		camel_header_raw_clear (&headers);
+		g_ptr_array_set_size (worker->entries, 0);
 	}
 
-	g_clear_object (&nntp_stream);
+	/* On failure, stop any workers still running before
+	 * their results are thrown away. */
+	if (workers_cancellable != NULL) {
+		if (ret == -1)
+			g_cancellable_cancel (workers_cancellable);
+		if (cancel_id != 0)
+			g_cancellable_disconnect (cancellable, cancel_id);
+	}
+
+	g_ptr_array_unref (workers);
+	g_clear_object (&workers_cancellable);
+	g_free (user);
 
 	camel_operation_pop_message (cancellable);
 
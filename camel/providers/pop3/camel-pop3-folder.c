@@ -38,6 +38,14 @@
 
 #define d(x) if (camel_debug("pop3")) x;
 
+/* How many RETR commands get_message() keeps in flight ahead of the
+ * message asked for.  A pipelining server takes the whole window in one
+ * go; otherwise the engine queues the commands and sends each as soon as
+ * the previous response is read, which still saves the round trip the
+ * caller would pay between messages. */
+#define POP3_FETCH_WINDOW (10)
+#define POP3_FETCH_WINDOW_PIPELINED (32)
+
 G_DEFINE_TYPE (CamelPOP3Folder, camel_pop3_folder, CAMEL_TYPE_FOLDER)
 
 static void
@@ -66,6 +74,35 @@ free_fi (CamelPOP3Folder *pop3_folder,
 	g_free (fi);
 
 }
+
+/* A message is only complete in the cache once cmd_tocache() has
+ * replaced its leading '*' with a '#'. */
+static gboolean
+pop3_folder_is_cached (CamelDataCache *pop3_cache,
+                       CamelPOP3FolderInfo *fi)
+{
+	CamelStream *stream;
+	gchar buffer[1];
+
+	/* Messages once found complete are not looked up again */
+	if (fi->cached)
+		return TRUE;
+
+	if (pop3_cache == NULL || fi->uid == NULL)
+		return FALSE;
+
+	stream = camel_data_cache_get (pop3_cache, "cache", fi->uid, NULL);
+	if (stream == NULL)
+		return FALSE;
+
+	fi->cached = camel_stream_read (stream, buffer, 1, NULL, NULL) == 1 &&
+		buffer[0] == '#';
+
+	g_object_unref (stream);
+
+	return fi->cached;
+}
+
 static void
 cmd_uidl (CamelPOP3Engine *pe,
           CamelPOP3Stream *stream,
@@ -333,7 +370,7 @@ cmd_tocache (CamelPOP3Engine *pe,
              gpointer data)
 {
 	CamelPOP3FolderInfo *fi = data;
-	gchar buffer[2048];
+	gchar buffer[16384];
 	gint w = 0, n;
 	GError *local_error = NULL;
 
@@ -361,7 +398,8 @@ cmd_tocache (CamelPOP3Engine *pe,
 		g_seekable_seek (
 			G_SEEKABLE (fi->stream),
 			0, G_SEEK_SET, cancellable, NULL);
-		camel_stream_write (fi->stream, "#", 1, cancellable, &local_error);
+		if (camel_stream_write (fi->stream, "#", 1, cancellable, &local_error) == 1)
+			fi->cached = !CAMEL_IS_STREAM_MEM (fi->stream);
 	}
 
 done:
@@ -465,18 +503,11 @@ pop3_get_uncached_uids (CamelFolder *folder,
 
 	for (ii = 0; ii < uids->len; ii++) {
 		const gchar *uid = uids->pdata[ii];
-		CamelStream *stream = NULL;
 		CamelPOP3FolderInfo *fi;
-		gchar buffer[1];
 
 		fi = g_hash_table_lookup (pop3_folder->uids_fi, uid);
-		if (!fi || !pop3_cache ||
-		    (stream = camel_data_cache_get (pop3_cache, "cache", fi->uid, NULL)) == NULL ||
-		    camel_stream_read (stream, buffer, 1, NULL, NULL) != 1 ||
-		    buffer[0] != '#')
+		if (!fi || !pop3_folder_is_cached (pop3_cache, fi))
 			g_ptr_array_add (uncached_uids, (gpointer) camel_pstring_strdup (uid));
-
-		g_clear_object (&stream);
 	}
 
 	g_clear_object (&pop3_cache);
@@ -541,6 +572,49 @@ pop3_folder_set_message_flags (CamelFolder *folder,
 	return res;
 }
 
+/* Keeps RETR commands in flight for the messages following @index, so
+ * they stream into the cache while the caller deals with the current
+ * one.  Messages already complete in the cache, typically from a
+ * download which got interrupted, are not fetched again. */
+static void
+pop3_folder_prefetch (CamelPOP3Folder *pop3_folder,
+                      CamelPOP3Engine *pop3_engine,
+                      CamelDataCache *pop3_cache,
+                      guint index,
+                      GCancellable *cancellable)
+{
+	guint ii, last, window;
+
+	if (pop3_engine->capa & CAMEL_POP3_CAP_PIPE)
+		window = POP3_FETCH_WINDOW_PIPELINED;
+	else
+		window = POP3_FETCH_WINDOW;
+
+	last = MIN (index + window, pop3_folder->uids->len);
+
+	for (ii = index; ii < last; ii++) {
+		CamelPOP3FolderInfo *pfi = pop3_folder->uids->pdata[ii];
+
+		if (pfi->uid == NULL || pfi->cmd != NULL)
+			continue;
+
+		if (pop3_folder_is_cached (pop3_cache, pfi))
+			continue;
+
+		pfi->stream = camel_data_cache_add (
+			pop3_cache, "cache", pfi->uid, NULL);
+		if (pfi->stream == NULL)
+			continue;
+
+		pfi->cmd = camel_pop3_engine_command_new (
+			pop3_engine,
+			CAMEL_POP3_COMMAND_MULTI,
+			cmd_tocache, pfi,
+			cancellable, NULL,
+			"RETR %u\r\n", pfi->id);
+	}
+}
+
 static CamelMimeMessage *
 pop3_folder_get_message_sync (CamelFolder *folder,
                               const gchar *uid,
@@ -556,7 +630,7 @@ pop3_folder_get_message_sync (CamelFolder *folder,
 	CamelPOP3Command *pcr;
 	CamelPOP3FolderInfo *fi;
 	gchar buffer[1];
-	gint i, last;
+	gint i;
 	CamelStream *stream = NULL;
 	CamelService *service;
 	CamelSettings *settings;
@@ -647,30 +721,10 @@ pop3_folder_get_message_sync (CamelFolder *folder,
 
 		/* Also initiate retrieval of some of the following
 		 * messages, assume we'll be receiving them. */
-		if (auto_fetch && pop3_cache != NULL) {
-			/* This should keep track of the last one retrieved,
-			 * also how many are still oustanding incase of random
-			 * access on large folders. */
-			i = fi->index + 1;
-			last = MIN (i + 10, pop3_folder->uids->len);
-			for (; i < last; i++) {
-				CamelPOP3FolderInfo *pfi = pop3_folder->uids->pdata[i];
-
-				if (pfi->uid && pfi->cmd == NULL) {
-					pfi->stream = camel_data_cache_add (
-						pop3_cache,
-						"cache", pfi->uid, NULL);
-					if (pfi->stream) {
-						pfi->cmd = camel_pop3_engine_command_new (
-							pop3_engine,
-							CAMEL_POP3_COMMAND_MULTI,
-							cmd_tocache, pfi,
-							cancellable, error,
-							"RETR %u\r\n", pfi->id);
-					}
-				}
-			}
-		}
+		if (auto_fetch && pop3_cache != NULL)
+			pop3_folder_prefetch (
+				pop3_folder, pop3_engine, pop3_cache,
+				fi->index + 1, cancellable);
 
 		/* now wait for the first one to finish */
 		while ((i = camel_pop3_engine_iterate (pop3_engine, pcr, cancellable, error)) > 0)
@@ -699,6 +753,15 @@ pop3_folder_get_message_sync (CamelFolder *folder,
 				_("Unknown reason"));
 			goto done;
 		}
+	} else if (auto_fetch) {
+		/* Served from the cache, most likely read ahead by an
+		 * earlier call; keep the window moving all the same.
+		 * Messages read ahead are known to be cached by now,
+		 * so this does not go looking for their files. */
+		fi->cached = TRUE;
+		pop3_folder_prefetch (
+			pop3_folder, pop3_engine, pop3_cache,
+			fi->index + 1, cancellable);
 	}
 
 	message = camel_mime_message_new ();
@@ -1021,8 +1084,10 @@ pop3_folder_synchronize_sync (CamelFolder *folder,
 				"DELE %u\r\n", fi->id);
 
 			/* also remove from cache */
-			if (pop3_cache != NULL && fi->uid)
+			if (pop3_cache != NULL && fi->uid) {
 				camel_data_cache_remove (pop3_cache, "cache", fi->uid, NULL);
+				fi->cached = FALSE;
+			}
 		}
 	}
 
@@ -1301,6 +1366,7 @@ camel_pop3_delete_old (CamelFolder *folder,
 				/* also remove from cache */
 				if (pop3_cache != NULL && fi->uid) {
 					camel_data_cache_remove (pop3_cache, "cache", fi->uid, NULL);
+					fi->cached = FALSE;
 				}
 			}
 		}
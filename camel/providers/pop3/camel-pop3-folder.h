@@ -61,6 +61,7 @@ struct _CamelPOP3FolderInfo {
 	gchar *uid;
 	struct _CamelPOP3Command *cmd;
 	struct _CamelStream *stream;
+	gboolean cached;	/* known to be complete in the cache */
 };
 
 struct _CamelPOP3Folder {
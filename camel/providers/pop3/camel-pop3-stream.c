@@ -33,7 +33,8 @@
 
 #define dd(x) (camel_debug ("pop3")?(x):0)
 
-#define CAMEL_POP3_STREAM_SIZE (4096)
+/* large enough to take a whole TLS record per read while streaming RETR */
+#define CAMEL_POP3_STREAM_SIZE (16384)
 #define CAMEL_POP3_STREAM_LINE_SIZE (1024) /* maximum line size */
 
 G_DEFINE_TYPE (CamelPOP3Stream, camel_pop3_stream, CAMEL_TYPE_STREAM)
@@ -53,6 +53,13 @@
 #define SMTP_PORT  25
 #define SMTPS_PORT 465
 
+/* how often camel_transport_send_queue_sync() starts a new session
+ * after losing the connection without getting any message through */
+#define SMTP_QUEUE_MAX_RECONNECTS 3
+
+/* size of each BDAT chunk (RFC 3030) */
+#define SMTP_BDAT_CHUNK_SIZE (1024 * 1024)
+
 enum {
 	PROP_0,
 	PROP_CONNECTABLE,
@@ -73,10 +80,21 @@ static gboolean		smtp_rcpt		(CamelSmtpTransport *transport,
 						 const gchar *recipient,
 						 GCancellable *cancellable,
 						 GError **error);
+static gboolean		smtp_mail_rcpt_pipelined
+						(CamelSmtpTransport *transport,
+						 const gchar *sender,
+						 gboolean has_8bit_parts,
+						 GPtrArray *recipients,
+						 GCancellable *cancellable,
+						 GError **error);
 static gboolean		smtp_data		(CamelSmtpTransport *transport,
 						 CamelMimeMessage *message,
 						 GCancellable *cancellable,
 						 GError **error);
+static gboolean		smtp_bdat		(CamelSmtpTransport *transport,
+						 CamelMimeMessage *message,
+						 GCancellable *cancellable,
+						 GError **error);
 static gboolean		smtp_rset		(CamelSmtpTransport *transport,
 						 GCancellable *cancellable,
 						 GError **error);
@@ -681,6 +699,8 @@ smtp_transport_send_to_sync (CamelTransport *transport,
 	CamelSmtpTransport *smtp_transport = CAMEL_SMTP_TRANSPORT (transport);
 	CamelInternetAddress *cia;
 	gboolean has_8bit_parts;
+	gboolean success;
+	GPtrArray *rcpts;
 	const gchar *addr;
 	gint i, len;
 
@@ -699,68 +719,173 @@ smtp_transport_send_to_sync (CamelTransport *transport,
 		return FALSE;
 	}
 
-	camel_operation_push_message (cancellable, _("Sending message"));
-
-	/* find out if the message has 8bit mime parts */
-	has_8bit_parts = camel_mime_message_has_8bit_parts (message);
-
-	/* If the connection needs a ReSET, then do so */
-	if (smtp_transport->need_rset &&
-	    !smtp_rset (smtp_transport, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
-		return FALSE;
-	}
-	smtp_transport->need_rset = FALSE;
-
-	/* rfc1652 (8BITMIME) requires that you notify the ESMTP daemon that
-	 * you'll be sending an 8bit mime message at "MAIL FROM:" time. */
-	if (!smtp_mail (
-		smtp_transport, addr, has_8bit_parts, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
-		return FALSE;
-	}
-
 	len = camel_address_length (recipients);
 	if (len == 0) {
 		g_set_error (
 			error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
 			_("Cannot send message: no recipients defined."));
-		camel_operation_pop_message (cancellable);
-		smtp_transport->need_rset = TRUE;
 		return FALSE;
 	}
 
 	cia = CAMEL_INTERNET_ADDRESS (recipients);
+	rcpts = g_ptr_array_new_with_free_func (g_free);
 	for (i = 0; i < len; i++) {
-		gchar *enc;
+		const gchar *rcpt;
 
-		if (!camel_internet_address_get (cia, i, NULL, &addr)) {
+		if (!camel_internet_address_get (cia, i, NULL, &rcpt)) {
 			g_set_error (
 				error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
 				_("Cannot send message: "
 				"one or more invalid recipients"));
-			camel_operation_pop_message (cancellable);
-			smtp_transport->need_rset = TRUE;
+			g_ptr_array_unref (rcpts);
 			return FALSE;
 		}
 
-		enc = camel_internet_address_encode_address (NULL, NULL, addr);
-		if (!smtp_rcpt (smtp_transport, enc, cancellable, error)) {
-			g_free (enc);
-			camel_operation_pop_message (cancellable);
+		g_ptr_array_add (
+			rcpts, camel_internet_address_encode_address (
+			NULL, NULL, rcpt));
+	}
+
+	camel_operation_push_message (cancellable, _("Sending message"));
+
+	/* find out if the message has 8bit mime parts */
+	has_8bit_parts = camel_mime_message_has_8bit_parts (message);
+
+	/* If the connection needs a ReSET, then do so */
+	if (smtp_transport->need_rset &&
+	    !smtp_rset (smtp_transport, cancellable, error)) {
+		success = FALSE;
+		goto exit;
+	}
+	smtp_transport->need_rset = FALSE;
+
+	if (smtp_transport->flags & CAMEL_SMTP_TRANSPORT_PIPELINING) {
+		/* rfc2920: send MAIL FROM and all the RCPT TOs in one go */
+		if (!smtp_mail_rcpt_pipelined (
+			smtp_transport, addr, has_8bit_parts,
+			rcpts, cancellable, error)) {
 			smtp_transport->need_rset = TRUE;
-			return FALSE;
+			success = FALSE;
+			goto exit;
+		}
+	} else {
+		/* rfc1652 (8BITMIME) requires that you notify the ESMTP daemon that
+		 * you'll be sending an 8bit mime message at "MAIL FROM:" time. */
+		if (!smtp_mail (
+			smtp_transport, addr, has_8bit_parts, cancellable, error)) {
+			success = FALSE;
+			goto exit;
+		}
+
+		for (i = 0; i < rcpts->len; i++) {
+			if (!smtp_rcpt (smtp_transport, rcpts->pdata[i], cancellable, error)) {
+				smtp_transport->need_rset = TRUE;
+				success = FALSE;
+				goto exit;
+			}
 		}
-		g_free (enc);
 	}
 
-	if (!smtp_data (smtp_transport, message, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
+	/* rfc3030 (CHUNKING) sends the message as sized chunks,
+	 * which saves the dot-stuffing of DATA */
+	if (smtp_transport->flags & CAMEL_SMTP_TRANSPORT_CHUNKING)
+		success = smtp_bdat (smtp_transport, message, cancellable, error);
+	else
+		success = smtp_data (smtp_transport, message, cancellable, error);
+
+	if (!success)
 		smtp_transport->need_rset = TRUE;
-		return FALSE;
-	}
 
+exit:
 	camel_operation_pop_message (cancellable);
+	g_ptr_array_unref (rcpts);
+
+	return success;
+}
+
+static gboolean
+smtp_transport_send_queue_sync (CamelTransport *transport,
+                                GPtrArray *queue,
+                                GCancellable *cancellable,
+                                GError **error)
+{
+	CamelSmtpTransport *smtp_transport = CAMEL_SMTP_TRANSPORT (transport);
+	CamelService *service = CAMEL_SERVICE (transport);
+	gint64 drain_started;
+	guint ii, n_sent = 0, n_reconnects = 0;
+
+	drain_started = g_get_monotonic_time ();
+
+	/* Connect, say EHLO, STARTTLS and authenticate once, then run
+	 * one mail transaction after another on the same session.
+	 * smtp_transport_send_to_sync() issues RSET before a
+	 * transaction whenever the previous one was left unfinished;
+	 * a completed transaction already resets the server state
+	 * (rfc5321 section 4.1.4), so no extra round trip is paid per
+	 * message when everything goes well. */
+	for (ii = 0; ii < queue->len; ii++) {
+		CamelTransportQueueItem *item = queue->pdata[ii];
+		gint64 started;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return FALSE;
+
+		/* The server may drop us mid-queue, typically when it
+		 * limits the number of messages per session.  Start a
+		 * new session for the rest of the queue; the message
+		 * which failed keeps its error and is not resent, as
+		 * we cannot tell whether the server accepted it.  Give
+		 * up when sessions keep failing without any progress. */
+		if (!smtp_transport->connected) {
+			if (n_reconnects >= SMTP_QUEUE_MAX_RECONNECTS) {
+				g_set_error (
+					error, CAMEL_SERVICE_ERROR,
+					CAMEL_SERVICE_ERROR_UNAVAILABLE,
+					_("Connection to the mail server "
+					"keeps being lost"));
+				return FALSE;
+			}
+
+			n_reconnects++;
+
+			if (camel_service_get_connection_status (service) ==
+			    CAMEL_SERVICE_CONNECTED)
+				camel_service_disconnect_sync (
+					service, FALSE, cancellable, NULL);
+
+			if (!camel_service_connect_sync (
+				service, cancellable, error))
+				return FALSE;
+		}
+
+		camel_operation_progress (
+			cancellable, ii * 100 / queue->len);
+
+		started = g_get_monotonic_time ();
+		item->sent = smtp_transport_send_to_sync (
+			transport, item->message, item->from,
+			item->recipients, cancellable, &item->error);
+		item->elapsed = g_get_monotonic_time () - started;
+
+		if (item->sent) {
+			n_sent++;
+			n_reconnects = 0;
+		}
+
+		d (fprintf (
+			stderr, "[SMTP] queue item %u/%u %s in "
+			"%" G_GINT64_FORMAT " ms%s%s\n",
+			ii + 1, queue->len,
+			item->sent ? "sent" : "failed",
+			item->elapsed / 1000,
+			item->error ? ": " : "",
+			item->error ? item->error->message : ""));
+	}
+
+	d (fprintf (
+		stderr, "[SMTP] queue drained, %u of %u sent in "
+		"%" G_GINT64_FORMAT " ms\n", n_sent, queue->len,
+		(g_get_monotonic_time () - drain_started) / 1000));
 
 	return TRUE;
 }
@@ -824,6 +949,7 @@ camel_smtp_transport_class_init (CamelSmtpTransportClass *class)
 
 	transport_class = CAMEL_TRANSPORT_CLASS (class);
 	transport_class->send_to_sync = smtp_transport_send_to_sync;
+	transport_class->send_queue_sync = smtp_transport_send_queue_sync;
 
 	/* Inherited from CamelNetworkService. */
 	g_object_class_override_property (
@@ -1155,7 +1281,9 @@ smtp_helo (CamelSmtpTransport *transport,
 	 * are being called a second time (ie, after a STARTTLS) */
 	transport->flags &= ~(CAMEL_SMTP_TRANSPORT_8BITMIME |
 			      CAMEL_SMTP_TRANSPORT_ENHANCEDSTATUSCODES |
-			      CAMEL_SMTP_TRANSPORT_STARTTLS);
+			      CAMEL_SMTP_TRANSPORT_STARTTLS |
+			      CAMEL_SMTP_TRANSPORT_PIPELINING |
+			      CAMEL_SMTP_TRANSPORT_CHUNKING);
 
 	if (transport->authtypes) {
 		g_hash_table_foreach (transport->authtypes, authtypes_free, NULL);
@@ -1227,6 +1355,10 @@ smtp_helo (CamelSmtpTransport *transport,
 				transport->flags |= CAMEL_SMTP_TRANSPORT_ENHANCEDSTATUSCODES;
 			} else if (!g_ascii_strncasecmp (token, "STARTTLS", 8)) {
 				transport->flags |= CAMEL_SMTP_TRANSPORT_STARTTLS;
+			} else if (!g_ascii_strncasecmp (token, "PIPELINING", 10)) {
+				transport->flags |= CAMEL_SMTP_TRANSPORT_PIPELINING;
+			} else if (!g_ascii_strncasecmp (token, "CHUNKING", 8)) {
+				transport->flags |= CAMEL_SMTP_TRANSPORT_CHUNKING;
 			} else if (!g_ascii_strncasecmp (token, "AUTH", 4)) {
 				if (!transport->authtypes || transport->flags & CAMEL_SMTP_TRANSPORT_AUTH_EQUAL) {
 					/* Don't bother parsing any authtypes if we already have a list.
@@ -1377,13 +1509,393 @@ smtp_rcpt (CamelSmtpTransport *transport,
 	return TRUE;
 }
 
+/* Reads one, possibly multi-line, reply and checks its status code.
+ * *@io_failed is set if the connection broke while reading it. */
+static gboolean
+smtp_read_reply (CamelSmtpTransport *transport,
+                 const gchar *code,
+                 gboolean *io_failed,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	gchar *respbuf = NULL;
+
+	*io_failed = FALSE;
+
+	do {
+		g_free (respbuf);
+		respbuf = camel_stream_buffer_read_line (
+			CAMEL_STREAM_BUFFER (transport->istream),
+			cancellable, error);
+		if (respbuf == NULL) {
+			*io_failed = TRUE;
+			return FALSE;
+		}
+		if (strncmp (respbuf, code, 3) != 0) {
+			/* this reads the rest of a multi-line reply */
+			smtp_set_error (
+				transport, respbuf, cancellable, error);
+			g_free (respbuf);
+			return FALSE;
+		}
+	} while (*(respbuf+3) == '-'); /* if we got "250-" then loop again */
+	g_free (respbuf);
+
+	return TRUE;
+}
+
+static gboolean
+smtp_mail_rcpt_pipelined (CamelSmtpTransport *transport,
+                          const gchar *sender,
+                          gboolean has_8bit_parts,
+                          GPtrArray *recipients,
+                          GCancellable *cancellable,
+                          GError **error)
+{
+	GString *cmdbuf;
+	gboolean success, io_failed = FALSE;
+	gint i;
+
+	cmdbuf = g_string_new ("");
+
+	if (transport->flags & CAMEL_SMTP_TRANSPORT_8BITMIME && has_8bit_parts)
+		g_string_append_printf (cmdbuf, "MAIL FROM:<%s> BODY=8BITMIME\r\n", sender);
+	else
+		g_string_append_printf (cmdbuf, "MAIL FROM:<%s>\r\n", sender);
+
+	for (i = 0; i < recipients->len; i++)
+		g_string_append_printf (
+			cmdbuf, "RCPT TO:<%s>\r\n",
+			(const gchar *) recipients->pdata[i]);
+
+	d (fprintf (stderr, "sending : %s", cmdbuf->str));
+
+	if (camel_stream_write (
+		transport->ostream, cmdbuf->str, cmdbuf->len,
+		cancellable, error) == -1) {
+		g_string_free (cmdbuf, TRUE);
+		g_prefix_error (error, _("MAIL FROM command failed: "));
+		camel_service_disconnect_sync (
+			CAMEL_SERVICE (transport),
+			FALSE, cancellable, NULL);
+		return FALSE;
+	}
+	g_string_free (cmdbuf, TRUE);
+
+	/* Every command gets its reply, in order.  Read them all to
+	 * stay in step with the server, reporting the first failure. */
+	success = smtp_read_reply (
+		transport, "250", &io_failed, cancellable, error);
+	if (!success)
+		g_prefix_error (error, _("MAIL FROM command failed: "));
+
+	for (i = 0; i < recipients->len && !io_failed; i++) {
+		GError *local_error = NULL;
+
+		if (smtp_read_reply (
+			transport, "250", &io_failed,
+			cancellable, &local_error))
+			continue;
+
+		if (success) {
+			g_propagate_prefixed_error (
+				error, local_error,
+				_("RCPT TO <%s> failed: "),
+				(const gchar *) recipients->pdata[i]);
+			success = FALSE;
+		} else {
+			g_clear_error (&local_error);
+		}
+	}
+
+	if (io_failed)
+		camel_service_disconnect_sync (
+			CAMEL_SERVICE (transport),
+			FALSE, cancellable, NULL);
+
+	return success;
+}
+
+/* Takes the Bcc headers out of @message, they must not be sent.
+ * Returns them, and the header to hang them back on. */
+static struct _camel_header_raw *
+smtp_unlink_bcc (CamelMimeMessage *message,
+                 struct _camel_header_raw **out_last)
+{
+	struct _camel_header_raw *header, *savedbcc, *n, *tail;
+
+	savedbcc = NULL;
+	tail = (struct _camel_header_raw *) &savedbcc;
+
+	header = (struct _camel_header_raw *) &CAMEL_MIME_PART (message)->headers;
+	n = header->next;
+	while (n != NULL) {
+		if (!g_ascii_strcasecmp (n->name, "Bcc")) {
+			header->next = n->next;
+			tail->next = n;
+			n->next = NULL;
+			tail = n;
+		} else {
+			header = n;
+		}
+
+		n = header->next;
+	}
+
+	*out_last = header;
+
+	return savedbcc;
+}
+
+/* A stream sending everything written to it as BDAT chunks of
+ * SMTP_BDAT_CHUNK_SIZE bytes, so at most one chunk of the message
+ * is held in memory; smtp_bdat_stream_finish() sends the last one. */
+
+typedef struct _SmtpBdatStream SmtpBdatStream;
+typedef struct _SmtpBdatStreamClass SmtpBdatStreamClass;
+
+struct _SmtpBdatStream {
+	CamelStream parent;
+
+	CamelSmtpTransport *transport;
+	GByteArray *chunk;
+	guint pending;		/* chunks whose reply was not read yet */
+	gboolean failed;	/* a chunk was refused or could not be sent */
+	gboolean io_failed;
+};
+
+struct _SmtpBdatStreamClass {
+	CamelStreamClass parent_class;
+};
+
+static GType smtp_bdat_stream_get_type (void);
+
+G_DEFINE_TYPE (SmtpBdatStream, smtp_bdat_stream, CAMEL_TYPE_STREAM)
+
+/* Reads the replies of all chunks sent so far, reporting the first failure. */
+static gboolean
+smtp_bdat_stream_read_replies (SmtpBdatStream *bdat,
+                               GCancellable *cancellable,
+                               GError **error)
+{
+	gboolean success = TRUE;
+
+	while (bdat->pending > 0 && !bdat->io_failed) {
+		GError *local_error = NULL;
+
+		bdat->pending--;
+
+		if (smtp_read_reply (
+			bdat->transport, "250", &bdat->io_failed,
+			cancellable, &local_error))
+			continue;
+
+		if (success) {
+			g_propagate_prefixed_error (
+				error, local_error,
+				_("BDAT command failed: "));
+			success = FALSE;
+		} else {
+			g_clear_error (&local_error);
+		}
+	}
+
+	if (!success || bdat->io_failed)
+		bdat->failed = TRUE;
+
+	return !bdat->failed;
+}
+
+static gboolean
+smtp_bdat_stream_send_chunk (SmtpBdatStream *bdat,
+                             gboolean last,
+                             GCancellable *cancellable,
+                             GError **error)
+{
+	CamelSmtpTransport *transport = bdat->transport;
+	gchar *cmdbuf;
+
+	cmdbuf = g_strdup_printf (
+		"BDAT %u%s\r\n", bdat->chunk->len, last ? " LAST" : "");
+
+	d (fprintf (stderr, "sending : %s", cmdbuf));
+
+	if (camel_stream_write_string (
+		transport->ostream, cmdbuf, cancellable, error) == -1 ||
+	    camel_stream_write (
+		transport->ostream, (const gchar *) bdat->chunk->data,
+		bdat->chunk->len, cancellable, error) == -1) {
+		g_free (cmdbuf);
+		g_prefix_error (error, _("BDAT command failed: "));
+		bdat->failed = TRUE;
+		bdat->io_failed = TRUE;
+		return FALSE;
+	}
+	g_free (cmdbuf);
+
+	g_byte_array_set_size (bdat->chunk, 0);
+	bdat->pending++;
+
+	/* with PIPELINING the replies are collected at the end */
+	if (!last && (transport->flags & CAMEL_SMTP_TRANSPORT_PIPELINING))
+		return TRUE;
+
+	return smtp_bdat_stream_read_replies (bdat, cancellable, error);
+}
+
+static void
+smtp_bdat_stream_finalize (GObject *object)
+{
+	SmtpBdatStream *bdat = (SmtpBdatStream *) object;
+
+	g_byte_array_free (bdat->chunk, TRUE);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (smtp_bdat_stream_parent_class)->finalize (object);
+}
+
+static gssize
+smtp_bdat_stream_write (CamelStream *stream,
+                        const gchar *buffer,
+                        gsize n,
+                        GCancellable *cancellable,
+                        GError **error)
+{
+	SmtpBdatStream *bdat = (SmtpBdatStream *) stream;
+	gsize written = 0;
+
+	while (written < n) {
+		gsize len = SMTP_BDAT_CHUNK_SIZE - bdat->chunk->len;
+
+		if (len > n - written)
+			len = n - written;
+
+		g_byte_array_append (
+			bdat->chunk, (const guint8 *) buffer + written, len);
+		written += len;
+
+		if (bdat->chunk->len == SMTP_BDAT_CHUNK_SIZE &&
+		    !smtp_bdat_stream_send_chunk (bdat, FALSE, cancellable, error))
+			return -1;
+	}
+
+	return n;
+}
+
+static void
+smtp_bdat_stream_class_init (SmtpBdatStreamClass *class)
+{
+	GObjectClass *object_class;
+	CamelStreamClass *stream_class;
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = smtp_bdat_stream_finalize;
+
+	stream_class = CAMEL_STREAM_CLASS (class);
+	stream_class->write = smtp_bdat_stream_write;
+}
+
+static void
+smtp_bdat_stream_init (SmtpBdatStream *bdat)
+{
+	bdat->chunk = g_byte_array_sized_new (SMTP_BDAT_CHUNK_SIZE);
+}
+
+static CamelStream *
+smtp_bdat_stream_new (CamelSmtpTransport *transport)
+{
+	SmtpBdatStream *bdat;
+
+	bdat = g_object_new (smtp_bdat_stream_get_type (), NULL);
+	bdat->transport = transport;
+
+	return CAMEL_STREAM (bdat);
+}
+
+/* Sends what is left as the last chunk, possibly an empty one. */
+static gboolean
+smtp_bdat_stream_finish (SmtpBdatStream *bdat,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	return smtp_bdat_stream_send_chunk (bdat, TRUE, cancellable, error);
+}
+
+static gboolean
+smtp_bdat (CamelSmtpTransport *transport,
+           CamelMimeMessage *message,
+           GCancellable *cancellable,
+           GError **error)
+{
+	struct _camel_header_raw *header, *savedbcc;
+	CamelBestencEncoding enctype = CAMEL_BESTENC_8BIT;
+	CamelStream *stream, *filtered_stream;
+	CamelMimeFilter *filter;
+	SmtpBdatStream *bdat;
+	gboolean success;
+	gint ret;
+
+	/* If the server doesn't support 8BITMIME, set our required encoding to be 7bit */
+	if (!(transport->flags & CAMEL_SMTP_TRANSPORT_8BITMIME))
+		enctype = CAMEL_BESTENC_7BIT;
+
+	camel_mime_message_set_best_encoding (
+		message, CAMEL_BESTENC_GET_ENCODING, enctype);
+
+	/* only line endings are converted, BDAT needs no dot-stuffing */
+	savedbcc = smtp_unlink_bcc (message, &header);
+
+	stream = smtp_bdat_stream_new (transport);
+	bdat = (SmtpBdatStream *) stream;
+
+	filtered_stream = camel_stream_filter_new (stream);
+	filter = camel_mime_filter_crlf_new (
+		CAMEL_MIME_FILTER_CRLF_ENCODE,
+		CAMEL_MIME_FILTER_CRLF_MODE_CRLF_ONLY);
+	camel_stream_filter_add (
+		CAMEL_STREAM_FILTER (filtered_stream), filter);
+	g_object_unref (filter);
+
+	ret = camel_data_wrapper_write_to_stream_sync (
+		CAMEL_DATA_WRAPPER (message),
+		filtered_stream, cancellable, error);
+	if (ret != -1)
+		ret = camel_stream_flush (filtered_stream, cancellable, error);
+
+	g_object_unref (filtered_stream);
+
+	/* restore the bcc headers */
+	header->next = savedbcc;
+
+	if (ret != -1) {
+		success = smtp_bdat_stream_finish (bdat, cancellable, error);
+	} else {
+		if (!bdat->failed)
+			g_prefix_error (error, _("BDAT command failed: "));
+
+		/* Stay in step with the server for the RSET which
+		 * follows, the replies of pipelined chunks are due. */
+		smtp_bdat_stream_read_replies (bdat, cancellable, NULL);
+		success = FALSE;
+	}
+
+	if (bdat->io_failed)
+		camel_service_disconnect_sync (
+			CAMEL_SERVICE (transport),
+			FALSE, cancellable, NULL);
+
+	g_object_unref (stream);
+
+	return success;
+}
+
 static gboolean
 smtp_data (CamelSmtpTransport *transport,
            CamelMimeMessage *message,
            GCancellable *cancellable,
            GError **error)
 {
-	struct _camel_header_raw *header, *savedbcc, *n, *tail;
+	struct _camel_header_raw *header, *savedbcc;
 	CamelBestencEncoding enctype = CAMEL_BESTENC_8BIT;
 	CamelStream *filtered_stream;
 	gchar *cmdbuf, *respbuf = NULL;
@@ -1440,23 +1952,7 @@ smtp_data (CamelSmtpTransport *transport,
 	respbuf = NULL;
 
 	/* unlink the bcc headers */
-	savedbcc = NULL;
-	tail = (struct _camel_header_raw *) &savedbcc;
-
-	header = (struct _camel_header_raw *) &CAMEL_MIME_PART (message)->headers;
-	n = header->next;
-	while (n != NULL) {
-		if (!g_ascii_strcasecmp (n->name, "Bcc")) {
-			header->next = n->next;
-			tail->next = n;
-			n->next = NULL;
-			tail = n;
-		} else {
-			header = n;
-		}
-
-		n = header->next;
-	}
+	savedbcc = smtp_unlink_bcc (message, &header);
 
 	/* find out how large the message is... */
 	null = CAMEL_STREAM_NULL (camel_stream_null_new ());
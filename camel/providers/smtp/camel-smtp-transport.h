@@ -54,6 +54,9 @@
 /* set if we are using authtypes from a broken AUTH= */
 #define CAMEL_SMTP_TRANSPORT_AUTH_EQUAL             (1 << 4)
 
+#define CAMEL_SMTP_TRANSPORT_PIPELINING             (1 << 5)
+#define CAMEL_SMTP_TRANSPORT_CHUNKING               (1 << 6)
+
 #ifdef G_OS_WIN32
 #define socklen_t int
 #endif
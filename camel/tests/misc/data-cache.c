@@ -0,0 +1,120 @@
+/* data cache size index */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "camel-test.h"
+
+#define CACHE_PATH "/tmp/camel-test/data-cache"
+
+static const gchar body[] =
+	"From: sender@example.com\r\n"
+	"Subject: cached\r\n"
+	"\r\n"
+	"Message body.\r\n";
+
+/* Stores a message the way a provider downloads one, into "tmp". */
+static void
+cache_write (CamelDataCache *cdc,
+             const gchar *uid)
+{
+	CamelStream *stream;
+	GError *error = NULL;
+
+	stream = camel_data_cache_add (cdc, "tmp", uid, &error);
+	check_msg (error == NULL, "%s", error->message);
+	check (stream != NULL);
+
+	check (camel_stream_write_string (stream, body, NULL, &error) == strlen (body));
+	check_msg (error == NULL, "%s", error->message);
+	check (camel_stream_flush (stream, NULL, &error) == 0);
+	check_msg (error == NULL, "%s", error->message);
+
+	check_unref (stream, 1);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	CamelDataCache *cdc;
+	CamelStream *stream;
+	GError *error = NULL;
+	gchar *tmp_filename, *cur_filename;
+	goffset total_size;
+
+	camel_test_init (argc, argv);
+
+	system ("/bin/rm -rf " CACHE_PATH);
+
+	camel_test_start ("Data cache size index");
+
+	cdc = camel_data_cache_new (CACHE_PATH, &error);
+	check_msg (error == NULL, "%s", error->message);
+	camel_data_cache_set_max_size (cdc, 1024 * 1024);
+
+	camel_test_push ("moving tmp to cur with camel_data_cache_rename");
+
+	cache_write (cdc, "1");
+	check (camel_data_cache_contains (cdc, "tmp", "1"));
+
+	check (camel_data_cache_rename (cdc, "tmp", "1", "cur", "1", &error));
+	check_msg (error == NULL, "%s", error->message);
+
+	check (camel_data_cache_contains (cdc, "cur", "1"));
+	check (!camel_data_cache_contains (cdc, "tmp", "1"));
+
+	camel_data_cache_get_statistics (cdc, &total_size, NULL, NULL);
+	check_msg (total_size == strlen (body), "total_size = %d", (gint) total_size);
+
+	camel_test_pull ();
+
+	camel_test_push ("moving tmp to cur behind the cache's back");
+
+	cache_write (cdc, "2");
+
+	tmp_filename = camel_data_cache_get_filename (cdc, "tmp", "2");
+	cur_filename = camel_data_cache_get_filename (cdc, "cur", "2");
+	check (g_rename (tmp_filename, cur_filename) == 0);
+	g_free (tmp_filename);
+	g_free (cur_filename);
+
+	stream = camel_data_cache_get (cdc, "cur", "2", &error);
+	check_msg (error == NULL, "%s", error->message);
+	check (stream != NULL);
+	check_unref (stream, 1);
+
+	check (camel_data_cache_remove (cdc, "tmp", "2", NULL) == 0);
+
+	check (camel_data_cache_contains (cdc, "cur", "2"));
+	check (!camel_data_cache_contains (cdc, "tmp", "2"));
+
+	camel_data_cache_get_statistics (cdc, &total_size, NULL, NULL);
+	check_msg (total_size == 2 * strlen (body), "total_size = %d", (gint) total_size);
+
+	camel_test_pull ();
+
+	camel_test_push ("evicting once over the limit");
+
+	camel_data_cache_set_max_size (cdc, strlen (body) + 1);
+
+	cache_write (cdc, "3");
+
+	camel_data_cache_get_statistics (cdc, &total_size, NULL, NULL);
+	check_msg (total_size <= strlen (body) + 1, "total_size = %d", (gint) total_size);
+	check (!camel_data_cache_contains (cdc, "cur", "1"));
+
+	camel_test_pull ();
+
+	check_unref (cdc, 1);
+
+	camel_test_end ();
+
+	system ("/bin/rm -rf " CACHE_PATH);
+
+	return 0;
+}
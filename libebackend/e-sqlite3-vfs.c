@@ -33,6 +33,17 @@
 
 #define SYNC_TIMEOUT_SECONDS 5
 
+/* Highest sqlite3_io_methods version forwarded to the old VFS; the shared
+ * memory methods used by WAL appeared in 3.7.0, the memory-mapped I/O
+ * methods in 3.7.17 */
+#if SQLITE_VERSION_NUMBER >= 3007017
+#define IO_METHODS_VERSION 3
+#elif SQLITE_VERSION_NUMBER >= 3007000
+#define IO_METHODS_VERSION 2
+#else
+#define IO_METHODS_VERSION 1
+#endif
+
 static sqlite3_vfs *old_vfs = NULL;
 static GThreadPool *sync_pool = NULL;
 
@@ -42,6 +53,11 @@ typedef struct {
 	GRecMutex sync_mutex;
 	guint timeout_id;
 	gint flags;
+
+	/* Syncs of the write-ahead log, and of a database using one, are
+	 * part of checkpoints, which rely on them having hit the disk
+	 * before the log is reset. They cannot be deferred. */
+	gboolean sync_immediately;
 } ESqlite3File;
 
 static gint
@@ -162,9 +178,70 @@ def_subclassed (xUnlock, (sqlite3_file *pFile, gint lockType), (cFile->old_vfs_f
 def_subclassed (xFileControl, (sqlite3_file *pFile, gint op, gpointer pArg), (cFile->old_vfs_file, op, pArg))
 def_subclassed (xSectorSize, (sqlite3_file *pFile), (cFile->old_vfs_file))
 def_subclassed (xDeviceCharacteristics, (sqlite3_file *pFile), (cFile->old_vfs_file))
+#if IO_METHODS_VERSION >= 2
+def_subclassed (xShmLock, (sqlite3_file *pFile, gint offset, gint n, gint flags), (cFile->old_vfs_file, offset, n, flags))
+def_subclassed (xShmUnmap, (sqlite3_file *pFile, gint deleteFlag), (cFile->old_vfs_file, deleteFlag))
+#endif
+#if IO_METHODS_VERSION >= 3
+def_subclassed (xFetch, (sqlite3_file *pFile, sqlite3_int64 iOfst, gint iAmt, gpointer *pp), (cFile->old_vfs_file, iOfst, iAmt, pp))
+def_subclassed (xUnfetch, (sqlite3_file *pFile, sqlite3_int64 iOfst, gpointer p), (cFile->old_vfs_file, iOfst, p))
+#endif
 
 #undef def_subclassed
 
+#if IO_METHODS_VERSION >= 2
+static gint
+e_sqlite3_file_xShmMap (sqlite3_file *pFile,
+                        gint iPg,
+                        gint pgsz,
+                        gint bExtend,
+                        void volatile **pp)
+{
+	ESqlite3File *cFile;
+
+	g_return_val_if_fail (old_vfs != NULL, SQLITE_ERROR);
+	g_return_val_if_fail (pFile != NULL, SQLITE_ERROR);
+
+	cFile = (ESqlite3File *) pFile;
+	g_return_val_if_fail (cFile->old_vfs_file->pMethods != NULL, SQLITE_ERROR);
+
+	/* Only a database in WAL journal mode maps the shared memory
+	 * index, its syncs from now on belong to checkpoints */
+	g_rec_mutex_lock (&cFile->sync_mutex);
+
+	if (!cFile->sync_immediately) {
+		cFile->sync_immediately = TRUE;
+
+		/* Such as the one switching the journal mode */
+		if (cFile->timeout_id > 0) {
+			g_source_remove (cFile->timeout_id);
+			cFile->timeout_id = 0;
+
+			call_old_file_Sync (cFile, cFile->flags);
+			cFile->flags = 0;
+		}
+	}
+
+	g_rec_mutex_unlock (&cFile->sync_mutex);
+
+	return cFile->old_vfs_file->pMethods->xShmMap (cFile->old_vfs_file, iPg, pgsz, bExtend, pp);
+}
+
+static void
+e_sqlite3_file_xShmBarrier (sqlite3_file *pFile)
+{
+	ESqlite3File *cFile;
+
+	g_return_if_fail (old_vfs != NULL);
+	g_return_if_fail (pFile != NULL);
+
+	cFile = (ESqlite3File *) pFile;
+	g_return_if_fail (cFile->old_vfs_file->pMethods != NULL);
+
+	cFile->old_vfs_file->pMethods->xShmBarrier (cFile->old_vfs_file);
+}
+#endif
+
 static gint
 e_sqlite3_file_xCheckReservedLock (sqlite3_file *pFile,
                                    gint *pResOut)
@@ -238,8 +315,19 @@ e_sqlite3_file_xSync (sqlite3_file *pFile,
 	cFile->flags |= flags;
 
 	/* Cancel any pending sync requests. */
-	if (cFile->timeout_id > 0)
+	if (cFile->timeout_id > 0) {
 		g_source_remove (cFile->timeout_id);
+		cFile->timeout_id = 0;
+	}
+
+	if (cFile->sync_immediately) {
+		flags = cFile->flags;
+		cFile->flags = 0;
+
+		g_rec_mutex_unlock (&cFile->sync_mutex);
+
+		return call_old_file_Sync (cFile, flags);
+	}
 
 	/* Wait SYNC_TIMEOUT_SECONDS before we actually sync. */
 	cFile->timeout_id = g_timeout_add_seconds (
@@ -276,6 +364,14 @@ e_sqlite3_vfs_xOpen (sqlite3_vfs *pVfs,
 	}
 
 	g_rec_mutex_init (&cFile->sync_mutex);
+	cFile->timeout_id = 0;
+	cFile->flags = 0;
+
+	#ifdef SQLITE_OPEN_WAL
+	cFile->sync_immediately = (flags & SQLITE_OPEN_WAL) != 0;
+	#else
+	cFile->sync_immediately = FALSE;
+	#endif
 
 	g_rec_mutex_lock (&only_once_lock);
 
@@ -286,7 +382,9 @@ e_sqlite3_vfs_xOpen (sqlite3_vfs *pVfs,
 	 * thus do not initialize our structure when do not know the version */
 	if (io_methods.xClose == NULL && cFile->old_vfs_file->pMethods) {
 		/* initialize our subclass function only once */
-		io_methods.iVersion = cFile->old_vfs_file->pMethods->iVersion;
+		io_methods.iVersion = MIN (
+			cFile->old_vfs_file->pMethods->iVersion,
+			IO_METHODS_VERSION);
 
 		/* check version in compile time */
 		#if SQLITE_VERSION_NUMBER < 3006000
@@ -307,6 +405,22 @@ e_sqlite3_vfs_xOpen (sqlite3_vfs *pVfs,
 		use_subclassed (xFileControl);
 		use_subclassed (xSectorSize);
 		use_subclassed (xDeviceCharacteristics);
+
+		/* WAL journal mode and memory-mapped I/O need these */
+		#if IO_METHODS_VERSION >= 2
+		if (io_methods.iVersion >= 2) {
+			use_subclassed (xShmMap);
+			use_subclassed (xShmLock);
+			use_subclassed (xShmBarrier);
+			use_subclassed (xShmUnmap);
+		}
+		#endif
+		#if IO_METHODS_VERSION >= 3
+		if (io_methods.iVersion >= 3) {
+			use_subclassed (xFetch);
+			use_subclassed (xUnfetch);
+		}
+		#endif
 		#undef use_subclassed
 	}
 
@@ -0,0 +1,170 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+/* Measures the vCard parse throughput of EVCard.
+ *
+ * Parses every vCard of the .vcf file given on the command line, or of a
+ * generated corpus if none is given, a few times over and reports the
+ * throughput of parsing alone, and of parsing followed by reading all
+ * attribute values.
+ */
+
+#include <libebook-contacts/libebook-contacts.h>
+#include <string.h>
+
+static gint n_contacts = 5000;
+static gint n_iterations = 5;
+
+static GOptionEntry entries[] = {
+	{ "contacts", 'n', 0, G_OPTION_ARG_INT, &n_contacts,
+	  "Number of contacts to generate if no file is given", "N" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations,
+	  "Number of passes over the corpus", "N" },
+	{ NULL }
+};
+
+static gchar *
+generate_corpus (gint n)
+{
+	GString *corpus = g_string_new (NULL);
+	gint i;
+
+	for (i = 0; i < n; i++) {
+		g_string_append_printf (
+			corpus,
+			"BEGIN:VCARD\r\n"
+			"VERSION:3.0\r\n"
+			"UID:contact-%d\r\n"
+			"REV:2013-11-%02dT10:00:00Z\r\n"
+			"FN:Firstname%d Lastname%d\r\n"
+			"N:Lastname%d;Firstname%d;Middle;Dr.;Jr.\r\n"
+			"NICKNAME:nick%d\r\n"
+			"EMAIL;TYPE=WORK:first%d.last@example.com\r\n"
+			"EMAIL;TYPE=HOME:first%d@example.org\r\n"
+			"TEL;TYPE=WORK,VOICE:+1 555 01%05d\r\n"
+			"TEL;TYPE=CELL:+1 555 02%05d\r\n"
+			"ADR;TYPE=WORK:;;%d Main Street\\, Suite 100;Springfield;ST;12345;\r\n"
+			" Country\r\n"
+			"ORG:Example Corp;Engineering\r\n"
+			"TITLE:Engineer\r\n"
+			"CATEGORIES:Work,Friends,Example\r\n"
+			"NOTE;ENCODING=QUOTED-PRINTABLE:A note spanning=0D=0Atwo lines for con=\r\n"
+			"tact %d\r\n"
+			"X-EVOLUTION-FILE-AS:Lastname%d\\, Firstname%d\r\n"
+			"PHOTO;ENCODING=b;TYPE=JPEG:/9j/4AAQSkZJRgABAQEASABIAAD/2wBDAAMCAgMCAgMDAwME\r\n"
+			" AwMEBQgFBQQEBQoHBwYIDAoMDAsKCwsNDhIQDQ4RDgsLEBYQERMUFRUVDA8XGBYUGBIUFRT/\r\n"
+			" 2wBDAQMEBAUEBQkFBQkUDQsNFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQU\r\n"
+			"END:VCARD\r\n",
+			i, i % 28 + 1, i, i, i, i, i, i, i, i, i, i, i, i, i);
+	}
+
+	return g_string_free (corpus, FALSE);
+}
+
+/* Splits a .vcf corpus into its individual vCards */
+static GPtrArray *
+split_corpus (const gchar *corpus,
+              gsize *total_length)
+{
+	GPtrArray *vcards = g_ptr_array_new_with_free_func (g_free);
+	const gchar *begin, *end;
+
+	*total_length = 0;
+
+	for (begin = strstr (corpus, "BEGIN:VCARD");
+	     begin != NULL;
+	     begin = strstr (end, "BEGIN:VCARD")) {
+		end = strstr (begin, "END:VCARD");
+		if (end == NULL)
+			break;
+
+		end += strlen ("END:VCARD");
+		g_ptr_array_add (vcards, g_strndup (begin, end - begin));
+		*total_length += end - begin;
+	}
+
+	return vcards;
+}
+
+static void
+run_pass (GPtrArray *vcards,
+          gsize total_length,
+          gboolean read_values,
+          const gchar *description)
+{
+	GTimer *timer;
+	gdouble elapsed;
+	gint i, j;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_iterations; i++) {
+		for (j = 0; j < vcards->len; j++) {
+			EVCard *vcard;
+			GList *attrs;
+
+			vcard = e_vcard_new_from_string (g_ptr_array_index (vcards, j));
+
+			for (attrs = e_vcard_get_attributes (vcard); attrs; attrs = attrs->next) {
+				if (read_values)
+					e_vcard_attribute_get_values (attrs->data);
+			}
+
+			g_object_unref (vcard);
+		}
+	}
+
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_print (
+		"%-28s %8.3f s  %10.0f vCards/s  %8.2f MB/s\n",
+		description, elapsed,
+		vcards->len * n_iterations / elapsed,
+		total_length * n_iterations / elapsed / (1024 * 1024));
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	GOptionContext *context;
+	GPtrArray *vcards;
+	GError *error = NULL;
+	gchar *corpus = NULL;
+	gsize total_length;
+
+	g_type_init ();
+
+	context = g_option_context_new ("[FILE.vcf]");
+	g_option_context_add_main_entries (context, entries, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+
+	g_option_context_free (context);
+
+	if (argc > 1) {
+		if (!g_file_get_contents (argv[1], &corpus, NULL, &error)) {
+			g_printerr ("%s\n", error->message);
+			return 1;
+		}
+	} else {
+		corpus = generate_corpus (n_contacts);
+	}
+
+	vcards = split_corpus (corpus, &total_length);
+	g_free (corpus);
+
+	g_print (
+		"Parsing %u vCards (%.2f MB), %d iterations\n",
+		vcards->len, total_length / (1024.0 * 1024.0), n_iterations);
+
+	run_pass (vcards, total_length, FALSE, "Parse attributes:");
+	run_pass (vcards, total_length, TRUE, "Parse and read all values:");
+
+	g_ptr_array_unref (vcards);
+
+	return 0;
+}
@@ -167,6 +167,28 @@ test_categories_convert_to_list (TypesFixture *fixture,
 	g_assert_cmpstr ((gchar *) g_list_nth_data (category_list, 2), ==, "Competition");
 }
 
+/************* LIST ELEMENTS *****************/
+static void
+test_list_elem_serialized (TypesFixture *fixture,
+                           gconstpointer user_data)
+{
+	gchar *vcard_str;
+
+	e_contact_set (fixture->contact, E_CONTACT_ORG, "Company");
+	e_contact_set (fixture->contact, E_CONTACT_ORG_UNIT, "Unit");
+
+	vcard_str = e_vcard_to_string (E_VCARD (fixture->contact), EVC_FORMAT_VCARD_30);
+	g_assert (strstr (vcard_str, "ORG:Company;Unit\r\n") != NULL);
+	g_free (vcard_str);
+
+	/* Replaces the existing element of the serialized attribute */
+	e_contact_set (fixture->contact, E_CONTACT_ORG_UNIT, "Other Unit");
+
+	vcard_str = e_vcard_to_string (E_VCARD (fixture->contact), EVC_FORMAT_VCARD_30);
+	g_assert (strstr (vcard_str, "ORG:Company;Other Unit\r\n") != NULL);
+	g_free (vcard_str);
+}
+
 gint
 main (gint argc,
       gchar **argv)
@@ -220,6 +242,12 @@ main (gint argc,
 		types_setup,
 		test_categories_convert_to_list,
 		types_teardown);
+	g_test_add (
+		"/Contact/Types/ListElem/Serialized",
+		TypesFixture, NULL,
+		types_setup,
+		test_list_elem_serialized,
+		types_teardown);
 
 	return g_test_run ();
 }
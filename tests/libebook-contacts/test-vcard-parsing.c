@@ -377,6 +377,55 @@ test_vcard_quoted_printable (void)
 	g_assert (test_vcard_qp_3_0_saving (expected_text));
 }
 
+/* The value is the last thing in the vCard string, which makes it lack
+ * the END:VCARD, so that decoding it hits the end of the string */
+static gboolean
+test_vcard_truncated_value (const gchar *vcard_str,
+                            const gchar *attrname,
+                            const gchar *expected_value)
+{
+	EVCard *vcard;
+	gboolean success;
+
+	vcard = e_vcard_new_from_string (vcard_str);
+	g_return_val_if_fail (vcard != NULL, FALSE);
+
+	g_test_expect_message (
+		"libebook-contacts", G_LOG_LEVEL_WARNING,
+		"vcard ended without END:VCARD*");
+	success = compare_single_value (vcard, attrname, expected_value);
+	g_test_assert_expected_messages ();
+
+	g_object_unref (vcard);
+
+	return success;
+}
+
+static void
+test_vcard_trailing_equal_sign (void)
+{
+	g_assert (test_vcard_truncated_value (
+		"BEGIN:VCARD\r\n"
+		"VERSION:2.1\r\n"
+		"FN;ENCODING=quoted-printable:abc=",
+		"FN", "abc"));
+	g_assert (test_vcard_truncated_value (
+		"BEGIN:VCARD\r\n"
+		"VERSION:2.1\r\n"
+		"FN;ENCODING=quoted-printable:abc=4",
+		"FN", "abc"));
+}
+
+static void
+test_vcard_trailing_backslash (void)
+{
+	g_assert (test_vcard_truncated_value (
+		"BEGIN:VCARD\r\n"
+		"VERSION:3.0\r\n"
+		"FN:abc\\",
+		"FN", "abc\\"));
+}
+
 static const gchar *test_vcard_no_uid_str =
 	"BEGIN:VCARD\r\n"
 	"VERSION:3.0\r\n"
@@ -432,6 +481,8 @@ main (gint argc,
 	g_test_add_func ("/Parsing/VCard/WithUID", test_contact_with_uid);
 	g_test_add_func ("/Parsing/VCard/WithoutUID", test_contact_without_uid);
 	g_test_add_func ("/Parsing/VCard/QuotedPrintable", test_vcard_quoted_printable);
+	g_test_add_func ("/Parsing/VCard/TrailingEqualSign", test_vcard_trailing_equal_sign);
+	g_test_add_func ("/Parsing/VCard/TrailingBackslash", test_vcard_trailing_backslash);
 
 	return g_test_run ();
 }
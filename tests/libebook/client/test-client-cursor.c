@@ -0,0 +1,321 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+#include <locale.h>
+#include <libebook/libebook.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+static ETestServerClosure book_closure = { E_TEST_SERVER_DIRECT_ADDRESS_BOOK, NULL, 0 };
+
+/* In the order the cursor sorts them by full name */
+static const gchar *sorted_names[] = {
+	"Alice Apple",
+	"Betty Blue",
+	"Bob Banana",
+	"Charlie Cherry",
+	"Dan Date",
+	"Eve Elder"
+};
+
+static EContact *
+add_named_contact (EBookClient *book_client,
+                   const gchar *full_name)
+{
+	EContact *contact;
+
+	contact = e_contact_new ();
+	e_contact_set (contact, E_CONTACT_FULL_NAME, full_name);
+
+	if (!add_contact_verify (book_client, contact))
+		g_error ("Failed to add contact '%s'", full_name);
+
+	return contact;
+}
+
+static EBookClientCursor *
+setup_cursor (ETestServerFixture *fixture)
+{
+	EBookClient *book_client;
+	EBookClientCursor *cursor = NULL;
+	EContactField sort_fields[] = { E_CONTACT_FULL_NAME };
+	EBookCursorSortType sort_types[] = { E_BOOK_CURSOR_SORT_ASCENDING };
+	GError *error = NULL;
+	gint ii;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	/* Added out of order, to have the cursor do the sorting */
+	for (ii = G_N_ELEMENTS (sorted_names) - 1; ii >= 0; ii--)
+		g_object_unref (add_named_contact (book_client, sorted_names[ii]));
+
+	if (!e_book_client_get_cursor_sync (book_client, NULL,
+					    sort_fields, sort_types, 1,
+					    &cursor, NULL, &error))
+		g_error ("Failed to create a cursor: %s", error->message);
+
+	return cursor;
+}
+
+static void
+assert_step (EBookClientCursor *cursor,
+             EBookCursorOrigin origin,
+             gint count,
+             gint n_expected,
+             ...)
+{
+	GSList *contacts = NULL, *link;
+	GError *error = NULL;
+	va_list args;
+	gint n_traversed;
+
+	n_traversed = e_book_client_cursor_step_sync (
+		cursor, E_BOOK_CURSOR_STEP_MOVE | E_BOOK_CURSOR_STEP_FETCH,
+		origin, count, &contacts, NULL, &error);
+
+	if (n_traversed < 0)
+		g_error ("Failed to step the cursor: %s", error->message);
+
+	g_assert_cmpint (n_traversed, ==, n_expected);
+	g_assert_cmpint (g_slist_length (contacts), ==, n_expected);
+
+	va_start (args, n_expected);
+	for (link = contacts; link != NULL; link = g_slist_next (link)) {
+		const gchar *expected = va_arg (args, const gchar *);
+
+		g_assert_cmpstr (
+			e_contact_get_const (link->data, E_CONTACT_FULL_NAME),
+			==, expected);
+	}
+	va_end (args);
+
+	g_slist_free_full (contacts, g_object_unref);
+}
+
+static void
+assert_position (EBookClientCursor *cursor,
+                 gint expected_total,
+                 gint expected_position)
+{
+	GError *error = NULL;
+	gint total = -1, position = -1;
+
+	if (!e_book_client_cursor_get_position_sync (cursor, &total, &position, NULL, &error))
+		g_error ("Failed to calculate the cursor position: %s", error->message);
+
+	g_assert_cmpint (total, ==, expected_total);
+	g_assert_cmpint (position, ==, expected_position);
+}
+
+static gint
+find_alphabetic_index (EBookClientCursor *cursor,
+                       const gchar *label)
+{
+	const gchar * const *alphabet;
+	gint n_labels, ii;
+
+	alphabet = e_book_client_cursor_get_alphabet (cursor, &n_labels);
+
+	for (ii = 0; ii < n_labels; ii++) {
+		if (g_strcmp0 (alphabet[ii], label) == 0)
+			return ii;
+	}
+
+	g_error ("No alphabetic index for '%s'", label);
+
+	return -1;
+}
+
+static void
+test_cursor_step (ETestServerFixture *fixture,
+                  gconstpointer user_data)
+{
+	EBookClientCursor *cursor;
+
+	cursor = setup_cursor (fixture);
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_BEGIN, 3, 3,
+		"Alice Apple", "Betty Blue", "Bob Banana");
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 3, 3,
+		"Charlie Cherry", "Dan Date", "Eve Elder");
+
+	/* Nothing left, which moves the cursor to the end */
+	assert_step (cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 0);
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, -2, 2,
+		"Eve Elder", "Dan Date");
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, -2, 2,
+		"Charlie Cherry", "Bob Banana");
+
+	/* Fewer contacts than asked for, which moves it to the beginning */
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, -5, 2,
+		"Betty Blue", "Alice Apple");
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 1,
+		"Alice Apple");
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_END, -1, 1,
+		"Eve Elder");
+
+	g_object_unref (cursor);
+}
+
+static void
+test_cursor_alphabetic_index (ETestServerFixture *fixture,
+                              gconstpointer user_data)
+{
+	EBookClientCursor *cursor;
+
+	cursor = setup_cursor (fixture);
+
+	e_book_client_cursor_set_alphabetic_index (
+		cursor, find_alphabetic_index (cursor, "B"));
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 2, 2,
+		"Betty Blue", "Bob Banana");
+
+	e_book_client_cursor_set_alphabetic_index (
+		cursor, find_alphabetic_index (cursor, "D"));
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 1,
+		"Dan Date");
+
+	/* Stepping back from a label traverses what sorts before it */
+	e_book_client_cursor_set_alphabetic_index (
+		cursor, find_alphabetic_index (cursor, "C"));
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, -1, 1,
+		"Bob Banana");
+
+	/* No contacts start with 'X' or any label after it */
+	e_book_client_cursor_set_alphabetic_index (
+		cursor, find_alphabetic_index (cursor, "X"));
+	assert_step (cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 0);
+
+	g_object_unref (cursor);
+}
+
+static void
+test_cursor_position (ETestServerFixture *fixture,
+                      gconstpointer user_data)
+{
+	EBookClientCursor *cursor;
+
+	cursor = setup_cursor (fixture);
+
+	assert_position (cursor, 6, 0);
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_BEGIN, 2, 2,
+		"Alice Apple", "Betty Blue");
+	assert_position (cursor, 6, 2);
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 3, 3,
+		"Bob Banana", "Charlie Cherry", "Dan Date");
+	assert_position (cursor, 6, 5);
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 2, 1,
+		"Eve Elder");
+	assert_position (cursor, 6, 7);
+
+	g_object_unref (cursor);
+}
+
+static void
+test_cursor_changes (ETestServerFixture *fixture,
+                     gconstpointer user_data)
+{
+	EBookClient *book_client;
+	EBookClientCursor *cursor;
+	EContact *removed;
+	GError *error = NULL;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+	cursor = setup_cursor (fixture);
+
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_BEGIN, 3, 3,
+		"Alice Apple", "Betty Blue", "Bob Banana");
+
+	/* One contact added before the cursor, one after it */
+	g_object_unref (add_named_contact (book_client, "Aaron Able"));
+	g_object_unref (add_named_contact (book_client, "Carl Coal"));
+
+	assert_position (cursor, 8, 4);
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 1,
+		"Carl Coal");
+
+	/* Removing the contact the cursor sits on keeps its place */
+	removed = add_named_contact (book_client, "Cathy Clay");
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 1,
+		"Cathy Clay");
+
+	if (!e_book_client_remove_contact_sync (book_client, removed, NULL, &error))
+		g_error ("Failed to remove contact: %s", error->message);
+	g_object_unref (removed);
+
+	assert_position (cursor, 8, 5);
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_CURRENT, 1, 1,
+		"Charlie Cherry");
+	assert_step (
+		cursor, E_BOOK_CURSOR_ORIGIN_BEGIN, 2, 2,
+		"Aaron Able", "Alice Apple");
+
+	g_object_unref (cursor);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+#if !GLIB_CHECK_VERSION (2, 35, 1)
+	g_type_init ();
+#endif
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	/* Change environment so that the addressbook factory inherits this setting */
+	g_setenv ("LC_ALL", "en_US.UTF-8", TRUE);
+	setlocale (LC_ALL, "");
+
+	g_test_add (
+		"/EBookClientCursor/Step",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_cursor_step,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClientCursor/AlphabeticIndex",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_cursor_alphabetic_index,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClientCursor/Position",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_cursor_position,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClientCursor/Changes",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_cursor_changes,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
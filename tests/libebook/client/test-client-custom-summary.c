@@ -53,6 +53,8 @@ setup_custom_book (ESource *scratch,
 		E_CONTACT_FULL_NAME, E_BOOK_INDEX_SUFFIX,
 		E_CONTACT_FAMILY_NAME, E_BOOK_INDEX_PREFIX,
 		E_CONTACT_FAMILY_NAME, E_BOOK_INDEX_SUFFIX,
+		E_CONTACT_FULL_NAME, E_BOOK_INDEX_SUBSTRING,
+		E_CONTACT_EMAIL, E_BOOK_INDEX_SUBSTRING,
 		0);
 }
 
@@ -464,6 +466,117 @@ main (gint argc,
 			suites[i].custom,
 			FALSE);
 
+		/* The custom book has a substring index on the full
+		 * name and email, the default book none at all */
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/FullName",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_FULL_NAME,
+				E_BOOK_QUERY_CONTAINS,
+				"bobby"),
+			2,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/FullName/Normalized",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_FULL_NAME,
+				E_BOOK_QUERY_CONTAINS,
+				"JACKSON"),
+			2,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		/* Shorter than a trigram, which cannot use the index */
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/FullName/Short",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_FULL_NAME,
+				E_BOOK_QUERY_CONTAINS,
+				"ob"),
+			2,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		/* Big Bobby Brown has every trigram of the term,
+		 * but not the term itself */
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/FullName/Scrambled",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_FULL_NAME,
+				E_BOOK_QUERY_CONTAINS,
+				"bobby bob"),
+			0,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/Email",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_EMAIL,
+				E_BOOK_QUERY_CONTAINS,
+				"bobby@"),
+			2,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		add_client_test (
+			suites[i].prefix,
+			"/Contains/Email/NoMatch",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_EMAIL,
+				E_BOOK_QUERY_CONTAINS,
+				"xyzzy"),
+			0,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		/* Email has no suffix index in the custom book,
+		 * so this goes through the substring index */
+		add_client_test (
+			suites[i].prefix,
+			"/Suffix/Email/Substring",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_EMAIL,
+				E_BOOK_QUERY_ENDS_WITH,
+				"pony.com"),
+			2,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
+		add_client_test (
+			suites[i].prefix,
+			"/Suffix/Email/Substring/NotAtEnd",
+			suites[i].func,
+			e_book_query_field_test (
+				E_CONTACT_EMAIL,
+				E_BOOK_QUERY_ENDS_WITH,
+				"@pony"),
+			0,
+			suites[i].direct,
+			suites[i].custom,
+			FALSE);
+
 		/*********************************************
 		 *         PHONE NUMBER QUERIES FOLLOW       *
 		 *********************************************/